@@ -48,6 +48,22 @@
 * - cy_wcm_is_connected_to_ap
 * - cy_wcm_register_event_callback
 * - cy_wcm_deregister_event_callback
+* - cy_wcm_get_ip_addr, cy_wcm_get_gateway_ip_address, and cy_wcm_get_mac_addr (STA interface only)
+* - cy_wcm_get_associated_ap_info
+*
+* The primary core publishes the STA state in shared memory on every connection and IP change. Once the secondary core
+* knows the address of that block, cy_wcm_is_connected_to_ap and the getters above read it locally without an IPC round trip.
+* VCM has no request that passes the address, so it is handed over in one of two ways:
+* - Place the block at the same fixed address in both images: define WCM_SHARED_STATE_SECTION on the primary core with the
+*   name of a linker section at that address, and WCM_SHARED_STATE_ADDRESS with the address on the secondary core.
+*   The virtual cy_wcm_init then picks the block up.
+* - Pass the address returned by cy_wcm_get_shared_state on the primary core to cy_wcm_set_shared_state on the secondary
+*   core (both declared in cy_wcm_internal.h) over an IPC channel of the application.
+*
+* Without the block, cy_wcm_is_connected_to_ap goes over IPC. cy_wcm_get_ip_addr, cy_wcm_get_gateway_ip_address, and
+* cy_wcm_get_associated_ap_info then ask the primary core over IPC whether the STA is connected: they return
+* \ref CY_RSLT_WCM_STA_NETWORK_DOWN if it is not, and \ref CY_RSLT_WCM_UNSUPPORTED_API otherwise. cy_wcm_get_mac_addr
+* returns \ref CY_RSLT_WCM_UNSUPPORTED_API.
 *
 * In order to use the virtual APIs, the Virtual Connectivity Manager (VCM) library needs to be included and initialized first.
 * Define the following compile-time macros in the secondary core's application:
@@ -146,9 +162,38 @@ extern "C" {
 /** WPS password length for PIN mode. */
 #define CY_WCM_WPS_PIN_LENGTH              (9)
 
-/** Maximum number of callbacks that can be registered with the WCM library. */
+/** Maximum number of phase records returned by \ref cy_wcm_wps_get_timeline. */
+#ifndef CY_WCM_WPS_TIMELINE_SIZE
+#define CY_WCM_WPS_TIMELINE_SIZE           (48)
+#endif
+
+/** Maximum number of callbacks that can be registered through the virtual API from the secondary core. The primary core has no limit. */
 #define CY_WCM_MAXIMUM_CALLBACKS_COUNT     (5)
 
+/** Maximum number of targets of a ping session started with \ref cy_wcm_ping_start. */
+#ifndef CY_WCM_PING_MAX_TARGETS
+#define CY_WCM_PING_MAX_TARGETS            (4)
+#endif
+
+/** Maximum number of SSIDs in \ref cy_wcm_scan_request_t. */
+#ifndef CY_WCM_SCAN_MAX_SSIDS
+#define CY_WCM_SCAN_MAX_SSIDS              (8)
+#endif
+
+/** Maximum number of channels in \ref cy_wcm_scan_request_t. */
+#ifndef CY_WCM_SCAN_MAX_CHANNELS
+#define CY_WCM_SCAN_MAX_CHANNELS           (16)
+#endif
+
+/** Number of round-trip time histogram bins in \ref cy_wcm_ping_target_stats_t. */
+#define CY_WCM_PING_HISTOGRAM_BINS         (8)
+
+/** Event mask bit of a \ref cy_wcm_event_t event, for \ref cy_wcm_register_event_callback_ex. */
+#define CY_WCM_EVENT_MASK(event)           (1UL << (uint32_t)(event))
+
+/** Event mask that selects all events. */
+#define CY_WCM_EVENT_MASK_ALL              (0xFFFFFFFFUL)
+
 /**
  * Setup Command field (Table 9-262k)
  */
@@ -387,6 +432,27 @@ typedef enum
     CY_WCM_WPS_DEVICE_OTHER                  = 0xFF,  /**< Other devices.                  */
 } cy_wcm_wps_device_category_t;
 
+/**
+ * Enumeration of WPS phases recorded in the timeline returned by \ref cy_wcm_wps_get_timeline
+ */
+typedef enum
+{
+    CY_WCM_WPS_PHASE_STARTED = 0,         /**< WPS started. */
+    CY_WCM_WPS_PHASE_SCAN_STARTED,        /**< Scan for WPS APs started. */
+    CY_WCM_WPS_PHASE_SCAN_COMPLETE,       /**< Scan for WPS APs complete; detail is the number of WPS APs found. */
+    CY_WCM_WPS_PHASE_JOIN_STARTED,        /**< Joining a WPS AP; detail is the channel of the AP. */
+    CY_WCM_WPS_PHASE_JOIN_COMPLETE,       /**< Joined the WPS AP; detail is the channel of the AP. */
+    CY_WCM_WPS_PHASE_JOIN_FAILED,         /**< Failed to join the WPS AP; detail is the failure result. */
+    CY_WCM_WPS_PHASE_EAPOL_START_SENT,    /**< EAPOL-Start sent. */
+    CY_WCM_WPS_PHASE_IDENTITY_SENT,       /**< EAP identity response sent. */
+    CY_WCM_WPS_PHASE_WSC_START_RECEIVED,  /**< WSC start received from the registrar. */
+    CY_WCM_WPS_PHASE_MESSAGE_SENT,        /**< WPS message sent; detail is the WPS message type (0x04 = M1 to 0x0C = M8, 0x0D = ACK, 0x0E = NACK, 0x0F = DONE). */
+    CY_WCM_WPS_PHASE_MESSAGE_RECEIVED,    /**< WPS message received; detail is the WPS message type. */
+    CY_WCM_WPS_PHASE_FRAG_ACK_SENT,       /**< Fragment ACK sent; detail is the EAP identifier of the acknowledged fragment. */
+    CY_WCM_WPS_PHASE_RESTARTED,           /**< WPS handshake failed and was restarted; detail is the failure result. */
+    CY_WCM_WPS_PHASE_FINISHED             /**< WPS finished; detail is the internal WPS result. */
+} cy_wcm_wps_phase_t;
+
 /**
  * Enumeration of WCM events
  */
@@ -414,6 +480,15 @@ typedef enum
    CY_WCM_SCAN_FILTER_TYPE_RSSI,       /**< RSSI-based scan filtering. */
 }cy_wcm_scan_filter_type_t;
 
+/**
+ * Enumeration of scan types
+ */
+typedef enum
+{
+   CY_WCM_SCAN_TYPE_ACTIVE = 0,        /**< Probe requests are sent on each channel. */
+   CY_WCM_SCAN_TYPE_PASSIVE,           /**< Only beacons are listened for; nothing is transmitted. */
+}cy_wcm_scan_type_t;
+
 /**
  * Enumeration of network types
  */
@@ -450,6 +525,16 @@ typedef enum {
     CY_WCM_TWT_SESSION_STATE_TEARDOWN_IN_PROGRESS,  /**< TWT session teardown is currently in progress. */
 } cy_wcm_twt_session_state_t;
 
+/**
+ * Enumeration of the queues of the WCM worker thread. Pending work in the control lane always runs before pending work in the bulk lane.
+ */
+typedef enum
+{
+    CY_WCM_WORKER_LANE_CONTROL = 0,  /**< Link up/down, connection status, IP change, handshake retry, and WPS work. */
+    CY_WCM_WORKER_LANE_BULK,         /**< Scan results, scan completion, and SoftAP client join/leave events.      */
+    CY_WCM_WORKER_LANE_MAX           /**< Number of lanes.                                                          */
+} cy_wcm_worker_lane_t;
+
 /** \} group_wcm_enums */
 
 /**
@@ -574,6 +659,27 @@ typedef struct
     } param;                                    /**< Parameter specific to scan filter mode.  */
 } cy_wcm_scan_filter_t;
 
+/**
+ * Structure used to pass a scan request to \ref cy_wcm_start_scan_request.
+ * Unlike \ref cy_wcm_scan_filter_t, all the filters apply together; a result is reported only if it passes each of them.
+ * The channel list, scan type and dwell times limit the airtime and current spent by the scan.
+ * A zero-initialized request is an active scan of all channels with the firmware defaults, for all networks.
+ */
+typedef struct
+{
+    uint8_t                        ssid_count;                       /**< Number of SSIDs in SSID; 0 to report any SSID. */
+    cy_wcm_ssid_t                  SSID[CY_WCM_SCAN_MAX_SSIDS];      /**< SSIDs to look for; a result matching any of them is reported. */
+    cy_wcm_wifi_band_t             band;                             /**< Radio band to scan; CY_WCM_WIFI_BAND_ANY for all bands. */
+    int16_t                        min_signal_strength;              /**< Results with an RSSI at or below this value in dBm are dropped; 0 disables the RSSI filter. */
+    cy_wcm_scan_type_t             scan_type;                        /**< Active or passive scan. */
+    uint8_t                        channel_count;                    /**< Number of channels in channel_list; 0 to scan all the channels of the band. */
+    uint16_t                       channel_list[CY_WCM_SCAN_MAX_CHANNELS]; /**< Channels to scan. */
+    uint16_t                       active_dwell_time_ms;             /**< Time spent on each channel by an active scan; 0 for the firmware default. */
+    uint16_t                       passive_dwell_time_ms;            /**< Time spent on each channel by a passive scan; 0 for the firmware default. */
+    uint16_t                       home_dwell_time_ms;               /**< Time spent on the channel of the connected AP between scanned channels; 0 for the firmware default. */
+    uint8_t                        probes_per_channel;               /**< Probe requests sent on each channel by an active scan; 0 for the firmware default. */
+} cy_wcm_scan_request_t;
+
 
 /**
  * Structure used for storing scan results.
@@ -627,8 +733,31 @@ typedef struct
     cy_wcm_ssid_t         ssid;                                    /**< AP SSID (name) - must be null-terminated. */
     cy_wcm_security_t     security;                                /**< AP security type.                         */
     cy_wcm_passphrase_t   passphrase;                              /**< AP passphrase - must be null-terminated.  */
+    cy_wcm_mac_t          BSSID;                                   /**< BSSID of the registrar AP the credentials were obtained from. All zeros if the credentials are for a different SSID. */
+    uint8_t               channel;                                 /**< Channel of the registrar AP. Zero if BSSID is not valid.  */
+    cy_wcm_wifi_band_t    band;                                    /**< Radio band of the registrar AP.           */
 } cy_wcm_wps_credential_t;
 
+/**
+ * Structure used to receive one phase record of the WPS timeline from \ref cy_wcm_wps_get_timeline.
+ */
+typedef struct
+{
+    uint32_t              time_ms;  /**< Time in milliseconds since WPS was started. */
+    cy_wcm_wps_phase_t    phase;    /**< Phase that was reached.                     */
+    uint32_t              detail;   /**< Phase specific detail, see \ref cy_wcm_wps_phase_t. */
+} cy_wcm_wps_phase_record_t;
+
+/**
+ * Structure used to receive the timeline of the last WPS enrollment from \ref cy_wcm_wps_get_timeline.
+ */
+typedef struct
+{
+    uint32_t                  count;                              /**< Number of valid entries in records, oldest first. */
+    uint32_t                  dropped;                            /**< Number of older records that did not fit in records. */
+    cy_wcm_wps_phase_record_t records[CY_WCM_WPS_TIMELINE_SIZE];  /**< Phase records.                                    */
+} cy_wcm_wps_timeline_t;
+
 /**
  * Structure used to receive the information of the associated AP from \ref cy_wcm_get_associated_ap_info().
  */
@@ -656,6 +785,90 @@ typedef struct
     uint32_t tx_bitrate; /**< Current transmitted data rate in Kbps */
 } cy_wcm_wlan_statistics_t;
 
+/**
+ * Structure used to receive the 64-bit WLAN counters of the given interface from \ref cy_wcm_get_wlan_counters.
+ */
+typedef struct
+{
+    uint64_t rx_bytes;       /**< Total received bytes.                                        */
+    uint64_t tx_bytes;       /**< Total transmitted bytes.                                     */
+    uint64_t rx_packets;     /**< Total received WLAN packets.                                 */
+    uint64_t tx_packets;     /**< Total transmitted WLAN packets.                              */
+    uint64_t tx_retries;     /**< Total transmission retries.                                  */
+    uint64_t tx_failed;      /**< Total packets that could not be sent after all retries.      */
+    uint64_t tx_errors;      /**< Total transmit errors.                                       */
+    uint64_t rx_fcs_errors;  /**< Total received frames with a bad frame check sequence (CRC). */
+    uint64_t rx_dropped;     /**< Total received frames dropped because no buffer was free.    */
+    uint64_t rx_errors;      /**< Total receive errors.                                        */
+    uint32_t tx_bitrate;     /**< Current transmitted data rate in Kbps. Always 0 for the SoftAP interface. */
+} cy_wcm_wlan_counters_t;
+
+/**
+ * Structure used to receive the statistics of one WCM worker thread lane from \ref cy_wcm_get_worker_stats.
+ */
+typedef struct
+{
+    uint32_t enqueued;        /**< Work items added to the lane.                                                         */
+    uint32_t coalesced;       /**< Work items merged into an identical item already waiting in the lane.                 */
+    uint32_t dropped;         /**< Work items rejected because the lane was full.                                        */
+    uint16_t pending;         /**< Work items currently waiting in the lane.                                             */
+    uint16_t high_water_mark; /**< Largest number of work items that were waiting in the lane at the same time.          */
+    uint32_t max_latency_ms;  /**< Longest time in milliseconds a work item waited in the lane before it started to run. */
+} cy_wcm_worker_lane_stats_t;
+
+/**
+ * Structure used to configure the STA roaming engine started with \ref cy_wcm_start_roaming.
+ */
+typedef struct
+{
+    int16_t  trigger_rssi;          /**< Smoothed RSSI in dBm at or below which WCM looks for a better AP of the same network, for example -75. */
+    uint8_t  rssi_delta;            /**< Hysteresis in dB. WCM only roams to an AP whose RSSI is at least this much above the smoothed RSSI of the current AP. */
+    uint8_t  smoothing_shift;       /**< Each new RSSI sample is given a weight of 1/2^smoothing_shift in the smoothed RSSI. Range: 0 (no smoothing) to 4. */
+    uint32_t sample_interval_ms;    /**< Time in milliseconds between two RSSI samples.                                                             */
+    uint32_t min_roam_interval_ms;  /**< Minimum time in milliseconds between two searches for a better AP.                                         */
+} cy_wcm_roam_config_t;
+
+/**
+ * Structure used to receive the details of a client of the SoftAP from \ref cy_wcm_get_associated_client_info.
+ */
+typedef struct
+{
+    cy_wcm_mac_t mac_addr;      /**< MAC address of the client.                                                                                   */
+    int16_t      rssi;          /**< RSSI of the client in dBm as of the last reconciliation with the firmware. 0 if it has not been read yet.   */
+    uint32_t     join_time_ms;  /**< Time the client joined, in milliseconds as returned by cy_rtos_get_time().                                   */
+    uint32_t     last_seen_ms;  /**< Time of the last event or reconciliation that showed the client, in milliseconds as returned by cy_rtos_get_time(). */
+} cy_wcm_ap_client_info_t;
+
+/**
+ * Structure used to configure a ping session started with \ref cy_wcm_ping_start.
+ */
+typedef struct
+{
+    cy_wcm_interface_t  interface;                          /**< Interface to ping from: CY_WCM_INTERFACE_TYPE_STA or CY_WCM_INTERFACE_TYPE_AP.  */
+    cy_wcm_ip_address_t targets[CY_WCM_PING_MAX_TARGETS];   /**< Addresses to ping.                                                              */
+    uint8_t             target_count;                       /**< Number of valid entries in targets. Range: 1 to CY_WCM_PING_MAX_TARGETS.        */
+    uint32_t            count;                              /**< Number of echo requests sent to each target. 0 to ping until \ref cy_wcm_ping_stop is called. */
+    uint32_t            interval_ms;                        /**< Time in milliseconds between the starts of two rounds of echo requests.         */
+    uint32_t            timeout_ms;                         /**< Time in milliseconds to wait for each echo reply.                              */
+} cy_wcm_ping_config_t;
+
+/**
+ * Structure used to report the results of one target of a ping session through \ref cy_wcm_ping_callback_t.
+ *
+ * Bin 0 of the histogram counts round-trip times below 2 ms, bin n counts round-trip times from 2^n ms up to
+ * 2^(n+1) - 1 ms, and the last bin counts all longer round-trip times.
+ */
+typedef struct
+{
+    cy_wcm_ip_address_t address;                                /**< Address of the target.                                           */
+    uint32_t            sent;                                   /**< Echo requests sent.                                              */
+    uint32_t            received;                               /**< Echo replies received. Loss is sent - received.                  */
+    uint32_t            min_rtt_ms;                             /**< Shortest round-trip time in milliseconds. 0 if no reply arrived.  */
+    uint32_t            avg_rtt_ms;                             /**< Average round-trip time in milliseconds. 0 if no reply arrived.   */
+    uint32_t            max_rtt_ms;                             /**< Longest round-trip time in milliseconds. 0 if no reply arrived.   */
+    uint32_t            histogram[CY_WCM_PING_HISTOGRAM_BINS];  /**< Number of replies per round-trip time range.                    */
+} cy_wcm_ping_target_stats_t;
+
 /**
  * Structure used to fill the vendor information element (IE) as a part of starting SoftAP. \ref cy_wcm_start_ap.
  */
@@ -712,6 +925,24 @@ typedef struct {
     bool                        is_announced;       /**< True for an Announced (protected) TWT session. */
 } cy_wcm_itwt_negotiated_params_t;
 
+/**
+ * Structure used to get the wake schedule statistics of one iTWT flow from \ref cy_wcm_sta_itwt_get_flow_stats.
+ * The negotiated values are those of the last agreement of the flow; they stay 0 until the firmware has reported them.
+ */
+typedef struct {
+    cy_wcm_twt_session_state_t  session_state;              /**< CY_WCM_TWT_SESSION_STATE_SETUP_COMPLETE while the flow has an agreement, CY_WCM_TWT_SESSION_STATE_INACTIVE otherwise. */
+    uint32_t                    requested_wake_duration_us; /**< Wake duration requested by the STA in microseconds.                                  */
+    uint32_t                    requested_wake_interval_us; /**< Wake interval requested by the STA in microseconds, mantissa * 2^exponent.            */
+    uint32_t                    wake_duration_us;           /**< Negotiated wake duration in microseconds.                                            */
+    uint32_t                    wake_interval_us;           /**< Negotiated wake interval in microseconds.                                            */
+    uint16_t                    duty_cycle_permille;        /**< Negotiated wake duration per wake interval, in 1/1000. A measure of the awake time of the radio. */
+    uint32_t                    setup_count;                /**< Agreements set up for the flow, including re-negotiations.                           */
+    uint32_t                    renegotiation_count;        /**< Automatic re-negotiations after the STA reconnected or roamed.                       */
+    uint32_t                    renegotiation_failures;     /**< Automatic re-negotiations that the AP did not accept.                                */
+    uint32_t                    ap_teardown_count;          /**< Agreements torn down by the AP.                                                      */
+    uint32_t                    active_time_ms;             /**< Total time in milliseconds the flow had an agreement.                                */
+} cy_wcm_itwt_flow_stats_t;
+
 /** \} group_wcm_structures */
 
 /**
@@ -734,6 +965,25 @@ typedef struct {
  */
 typedef void (*cy_wcm_scan_result_callback_t)( cy_wcm_scan_result_t *result_ptr, void *user_data, cy_wcm_scan_status_t status );
 
+/**
+ * Borrowed view of one scan result and its IEs, passed to \ref cy_wcm_scan_view_callback_t.
+ * The view refers to the WHD receive buffer and is read through the cy_wcm_scan_view_get_* functions.
+ */
+typedef struct cy_wcm_scan_result_view cy_wcm_scan_result_view_t;
+
+/**
+ * Scan result callback function pointer type for \ref cy_wcm_start_scan_view.
+ *
+ * @param[in] view             : Borrowed view of the scan result; valid only until the callback returns. Copy anything that is needed later.
+ *                               NULL when the scan status is CY_WCM_SCAN_COMPLETE.
+ * @param[in] user_data        : User-provided data.
+ * @param[in] status           : Status of the scan process; see \ref cy_wcm_scan_result_callback_t.
+ *
+ * Note: Results are delivered in the context of the WHD thread, which cannot process other events until the callback returns.
+ *       The callback must be short and must not call WCM or WHD APIs. The CY_WCM_SCAN_COMPLETE notification is delivered in the context of the WCM.
+ */
+typedef void (*cy_wcm_scan_view_callback_t)( const cy_wcm_scan_result_view_t *view, void *user_data, cy_wcm_scan_status_t status );
+
 
 /**
  * WCM event callback function pointer type; events are invoked when the WHD posts events to WCM.
@@ -744,14 +994,61 @@ typedef void (*cy_wcm_scan_result_callback_t)( cy_wcm_scan_result_t *result_ptr,
  */
 typedef void (*cy_wcm_event_callback_t)(cy_wcm_event_t event, cy_wcm_event_data_t *event_data);
 
+/**
+ * WCM event callback function pointer type for \ref cy_wcm_register_event_callback_ex.
+ * @param[in] event            : WCM events.
+ * @param[in] event_data       : A pointer to the event data. The event data will be freed once the callback returns from the application.
+ * @param[in] user_data        : User data passed to \ref cy_wcm_register_event_callback_ex.
+ *
+ * Note: The callback function will be executed in the context of the WCM.
+ */
+typedef void (*cy_wcm_event_callback_ex_t)(cy_wcm_event_t event, cy_wcm_event_data_t *event_data, void *user_data);
+
+/**
+ * WPS completion callback function pointer type; invoked once the enrollment started with \ref cy_wcm_wps_enrollee_async has finished.
+ * @param[in] result           : CY_RSLT_SUCCESS if credentials were retrieved; \ref cy_wcm_error otherwise.
+ * @param[in] credentials      : The credentials array passed to \ref cy_wcm_wps_enrollee_async.
+ * @param[in] credential_count : Number of credentials returned. Zero if the enrollment failed.
+ * @param[in] user_data        : User data passed to \ref cy_wcm_wps_enrollee_async.
+ *
+ * Note: The callback function will be executed in the context of the WCM.
+ */
+typedef void (*cy_wcm_wps_completion_callback_t)(cy_rslt_t result, cy_wcm_wps_credential_t *credentials, uint16_t credential_count, void *user_data);
+
+/**
+ * WPS registrar callback function pointer type; invoked each time a WPS session started by \ref cy_wcm_wps_registrar_start has finished.
+ * @param[in] result       : CY_RSLT_SUCCESS if the credentials were delivered to the enrollee; \ref cy_wcm_error otherwise.
+ * @param[in] enrollee_mac : MAC address of the enrollee.
+ * @param[in] user_data    : User data passed to \ref cy_wcm_wps_registrar_start.
+ *
+ * Note: The callback function will be executed in the context of the WCM.
+ */
+typedef void (*cy_wcm_wps_registrar_callback_t)(cy_rslt_t result, const cy_wcm_mac_t *enrollee_mac, void *user_data);
+
+/**
+ * Ping session callback function pointer type; invoked after each round of echo requests of a session started with \ref cy_wcm_ping_start.
+ * @param[in] result           : CY_RSLT_SUCCESS while the session runs normally; \ref cy_wcm_error if the session was ended early,
+ *                               for example CY_RSLT_WCM_STA_NETWORK_DOWN when the network of the interface went down.
+ * @param[in] stats            : Results of each target, accumulated since the session started. Valid only until the callback returns.
+ * @param[in] target_count     : Number of entries in stats.
+ * @param[in] is_complete      : True for the last callback of the session.
+ * @param[in] user_data        : User data passed to \ref cy_wcm_ping_start.
+ *
+ * Note: The callback function will be executed in the context of the WCM ping thread.
+ */
+typedef void (*cy_wcm_ping_callback_t)(cy_rslt_t result, const cy_wcm_ping_target_stats_t *stats, uint8_t target_count, bool is_complete, void *user_data);
+
 /** \} group_wcm_typedefs */
 /**
  * \addtogroup group_wcm_functions
  * \{
  * * The WCM library internally creates a thread; the created threads are executed with the "CY_RTOS_PRIORITY_ABOVENORMAL" priority. The definition of the CY_RTOS_PRIORITY_ABOVENORMAL macro is located at "libs/abstraction-rtos/include/COMPONENT_FREERTOS/cyabs_rtos_impl.h".
  * * The WCM APIs are thread-safe.
- * * All the WCM APIs except \ref cy_wcm_start_scan are blocking APIs.
- * * \ref cy_wcm_start_scan is a non-blocking API; scan results are delivered via \ref cy_wcm_scan_result_callback_t.
+ * * All the WCM APIs except \ref cy_wcm_start_scan, \ref cy_wcm_start_scan_view, \ref cy_wcm_start_scan_request, \ref cy_wcm_wps_enrollee_async, and \ref cy_wcm_ping_start are blocking APIs.
+ * * \ref cy_wcm_start_scan and \ref cy_wcm_start_scan_request are non-blocking APIs; scan results are delivered via \ref cy_wcm_scan_result_callback_t.
+ * * \ref cy_wcm_start_scan_view is a non-blocking API; scan results are delivered via \ref cy_wcm_scan_view_callback_t.
+ * * \ref cy_wcm_wps_enrollee_async is a non-blocking API; the result is delivered via \ref cy_wcm_wps_completion_callback_t.
+ * * \ref cy_wcm_ping_start is a non-blocking API; the results are delivered via \ref cy_wcm_ping_callback_t.
  * * All application callbacks invoked by the WCM will be running in the context of the WCM; the pointers passed as argument in the callback function will be freed once the function returns.
  * * For the APIs that expect \ref cy_wcm_interface_t as an argument, unless a specific interface type has been called out in the description of the API, any valid WCM interface type can be passed as an argument to the API.
  */
@@ -791,7 +1088,7 @@ cy_rslt_t cy_wcm_deinit(void);
  * Performs a Wi-Fi network scan.
  * The scan progressively accumulates results over time and may take between 1 and 10 seconds to complete.
  * The results of the scan will be individually provided to the callback function.
- * This API can be invoked while being connected to an AP.
+ * This API can be invoked while being connected to an AP. If a connection to an AP is being established, this API waits for the join to finish before starting the scan.
  *
  *  @param[in]  scan_callback  : Callback function which receives the scan results;
  *                               callback will be executed in the context of the WCM.
@@ -807,6 +1104,26 @@ cy_rslt_t cy_wcm_deinit(void);
  */
 cy_rslt_t cy_wcm_start_scan(cy_wcm_scan_result_callback_t scan_callback, void *user_data, cy_wcm_scan_filter_t *scan_filter);
 
+/**
+ * Performs a Wi-Fi network scan for any of several SSIDs, and filters the results by band and RSSI in the same pass.
+ * One scan replaces the scan per SSID that \ref cy_wcm_start_scan would need. Results and completion are reported as
+ * for \ref cy_wcm_start_scan, and the scan is stopped with \ref cy_wcm_stop_scan.
+ * The request can also restrict the scan to a list of channels, make it passive, and set the dwell times and probe count.
+ *
+ * With a single SSID the probe requests are directed to it. With several SSIDs the scan is a broadcast scan, so an AP
+ * that hides its SSID is only found by a scan directed to that SSID.
+ *
+ * This API is not available as a virtual API.
+ *
+ *  @param[in]  scan_callback  : Callback function which receives the scan results; see \ref cy_wcm_scan_result_callback_t.
+ *  @param[in]  user_data      : User data to be returned as an argument in the callback function.
+ *  @param[in]  request        : SSIDs and filters of the scan; see \ref cy_wcm_scan_request_t.
+ *
+ * @return CY_RSLT_SUCCESS if the scan was started; returns \ref cy_wcm_error otherwise.
+ * While a scan is in progress, this API returns CY_RSLT_WCM_SCAN_IN_PROGRESS.
+ */
+cy_rslt_t cy_wcm_start_scan_request(cy_wcm_scan_result_callback_t scan_callback, void *user_data, const cy_wcm_scan_request_t *request);
+
 /**
  * Stops an ongoing Wi-Fi network scan.
  *
@@ -815,6 +1132,117 @@ cy_rslt_t cy_wcm_start_scan(cy_wcm_scan_result_callback_t scan_callback, void *u
  */
 cy_rslt_t cy_wcm_stop_scan(void);
 
+/**
+ * Performs a Wi-Fi network scan like \ref cy_wcm_start_scan, but delivers each result as a borrowed view of the WHD buffer
+ * instead of a copy. No memory is allocated per scanned BSS.
+ * Use this when scanning busy environments or when heap fragmentation matters, and the callback only inspects or filters the results.
+ *
+ * This API is not available as a virtual API.
+ *
+ *  @param[in]  scan_callback  : Callback function which receives the scan results; see \ref cy_wcm_scan_view_callback_t for its context and restrictions.
+ *  @param[in]  user_data      : User data to be returned as an argument in the callback function.
+ *  @param[in]  scan_filter    : Scan filter parameter passed for scanning (optional).
+ *
+ * @return CY_RSLT_SUCCESS if the scan was started; returns \ref cy_wcm_error otherwise.
+ * The scan is stopped with \ref cy_wcm_stop_scan. While a scan is in progress, this API returns CY_RSLT_WCM_SCAN_IN_PROGRESS.
+ */
+cy_rslt_t cy_wcm_start_scan_view(cy_wcm_scan_view_callback_t scan_callback, void *user_data, cy_wcm_scan_filter_t *scan_filter);
+
+/**
+ * Returns the SSID of a scan result view.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ * @param[out]  length  : Length of the SSID; 0 for a hidden AP.
+ *
+ * @return Pointer to the SSID octets, which are not NUL-terminated.
+ */
+const uint8_t *cy_wcm_scan_view_get_ssid(const cy_wcm_scan_result_view_t *view, uint8_t *length);
+
+/**
+ * Returns the BSSID of a scan result view.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ *
+ * @return Pointer to the CY_WCM_MAC_ADDR_LEN octets of the BSSID.
+ */
+const uint8_t *cy_wcm_scan_view_get_bssid(const cy_wcm_scan_result_view_t *view);
+
+/**
+ * Returns the RSSI of a scan result view in dBm.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ *
+ * @return RSSI in dBm.
+ */
+int16_t cy_wcm_scan_view_get_signal_strength(const cy_wcm_scan_result_view_t *view);
+
+/**
+ * Returns the channel on which the scan result was received.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ *
+ * @return Channel number.
+ */
+uint8_t cy_wcm_scan_view_get_channel(const cy_wcm_scan_result_view_t *view);
+
+/**
+ * Returns the radio band of a scan result view.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ *
+ * @return Radio band; see \ref cy_wcm_wifi_band_t.
+ */
+cy_wcm_wifi_band_t cy_wcm_scan_view_get_band(const cy_wcm_scan_result_view_t *view);
+
+/**
+ * Returns the security type of a scan result view.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ *
+ * @return Security type; see \ref cy_wcm_security_t.
+ */
+cy_wcm_security_t cy_wcm_scan_view_get_security(const cy_wcm_scan_result_view_t *view);
+
+/**
+ * Returns the network type of a scan result view.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ *
+ * @return Network type; see \ref cy_wcm_bss_type_t.
+ */
+cy_wcm_bss_type_t cy_wcm_scan_view_get_bss_type(const cy_wcm_scan_result_view_t *view);
+
+/**
+ * Returns the country code and flags of a scan result view; see \ref cy_wcm_scan_result_t for their meaning.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ * @param[out]  ccode   : Receives the two-letter ISO country code in network byte order (optional, may be NULL).
+ *
+ * @return Scan result flags.
+ */
+uint8_t cy_wcm_scan_view_get_flags(const cy_wcm_scan_result_view_t *view, uint8_t ccode[2]);
+
+/**
+ * Returns the Beacon/Probe Response IEs of a scan result view.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ * @param[out]  ie_len  : Length of the IE block.
+ *
+ * @return Pointer to the IE block in the WHD buffer.
+ */
+const uint8_t *cy_wcm_scan_view_get_ies(const cy_wcm_scan_result_view_t *view, uint32_t *ie_len);
+
+/**
+ * Finds the first IE with the given ID in a scan result view.
+ *
+ * @param[in]   view    : Scan result view passed to \ref cy_wcm_scan_view_callback_t.
+ * @param[in]   ie_id   : Element ID to find.
+ * @param[out]  length  : Length of the IE body.
+ *
+ * @return Pointer to the IE body (after the ID and length octets), or NULL if the IE is not present.
+ */
+const uint8_t *cy_wcm_scan_view_find_ie(const cy_wcm_scan_result_view_t *view, uint8_t ie_id, uint8_t *length);
+
 /**
  * Connects the STA interface to a AP using the Wi-Fi credentials and configuration parameters provided.
  * On a successful connection to the Wi-Fi network, the API returns the IP address.
@@ -826,6 +1254,11 @@ cy_rslt_t cy_wcm_stop_scan(void);
  * 1) Checks for and ignores duplicate connect requests to an already connected AP.
  * 2) Checks the current connection state; if already connected, disconnects from the current
  *    Wi-Fi network and connects to the new Wi-Fi network.
+ *    If only the credentials or the BSSID differ from the current connection to the same SSID, it reassociates
+ *    instead: the network interface stays up and the DHCP lease is renewed, which keeps the IP address when the
+ *    new AP is on the same subnet. A failed reassociation leaves the STA disconnected.
+ *    The renewal completes after this API returns, so ip_addr holds the address from before the reassociation;
+ *    if the DHCP server assigns a different one, WCM notifies CY_WCM_EVENT_IP_CHANGED.
  * 3) If the user does not know the security type of the AP, the library internally finds the security type.
  *
  * @param[in]   connect_params      : Configuration to join the AP.
@@ -855,6 +1288,9 @@ cy_rslt_t cy_wcm_disconnect_ap(void);
  *                                If the given interface is CY_WCM_INTERFACE_TYPE_STA or CY_WCM_INTERFACE_TYPE_AP upon return, index-0 stores the IPv4 address of the interface.
  *                                If the given interface type is CY_WCM_INTERFACE_TYPE_AP_STA, index-0 stores the IPv4 address of the STA interface and index-1 stores the IPv4 address of the AP interface. ip_addr should have enough valid memory to hold two IP address structures.
  *
+ * This API can be invoked as a virtual API from the secondary core application for CY_WCM_INTERFACE_TYPE_STA only.
+ * The virtual API reads the state published by the primary core; see the multi-core notes at the top of this file.
+ *
  * @return CY_RSLT_SUCCESS if IP-address get is successful; returns \ref cy_wcm_error otherwise.
 
  */
@@ -885,6 +1321,9 @@ cy_rslt_t cy_wcm_get_ipv6_addr(cy_wcm_interface_t interface_type, cy_wcm_ipv6_ty
  *                                In future, IPv6 addresses will be supported.
  *
  *
+ * This API can be invoked as a virtual API from the secondary core application for CY_WCM_INTERFACE_TYPE_STA only.
+ * The virtual API reads the state published by the primary core; see the multi-core notes at the top of this file.
+ *
  * @return CY_RSLT_SUCCESS if retrieval of the gateway IP address was successful; returns \ref cy_wcm_error otherwise.
  */
 cy_rslt_t cy_wcm_get_gateway_ip_address(cy_wcm_interface_t interface_type, cy_wcm_ip_address_t *gateway_addr);
@@ -912,6 +1351,9 @@ cy_rslt_t cy_wcm_get_ip_netmask(cy_wcm_interface_t interface_type, cy_wcm_ip_add
  *                                If the given interface type is CY_WCM_INTERFACE_TYPE_AP_STA, index-0 stores the MAC address of the STA interface and index-1 stores the MAC address of the AP interface. mac_addr should have enough valid memory to hold two MAC address structures.
  *
  *
+ * This API can be invoked as a virtual API from the secondary core application for CY_WCM_INTERFACE_TYPE_STA only.
+ * The virtual API reads the state published by the primary core; see the multi-core notes at the top of this file.
+ *
  * @return CY_RSLT_SUCCESS if the MAC address get is successful; returns \ref cy_wcm_error otherwise.
  */
 cy_rslt_t cy_wcm_get_mac_addr(cy_wcm_interface_t interface_type, cy_wcm_mac_t *mac_addr);
@@ -931,6 +1373,44 @@ cy_rslt_t cy_wcm_get_mac_addr(cy_wcm_interface_t interface_type, cy_wcm_mac_t *m
  */
 cy_rslt_t cy_wcm_wps_enrollee(cy_wcm_wps_config_t* config, const cy_wcm_wps_device_detail_t *details, cy_wcm_wps_credential_t *credentials, uint16_t *credential_count);
 
+/**
+ * Runs a WPS enrollment as \ref cy_wcm_wps_enrollee does and then connects to the network described by the first credential.
+ *
+ * When the credential is for the network of the registrar AP, the join is directed at the BSSID and channel the enrollment
+ * was run against, so no scan is needed to find the AP again. Otherwise this behaves like \ref cy_wcm_connect_ap.
+ *
+ * @param[in]  config       : Pointer to the WPS configuration information.
+ * @param[in]  details      : Pointer to a structure containing manufacturing details of this device.
+ * @param[out] credential   : Pointer to a credentials structure to receive the AP credentials so that the application can store them.
+ * @param[out] ip_addr      : Pointer to return the IP address (optional).
+ *
+ * @return CY_RSLT_SUCCESS if the credentials were retrieved and the connection succeeded; returns \ref cy_wcm_error otherwise.
+ *         If the connection fails, the retrieved credentials are still returned in credential.
+ */
+cy_rslt_t cy_wcm_wps_enroll_and_connect(cy_wcm_wps_config_t* config, const cy_wcm_wps_device_detail_t *details, cy_wcm_wps_credential_t *credential, cy_wcm_ip_address_t *ip_addr);
+
+/**
+ * Starts a WPS enrollment and returns without waiting for it to finish.
+ *
+ * The WPS handshake runs as a state machine on a WPS thread that is created when the enrollment starts and deleted once it has finished,
+ * unless a registrar started with \ref cy_wcm_wps_registrar_start is still using it. The stack size of the thread is set with WCM_WPS_THREAD_STACK_SIZE (4 KB by default).
+ * The blocking WPS steps (scan, Diffie-Hellman key calculation, join) do not delay the link and IP event handling on the WCM worker thread.
+ * The callback is invoked on the WCM worker thread.
+ * Only one enrollment, synchronous or asynchronous, can be in progress at a time.
+ *
+ * @param[in]  config               : Pointer to the WPS configuration information. The password must remain valid until the callback is invoked.
+ * @param[in]  details              : Pointer to a structure containing manufacturing details of this device. Must remain valid until the callback is invoked.
+ * @param[out] credentials          : Pointer to an array of credentials structure \ref cy_wcm_wps_credential_t to receive the AP credentials.
+ *                                    Must remain valid until the callback is invoked.
+ * @param[in]  credential_count     : Number of entries in the credentials array.
+ * @param[in]  callback             : Callback function to be invoked when the enrollment has finished.
+ * @param[in]  user_data            : User data to be passed to the callback.
+ *
+ * @return CY_RSLT_SUCCESS if the enrollment was started; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_wps_enrollee_async(cy_wcm_wps_config_t* config, const cy_wcm_wps_device_detail_t *details, cy_wcm_wps_credential_t *credentials, uint16_t credential_count,
+                                    cy_wcm_wps_completion_callback_t callback, void *user_data);
+
 /**
  * Generates a random WPS PIN for PIN mode connection.
  *
@@ -940,6 +1420,54 @@ cy_rslt_t cy_wcm_wps_enrollee(cy_wcm_wps_config_t* config, const cy_wcm_wps_devi
  */
 cy_rslt_t cy_wcm_wps_generate_pin(char wps_pin_string[CY_WCM_WPS_PIN_LENGTH]);
 
+/**
+ * Retrieves the timeline of the last WPS enrollment started with \ref cy_wcm_wps_enrollee.
+ * The timeline records when each phase of the enrollment (scan, join, EAPOL-Start, M1 to M8, fragment ACKs, restarts) was reached,
+ * which helps to find out where the time is spent when enrollment with a particular registrar is slow or fails.
+ *
+ * Note: Available only when the library is built with WCM_ENABLE_WPS_TIMELINE; returns CY_RSLT_WCM_UNSUPPORTED_API otherwise.
+ *       Recording the timeline adds CY_WPS_TIMELINE_SIZE (48 by default) records of 12 bytes to each WPS session.
+ *
+ * @param[out]  timeline  : Pointer to store the timeline. The count is zero if no enrollment has run yet.
+ *
+ * @return CY_RSLT_SUCCESS if the timeline was retrieved; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_wps_get_timeline(cy_wcm_wps_timeline_t *timeline);
+
+/**
+ * Starts a WPS registrar on the SoftAP that hands out the AP credentials to several enrollees at the same time.
+ *
+ * Each enrollee that sends an EAPOL-Start gets its own WPS session. The sessions run on the WPS thread that is also used by
+ * \ref cy_wcm_wps_enrollee_async, so no thread is created per enrollee and the WCM worker thread is not held up by the sessions.
+ * The WPS thread is kept while the registrar runs and is deleted by \ref cy_wcm_wps_registrar_stop once no enrollment uses it.
+ * At most max_enrollees sessions run at the same time; further enrollees are served as sessions finish.
+ * Each session generates its own Diffie-Hellman key pair.
+ * PBC overlap detection is not done, as several enrollees pressing the button at the same time is the intended use.
+ * The registrar keeps running until \ref cy_wcm_wps_registrar_stop is called.
+ *
+ * Note: Available only when the library is built with WCM_ENABLE_WPS_REGISTRAR; returns CY_RSLT_WCM_UNSUPPORTED_API otherwise.
+ *
+ * @param[in]  config         : Pointer to the WPS configuration information.
+ * @param[in]  details        : Pointer to a structure containing manufacturing details of this device. Must remain valid until the registrar is stopped.
+ * @param[in]  ap_credentials : Credentials of the SoftAP to be handed out to the enrollees.
+ * @param[in]  max_enrollees  : Maximum number of enrollees served at the same time. From 1 to CY_WPS_REGISTRAR_MAX_SESSIONS (8 by default).
+ * @param[in]  callback       : Callback function to be invoked each time a session has finished. Can be NULL.
+ * @param[in]  user_data      : User data to be passed to the callback.
+ *
+ * @return CY_RSLT_SUCCESS if the registrar was started; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_wps_registrar_start(const cy_wcm_wps_config_t *config, const cy_wcm_wps_device_detail_t *details, const cy_wcm_wps_credential_t *ap_credentials,
+                                     uint8_t max_enrollees, cy_wcm_wps_registrar_callback_t callback, void *user_data);
+
+/**
+ * Stops the WPS registrar started with \ref cy_wcm_wps_registrar_start. Sessions in progress are aborted and reported through the callback.
+ * Waits up to WCM_WPS_REGISTRAR_STOP_WAIT_MS (5 seconds by default) for the aborted sessions to end before the WPS thread is deleted; if they have
+ * not ended by then, the thread is deleted by a later call. Must not be called from the registrar callback.
+ *
+ * @return CY_RSLT_SUCCESS if the registrar was stopped or was not running; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_wps_registrar_stop(void);
+
 /**
  * Registers an event callback to monitor the connection and IP address change events.
  * This is an optional registration; use it if the application needs to monitor events across disconnection and reconnection of the STA interface and notifies the clients which are connected or disconnected from the SoftAP.
@@ -966,6 +1494,33 @@ cy_rslt_t cy_wcm_register_event_callback(cy_wcm_event_callback_t event_callback)
 */
 cy_rslt_t cy_wcm_deregister_event_callback(cy_wcm_event_callback_t event_callback);
 
+/**
+ * Registers an event callback that is invoked only for the events selected by event_mask.
+ * There is no limit on the number of callbacks other than the available heap. The same callback can be registered more than once with different user data.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[in]  event_callback  : Callback function to be invoked for event notification.
+ *                               The callback will be executed in the context of the WCM.
+ * @param[in]  event_mask      : Events to be notified about; a combination of \ref CY_WCM_EVENT_MASK values or \ref CY_WCM_EVENT_MASK_ALL.
+ * @param[in]  user_data       : User data to be passed to the callback.
+ *
+ * @return CY_RSLT_SUCCESS if application callback registration was successful; returns \ref cy_wcm_error otherwise.
+*/
+cy_rslt_t cy_wcm_register_event_callback_ex(cy_wcm_event_callback_ex_t event_callback, uint32_t event_mask, void *user_data);
+
+/**
+ * De-registers an event callback registered with \ref cy_wcm_register_event_callback_ex.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[in]  event_callback  : Callback function to de-register from getting notifications.
+ * @param[in]  user_data       : User data the callback was registered with.
+ *
+ * @return CY_RSLT_SUCCESS if application callback de-registration was successful; returns \ref cy_wcm_error otherwise.
+*/
+cy_rslt_t cy_wcm_deregister_event_callback_ex(cy_wcm_event_callback_ex_t event_callback, void *user_data);
+
 /**
  * Checks if the STA interface is connected to an AP.
  *
@@ -978,6 +1533,9 @@ uint8_t cy_wcm_is_connected_to_ap(void);
 /**
  * Retrieves the information such as SSID, BSSID, and other details of the AP to which the STA interface is connected.
  *
+ * This API is supported in multi-core environment and can be invoked as a virtual API from the secondary core application.
+ * The virtual API reads the state published by the primary core at the last connection event, so signal_strength is not refreshed.
+ *
  * @param[out] ap_info : Pointer to store the information of the associated AP \ref cy_wcm_associated_ap_info_t.
  *
  * @return CY_RSLT_SUCCESS if retrieving the information of the associated AP was successful; returns \ref cy_wcm_error otherwise.
@@ -988,15 +1546,81 @@ cy_rslt_t cy_wcm_get_associated_ap_info(cy_wcm_associated_ap_info_t *ap_info);
  * Gets the WLAN statistics of the given interface from the time WLAN driver is up and running.
  *
  * The application would typically use this API to get information such as "total transmitted packets" and "total received packets";
- * for more details, see members of \ref cy_wcm_wlan_statistics_t.
+ * for more details, see members of \ref cy_wcm_wlan_statistics_t. The counters are the lower 32 bits of the totals returned by
+ * \ref cy_wcm_get_wlan_counters.
  *
- * @param[in] interface : Type of the WCM interface.
+ * @param[in] interface : Type of the WCM interface. CY_WCM_INTERFACE_TYPE_STA while connected, or CY_WCM_INTERFACE_TYPE_AP while SoftAP is up.
  * @param[in] stat      : Pointer to store the statistics \ref cy_wcm_wlan_statistics_t.
  *
  * @return CY_RSLT_SUCCESS if retrieval of statistics was successful; returns \ref cy_wcm_error otherwise.
  */
 cy_rslt_t cy_wcm_get_wlan_statistics(cy_wcm_interface_t interface, cy_wcm_wlan_statistics_t *stat);
 
+/**
+ * Gets the WLAN counters of the given interface as 64-bit totals from the time WLAN driver is up and running.
+ *
+ * The firmware keeps 32-bit counters. WCM adds the change since the previous call to 64-bit totals, so the totals stay
+ * correct as long as this API or \ref cy_wcm_get_wlan_statistics is called at least once before a firmware counter wraps;
+ * at 100 Mbps the byte counters wrap about every 5 minutes. On devices where the firmware keeps one set of counters per radio,
+ * the STA and SoftAP interfaces report the same traffic.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[in]  interface : Type of the WCM interface. CY_WCM_INTERFACE_TYPE_STA while connected, or CY_WCM_INTERFACE_TYPE_AP while SoftAP is up.
+ * @param[out] counters  : Pointer to store the counters \ref cy_wcm_wlan_counters_t.
+ *
+ * @return CY_RSLT_SUCCESS if retrieval of the counters was successful; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_get_wlan_counters(cy_wcm_interface_t interface, cy_wcm_wlan_counters_t *counters);
+
+/**
+ * Gets the queue statistics of one lane of the WCM worker thread.
+ *
+ * The statistics are counted from \ref cy_wcm_init or from the last reset, whichever is later.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[in]  lane  : Lane of the worker thread \ref cy_wcm_worker_lane_t.
+ * @param[out] stats : Pointer to store the statistics \ref cy_wcm_worker_lane_stats_t.
+ * @param[in]  reset : If true, the counters, high water mark, and maximum latency of the lane are cleared after they are read.
+ *
+ * @return CY_RSLT_SUCCESS if retrieval of statistics was successful; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_get_worker_stats(cy_wcm_worker_lane_t lane, cy_wcm_worker_lane_stats_t *stats, bool reset);
+
+/**
+ * Starts the STA roaming engine, or updates its configuration if it is already running.
+ *
+ * While the STA is connected, WCM samples the RSSI of the AP every config->sample_interval_ms and keeps a smoothed value.
+ * When the smoothed RSSI drops to config->trigger_rssi or below, WCM scans for other APs with the same SSID. After the first
+ * scan, only the channels on which the network was seen are scanned, except for every fourth scan, which covers all channels.
+ * If the strongest AP found is at least config->rssi_delta dB stronger than the current AP, WCM joins it directly.
+ * If that join fails, WCM reports the link as down and falls back to its usual reconnection logic.
+ * A scan started by the application, or by \ref cy_wcm_connect_ap, aborts a roam scan in progress. While WCM joins
+ * the new AP, \ref cy_wcm_connect_ap and the scan APIs return CY_RSLT_WCM_CONNECT_IN_PROGRESS.
+ * The join runs on a roam thread that is created by the first call and kept until \ref cy_wcm_deinit. The stack size of the
+ * thread is set with WCM_ROAM_THREAD_STACK_SIZE (4 KB by default).
+ *
+ * Roaming is not attempted when the application connected to a specific BSSID, for enterprise security,
+ * or when the firmware requires the host to run the WPA3 SAE handshake.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[in] config : Roaming configuration \ref cy_wcm_roam_config_t.
+ *
+ * @return CY_RSLT_SUCCESS if the roaming engine was started; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_start_roaming(const cy_wcm_roam_config_t *config);
+
+/**
+ * Stops the STA roaming engine started with \ref cy_wcm_start_roaming. A roam that is already in progress is completed.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @return CY_RSLT_SUCCESS if the roaming engine was stopped; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_stop_roaming(void);
+
 /**
  * Retrieves the MAC address of the gateway for STA interface. Uses Address Resolution Protocol (ARP) to retrieve the gateway MAC address.
  *
@@ -1021,6 +1645,40 @@ cy_rslt_t cy_wcm_get_gateway_mac_address(cy_wcm_mac_t *mac_addr);
  */
 cy_rslt_t cy_wcm_ping(cy_wcm_interface_t interface, cy_wcm_ip_address_t *ip_addr, uint32_t timeout_ms, uint32_t* elapsed_ms);
 
+/**
+ * Starts a ping session to one or more targets. This function is non-blocking; the results are reported via the callback.
+ *
+ * Every config->interval_ms, WCM sends one echo request to each target in turn and then calls the callback with the
+ * loss, minimum, average, and maximum round-trip time, and round-trip time histogram of each target so far.
+ * The session ends after config->count rounds, when \ref cy_wcm_ping_stop is called, or when the network of the interface goes down.
+ * The targets of a round are pinged sequentially, not in parallel: each echo request is sent only after the reply to the
+ * previous one arrived or config->timeout_ms passed. A round can therefore take up to config->target_count * config->timeout_ms,
+ * so set config->interval_ms to at least that value for rounds to start on time. A round that takes longer than
+ * config->interval_ms delays the next round; rounds are never run in parallel either.
+ *
+ * The echo requests are sent from a separate WCM ping thread without holding any WCM lock, so an unreachable target
+ * does not delay other WCM APIs. Only one session can run at a time.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[in] config    : Ping session configuration \ref cy_wcm_ping_config_t.
+ * @param[in] callback  : Callback function to receive the results \ref cy_wcm_ping_callback_t.
+ * @param[in] user_data : User data to be passed to the callback.
+ *
+ * @return CY_RSLT_SUCCESS if the session was started; CY_RSLT_WCM_PING_IN_PROGRESS if a session is already running; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_ping_start(const cy_wcm_ping_config_t *config, cy_wcm_ping_callback_t callback, void *user_data);
+
+/**
+ * Stops the ping session started with \ref cy_wcm_ping_start. The callback is not invoked again,
+ * but an echo request that is already in flight runs until its reply arrives or it times out.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @return CY_RSLT_SUCCESS if the session was stopped or no session was running; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_ping_stop(void);
+
 
 /**
  * Starts an infrastructure Wi-Fi network (SoftAP).
@@ -1047,12 +1705,40 @@ cy_rslt_t cy_wcm_stop_ap(void);
  * @param[in]  num_clients : Length of the array passed in sta_list.
  *
  * \note If the number of connected clients is less than the num_clients, then elements of sta_list beyond number of connected clients will be set to zero.
- *       The maximum number of supported client list varies for different Wi-Fi chips.
+ *       The list is served from the client table of WCM, see \ref cy_wcm_get_associated_client_info.
  *
  * @return CY_RSLT_SUCCESS If getting the client list is successful; returns \ref cy_wcm_error otherwise.
  */
 cy_rslt_t cy_wcm_get_associated_client_list(cy_wcm_mac_t *sta_list, uint8_t num_clients);
 
+/**
+ * Gets the details of the clients associated with the SoftAP.
+ *
+ * WCM keeps a table of the clients, which is updated from the join and leave events of the SoftAP.
+ * This API and \ref cy_wcm_get_associated_client_list are served from that table and do not access the Wi-Fi chip.
+ * The table is reconciled with the association list of the firmware periodically, which also refreshes the RSSI of
+ * each client, and when \ref cy_wcm_refresh_associated_clients is called.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[out] client_info : Array to store the details of the clients \ref cy_wcm_ap_client_info_t.
+ * @param[in]  max_clients : Length of the array passed in client_info.
+ * @param[out] num_clients : Number of entries stored in client_info.
+ *
+ * @return CY_RSLT_SUCCESS if getting the client details is successful; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_get_associated_client_info(cy_wcm_ap_client_info_t *client_info, uint8_t max_clients, uint8_t *num_clients);
+
+/**
+ * Reconciles the SoftAP client table with the association list of the firmware and reads the RSSI of every client.
+ * Clients whose join or leave event was lost are added or removed.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @return CY_RSLT_SUCCESS if the client table was refreshed; returns \ref cy_wcm_error otherwise.
+ */
+cy_rslt_t cy_wcm_refresh_associated_clients(void);
+
 /**
  * Stores the AP settings provided by the user.
  * NOTE: Dotted-decimal format example: 192.168.0.1
@@ -1080,17 +1766,23 @@ cy_rslt_t cy_wcm_set_ap_ip_setting(cy_wcm_ip_setting_t *ap_ip, const char *ip_ad
 cy_rslt_t cy_wcm_allow_low_power_mode(cy_wcm_powersave_mode_t mode);
 
 /**
- * Enable the iTWT session.
+ * Enable an iTWT session.
+ *
+ * Several sessions with different flow IDs can be active at the same time. If itwt_params->flow_id is 0xFF, WCM uses the
+ * lowest flow ID that has no session. When the STA reconnects or roams, WCM sets up its sessions again with the new AP.
+ * Sessions torn down by the AP are not set up again.
+ *
  * @param[in] itwt_params : Pointer to the iTWT setup parameters. Refer to \ref cy_wcm_itwt_setup_params_t for details.
  * 
- * @return CY_RSLT_SUCCESS if the iTWT session is successfully setup; returns \ref cy_wcm_error otherwise.
+ * @return CY_RSLT_SUCCESS if the iTWT session is successfully setup; CY_RSLT_WCM_ITWT_ENABLED if the flow ID already has a session
+ *         or all flow IDs are in use; returns \ref cy_wcm_error otherwise.
  * 
  * Note: iTWT feature is supported only on CYW955913EVK-01 Wi-Fi Bluetooth&reg; Prototyping Kit (CYW955913EVK-01).
  */
 cy_rslt_t cy_wcm_sta_itwt_setup(cy_wcm_itwt_setup_params_t *itwt_params);
 
 /**
- * Teardown/Disable the iTWT session.
+ * Teardown/Disable the iTWT session. Sessions torn down by the application are not set up again when the STA reconnects.
  * @param[in] flow_id : Flow ID of the iTWT session to be torn down. Valid values are between 0 and 7. To teardown all sessions, 0xFF can be passed.
  * @param[in] all_twt : If true, all the iTWT sessions will be torn down. If false, only the session with the given flow_id will be torn down.
  * 
@@ -1110,6 +1802,21 @@ cy_rslt_t cy_wcm_sta_itwt_teardown(uint8_t flow_id, bool all_twt);
  */
 cy_rslt_t cy_wcm_sta_itwt_get_session_info(cy_wcm_itwt_negotiated_params_t *negotiated_params);
 
+/**
+ * Get the wake schedule statistics of one iTWT flow, for example to check the negotiated duty cycle against the current budget of the application.
+ * The statistics of a flow are kept until the STA connects again with \ref cy_wcm_connect_ap or disconnects with \ref cy_wcm_disconnect_ap.
+ *
+ * This API is not available as a virtual API.
+ *
+ * @param[in]  flow_id : Flow ID of the iTWT session, between 0 and 7.
+ * @param[out] stats   : Pointer to store the statistics. Refer to \ref cy_wcm_itwt_flow_stats_t for details.
+ *
+ * @return CY_RSLT_SUCCESS if the statistics are successfully retrieved; returns \ref cy_wcm_error otherwise.
+ *
+ * Note: iTWT feature is supported only on CYW955913EVK-01 Wi-Fi Bluetooth&reg; Prototyping Kit (CYW955913EVK-01).
+ */
+cy_rslt_t cy_wcm_sta_itwt_get_flow_stats(uint8_t flow_id, cy_wcm_itwt_flow_stats_t *stats);
+
 /** \} group_wcm_functions */
 
 #ifdef __cplusplus
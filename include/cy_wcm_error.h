@@ -145,6 +145,12 @@ extern "C" {
 /** Powersave Mode error code **/
 #define CY_RSLT_WCM_POWERSAVE_MODE_NOT_SUPPORTED           (CY_RSLT_WCM_ERR_BASE + 55) /**< Powersave mode not supported on this device.  */
 
+/** WPS busy error code */
+#define CY_RSLT_WCM_WPS_IN_PROGRESS                        (CY_RSLT_WCM_ERR_BASE + 56) /**< A WPS enrollment is already in progress.      */
+
+/** Ping busy error code */
+#define CY_RSLT_WCM_PING_IN_PROGRESS                       (CY_RSLT_WCM_ERR_BASE + 57) /**< A ping session is already in progress.        */
+
 /** Reason codes for disconnection based on WHD enums */
 typedef enum
 {
@@ -47,6 +47,16 @@ extern "C" {
 #include "cy_vcm_internal.h"
 #endif
 
+#ifdef ENABLE_MULTICORE_CONN_MW
+/**
+ * \addtogroup group_wcm_macros
+ * \{
+ */
+#define CY_WCM_SHARED_STATE_MAGIC          (0x5743534DUL) /**< Marks a published \ref cy_wcm_shared_state_t block. */
+#define CY_WCM_SHARED_STATE_VERSION        (1UL)          /**< Layout version of \ref cy_wcm_shared_state_t. */
+/** \} group_wcm_macros */
+#endif
+
 /**
  * \addtogroup group_wcm_structures
  * \{
@@ -87,8 +97,53 @@ typedef struct
     cy_wcm_event_data_t        *event_data;         /**< A pointer to the event data. The event data will be freed once the callback returns from the application */
 } cy_wcm_event_callback_params_t;
 
+#ifdef ENABLE_MULTICORE_CONN_MW
+/**
+ * STA state published by the primary core in shared memory, so that the virtual getters on the secondary core
+ * can answer without an IPC round trip.
+ *
+ * The primary core is the only writer. It makes sequence odd before it updates the block and even again afterwards;
+ * a reader copies the block and retries if sequence was odd or changed while it was copying.
+ * The block must be placed in memory that both cores see coherently (non-cacheable shared memory).
+ */
+typedef struct
+{
+    uint32_t                       magic;            /**< \ref CY_WCM_SHARED_STATE_MAGIC while the primary core is initialized; 0 otherwise. */
+    uint32_t                       version;          /**< \ref CY_WCM_SHARED_STATE_VERSION of the primary core. */
+    volatile uint32_t              sequence;         /**< Odd while the primary core is updating the block. */
+    uint8_t                        is_connected;     /**< 1 if the STA interface is connected to an AP, 0 otherwise. */
+    cy_wcm_mac_t                   sta_mac;          /**< MAC address of the STA interface. */
+    cy_wcm_ip_address_t            ip_addr;          /**< IPv4 address of the STA interface; zero when not connected. */
+    cy_wcm_ip_address_t            gateway_addr;     /**< IPv4 gateway address of the STA interface; zero when not connected. */
+    cy_wcm_associated_ap_info_t    ap_info;          /**< Associated AP as of the last connection event; zero when not connected. */
+} cy_wcm_shared_state_t;
+#endif
+
 /** \} group_wcm_structures */
 
+#ifdef ENABLE_MULTICORE_CONN_MW
+#if defined(USE_VIRTUAL_API)
+/**
+ * Hands the state block of the primary core to the virtual WCM APIs on the secondary core.
+ * The application calls this with the address returned by \ref cy_wcm_get_shared_state on the primary core, which it passes
+ * over its own IPC channel, as VCM has no request for it. Not needed when WCM_SHARED_STATE_ADDRESS is defined, in which case
+ * the virtual cy_wcm_init() hands the block over.
+ * Until then, or when NULL is passed, the virtual getters fall back to IPC or report \ref CY_RSLT_WCM_UNSUPPORTED_API.
+ *
+ * @param[in]  state : Address of the primary core's state block, or NULL.
+ */
+void cy_wcm_set_shared_state(const cy_wcm_shared_state_t *state);
+#else
+/**
+ * Returns the address of the state block that the primary core publishes in shared memory.
+ * The application passes this address to the secondary core; see cy_wcm_set_shared_state().
+ *
+ * @return Address of the state block.
+ */
+const cy_wcm_shared_state_t *cy_wcm_get_shared_state(void);
+#endif
+#endif
+
 #ifdef __cplusplus
 } /* extern C */
 #endif
@@ -39,6 +39,70 @@
 #define cy_wcm_log_msg(a,b,c,...)
 #endif
 
+/*
+ * Binary trace of WCM internals. Unlike cy_wcm_log_msg, recording a trace event formats nothing and takes no lock,
+ * so it can stay enabled on timing-sensitive paths. Add ENABLE_WCM_TRACE to DEFINES to enable it.
+ *
+ * Records go to the cy_wcm_trace_buffer ring in RAM, which overwrites the oldest record when full.
+ * Dump the buffer (for example with GDB: dump binary value wcm_trace.bin cy_wcm_trace_buffer) and decode it
+ * on the host with tools/wcm_trace_decode.py, which reads the event names below from this file.
+ */
+#ifdef ENABLE_WCM_TRACE
+
+#include <stdint.h>
+
+/* Number of records in the ring; must be a power of two */
+#ifndef CY_WCM_TRACE_BUFFER_SIZE
+#define CY_WCM_TRACE_BUFFER_SIZE           (256)
+#endif
+
+#define CY_WCM_TRACE_MAGIC                 (0x54434D57UL)  /* "WMCT" */
+#define CY_WCM_TRACE_VERSION               (1U)
+
+/* Trace event IDs; the arguments of each event are listed in its comment */
+typedef enum
+{
+    CY_WCM_TRACE_CONNECT_START = 1,        /**< security, band, channel */
+    CY_WCM_TRACE_CONNECT_JOIN,             /**< join result */
+    CY_WCM_TRACE_CONNECT_DONE,             /**< result */
+    CY_WCM_TRACE_SCAN_START,               /**< result, is security type scan */
+    CY_WCM_TRACE_SCAN_RESULT,              /**< channel, signal strength, security */
+    CY_WCM_TRACE_SCAN_COMPLETE,            /**< scan status */
+    CY_WCM_TRACE_LINK_EVENT,               /**< event type, status, reason */
+    CY_WCM_TRACE_LINK_UP,                  /**< was link up */
+    CY_WCM_TRACE_LINK_DOWN,                /**< reason, was link up */
+    CY_WCM_TRACE_HANDSHAKE_TIMEOUT,        /**< none */
+    CY_WCM_TRACE_RETRY_JOIN,               /**< join result, security */
+    CY_WCM_TRACE_RETRY_SCHEDULED,          /**< back-off in milliseconds, timer result */
+} cy_wcm_trace_event_t;
+
+typedef struct
+{
+    volatile uint32_t sequence;            /* Write index + 1; 0 while the record is being written */
+    uint32_t          timestamp;           /* RTOS time in milliseconds */
+    uint32_t          event;               /* cy_wcm_trace_event_t */
+    uint32_t          arg[3];
+} cy_wcm_trace_record_t;
+
+typedef struct
+{
+    uint32_t              magic;           /* CY_WCM_TRACE_MAGIC */
+    uint16_t              version;         /* CY_WCM_TRACE_VERSION */
+    uint16_t              record_size;     /* sizeof(cy_wcm_trace_record_t) */
+    uint32_t              capacity;        /* CY_WCM_TRACE_BUFFER_SIZE */
+    volatile uint32_t     head;            /* Number of records written so far */
+    cy_wcm_trace_record_t records[CY_WCM_TRACE_BUFFER_SIZE];
+} cy_wcm_trace_buffer_t;
+
+extern cy_wcm_trace_buffer_t cy_wcm_trace_buffer;
+
+void cy_wcm_trace_record(uint32_t event, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+
+#define cy_wcm_trace(event, a0, a1, a2)    cy_wcm_trace_record((uint32_t)(event), (uint32_t)(a0), (uint32_t)(a1), (uint32_t)(a2))
+#else
+#define cy_wcm_trace(event, a0, a1, a2)
+#endif
+
 #define cy_wps_assert(error_string, assertion)         do { if (!(assertion) ){ printf( (error_string) ); } } while (0)
 
 #endif /* LIBS_WCM_INCLUDE_CY_WCM_LOG_H_ */
@@ -116,6 +116,47 @@ cy_rslt_t cy_aes_cbc_decrypt( const unsigned char *input, uint32_t input_length,
     return CY_RSLT_SUCCESS;
 }
 
+#ifndef CY_WPS_AES_CBC_ALT
+/*
+ * Expand the key once for both directions. With cy-mbedtls-acceleration the contexts are backed by the crypto block.
+ */
+cy_rslt_t cy_aes_cbc_context_init( cy_aes_cbc_context_t *ctx, const unsigned char *key, unsigned int keybits )
+{
+    mbedtls_aes_init( &ctx->enc );
+    mbedtls_aes_init( &ctx->dec );
+    if ( ( mbedtls_aes_setkey_enc( &ctx->enc, key, keybits ) != 0 ) ||
+         ( mbedtls_aes_setkey_dec( &ctx->dec, key, keybits ) != 0 ) )
+    {
+        cy_aes_cbc_context_free( ctx );
+        return -1;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_aes_cbc_context_free( cy_aes_cbc_context_t *ctx )
+{
+    mbedtls_aes_free( &ctx->enc );
+    mbedtls_aes_free( &ctx->dec );
+}
+
+cy_rslt_t cy_aes_cbc_encrypt_with_context( cy_aes_cbc_context_t *ctx, const unsigned char *input, uint32_t input_length, unsigned char *output, const unsigned char iv[16] )
+{
+    aes_cbc_crypt_pad_length_padding( &ctx->enc, MBEDTLS_AES_ENCRYPT, input_length, iv, input, output );
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_aes_cbc_decrypt_with_context( cy_aes_cbc_context_t *ctx, const unsigned char *input, uint32_t input_length, unsigned char *output, uint32_t* output_length, const unsigned char iv[16] )
+{
+    uint32_t result;
+
+    result = aes_cbc_crypt_pad_length_padding( &ctx->dec, MBEDTLS_AES_DECRYPT, input_length, iv, input, output );
+    *output_length = result;
+    return CY_RSLT_SUCCESS;
+}
+#endif /* CY_WPS_AES_CBC_ALT */
+
 void cy_sha2_hmac_starts(cy_sha2_hmac_context *ctx, const unsigned char *key, uint32_t keylen,
               int32_t is224)
 {
@@ -229,3 +270,113 @@ void cy_sha2_hmac(const unsigned char *key, uint32_t keylen,
 
     memset(&ctx, 0, sizeof(cy_sha2_hmac_context));
 }
+
+/*
+ * Precompute the HMAC inner and outer hash states for a key
+ */
+void cy_sha2_hmac_key_setup(cy_sha2_hmac_key_t *key_ctx, const unsigned char *key, uint32_t keylen,
+              int32_t is224)
+{
+    uint32_t i;
+    unsigned char sum[32];
+    unsigned char ipad[64];
+    unsigned char opad[64];
+
+    if (keylen > 64) {
+#if MBEDTLS_VERSION_MAJOR == MBEDTLS_MAJOR_VERSION_3
+    mbedtls_sha256(key, keylen, sum, is224);
+#elif MBEDTLS_VERSION_MAJOR == MBEDTLS_MAJOR_VERSION_2
+    mbedtls_sha256_ret(key, keylen, sum, is224);
+#else
+error "Unsupported MBEDTLS version"
+#endif
+
+        keylen = (is224) ? 28 : 32;
+        key = sum;
+    }
+
+    memset(ipad, 0x36, 64);
+    memset(opad, 0x5C, 64);
+
+    for (i = 0; i < keylen; i++) {
+        ipad[i] = (unsigned char)(ipad[i] ^ key[i]);
+        opad[i] = (unsigned char)(opad[i] ^ key[i]);
+    }
+
+    mbedtls_sha256_init(&key_ctx->inner);
+    mbedtls_sha256_init(&key_ctx->outer);
+#if MBEDTLS_VERSION_MAJOR == MBEDTLS_MAJOR_VERSION_3
+    mbedtls_sha256_starts(&key_ctx->inner, is224);
+    mbedtls_sha256_update(&key_ctx->inner, ipad, 64);
+    mbedtls_sha256_starts(&key_ctx->outer, is224);
+    mbedtls_sha256_update(&key_ctx->outer, opad, 64);
+#elif MBEDTLS_VERSION_MAJOR == MBEDTLS_MAJOR_VERSION_2
+    mbedtls_sha256_starts_ret(&key_ctx->inner, is224);
+    mbedtls_sha256_update_ret(&key_ctx->inner, ipad, 64);
+    mbedtls_sha256_starts_ret(&key_ctx->outer, is224);
+    mbedtls_sha256_update_ret(&key_ctx->outer, opad, 64);
+#else
+error "Unsupported MBEDTLS version"
+#endif
+
+    memset(sum, 0, sizeof(sum));
+    memset(ipad, 0, sizeof(ipad));
+    memset(opad, 0, sizeof(opad));
+}
+
+void cy_sha2_hmac_key_free(cy_sha2_hmac_key_t *key_ctx)
+{
+    mbedtls_sha256_free(&key_ctx->inner);
+    mbedtls_sha256_free(&key_ctx->outer);
+}
+
+/*
+ * SHA-256 HMAC context setup from a precomputed key
+ */
+void cy_sha2_hmac_starts_with_key(cy_sha2_hmac_context *ctx, const cy_sha2_hmac_key_t *key_ctx)
+{
+    mbedtls_sha256_init(&ctx->ctx);
+    mbedtls_sha256_clone(&ctx->ctx, &key_ctx->inner);
+}
+
+/*
+ * SHA-256 HMAC final digest using a precomputed key
+ */
+void cy_sha2_hmac_finish_with_key(cy_sha2_hmac_context *ctx, const cy_sha2_hmac_key_t *key_ctx, unsigned char output[32])
+{
+    unsigned char tmpbuf[32];
+
+#if MBEDTLS_VERSION_MAJOR == MBEDTLS_MAJOR_VERSION_3
+    mbedtls_sha256_finish(&ctx->ctx, tmpbuf);
+    mbedtls_sha256_clone(&ctx->ctx, &key_ctx->outer);
+    mbedtls_sha256_update(&ctx->ctx, tmpbuf, 32);
+    mbedtls_sha256_finish(&ctx->ctx, output);
+    mbedtls_sha256_free(&ctx->ctx);
+#elif MBEDTLS_VERSION_MAJOR == MBEDTLS_MAJOR_VERSION_2
+    mbedtls_sha256_finish_ret(&ctx->ctx, tmpbuf);
+    mbedtls_sha256_clone(&ctx->ctx, &key_ctx->outer);
+    mbedtls_sha256_update_ret(&ctx->ctx, tmpbuf, 32);
+    mbedtls_sha256_finish_ret(&ctx->ctx, output);
+    mbedtls_sha256_free(&ctx->ctx);
+#else
+    error "Unsupported MBEDTLS version"
+#endif
+
+    memset(tmpbuf, 0, sizeof(tmpbuf));
+}
+
+/*
+ * Output = HMAC-SHA-256( precomputed hmac key, input buffer )
+ */
+void cy_sha2_hmac_with_key(const cy_sha2_hmac_key_t *key_ctx,
+           const unsigned char *input, uint32_t ilen,
+           unsigned char output[32])
+{
+    cy_sha2_hmac_context ctx;
+
+    cy_sha2_hmac_starts_with_key(&ctx, key_ctx);
+    cy_sha2_hmac_update(&ctx, input, ilen);
+    cy_sha2_hmac_finish_with_key(&ctx, key_ctx, output);
+
+    memset(&ctx, 0, sizeof(cy_sha2_hmac_context));
+}
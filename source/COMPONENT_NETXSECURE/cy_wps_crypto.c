@@ -74,9 +74,91 @@ cy_rslt_t cy_aes_cbc_encrypt( const unsigned char *input,
                               unsigned int keybits, 
                               const unsigned char iv[16] )
 {
-    void *handler = NULL;
-    NX_CRYPTO_AES aes_ctx;
-    ULONG meta_data_size = sizeof(aes_ctx);
+    cy_aes_cbc_context_t ctx;
+    cy_rslt_t result;
+
+    if ( input_length == 0 )
+    {
+        return -1;
+    }
+
+    if ( cy_aes_cbc_context_init( &ctx, key, keybits ) != CY_RSLT_SUCCESS )
+    {
+        return -1;
+    }
+
+    result = cy_aes_cbc_encrypt_with_context( &ctx, input, input_length, output, iv );
+    cy_aes_cbc_context_free( &ctx );
+
+    return result;
+}
+
+cy_rslt_t cy_aes_cbc_decrypt( const unsigned char *input,
+                              uint32_t input_length,
+                              unsigned char *output,
+                              uint32_t* output_length,
+                              const unsigned char *key,
+                              unsigned int keybits,
+                              const unsigned char iv[16] )
+{
+    cy_aes_cbc_context_t ctx;
+    cy_rslt_t result;
+
+    if ( ( input_length == 0 ) || ( ( input_length & 0x0f ) != 0 ) )
+    {
+        return -1;
+    }
+
+    if ( cy_aes_cbc_context_init( &ctx, key, keybits ) != CY_RSLT_SUCCESS )
+    {
+        return -1;
+    }
+
+    result = cy_aes_cbc_decrypt_with_context( &ctx, input, input_length, output, output_length, iv );
+    cy_aes_cbc_context_free( &ctx );
+
+    return result;
+}
+
+#ifndef CY_WPS_AES_CBC_ALT
+/*
+ * Expand the key once. The NetXSecure AES key schedule covers both directions.
+ */
+cy_rslt_t cy_aes_cbc_context_init( cy_aes_cbc_context_t *ctx,
+                                   const unsigned char *key,
+                                   unsigned int keybits )
+{
+    uint32_t result;
+
+    memset( ctx, 0, sizeof( cy_aes_cbc_context_t ) );
+    ctx->key     = key;
+    ctx->keybits = keybits;
+
+    result = crypto_method_aes_cbc_256.nx_crypto_init(&crypto_method_aes_cbc_256,
+                                                      (UCHAR *)key,
+                                                      keybits,
+                                                      &ctx->handler,
+                                                      &ctx->aes,
+                                                      sizeof(ctx->aes));
+    if(result != NX_CRYPTO_SUCCESS)
+    {
+        return -1;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_aes_cbc_context_free( cy_aes_cbc_context_t *ctx )
+{
+    memset( ctx, 0, sizeof( cy_aes_cbc_context_t ) );
+}
+
+cy_rslt_t cy_aes_cbc_encrypt_with_context( cy_aes_cbc_context_t *ctx,
+                                           const unsigned char *input,
+                                           uint32_t input_length,
+                                           unsigned char *output,
+                                           const unsigned char iv[16] )
+{
     int32_t remaining = input_length & 0x0f;
     uint32_t rounded_length = input_length & 0xfffffff0;
     unsigned char iv_copy[16];
@@ -90,30 +172,19 @@ cy_rslt_t cy_aes_cbc_encrypt( const unsigned char *input,
     }
     
     memcpy( iv_copy, iv, sizeof(iv_copy) );
-    
-    result = crypto_method_aes_cbc_256.nx_crypto_init(&crypto_method_aes_cbc_256,
-                                                      (UCHAR *)key,
-                                                      keybits,
-                                                      &handler,
-                                                      &aes_ctx,
-                                                      meta_data_size);
-    if(result != NX_CRYPTO_SUCCESS)
-    {
-        return -1;
-    }
 
     result = crypto_method_aes_cbc_256.nx_crypto_operation(NX_CRYPTO_ENCRYPT,
-                                                           handler,
+                                                           ctx->handler,
                                                            &crypto_method_aes_cbc_256,
-                                                           (UCHAR *)key,
-                                                           keybits,
+                                                           (UCHAR *)ctx->key,
+                                                           ctx->keybits,
                                                            (UCHAR *)input,
                                                            rounded_length,
                                                            iv_copy,
                                                            output,
                                                            0,
-                                                           &aes_ctx,
-                                                           meta_data_size,
+                                                           &ctx->aes,
+                                                           sizeof(ctx->aes),
                                                            NX_NULL, NX_NULL);
     if(result != NX_CRYPTO_SUCCESS)
     {
@@ -135,22 +206,18 @@ cy_rslt_t cy_aes_cbc_encrypt( const unsigned char *input,
         tmp[j] = (uint8_t)(NETXSECURE_AES_BLOCK_SZ - remaining) ^  iv_copy[j];
     }
 
-    _nx_crypto_aes_encrypt(&aes_ctx, tmp, output+rounded_length, NETXSECURE_AES_BLOCK_SZ);
+    _nx_crypto_aes_encrypt(&ctx->aes, tmp, output+rounded_length, NETXSECURE_AES_BLOCK_SZ);
 
     return CY_RSLT_SUCCESS;
 }
 
-cy_rslt_t cy_aes_cbc_decrypt( const unsigned char *input, 
-                              uint32_t input_length, 
-                              unsigned char *output, 
-                              uint32_t* output_length, 
-                              const unsigned char *key, 
-                              unsigned int keybits, 
-                              const unsigned char iv[16] )
+cy_rslt_t cy_aes_cbc_decrypt_with_context( cy_aes_cbc_context_t *ctx,
+                                           const unsigned char *input,
+                                           uint32_t input_length,
+                                           unsigned char *output,
+                                           uint32_t* output_length,
+                                           const unsigned char iv[16] )
 {
-    void *handler = NULL;
-    NX_CRYPTO_AES aes_ctx;
-    ULONG meta_data_size = sizeof(aes_ctx);
     int32_t remaining = input_length & 0x0f;
     uint32_t rounded_length = input_length & 0xfffffff0;
     unsigned char iv_copy[16];
@@ -167,30 +234,19 @@ cy_rslt_t cy_aes_cbc_decrypt( const unsigned char *input,
     }
     
     memcpy( iv_copy, iv, sizeof(iv_copy) );
-    
-    result = crypto_method_aes_cbc_256.nx_crypto_init(&crypto_method_aes_cbc_256,
-                                                      (UCHAR *)key,
-                                                      keybits,
-                                                      &handler,
-                                                      &aes_ctx,
-                                                      meta_data_size);
-    if(result != NX_CRYPTO_SUCCESS)
-    {
-        return -1;
-    }
 
     result = crypto_method_aes_cbc_256.nx_crypto_operation(NX_CRYPTO_DECRYPT,
-                                                           handler,
+                                                           ctx->handler,
                                                            &crypto_method_aes_cbc_256,
-                                                           (UCHAR *)key,
-                                                           keybits,
+                                                           (UCHAR *)ctx->key,
+                                                           ctx->keybits,
                                                            (UCHAR*)input,
                                                            rounded_length,
                                                            iv_copy,
                                                            output,
                                                            rounded_length,
-                                                           &aes_ctx,
-                                                           meta_data_size,
+                                                           &ctx->aes,
+                                                           sizeof(ctx->aes),
                                                            NX_NULL, NX_NULL);
 
     if(result != NX_CRYPTO_SUCCESS)
@@ -202,6 +258,7 @@ cy_rslt_t cy_aes_cbc_decrypt( const unsigned char *input,
 
     return CY_RSLT_SUCCESS;
 }
+#endif /* CY_WPS_AES_CBC_ALT */
 
 void cy_sha2_hmac_starts( cy_sha2_hmac_context *ctx, 
                           const unsigned char *key, 
@@ -286,3 +343,98 @@ void cy_sha2_hmac( const unsigned char *key,
 
     memset(&ctx, 0, sizeof(cy_sha2_hmac_context));
 }
+
+/*
+ * Precompute the HMAC inner and outer hash states for a key
+ */
+void cy_sha2_hmac_key_setup( cy_sha2_hmac_key_t *key_ctx,
+                             const unsigned char *key,
+                             uint32_t keylen,
+                             int32_t hash_algo_type )
+{
+    uint32_t i;
+    unsigned char sum[32];
+    unsigned char ipad[64];
+    unsigned char opad[64];
+
+    if (keylen > 64) {
+        cy_sha256(key, keylen, sum, hash_algo_type);
+        keylen = (hash_algo_type) ? 28 : 32;
+        key = sum;
+    }
+
+    memset(ipad, 0x36, 64);
+    memset(opad, 0x5C, 64);
+
+    for (i = 0; i < keylen; i++) {
+        ipad[i] = (unsigned char)(ipad[i] ^ key[i]);
+        opad[i] = (unsigned char)(opad[i] ^ key[i]);
+    }
+
+    memset( &(key_ctx->inner), 0, sizeof( NX_CRYPTO_SHA256 ) );
+    _nx_crypto_sha256_initialize(&(key_ctx->inner), hash_algo_type);
+    _nx_crypto_sha256_update(&(key_ctx->inner), ipad, 64);
+
+    memset( &(key_ctx->outer), 0, sizeof( NX_CRYPTO_SHA256 ) );
+    _nx_crypto_sha256_initialize(&(key_ctx->outer), hash_algo_type);
+    _nx_crypto_sha256_update(&(key_ctx->outer), opad, 64);
+
+    key_ctx->hash_algo_type = hash_algo_type;
+
+    memset(sum, 0, sizeof(sum));
+    memset(ipad, 0, sizeof(ipad));
+    memset(opad, 0, sizeof(opad));
+}
+
+void cy_sha2_hmac_key_free( cy_sha2_hmac_key_t *key_ctx )
+{
+    memset( key_ctx, 0, sizeof( cy_sha2_hmac_key_t ) );
+}
+
+/*
+ * SHA-256 HMAC context setup from a precomputed key
+ */
+void cy_sha2_hmac_starts_with_key( cy_sha2_hmac_context *ctx,
+                                   const cy_sha2_hmac_key_t *key_ctx )
+{
+    memcpy( &(ctx->ctx), &(key_ctx->inner), sizeof( NX_CRYPTO_SHA256 ) );
+}
+
+/*
+ * SHA-256 HMAC final digest using a precomputed key
+ */
+void cy_sha2_hmac_finish_with_key( cy_sha2_hmac_context *ctx,
+                                   const cy_sha2_hmac_key_t *key_ctx,
+                                   unsigned char output[32] )
+{
+    int32_t       hash_algo_type;
+    uint32_t      hlen;
+    unsigned char tmpbuf[32];
+
+    hash_algo_type = key_ctx->hash_algo_type;
+    hlen = 32;
+
+    _nx_crypto_sha256_digest_calculate(&(ctx->ctx), tmpbuf, hash_algo_type);
+    memcpy( &(ctx->ctx), &(key_ctx->outer), sizeof( NX_CRYPTO_SHA256 ) );
+    _nx_crypto_sha256_update(&ctx->ctx, tmpbuf, hlen);
+    _nx_crypto_sha256_digest_calculate(&ctx->ctx, output, hash_algo_type);
+
+    memset(tmpbuf, 0, sizeof(tmpbuf));
+}
+
+/*
+ * Output = HMAC-SHA-256( precomputed hmac key, input buffer )
+ */
+void cy_sha2_hmac_with_key( const cy_sha2_hmac_key_t *key_ctx,
+                            const unsigned char *input,
+                            uint32_t ilen,
+                            unsigned char output[32] )
+{
+    cy_sha2_hmac_context ctx;
+
+    cy_sha2_hmac_starts_with_key(&ctx, key_ctx);
+    cy_sha2_hmac_update(&ctx, input, ilen);
+    cy_sha2_hmac_finish_with_key(&ctx, key_ctx, output);
+
+    memset(&ctx, 0, sizeof(cy_sha2_hmac_context));
+}
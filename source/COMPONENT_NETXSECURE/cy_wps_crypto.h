@@ -44,6 +44,9 @@ extern "C" {
 #include "nx_crypto_aes.h"
 #include "aes_alt.h"
 #include "cy_result.h"
+#ifdef CY_WPS_AES_CBC_ALT
+#include "cy_wps_aes_cbc_alt.h"
+#endif
 /******************************************************
  *                      Macros
  ******************************************************/
@@ -77,6 +80,28 @@ typedef union
     };
 } cy_sha2_hmac_context;
 
+/* HMAC key schedule. Holds the hash state after absorbing the inner and outer padded key
+ * so that several MACs can be calculated with the same key without rehashing the pads. */
+typedef struct
+{
+    NX_CRYPTO_SHA256       inner;      /*!< State after hashing key ^ ipad */
+    NX_CRYPTO_SHA256       outer;      /*!< State after hashing key ^ opad */
+    int32_t                hash_algo_type; /*!< Hash algorithm the key schedule was built with */
+} cy_sha2_hmac_key_t;
+
+#ifndef CY_WPS_AES_CBC_ALT
+/* Keyed AES-CBC context. The key is expanded once and reused for every encrypt/decrypt operation.
+ * Define CY_WPS_AES_CBC_ALT and provide cy_wps_aes_cbc_alt.h together with the cy_aes_cbc_context_xxx and
+ * cy_aes_cbc_xxx_with_context functions to route the session key to an MCU crypto accelerator instead. */
+typedef struct
+{
+    NX_CRYPTO_AES        aes;       /*!< Expanded key schedule */
+    void*                handler;   /*!< Handler returned by nx_crypto_init */
+    const unsigned char* key;       /*!< Key the schedule was built from, must remain valid while the context is in use */
+    unsigned int         keybits;
+} cy_aes_cbc_context_t;
+#endif
+
 /******************************************************
  *                 Global Variables
  ******************************************************/
@@ -93,6 +118,15 @@ void      cy_sha2_hmac_starts(cy_sha2_hmac_context *ctx, const unsigned char *ke
 void      cy_sha2_hmac_update(cy_sha2_hmac_context *ctx, const unsigned char *input, uint32_t ilen);
 void      cy_sha2_hmac_finish(cy_sha2_hmac_context * ctx, unsigned char output[32]);
 void      cy_sha2_hmac(const unsigned char *key, uint32_t keylen, const unsigned char *input, uint32_t ilen, unsigned char output[32], int32_t hash_algo_type);
+void      cy_sha2_hmac_key_setup(cy_sha2_hmac_key_t *key_ctx, const unsigned char *key, uint32_t keylen, int32_t hash_algo_type);
+void      cy_sha2_hmac_key_free(cy_sha2_hmac_key_t *key_ctx);
+void      cy_sha2_hmac_starts_with_key(cy_sha2_hmac_context *ctx, const cy_sha2_hmac_key_t *key_ctx);
+void      cy_sha2_hmac_finish_with_key(cy_sha2_hmac_context *ctx, const cy_sha2_hmac_key_t *key_ctx, unsigned char output[32]);
+void      cy_sha2_hmac_with_key(const cy_sha2_hmac_key_t *key_ctx, const unsigned char *input, uint32_t ilen, unsigned char output[32]);
+cy_rslt_t cy_aes_cbc_context_init( cy_aes_cbc_context_t *ctx, const unsigned char *key, unsigned int keybits );
+void      cy_aes_cbc_context_free( cy_aes_cbc_context_t *ctx );
+cy_rslt_t cy_aes_cbc_encrypt_with_context( cy_aes_cbc_context_t *ctx, const unsigned char *input, uint32_t input_length, unsigned char *output, const unsigned char iv[16] );
+cy_rslt_t cy_aes_cbc_decrypt_with_context( cy_aes_cbc_context_t *ctx, const unsigned char *input, uint32_t input_length, unsigned char *output, uint32_t* output_length, const unsigned char iv[16] );
 
 #ifdef __cplusplus
 } /*extern "C" */
@@ -192,6 +192,106 @@ uint8_t* tlv_write_header( uint8_t* buffer, uint16_t type, uint16_t length )
 
 
 
+uint32_t tlv_build_index8( tlv_index_t* index, const uint8_t* message, uint32_t message_length, const uint8_t* types, uint8_t type_count )
+{
+    const uint8_t* current       = message;
+    uint32_t       wanted_mask   = ( type_count >= 32 ) ? 0xFFFFFFFF : ( ( 1UL << type_count ) - 1 );
+    uint8_t        a;
+
+    index->message    = message;
+    index->found_mask = 0;
+
+    while ( ( message_length >= sizeof(tlv8_header_t) ) && ( index->found_mask != wanted_mask ) )
+    {
+        uint8_t  current_tlv_type   = current[ 0 ];
+        uint16_t current_tlv_length = current[ 1 ] + 2;
+
+        /* Check if we've overrun the buffer */
+        if ( current_tlv_length > message_length )
+        {
+            break;
+        }
+
+        for ( a = 0; a < type_count; ++a )
+        {
+            if ( ( types[a] == current_tlv_type ) && ( ( index->found_mask & ( 1UL << a ) ) == 0 ) )
+            {
+                index->entry[a].offset = (uint16_t)( current - message );
+                index->entry[a].length = (uint16_t)( current_tlv_length - 2 );
+                index->found_mask     |= ( 1UL << a );
+                break;
+            }
+        }
+
+        /* Skip current TLV */
+        current        += current_tlv_length;
+        message_length -= current_tlv_length;
+    }
+
+    return index->found_mask;
+}
+
+uint32_t tlv_build_index16( tlv_index_t* index, const uint8_t* message, uint32_t message_length, const uint16_t* types, uint8_t type_count )
+{
+    const uint8_t* current       = message;
+    uint32_t       wanted_mask   = ( type_count >= 32 ) ? 0xFFFFFFFF : ( ( 1UL << type_count ) - 1 );
+    uint16_t       aligned_type, aligned_length;
+    uint8_t        a;
+
+    index->message    = message;
+    index->found_mask = 0;
+
+    while ( ( message_length >= sizeof(tlv16_header_t) ) && ( index->found_mask != wanted_mask ) )
+    {
+        tlv16_header_t* tlv                = (tlv16_header_t*) current;
+        aligned_type = tlv->type;
+        uint16_t        current_tlv_type   = htobe16( TLV_READ_16( &aligned_type ) );
+        aligned_length = tlv->length;
+        uint32_t        current_tlv_length = (uint32_t) htobe16( TLV_READ_16( &aligned_length ) ) + 4;
+
+        /* Check if we've overrun the buffer */
+        if ( current_tlv_length > message_length )
+        {
+            break;
+        }
+
+        for ( a = 0; a < type_count; ++a )
+        {
+            if ( ( types[a] == current_tlv_type ) && ( ( index->found_mask & ( 1UL << a ) ) == 0 ) )
+            {
+                index->entry[a].offset = (uint16_t)( current - message );
+                index->entry[a].length = (uint16_t)( current_tlv_length - 4 );
+                index->found_mask     |= ( 1UL << a );
+                break;
+            }
+        }
+
+        /* Skip current TLV */
+        current        += current_tlv_length;
+        message_length -= current_tlv_length;
+    }
+
+    return index->found_mask;
+}
+
+const uint8_t* tlv_index_get( const tlv_index_t* index, uint8_t slot )
+{
+    if ( ( slot >= TLV_INDEX_MAX_TYPES ) || ( ( index->found_mask & ( 1UL << slot ) ) == 0 ) )
+    {
+        return NULL;
+    }
+    return index->message + index->entry[slot].offset;
+}
+
+uint16_t tlv_index_get_length( const tlv_index_t* index, uint8_t slot )
+{
+    if ( ( slot >= TLV_INDEX_MAX_TYPES ) || ( ( index->found_mask & ( 1UL << slot ) ) == 0 ) )
+    {
+        return 0;
+    }
+    return index->entry[slot].length;
+}
+
 static uint32_t tlv_hton32_ptr(uint8_t * in, uint8_t * out)
 {
     uint32_t temp;
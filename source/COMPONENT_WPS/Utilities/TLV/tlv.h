@@ -70,6 +70,9 @@
  *                    Constants
  ******************************************************/
 
+/* Maximum number of TLV types that can be tracked by a single tlv_index_t */
+#define TLV_INDEX_MAX_TYPES         (32)
+
 /******************************************************
  *                   Enumerations
  ******************************************************/
@@ -168,6 +171,21 @@ typedef struct
 
 #pragma pack()
 
+/* Location of one indexed TLV within the buffer passed to tlv_build_index8() or tlv_build_index16() */
+typedef struct
+{
+    uint16_t offset;    /* Offset of the TLV header from the start of the buffer */
+    uint16_t length;    /* Length of the TLV value in host byte order */
+} tlv_index_entry_t;
+
+/* Attribute-to-offset table built with a single pass over a TLV buffer */
+typedef struct
+{
+    const uint8_t*    message;
+    uint32_t          found_mask;                   /* Bit n is set when a TLV with the n-th requested type was found */
+    tlv_index_entry_t entry[TLV_INDEX_MAX_TYPES];
+} tlv_index_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -203,6 +221,56 @@ uint8_t*      tlv_write_header ( uint8_t* buffer, uint16_t type, uint16_t length
 tlv_result_t  tlv_read_value   ( uint16_t type, const uint8_t* message, uint16_t message_length, void* value, uint16_t value_size, tlv_data_type_t data_type );
 uint8_t*      tlv_write_value  ( uint8_t* buffer, uint16_t type, uint16_t length, const void* data, tlv_data_type_t data_type );
 
+/** Indexes a buffer of TLV data in a single pass.
+ *
+ * Records the location of the first TLV matching each of the given types so that
+ * subsequent lookups with tlv_index_get() do not need to search the buffer again.
+ * The n-th entry of the types array maps to bit n of the returned mask and to slot n of the index.
+ * The pass ends early only once a TLV has been found for every entry of types.
+ * This is the 8-bit-Type & 8-bit-Length version
+ *
+ * @param[out] index          : The index to fill in
+ * @param[in]  message        : A pointer to the source TLV data to be indexed
+ * @param[in]  message_length : The length of the source TLV data to be indexed
+ * @param[in]  types          : The TLV types to record
+ * @param[in]  type_count     : Number of entries in types. Must not exceed TLV_INDEX_MAX_TYPES
+ *
+ * @return Mask of the slots for which a matching TLV was found
+ */
+uint32_t      tlv_build_index8 ( tlv_index_t* index, const uint8_t* message, uint32_t message_length, const uint8_t* types, uint8_t type_count );
+
+/** Indexes a buffer of TLV data in a single pass.
+ *
+ * This is the 16-bit-Type & 16-bit-Length version of tlv_build_index8()
+ *
+ * @param[out] index          : The index to fill in
+ * @param[in]  message        : A pointer to the source TLV data to be indexed
+ * @param[in]  message_length : The length of the source TLV data to be indexed
+ * @param[in]  types          : The TLV types to record
+ * @param[in]  type_count     : Number of entries in types. Must not exceed TLV_INDEX_MAX_TYPES
+ *
+ * @return Mask of the slots for which a matching TLV was found
+ */
+uint32_t      tlv_build_index16( tlv_index_t* index, const uint8_t* message, uint32_t message_length, const uint16_t* types, uint8_t type_count );
+
+/** Looks up an indexed TLV.
+ *
+ * @param[in] index : An index built by tlv_build_index8() or tlv_build_index16()
+ * @param[in] slot  : Position of the wanted type in the types array used to build the index
+ *
+ * @return Pointer to the start of the TLV (the 'type' field), or NULL if the type was not found
+ */
+const uint8_t* tlv_index_get   ( const tlv_index_t* index, uint8_t slot );
+
+/** Returns the value length of an indexed TLV, in host byte order.
+ *
+ * @param[in] index : An index built by tlv_build_index8() or tlv_build_index16()
+ * @param[in] slot  : Position of the wanted type in the types array used to build the index
+ *
+ * @return Length of the TLV value, or 0 if the type was not found
+ */
+uint16_t      tlv_index_get_length( const tlv_index_t* index, uint8_t slot );
+
 #ifdef __cplusplus
 } /*extern "C" */
 #endif
@@ -39,6 +39,7 @@
 #include "cy_wcm_error.h"
 #include "cybsp_wifi.h"
 #include "cyabs_rtos.h"
+#include "cy_worker_thread.h"
 #include "whd.h"
 #include "whd_wifi_api.h"
 #include "whd_network_types.h"
@@ -55,9 +56,23 @@
 #include "cy_wps_structures.h"
 
 #define MAX_INTERFACE            (2)
+/* How long cy_wcm_wps_registrar_stop() waits for the aborted sessions to end before keeping the WPS thread */
+#ifndef WCM_WPS_REGISTRAR_STOP_WAIT_MS
+#define WCM_WPS_REGISTRAR_STOP_WAIT_MS (5000)
+#endif
 /******************************************************
  *             Structures
  ******************************************************/
+/* State of the enrollment started with cy_wcm_wps_enrollee_async() */
+typedef struct
+{
+    cy_wps_agent_t                   *workspace;
+    cy_wps_credential_t              *wps_credentials;
+    uint16_t                          wps_credential_count;
+    cy_wcm_wps_credential_t          *credentials;
+    cy_wcm_wps_completion_callback_t  callback;
+    void                             *user_data;
+} cy_wcm_wps_async_session_t;
 
 /******************************************************
  *               Variable Definitions
@@ -65,16 +80,73 @@
 /* The primary Wi-Fi driver  */
 extern whd_interface_t whd_ifs[MAX_INTERFACE];
 extern bool is_wcm_initalized;
+extern bool is_soft_ap_up;
+extern cy_mutex_t wcm_wps_mutex;
+
+#ifdef WCM_ENABLE_WPS_TIMELINE
+/* Timeline of the last WPS enrollment, copied out under wcm_wps_mutex before the WPS workspace is freed */
+static cy_wps_phase_record_t wps_timeline_records[CY_WCM_WPS_TIMELINE_SIZE];
+static uint32_t              wps_timeline_count   = 0;
+static uint32_t              wps_timeline_dropped = 0;
+#endif
+
+static cy_wcm_wps_async_session_t wps_async_session;
+/* Set under wcm_wps_mutex while an enrollment, started with either cy_wcm_wps_enrollee() or cy_wcm_wps_enrollee_async(), is running */
+static bool                       is_wps_enrollee_active = false;
+
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+/* Set once the registrar has started */
+static cy_wcm_wps_registrar_callback_t wps_registrar_callback = NULL;
+/* Set under wcm_wps_mutex while the registrar holds a reference on the WPS thread */
+static bool                            is_registrar_worker_held = false;
+#endif
+
+#ifdef WCM_ENABLE_WPS_TIMELINE
+static const cy_wcm_wps_phase_t wps_phase_to_wcm[] =
+{
+    [CY_WPS_PHASE_STARTED]            = CY_WCM_WPS_PHASE_STARTED,
+    [CY_WPS_PHASE_SCAN_STARTED]       = CY_WCM_WPS_PHASE_SCAN_STARTED,
+    [CY_WPS_PHASE_SCAN_COMPLETE]      = CY_WCM_WPS_PHASE_SCAN_COMPLETE,
+    [CY_WPS_PHASE_JOIN_STARTED]       = CY_WCM_WPS_PHASE_JOIN_STARTED,
+    [CY_WPS_PHASE_JOIN_COMPLETE]      = CY_WCM_WPS_PHASE_JOIN_COMPLETE,
+    [CY_WPS_PHASE_JOIN_FAILED]        = CY_WCM_WPS_PHASE_JOIN_FAILED,
+    [CY_WPS_PHASE_EAPOL_START_SENT]   = CY_WCM_WPS_PHASE_EAPOL_START_SENT,
+    [CY_WPS_PHASE_IDENTITY_SENT]      = CY_WCM_WPS_PHASE_IDENTITY_SENT,
+    [CY_WPS_PHASE_WSC_START_RECEIVED] = CY_WCM_WPS_PHASE_WSC_START_RECEIVED,
+    [CY_WPS_PHASE_MESSAGE_SENT]       = CY_WCM_WPS_PHASE_MESSAGE_SENT,
+    [CY_WPS_PHASE_MESSAGE_RECEIVED]   = CY_WCM_WPS_PHASE_MESSAGE_RECEIVED,
+    [CY_WPS_PHASE_FRAG_ACK_SENT]      = CY_WCM_WPS_PHASE_FRAG_ACK_SENT,
+    [CY_WPS_PHASE_RESTARTED]          = CY_WCM_WPS_PHASE_RESTARTED,
+    [CY_WPS_PHASE_FINISHED]           = CY_WCM_WPS_PHASE_FINISHED,
+};
+#endif
 /******************************************************
  *               Static Function Declarations
  ******************************************************/
 static cy_rslt_t convert_result_type( cy_rslt_t wps_result );
 static int       cy_wps_compute_pin_checksum      (unsigned long int PIN);
 static cy_wps_mode_t wcm_wps_to_wps( cy_wcm_wps_mode_t mode );
+static cy_rslt_t wps_copy_credentials( cy_wps_agent_t *workspace, cy_wps_credential_t *wps_credentials, cy_wcm_wps_credential_t *credentials );
+static cy_rslt_t wps_enrollee_cleanup( cy_wps_agent_t *workspace, cy_wps_credential_t *wps_credentials, cy_rslt_t result, uint16_t *credential_count );
+static void      wps_async_completion( cy_wps_agent_t *workspace );
+static void      wps_async_finish( void *arg );
+static void      wps_async_end( cy_wps_agent_t *workspace, bool release_worker );
+static bool      wps_enrollee_claim( void );
+static void      wps_enrollee_release( void );
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+static void      wps_registrar_session_callback( const whd_mac_t *enrollee_mac, cy_rslt_t result, void *user_data );
+#endif
 /******************************************************
  *               Extern Functions
  ******************************************************/
 extern cy_wcm_security_t whd_to_wcm_security(whd_security_t sec);
+extern whd_security_t wcm_to_whd_security(cy_wcm_security_t sec);
+extern cy_wcm_wifi_band_t whd_to_wcm_band(whd_802_11_band_t band);
+extern cy_rslt_t cy_wcm_connect_ap_on_channel(cy_wcm_connect_params_t *connect_params, uint8_t channel, cy_wcm_ip_address_t *ip_addr);
+extern cy_rslt_t cy_wcm_create_wps_worker(void);
+extern void      cy_wcm_release_wps_worker(void);
+extern cy_rslt_t cy_wcm_enqueue_worker_job(cy_worker_thread_func_t *work_func, void *arg);
+extern cy_rslt_t cy_wcm_enqueue_wps_job(cy_worker_thread_func_t *work_func, void *arg);
 /******************************************************
  *               Function Definitions
  ******************************************************/
@@ -102,6 +174,9 @@ static cy_rslt_t convert_result_type( cy_rslt_t wps_result )
         case CY_RSLT_WPS_ERROR_RECEIVED_WEP_CREDENTIALS:
              result = CY_RSLT_WCM_WPS_ERROR_RECEIVED_WEP_CREDENTIALS;
              break;
+        case CY_RSLT_WPS_IN_PROGRESS:
+             result = CY_RSLT_WCM_WPS_IN_PROGRESS;
+             break;
         default:
              result = wps_result;
              break;
@@ -176,6 +251,79 @@ static cy_wps_mode_t wcm_wps_to_wps(cy_wcm_wps_mode_t mode)
     return ((mode == CY_WCM_WPS_PBC_MODE) ? CY_WPS_PBC_MODE : CY_WPS_PIN_MODE);
 }
 
+static cy_rslt_t wps_copy_credentials( cy_wps_agent_t *workspace, cy_wps_credential_t *wps_credentials, cy_wcm_wps_credential_t *credentials )
+{
+    memset(credentials->ssid, 0, sizeof(credentials->ssid));
+    memset(credentials->passphrase, 0, sizeof(credentials->passphrase));
+    memcpy(credentials->ssid, wps_credentials->ssid, sizeof(wps_credentials->ssid));
+    memcpy(credentials->passphrase, wps_credentials->passphrase, sizeof(wps_credentials->passphrase));
+    credentials->security = whd_to_wcm_security(wps_credentials->security);
+
+    /* Hand back the registrar AP so that the caller can join it without scanning, but only if the credentials are for its network */
+    memset(&credentials->BSSID, 0, sizeof(credentials->BSSID));
+    credentials->channel = 0;
+    credentials->band    = CY_WCM_WIFI_BAND_ANY;
+    if( ( workspace->ap != NULL ) &&
+        ( workspace->ap->scan_result.SSID.length == strlen( (char*) wps_credentials->ssid ) ) &&
+        ( memcmp( workspace->ap->scan_result.SSID.value, wps_credentials->ssid, workspace->ap->scan_result.SSID.length ) == 0 ) )
+    {
+        memcpy(&credentials->BSSID, &workspace->ap->scan_result.BSSID, sizeof(credentials->BSSID));
+        credentials->channel = workspace->ap->scan_result.channel;
+        credentials->band    = whd_to_wcm_band(workspace->ap->scan_result.band);
+    }
+    return cy_wps_get_result( workspace );
+}
+
+/* Only one enrollment can use the STA interface at a time */
+static bool wps_enrollee_claim( void )
+{
+    bool claimed = false;
+
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    if( !is_wps_enrollee_active )
+    {
+        is_wps_enrollee_active = true;
+        claimed = true;
+    }
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+
+    return claimed;
+}
+
+static void wps_enrollee_release( void )
+{
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    is_wps_enrollee_active = false;
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+}
+
+static cy_rslt_t wps_enrollee_cleanup( cy_wps_agent_t *workspace, cy_wps_credential_t *wps_credentials, cy_rslt_t result, uint16_t *credential_count )
+{
+    if( result == CY_RSLT_SUCCESS )
+    {
+        *credential_count = cy_wps_get_stored_credential_count(workspace);
+    }
+    else
+    {
+        *credential_count = 0;
+        if( whd_wifi_stop_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA]) != WHD_SUCCESS )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR,"Failed to stop scan \r\n");
+            /* Fall through to cleanup remaining resource */
+        }
+    }
+#ifdef WCM_ENABLE_WPS_TIMELINE
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    wps_timeline_count = cy_wps_get_timeline( workspace, wps_timeline_records, CY_WCM_WPS_TIMELINE_SIZE, &wps_timeline_dropped );
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+#endif
+    cy_wps_deinit( workspace );
+    free(wps_credentials);
+    free( workspace );
+
+    return convert_result_type( result );
+}
+
 cy_rslt_t cy_wcm_wps_enrollee(cy_wcm_wps_config_t* wps_config, const cy_wcm_wps_device_detail_t *details, cy_wcm_wps_credential_t *credentials, uint16_t *credential_count)
 {
     cy_rslt_t result;
@@ -188,9 +336,16 @@ cy_rslt_t cy_wcm_wps_enrollee(cy_wcm_wps_config_t* wps_config, const cy_wcm_wps_
         return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
+    if( !wps_enrollee_claim() )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WPS enrollment is already in progress \n");
+        return CY_RSLT_WCM_WPS_IN_PROGRESS;
+    }
+
     workspace = (cy_wps_agent_t*) cy_wps_calloc("wps", 1, sizeof(cy_wps_agent_t));
     if ( workspace == NULL )
     {
+        wps_enrollee_release();
         return CY_RSLT_WCM_OUT_OF_MEMORY;
     }
 
@@ -198,6 +353,7 @@ cy_rslt_t cy_wcm_wps_enrollee(cy_wcm_wps_config_t* wps_config, const cy_wcm_wps_
     if(wps_credentials == NULL)
     {
         free(workspace);
+        wps_enrollee_release();
         return CY_RSLT_WCM_OUT_OF_MEMORY;
     }
 
@@ -206,6 +362,7 @@ cy_rslt_t cy_wcm_wps_enrollee(cy_wcm_wps_config_t* wps_config, const cy_wcm_wps_
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Currently connected to an AP, disconnect from the current AP before trying to connect using WPS \n");
         free(wps_credentials);
         free(workspace);
+        wps_enrollee_release();
         return CY_RSLT_WCM_WPS_FAILED;
     }
     
@@ -226,32 +383,327 @@ cy_rslt_t cy_wcm_wps_enrollee(cy_wcm_wps_config_t* wps_config, const cy_wcm_wps_
         goto convert_result_type;
     }
 
-    memset(credentials->ssid, 0, sizeof(credentials->ssid));
-    memset(credentials->passphrase, 0, sizeof(credentials->passphrase));
-    memcpy(credentials->ssid, wps_credentials->ssid, sizeof(wps_credentials->ssid));
-    memcpy(credentials->passphrase, wps_credentials->passphrase, sizeof(wps_credentials->passphrase));
-    credentials->security = whd_to_wcm_security(wps_credentials->security);
-    result = cy_wps_get_result( workspace );
+    result = wps_copy_credentials( workspace, wps_credentials, credentials );
 
 convert_result_type:
+    result = wps_enrollee_cleanup( workspace, wps_credentials, result, credential_count );
+    wps_enrollee_release();
+    return result;
+}
+
+cy_rslt_t cy_wcm_wps_enroll_and_connect(cy_wcm_wps_config_t* wps_config, const cy_wcm_wps_device_detail_t *details, cy_wcm_wps_credential_t *credential, cy_wcm_ip_address_t *ip_addr)
+{
+    cy_rslt_t result;
+    cy_wcm_connect_params_t connect_params;
+    uint16_t credential_count = 1;
+
+    result = cy_wcm_wps_enrollee( wps_config, details, credential, &credential_count );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        return result;
+    }
+
+    memset(&connect_params, 0, sizeof(connect_params));
+    memcpy(connect_params.ap_credentials.SSID, credential->ssid, sizeof(connect_params.ap_credentials.SSID));
+    memcpy(connect_params.ap_credentials.password, credential->passphrase, sizeof(connect_params.ap_credentials.password));
+    connect_params.ap_credentials.security = credential->security;
+    memcpy(connect_params.BSSID, credential->BSSID, sizeof(connect_params.BSSID));
+    connect_params.band = credential->band;
+
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS credentials received, joining %s on channel %u \n", (char*) credential->ssid, credential->channel);
+    return cy_wcm_connect_ap_on_channel( &connect_params, credential->channel, ip_addr );
+}
+
+/* Runs on the WPS thread when the event loop has finished. The WPS thread cannot delete itself, so the session is
+ * finished on the WCM worker, which also drops the reference on the WPS thread */
+static void wps_async_completion( cy_wps_agent_t *workspace )
+{
+    if( cy_wcm_enqueue_worker_job( wps_async_finish, (void *) workspace ) != CY_RSLT_SUCCESS )
+    {
+        /* Keep the WPS thread until cy_wcm_deinit() rather than losing the result */
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to queue the end of the WPS enrollment, the WPS thread is kept \n");
+        wps_async_end( workspace, false );
+    }
+}
+
+static void wps_async_finish( void *arg )
+{
+    wps_async_end( (cy_wps_agent_t *) arg, true );
+}
+
+static void wps_async_end( cy_wps_agent_t *workspace, bool release_worker )
+{
+    cy_wcm_wps_async_session_t session = wps_async_session;
+    uint16_t                   credential_count;
+    cy_rslt_t                  result;
+
+    result = wps_copy_credentials( workspace, session.wps_credentials, session.credentials );
+    result = wps_enrollee_cleanup( workspace, session.wps_credentials, result, &credential_count );
+
+    /* Allow a new enrollment to be started from the callback */
+    memset( &wps_async_session, 0, sizeof(wps_async_session) );
+    if( release_worker )
+    {
+        cy_wcm_release_wps_worker();
+    }
+    wps_enrollee_release();
+
+    session.callback( result, session.credentials, credential_count, session.user_data );
+}
+
+cy_rslt_t cy_wcm_wps_enrollee_async(cy_wcm_wps_config_t* wps_config, const cy_wcm_wps_device_detail_t *details, cy_wcm_wps_credential_t *credentials, uint16_t credential_count,
+                                    cy_wcm_wps_completion_callback_t callback, void *user_data)
+{
+    cy_rslt_t result;
+    cy_wps_agent_t *workspace;
+    cy_wps_credential_t* wps_credentials;
+    uint16_t unused_count;
+
+    if( !is_wcm_initalized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized, to initialize call cy_wcm_init() \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if( (wps_config == NULL) || (details == NULL) || (credentials == NULL) || (credential_count == 0) || (callback == NULL) )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments to cy_wcm_wps_enrollee_async(). \n");
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if( cy_wcm_is_connected_to_ap() )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Currently connected to an AP, disconnect from the current AP before trying to connect using WPS \n");
+        return CY_RSLT_WCM_WPS_FAILED;
+    }
+
+    if( !wps_enrollee_claim() )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WPS enrollment is already in progress \n");
+        return CY_RSLT_WCM_WPS_IN_PROGRESS;
+    }
+
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    result = cy_wcm_create_wps_worker();
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+    if( result != CY_RSLT_SUCCESS )
+    {
+        wps_enrollee_release();
+        return result;
+    }
+
+    workspace = (cy_wps_agent_t*) cy_wps_calloc("wps", 1, sizeof(cy_wps_agent_t));
+    if ( workspace == NULL )
+    {
+        cy_wcm_release_wps_worker();
+        wps_enrollee_release();
+        return CY_RSLT_WCM_OUT_OF_MEMORY;
+    }
+
+    wps_credentials = (cy_wps_credential_t*)cy_wps_calloc("wps_creds", credential_count, sizeof(cy_wps_credential_t));
+    if(wps_credentials == NULL)
+    {
+        free(workspace);
+        cy_wcm_release_wps_worker();
+        wps_enrollee_release();
+        return CY_RSLT_WCM_OUT_OF_MEMORY;
+    }
+
+    wps_async_session.workspace            = workspace;
+    wps_async_session.wps_credentials      = wps_credentials;
+    wps_async_session.wps_credential_count = credential_count;
+    wps_async_session.credentials          = credentials;
+    wps_async_session.callback             = callback;
+    wps_async_session.user_data            = user_data;
+
+    result = cy_wps_init ( workspace, (cy_wps_device_detail_t*) details, CY_WPS_ENROLLEE_AGENT, whd_ifs[CY_WCM_INTERFACE_TYPE_STA] );
     if( result == CY_RSLT_SUCCESS )
     {
-        *credential_count = cy_wps_get_stored_credential_count(workspace);
+        /* The WPS event loop runs on the WPS thread and calls wps_async_completion() when it has finished */
+        result = cy_wps_start_on_worker( workspace, wcm_wps_to_wps(wps_config->mode), wps_config->password, wps_credentials, &wps_async_session.wps_credential_count,
+                                         cy_wcm_enqueue_wps_job, wps_async_completion );
+    }
+
+    if( result != CY_RSLT_SUCCESS )
+    {
+        memset( &wps_async_session, 0, sizeof(wps_async_session) );
+        result = wps_enrollee_cleanup( workspace, wps_credentials, result, &unused_count );
+        cy_wcm_release_wps_worker();
+        wps_enrollee_release();
+        return result;
+    }
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_wps_get_timeline(cy_wcm_wps_timeline_t *timeline)
+{
+#ifdef WCM_ENABLE_WPS_TIMELINE
+    uint32_t i;
+
+    if( !is_wcm_initalized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized, to initialize call cy_wcm_init() \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if( timeline == NULL )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments to cy_wcm_wps_get_timeline(). \n");
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    for( i = 0; i < wps_timeline_count; i++ )
+    {
+        timeline->records[i].time_ms = wps_timeline_records[i].time;
+        timeline->records[i].phase   = wps_phase_to_wcm[wps_timeline_records[i].phase];
+        timeline->records[i].detail  = wps_timeline_records[i].detail;
+    }
+    timeline->count   = wps_timeline_count;
+    timeline->dropped = wps_timeline_dropped;
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+
+    return CY_RSLT_SUCCESS;
+#else
+    (void) timeline;
+    return CY_RSLT_WCM_UNSUPPORTED_API;
+#endif
+}
+
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+static void wps_registrar_session_callback( const whd_mac_t *enrollee_mac, cy_rslt_t result, void *user_data )
+{
+    cy_wcm_wps_registrar_callback_t callback = wps_registrar_callback;
+
+    if( callback != NULL )
+    {
+        callback( convert_result_type( result ), (const cy_wcm_mac_t *) enrollee_mac, user_data );
+    }
+}
+#endif
+
+cy_rslt_t cy_wcm_wps_registrar_start(const cy_wcm_wps_config_t *config, const cy_wcm_wps_device_detail_t *details, const cy_wcm_wps_credential_t *ap_credentials,
+                                     uint8_t max_enrollees, cy_wcm_wps_registrar_callback_t callback, void *user_data)
+{
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+    cy_wps_credential_t             ap_details;
+    cy_wcm_wps_registrar_callback_t previous_callback;
+    cy_rslt_t                       result;
+
+    if( !is_wcm_initalized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized, to initialize call cy_wcm_init() \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if( (config == NULL) || (details == NULL) || (ap_credentials == NULL) || (max_enrollees == 0) || (max_enrollees > CY_WPS_REGISTRAR_MAX_SESSIONS) ||
+        ((config->mode == CY_WCM_WPS_PIN_MODE) && (config->password == NULL)) )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments to cy_wcm_wps_registrar_start(). \n");
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if( !is_soft_ap_up )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "AP not up \r\n");
+        return CY_RSLT_WCM_AP_NOT_UP;
+    }
+
+    memset(&ap_details, 0, sizeof(ap_details));
+    memcpy(ap_details.ssid, ap_credentials->ssid, sizeof(ap_details.ssid));
+    memcpy(ap_details.passphrase, ap_credentials->passphrase, sizeof(ap_details.passphrase));
+    ap_details.security = wcm_to_whd_security(ap_credentials->security);
+
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    result = cy_wcm_create_wps_worker();
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_rtos_set_mutex(&wcm_wps_mutex);
+        return result;
+    }
+
+    /* A session can finish as soon as the pool has started, so the callback must be in place before that */
+    previous_callback      = wps_registrar_callback;
+    wps_registrar_callback = callback;
+
+    /* The sessions run on the WPS thread so that their Diffie-Hellman calculations do not hold up the WCM worker */
+    result = cy_wps_registrar_pool_start( whd_ifs[CY_WCM_INTERFACE_TYPE_AP], (const cy_wps_device_detail_t*) details, wcm_wps_to_wps(config->mode), config->password,
+                                          &ap_details, max_enrollees, cy_wcm_enqueue_wps_job, wps_registrar_session_callback, user_data );
+    if( result != CY_RSLT_SUCCESS )
+    {
+        /* Keep the callback of a registrar that is already running */
+        wps_registrar_callback = previous_callback;
     }
     else
     {
-        *credential_count = 0;
-        if( whd_wifi_stop_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA]) != WHD_SUCCESS )
-        {
-            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR,"Failed to stop scan \r\n");
-            /* Fall through to cleanup remaining resource */
-        }
+        is_registrar_worker_held = true;
+    }
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+
+    if( result != CY_RSLT_SUCCESS )
+    {
+        cy_wcm_release_wps_worker();
     }
-    cy_wps_deinit( workspace );
-    free(wps_credentials);
-    free( workspace );
-    wps_credentials = NULL;
-    workspace = NULL;
 
     return convert_result_type( result );
+#else
+    (void) config;
+    (void) details;
+    (void) ap_credentials;
+    (void) max_enrollees;
+    (void) callback;
+    (void) user_data;
+    return CY_RSLT_WCM_UNSUPPORTED_API;
+#endif
+}
+
+cy_rslt_t cy_wcm_wps_registrar_stop(void)
+{
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+    cy_rslt_t result;
+    uint32_t  waited_ms = 0;
+    bool      release_worker;
+    bool      is_idle;
+
+    if( !is_wcm_initalized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized, to initialize call cy_wcm_init() \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    /* In progress means an earlier call timed out while the sessions were ending */
+    result = cy_wps_registrar_pool_stop();
+    if( ( result != CY_RSLT_SUCCESS ) && ( result != CY_RSLT_WPS_IN_PROGRESS ) )
+    {
+        return convert_result_type( result );
+    }
+
+    /* Aborted sessions finish on the WPS thread; the pool reports success again once the last one has ended */
+    while( !( is_idle = ( cy_wps_registrar_pool_stop() == CY_RSLT_SUCCESS ) ) && ( waited_ms < WCM_WPS_REGISTRAR_STOP_WAIT_MS ) )
+    {
+        cy_rtos_delay_milliseconds( 10 );
+        waited_ms += 10;
+    }
+    if( !is_idle )
+    {
+        /* The thread is released by a later call, once the sessions have ended */
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "WPS registrar sessions are still ending, the WPS thread is kept \n");
+        return CY_RSLT_SUCCESS;
+    }
+
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    release_worker = is_registrar_worker_held;
+    is_registrar_worker_held = false;
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+
+    if( release_worker )
+    {
+        cy_wcm_release_wps_worker();
+    }
+
+    return CY_RSLT_SUCCESS;
+#else
+    return CY_RSLT_WCM_UNSUPPORTED_API;
+#endif
 }
@@ -57,6 +57,7 @@
 #include "whd_debug.h"
 #include "cy_wifimwcore_eapol.h"
 #include "whd_proto.h"
+#include "cmsis_compiler.h"
 /******************************************************
  *             Constants
  ******************************************************/
@@ -66,11 +67,28 @@
 #define WL_CHANSPEC_BAND_2G               0x2000
 #define WPS_THREAD_STACK_SIZE             (4*1024)
 #define AUTHORIZED_MAC_LIST_LENGTH        (1)
+#define WPS_PIN_MAX_LENGTH                (8)
+
+/* Guards active_wps_workspaces and eapol_handler_users. The table is read on the WHD RX path, which must not block
+ * on a mutex held across a WHD IOCTL, so the short accesses run with interrupts masked instead */
+#define CY_WPS_ENTER_CRITICAL( state )    do { ( state ) = __get_PRIMASK(); __disable_irq(); } while ( 0 )
+#define CY_WPS_EXIT_CRITICAL( state )     __set_PRIMASK( state )
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+#define ACTIVE_WPS_WORKSPACE_ARRAY_SIZE   (1 + CY_WPS_REGISTRAR_MAX_SESSIONS)
+#else
 #define ACTIVE_WPS_WORKSPACE_ARRAY_SIZE   (1)
+#endif
 
 #define DOT11_IE_ID_VENDOR_SPECIFIC       ( 221 )
 #define KDK_REQUIRED_CRYPTO_MATERIAL      (CY_WPS_CRYPTO_MATERIAL_ENROLLEE_NONCE | CY_WPS_CRYPTO_MATERIAL_REGISTRAR_NONCE | CY_WPS_CRYPTO_MATERIAL_ENROLLEE_MAC_ADDRESS)
 
+/* Slots of the attributes indexed from the WPS IE and the 802.11 IEs of a scan result */
+#define WPS_IE_INDEX_PWD_ID               (0)
+#define WPS_IE_INDEX_UUID_E               (1)
+#define WPS_IE_INDEX_SEL_REGISTRAR        (2)
+#define DOT11_IE_INDEX_DSSS_PARAMETER_SET (0)
+#define DOT11_IE_INDEX_HT_OPERATION       (1)
+
 /* Time related constants */
 #define SECONDS                      (1000)
 #define MINUTES                      (60 * SECONDS)
@@ -84,8 +102,6 @@
  *             Macros
  ******************************************************/
 
-#define IF_TO_WORKSPACE( interface )   ( active_wps_workspaces[0] )     /* STA = 0,  AP = 1 */
-
 /******************************************************
  *             Local Structures
  ******************************************************/
@@ -121,15 +137,66 @@ typedef struct
 
 typedef void (*cy_wps_pbc_probreq_notify_callback_t)(whd_mac_t mac);
 
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+typedef enum
+{
+    CY_WPS_REGISTRAR_POOL_IDLE,
+    CY_WPS_REGISTRAR_POOL_STARTING,
+    CY_WPS_REGISTRAR_POOL_RUNNING,
+    CY_WPS_REGISTRAR_POOL_STOPPING,     /* Waiting for the running sessions to finish */
+} cy_wps_registrar_pool_state_t;
+
+typedef enum
+{
+    CY_WPS_REGISTRAR_SESSION_FREE,
+    CY_WPS_REGISTRAR_SESSION_STARTING,  /* EAPOL start received, session queued on the worker */
+    CY_WPS_REGISTRAR_SESSION_RUNNING,
+} cy_wps_registrar_session_state_t;
+
+typedef struct
+{
+    cy_wps_registrar_session_state_t state;
+    whd_mac_t                        enrollee_mac;
+    cy_wps_agent_t*                  workspace;
+} cy_wps_registrar_session_t;
+
+/* Registrar that runs one WPS session per enrollee, all on the same worker thread */
+typedef struct
+{
+    cy_wps_registrar_pool_state_t       state;
+    cy_mutex_t                          mutex;
+    bool                                mutex_initialized;
+    whd_interface_t                     interface;
+    const cy_wps_device_detail_t*       details;
+    cy_wps_mode_t                       mode;
+    char                                password[WPS_PIN_MAX_LENGTH + 1];
+    cy_wps_credential_t                 ap_details;
+    cy_wps_scheduler_t                  scheduler;
+    cy_wps_registrar_session_callback_t callback;
+    void*                               user_data;
+    uint8_t                             rf_band;
+    cy_ie_t                             ie;
+    uint8_t                             max_sessions;
+    cy_wps_registrar_session_t          sessions[CY_WPS_REGISTRAR_MAX_SESSIONS];
+} cy_wps_registrar_pool_t;
+#endif
+
 /******************************************************
  *             Static Variables
  ******************************************************/
 static whd_scan_result_t scan_result;
 
 /* Active WPS workspaces.
- * Need to have one for each interface, but for now as only STA is supported. added only one */
+ * One for the STA enrollee, plus one per session of the multi-enrollee registrar */
 static cy_wps_agent_t* active_wps_workspaces[ACTIVE_WPS_WORKSPACE_ARRAY_SIZE] = {0};
 
+/* Number of WPS workspaces using the EAPOL receive handler */
+static uint8_t eapol_handler_users = 0;
+
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+static cy_wps_registrar_pool_t registrar_pool;
+#endif
+
 static       cy_wps_pbc_overlap_record_t pbc_overlap_array[2] = { { 0 } };
 static       cy_wps_pbc_overlap_record_t last_pbc_enrollee    = { 0 };
 static const whd_event_num_t          wps_events[]         = { WLC_E_PROBREQ_MSG, WLC_E_NONE };
@@ -137,18 +204,45 @@ const        uint32_t wps_m2_timeout                       = WPS_PUBLIC_KEY_MESS
 
 static       cy_wps_pbc_probreq_notify_callback_t pbc_probreq_notify_callback;
 
+/* Types to index, ordered by the WPS_IE_INDEX_xxx and DOT11_IE_INDEX_xxx slots */
+static const uint16_t wps_ie_index_types[]   = { WPS_ID_DEVICE_PWD_ID, WPS_ID_UUID_E, WPS_ID_SEL_REGISTRAR };
+static const uint8_t  dot11_ie_index_types[] = { DOT11_IE_ID_DSSS_PARAMETER_SET, DOT11_IE_ID_HT_OPERATION };
+
 /******************************************************
  *             Static Function Prototypes
  ******************************************************/
 
 static void           cy_wps_thread                    ( cy_thread_arg_t arg );
+static cy_rslt_t      cy_wps_configure_start           ( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length );
+static cy_rslt_t      cy_wps_allocate_thread_stack     ( cy_host_workspace_t* host_workspace );
+static cy_rslt_t      cy_wps_post_event                ( cy_wps_agent_t* workspace, cy_event_message_t* message, cy_time_t timeout );
+static void           cy_wps_event_loop_begin          ( cy_wps_agent_t* workspace );
+static uint32_t       cy_wps_event_loop_time_to_wait   ( cy_wps_agent_t* workspace, bool* waiting_for_event );
+static void           cy_wps_event_loop_process        ( cy_wps_agent_t* workspace, cy_event_message_t* message, bool waiting_for_event );
+static void           cy_wps_event_loop_end            ( cy_wps_agent_t* workspace );
+static void           cy_wps_worker_begin              ( void* arg );
+static void           cy_wps_worker_step               ( void* arg );
+static void           cy_wps_worker_schedule_step      ( cy_wps_agent_t* workspace );
+static void           cy_wps_worker_wakeup             ( cy_timer_callback_arg_t arg );
 static void           cy_wps_whd_scan_result_handler   ( whd_scan_result_t** result_ptr, void* user_data, whd_scan_status_t status );
 static void*          cy_wps_softap_event_handler      ( whd_interface_t interface, const whd_event_header_t* event_header, const uint8_t* event_data, /*@returned@*/ void* handler_user_data );
 #ifdef WCM_ENABLE_WPS_REGISTRAR
 static cy_rslt_t      cy_wps_internal_pbc_overlap_check( const whd_mac_t* mac );
 #endif
 static void           cy_network_process_wps_eapol_data( /*@only@*/ whd_interface_t interface, whd_buffer_t buffer );
-static tlv8_header_t* cy_wps_parse_dot11_tlvs          ( const tlv8_header_t* tlv_buf, uint32_t buflen, dot11_ie_id_t key );
+static void           cy_wps_activate_workspace        ( cy_wps_agent_t* workspace );
+static void           cy_wps_deactivate_workspace      ( cy_wps_agent_t* workspace );
+static cy_wps_agent_t* cy_wps_find_workspace           ( whd_interface_t interface );
+static bool           cy_wps_is_workspace_active       ( const void* workspace );
+static void           cy_wps_eapol_handler_acquire     ( void );
+static void           cy_wps_eapol_handler_release     ( void );
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+static cy_rslt_t      cy_wps_registrar_pool_process_eapol( whd_interface_t interface, whd_buffer_t buffer );
+static void           cy_wps_registrar_session_begin   ( void* arg );
+static void           cy_wps_registrar_session_complete( cy_wps_agent_t* workspace );
+static void           cy_wps_registrar_session_finish  ( cy_wps_registrar_session_t* session, cy_rslt_t result );
+static uint8_t        cy_wps_get_rf_band               ( whd_interface_t interface );
+#endif
 
 /******************************************************
  *             Function definitions
@@ -170,19 +264,10 @@ cy_rslt_t cy_wps_init(cy_wps_agent_t* workspace, const cy_wps_device_detail_t* d
     }
     memset(host_workspace, 0, sizeof(cy_wps_workspace_t));
     workspace->wps_host_workspace = host_workspace;
+    cy_wps_eapol_handler_acquire();
 
-#ifdef RTOS_USE_STATIC_THREAD_STACK
-    host_workspace->host_workspace.thread_stack = cy_wps_malloc("wps stack", WPS_THREAD_STACK_SIZE);
-    if (host_workspace->host_workspace.thread_stack == NULL)
-    {
-        cy_wps_free(workspace->wps_host_workspace);
-        workspace->wps_host_workspace = NULL;
-        return WPS_ERROR_WPS_STACK_MALLOC_FAIL;
-    }
-    memset( host_workspace->host_workspace.thread_stack, 0, WPS_THREAD_STACK_SIZE );
-#else
+    /* The thread stack is only allocated when the WPS thread is started. See cy_wps_allocate_thread_stack() */
     host_workspace->host_workspace.thread_stack = NULL;
-#endif
     host_workspace->host_workspace.interface = interface;
     workspace->interface      = interface;
     workspace->agent_type     = type;
@@ -202,8 +287,6 @@ cy_rslt_t cy_wps_init(cy_wps_agent_t* workspace, const cy_wps_device_detail_t* d
 
     cy_wps_init_workspace( workspace );
 
-    cy_wifimwcore_eapol_register_receive_handler( (cy_wifimwcore_eapol_packet_handler_t) cy_network_process_wps_eapol_data );
-
     return CY_RSLT_SUCCESS;
 }
 
@@ -247,6 +330,37 @@ cy_rslt_t cy_wps_get_result( cy_wps_agent_t* workspace )
     }
 }
 
+#ifdef WCM_ENABLE_WPS_TIMELINE
+uint32_t cy_wps_get_timeline( cy_wps_agent_t* workspace, cy_wps_phase_record_t* records, uint32_t max_records, uint32_t* dropped )
+{
+    uint32_t first = 0;
+    uint32_t count = workspace->timeline_count;
+    uint32_t a;
+
+    /* Once the ring has wrapped, the oldest record is the next one to be overwritten */
+    if ( count > CY_WPS_TIMELINE_SIZE )
+    {
+        first = count - CY_WPS_TIMELINE_SIZE;
+        count = CY_WPS_TIMELINE_SIZE;
+    }
+
+    /* Keep the most recent records if the caller has less room than the timeline */
+    if ( count > max_records )
+    {
+        first += count - max_records;
+        count  = max_records;
+    }
+
+    for ( a = 0; a < count; ++a )
+    {
+        records[a] = workspace->timeline[( first + a ) % CY_WPS_TIMELINE_SIZE];
+    }
+
+    *dropped = first;
+    return count;
+}
+#endif /* WCM_ENABLE_WPS_TIMELINE */
+
 cy_rslt_t cy_wps_deinit( cy_wps_agent_t* workspace )
 {
     cy_host_workspace_t* host_workspace = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
@@ -270,19 +384,22 @@ cy_rslt_t cy_wps_deinit( cy_wps_agent_t* workspace )
             host_workspace->thread_stack = NULL;
         }
 
+        if ( host_workspace->scheduler != NULL )
+        {
+            cy_rtos_deinit_timer( &host_workspace->wakeup_timer );
+            host_workspace->scheduler = NULL;
+        }
+
         cy_rtos_deinit_queue( &host_workspace->event_queue );
         cy_wps_free( host_workspace );
         workspace->wps_host_workspace = NULL;
+        cy_wps_eapol_handler_release();
     }
-    cy_wifimwcore_eapol_register_receive_handler( NULL );
     return CY_RSLT_SUCCESS;
 }
 
-cy_rslt_t cy_wps_start( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length )
+static cy_rslt_t cy_wps_configure_start( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length )
 {
-    cy_rslt_t result;
-    cy_host_workspace_t* host_workspace = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
-
     switch ( mode )
     {
         case CY_WPS_PBC_MODE:
@@ -298,16 +415,48 @@ cy_rslt_t cy_wps_start( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const cha
     }
 
 #ifdef WCM_ENABLE_WPS_REGISTRAR
-    if ( ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT ) &&
+    if ( ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT ) && ( workspace->is_multi_enrollee_registrar == 0 ) &&
          ( cy_wps_internal_pbc_overlap_check( NULL ) == CY_RSLT_WPS_PBC_OVERLAP ) && ( mode == CY_WPS_PBC_MODE ) )
     {
         return CY_RSLT_WPS_PBC_OVERLAP;
     }
 #endif
 
-    result = cy_wps_internal_init( workspace, (uint32_t) workspace->interface, mode, password, credentials, credential_length );
+    return cy_wps_internal_init( workspace, (uint32_t) workspace->interface, mode, password, credentials, credential_length );
+}
+
+static cy_rslt_t cy_wps_allocate_thread_stack( cy_host_workspace_t* host_workspace )
+{
+#ifdef RTOS_USE_STATIC_THREAD_STACK
+    if ( host_workspace->thread_stack == NULL )
+    {
+        host_workspace->thread_stack = cy_wps_malloc("wps stack", WPS_THREAD_STACK_SIZE);
+        if (host_workspace->thread_stack == NULL)
+        {
+            return CY_RSLT_WPS_ERROR_WPS_STACK_MALLOC_FAIL;
+        }
+        memset( host_workspace->thread_stack, 0, WPS_THREAD_STACK_SIZE );
+    }
+#else
+    UNUSED_PARAMETER( host_workspace );
+#endif
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wps_start( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length )
+{
+    cy_rslt_t result;
+    cy_host_workspace_t* host_workspace = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
+
+    result = cy_wps_configure_start( workspace, mode, password, credentials, credential_length );
     if ( result == CY_RSLT_SUCCESS )
     {
+        result = cy_wps_allocate_thread_stack( host_workspace );
+        if ( result != CY_RSLT_SUCCESS )
+        {
+            return result;
+        }
+
         if ( cy_rtos_create_thread( &host_workspace->thread, cy_wps_thread, "wps", host_workspace->thread_stack, WPS_THREAD_STACK_SIZE, CY_RTOS_PRIORITY_ABOVENORMAL, (cy_thread_arg_t) workspace ) != CY_RSLT_SUCCESS )
         {
             return result;
@@ -318,6 +467,34 @@ cy_rslt_t cy_wps_start( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const cha
     return result;
 }
 
+cy_rslt_t cy_wps_start_on_worker( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length,
+                                  cy_wps_scheduler_t scheduler, cy_wps_completion_callback_t completion_callback )
+{
+    cy_rslt_t result;
+    cy_host_workspace_t* host_workspace = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
+
+    if ( ( scheduler == NULL ) || ( completion_callback == NULL ) )
+    {
+        return CY_RSLT_WPS_BADARG;
+    }
+
+    result = cy_wps_configure_start( workspace, mode, password, credentials, credential_length );
+    if ( result != CY_RSLT_SUCCESS )
+    {
+        return result;
+    }
+
+    result = cy_rtos_init_timer( &host_workspace->wakeup_timer, CY_TIMER_TYPE_ONCE, cy_wps_worker_wakeup, (cy_timer_callback_arg_t) workspace );
+    if ( result != CY_RSLT_SUCCESS )
+    {
+        return result;
+    }
+    host_workspace->scheduler           = scheduler;
+    host_workspace->completion_callback = completion_callback;
+
+    return scheduler( cy_wps_worker_begin, workspace );
+}
+
 #ifdef WCM_ENABLE_P2P
 cy_rslt_t cy_p2p_wps_start( cy_wps_agent_t* workspace )
 {
@@ -331,6 +508,12 @@ cy_rslt_t cy_p2p_wps_start( cy_wps_agent_t* workspace )
         return CY_RSLT_WPS_PBC_OVERLAP;
     }
 
+    result = cy_wps_allocate_thread_stack( host_workspace );
+    if ( result != CY_RSLT_SUCCESS )
+    {
+        return result;
+    }
+
     result = cy_rtos_create_thread( &host_workspace->thread, cy_wps_thread, "wps", host_workspace->thread_stack, WPS_THREAD_STACK_SIZE, (cy_thread_priority_t)RTOS_HIGHER_PRIORTIY_THAN(RTOS_DEFAULT_THREAD_PRIORITY), (cy_thread_arg_t) workspace );
 
     return result;
@@ -410,11 +593,10 @@ int cy_wps_get_stored_credential_count( cy_wps_agent_t* workspace )
 
 cy_rslt_t cy_wps_abort( cy_wps_agent_t* workspace )
 {
-    cy_host_workspace_t* host_workspace = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
     cy_event_message_t   message;
     message.event_type = CY_EVENT_ABORT_REQUESTED;
     message.data.value = 0;
-    return (cy_rslt_t) cy_rtos_put_queue( &host_workspace->event_queue, &message, CY_RTOS_NEVER_TIMEOUT, false );
+    return cy_wps_post_event( workspace, &message, CY_RTOS_NEVER_TIMEOUT );
 }
 
 void cy_wps_scan_result_handler( whd_scan_result_t* result, void* user_data )
@@ -428,6 +610,7 @@ void cy_wps_scan_result_handler( whd_scan_result_t* result, void* user_data )
     cy_wps_uuid_t               uuid;
     cy_dsss_parameter_set_ie_t* dsie = NULL;
     cy_ht_operation_ie_t*       ht_operation_ie = NULL;
+    tlv_index_t                 ie_index;
 
     whd_scan_result_t*       bss_info;
 
@@ -472,16 +655,19 @@ void cy_wps_scan_result_handler( whd_scan_result_t* result, void* user_data )
         {
             tlv16_data_t* tlv16;
 
+            /* Locate the pwd ID, UUID and Selected Registrar attributes with a single pass over the WPS IE */
+            tlv_build_index16( &ie_index, &tlv8->data[4], (uint32_t)( tlv8->length - 4 ), wps_ie_index_types, (uint8_t) ( sizeof( wps_ie_index_types ) / sizeof( wps_ie_index_types[0] ) ) );
+
             /* Look for pwd ID */
-            tlv16_uint16_t* pwd_id = (tlv16_uint16_t*) tlv_find_tlv16( &tlv8->data[4], (uint32_t)( tlv8->length - 4 ), WPS_ID_DEVICE_PWD_ID );
+            tlv16_uint16_t* pwd_id = (tlv16_uint16_t*) tlv_index_get( &ie_index, WPS_IE_INDEX_PWD_ID );
             if ( workspace->wps_mode == CY_WPS_PIN_MODE ||
                  ( pwd_id != NULL && cy_hton16( pwd_id->data ) == CY_WPS_PUSH_BTN_DEVICEPWDID ) ) /* XXX needs to change if NFC is in use */
             {
                 keep_record = 1;
 
                 /* Look for the AP's UUID */
-                tlv16 = tlv_find_tlv16( &tlv8->data[4], (uint32_t)( tlv8->length - 4 ), WPS_ID_UUID_E );
-                if ( ( tlv16 == NULL ) || ( cy_hton16(tlv16->length) != WPS_UUID_LENGTH ) )
+                tlv16 = (tlv16_data_t*) tlv_index_get( &ie_index, WPS_IE_INDEX_UUID_E );
+                if ( ( tlv16 == NULL ) || ( tlv_index_get_length( &ie_index, WPS_IE_INDEX_UUID_E ) != WPS_UUID_LENGTH ) )
                 {
                     memset( &uuid, 0, sizeof( cy_wps_uuid_t ) );
                 }
@@ -496,7 +682,7 @@ void cy_wps_scan_result_handler( whd_scan_result_t* result, void* user_data )
                     /* Check if the registrar is using PBC mode */
                     if ( ( pwd_id != NULL && cy_hton16( pwd_id->data ) == CY_WPS_PUSH_BTN_DEVICEPWDID ) )
                     {
-                        tlv16 = tlv_find_tlv16( &tlv8->data[4], (uint32_t)( tlv8->length - 4 ), WPS_ID_SEL_REGISTRAR );
+                        tlv16 = (tlv16_data_t*) tlv_index_get( &ie_index, WPS_IE_INDEX_SEL_REGISTRAR );
                         if ( tlv16 != NULL )
                         {
                             /* Check that selected registrar is asserted */
@@ -525,8 +711,10 @@ void cy_wps_scan_result_handler( whd_scan_result_t* result, void* user_data )
         data   = (uint8_t*) bss_info->ie_ptr;
         uint32_t ie_len = result->ie_len;
         length = CY_WPS_HOST_READ_32((uint32_t *)&ie_len);
+        tlv_build_index8( &ie_index, data, length, dot11_ie_index_types, (uint8_t) ( sizeof( dot11_ie_index_types ) / sizeof( dot11_ie_index_types[0] ) ) );
+
         /* In 2.4 GHz the radio firmware may report off channel probe responses. Parse the response to check if it is on or off the AP operating channel. */
-        dsie =  (cy_dsss_parameter_set_ie_t*) cy_wps_parse_dot11_tlvs( (tlv8_header_t*)data, length, DOT11_IE_ID_DSSS_PARAMETER_SET );
+        dsie =  (cy_dsss_parameter_set_ie_t*) tlv_index_get( &ie_index, DOT11_IE_INDEX_DSSS_PARAMETER_SET );
         if ( ( dsie != NULL ) && ( dsie->length == DSSS_PARAMETER_SET_LENGTH ) )
         {
             result->channel = dsie->current_channel;
@@ -539,7 +727,7 @@ void cy_wps_scan_result_handler( whd_scan_result_t* result, void* user_data )
         if ( dsie == NULL )
         {
             /* Find the primary channel */
-            ht_operation_ie = (cy_ht_operation_ie_t*)cy_wps_parse_dot11_tlvs( (tlv8_header_t*)data, length, DOT11_IE_ID_HT_OPERATION );
+            ht_operation_ie = (cy_ht_operation_ie_t*) tlv_index_get( &ie_index, DOT11_IE_INDEX_HT_OPERATION );
             if ( ( ht_operation_ie != NULL ) && ( ht_operation_ie->length == HT_OPERATION_IE_LENGTH ) )
             {
                 result->channel =  ht_operation_ie->primary_channel;
@@ -580,16 +768,43 @@ static void cy_wps_thread( cy_thread_arg_t arg )
 
 void cy_wps_thread_main( cy_thread_arg_t arg )
 {
-    cy_time_t             current_time;
-    cy_rslt_t          result;
     cy_event_message_t  message;
     cy_wps_agent_t*          workspace = (cy_wps_agent_t*)arg;
     cy_wps_workspace_t* host      = (cy_wps_workspace_t*) workspace->wps_host_workspace;
-    cy_rslt_t          wps_result;
+
+    cy_wps_event_loop_begin( workspace );
+
+    while ( workspace->wps_result == CY_RSLT_WPS_IN_PROGRESS )
+    {
+        uint32_t     time_to_wait;
+        bool         waiting_for_event = false;
+
+        time_to_wait = cy_wps_event_loop_time_to_wait( workspace, &waiting_for_event );
+        if ( workspace->wps_result != CY_RSLT_WPS_IN_PROGRESS )
+        {
+            continue;
+        }
+
+        if ( cy_rtos_get_queue( &host->host_workspace.event_queue, &message, time_to_wait, false ) != CY_RSLT_SUCCESS )
+        {
+            /* Create a timeout message */
+            message.event_type = CY_EVENT_TIMER_TIMEOUT;
+            message.data.value = 0;
+        }
+
+        cy_wps_event_loop_process( workspace, &message, waiting_for_event );
+    }
+
+    cy_wps_event_loop_end( workspace );
+}
+
+static void cy_wps_event_loop_begin( cy_wps_agent_t* workspace )
+{
     workspace->wps_result = CY_RSLT_WPS_IN_PROGRESS;
+    cy_wps_record_phase( workspace, CY_WPS_PHASE_STARTED, 0 );
 
     /* Now that our queue is initialized we can flag the workspace as active */
-    IF_TO_WORKSPACE( workspace->interface ) = workspace;
+    cy_wps_activate_workspace( workspace );
 
 
     cy_wps_prepare_workspace_crypto( workspace );
@@ -598,73 +813,94 @@ void cy_wps_thread_main( cy_thread_arg_t arg )
     cy_rtos_get_time( &workspace->start_time );
 
 
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+    if ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Starting WPS Registrar\r\n");
+        cy_wps_registrar_start( workspace );
+        return;
+    }
+#endif
+
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Starting WPS Enrollee\r\n");
     cy_wps_enrollee_start( workspace, workspace->interface );
+}
 
-    while ( workspace->wps_result == CY_RSLT_WPS_IN_PROGRESS )
+/* Returns how long the event loop may wait for the next event. Sets the WPS result to timeout once the 120 second window has passed */
+static uint32_t cy_wps_event_loop_time_to_wait( cy_wps_agent_t* workspace, bool* waiting_for_event )
+{
+    cy_wps_workspace_t* host = (cy_wps_workspace_t*) workspace->wps_host_workspace;
+    cy_time_t           current_time;
+    uint32_t            time_to_wait;
+
+    cy_rtos_get_time(&current_time);
+
+    if (( current_time - workspace->start_time ) >= 2 * MINUTES )
     {
-        uint32_t     time_to_wait;
-        bool         waiting_for_event = false;
+        workspace->wps_result = CY_RSLT_WPS_TIMEOUT;
+        return 0;
+    }
 
-        cy_rtos_get_time(&current_time);
+    time_to_wait = ( 2 * MINUTES ) - ( current_time - workspace->start_time );
+    if ( host->host_workspace.timer_timeout != 0 )
+    {
+        *waiting_for_event = true;
+        time_to_wait = MIN( time_to_wait, host->host_workspace.timer_timeout - (current_time - host->host_workspace.timer_reference));
+    }
 
-        if (( current_time - workspace->start_time ) >= 2 * MINUTES )
-        {
-            workspace->wps_result = CY_RSLT_WPS_TIMEOUT;
-            continue;
-        }
+    return time_to_wait;
+}
 
-        time_to_wait = ( 2 * MINUTES ) - ( current_time - workspace->start_time );
-        if ( host->host_workspace.timer_timeout != 0 )
-        {
-            waiting_for_event = true;
-            time_to_wait = MIN( time_to_wait, host->host_workspace.timer_timeout - (current_time - host->host_workspace.timer_reference));
-        }
+static void cy_wps_event_loop_process( cy_wps_agent_t* workspace, cy_event_message_t* message, bool waiting_for_event )
+{
+    cy_time_t current_time;
+    cy_rslt_t result;
 
-        if ( cy_rtos_get_queue( &host->host_workspace.event_queue, &message, time_to_wait, false ) != CY_RSLT_SUCCESS )
+    /* Process the message */
+    result = cy_wps_process_event( workspace, message );
+    if ( result != CY_RSLT_SUCCESS )
+    {
+        cy_wps_record_phase( workspace, CY_WPS_PHASE_RESTARTED, result );
+        if ( result == CY_RSLT_WPS_ATTEMPTED_EXTERNAL_REGISTRAR_DISCOVERY )
         {
-            /* Create a timeout message */
-            message.event_type = CY_EVENT_TIMER_TIMEOUT;
-            message.data.value = 0;
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO,"Client attempted external registrar discovery\r\n");
         }
-
-        /* Process the message */
-        result = cy_wps_process_event( workspace, &message );
-        if ( result != CY_RSLT_SUCCESS )
+        else
         {
-            if ( result == CY_RSLT_WPS_ATTEMPTED_EXTERNAL_REGISTRAR_DISCOVERY )
-            {
-                cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO,"Client attempted external registrar discovery\r\n");
-            }
-            else
-            {
-                if ( waiting_for_event == true )
-                {
-                    int32_t time_left;
-                    cy_rtos_get_time( &current_time );
-                    time_left = MAX( ( ( 2 * MINUTES ) - ( current_time - workspace->start_time ) )/1000, 0);
-                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "WPS Procedure failed. Restarting with %li seconds left\r\n", (long)time_left);
-                    REFERENCE_DEBUG_ONLY_VARIABLE( time_left );
-                }
-            }
-
-            /* Reset the agent type if we were in reverse registrar mode */
-            if (workspace->in_reverse_registrar_mode != 0)
+            if ( waiting_for_event == true )
             {
-                workspace->agent_type = CY_WPS_REGISTRAR_AGENT;
+                int32_t time_left;
+                cy_rtos_get_time( &current_time );
+                time_left = MAX( ( ( 2 * MINUTES ) - ( current_time - workspace->start_time ) )/1000, 0);
+                cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "WPS Procedure failed. Restarting with %li seconds left\r\n", (long)time_left);
+                REFERENCE_DEBUG_ONLY_VARIABLE( time_left );
             }
+        }
 
-            if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
-            {
-                whd_wifi_leave( workspace->interface );
-            }
+        /* Reset the agent type if we were in reverse registrar mode */
+        if (workspace->in_reverse_registrar_mode != 0)
+        {
+            workspace->agent_type = CY_WPS_REGISTRAR_AGENT;
+        }
 
-            cy_wps_reset_workspace( workspace, workspace->interface );
+        if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
+        {
+            whd_wifi_leave( workspace->interface );
         }
+
+        cy_wps_reset_workspace( workspace, workspace->interface );
     }
+}
+
+static void cy_wps_event_loop_end( cy_wps_agent_t* workspace )
+{
+    cy_event_message_t  message;
+    cy_wps_workspace_t* host      = (cy_wps_workspace_t*) workspace->wps_host_workspace;
+    cy_rslt_t          wps_result;
 
     /* Remove workspace from list of active workspaces */
-    IF_TO_WORKSPACE( workspace->interface ) = NULL;
+    cy_wps_deactivate_workspace( workspace );
+    cy_wps_record_phase( workspace, CY_WPS_PHASE_FINISHED, workspace->wps_result );
 
     /* Print result (if enabled) */
     if ( workspace->wps_result == CY_RSLT_WPS_COMPLETE )
@@ -696,9 +932,12 @@ void cy_wps_thread_main( cy_thread_arg_t arg )
     }
 
     
-    /* De-init the workspace */
+    /* De-init the workspace. A registrar stays up on its interface */
     cy_wps_deinit_workspace( workspace );
-    whd_wifi_leave( workspace->interface );
+    if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
+    {
+        whd_wifi_leave( workspace->interface );
+    }
 
 
     /* Clean up left over messages in the event queue */
@@ -711,19 +950,218 @@ void cy_wps_thread_main( cy_thread_arg_t arg )
     }
 }
 
+/* Cooperative event loop. Each step runs as a job on the worker thread given to cy_wps_start_on_worker(), processes
+ * at most one event and then yields. A step is scheduled whenever an event is posted or the wakeup timer expires */
+static void cy_wps_worker_begin( void* arg )
+{
+    cy_wps_agent_t* workspace = (cy_wps_agent_t*) arg;
+
+    cy_wps_event_loop_begin( workspace );
+    cy_wps_worker_step( workspace );
+}
+
+static void cy_wps_worker_step( void* arg )
+{
+    cy_wps_agent_t*     workspace = (cy_wps_agent_t*) arg;
+    cy_wps_workspace_t* host;
+    cy_event_message_t  message;
+    uint32_t            time_to_wait      = 0;
+    bool                waiting_for_event = false;
+
+    /* Steps can still be queued after the session has ended. Only run them for an active workspace */
+    if ( !cy_wps_is_workspace_active( arg ) )
+    {
+        return;
+    }
+
+    host = (cy_wps_workspace_t*) workspace->wps_host_workspace;
+    cy_rtos_stop_timer( &host->host_workspace.wakeup_timer );
+
+    if ( workspace->wps_result == CY_RSLT_WPS_IN_PROGRESS )
+    {
+        time_to_wait = cy_wps_event_loop_time_to_wait( workspace, &waiting_for_event );
+    }
+
+    if ( workspace->wps_result == CY_RSLT_WPS_IN_PROGRESS )
+    {
+        if ( cy_rtos_get_queue( &host->host_workspace.event_queue, &message, 0, false ) != CY_RSLT_SUCCESS )
+        {
+            if ( time_to_wait != 0 )
+            {
+                /* Nothing to do until the next event or timeout */
+                cy_rtos_start_timer( &host->host_workspace.wakeup_timer, time_to_wait );
+                return;
+            }
+
+            /* Create a timeout message */
+            message.event_type = CY_EVENT_TIMER_TIMEOUT;
+            message.data.value = 0;
+        }
+
+        cy_wps_event_loop_process( workspace, &message, waiting_for_event );
+    }
+
+    if ( workspace->wps_result == CY_RSLT_WPS_IN_PROGRESS )
+    {
+        /* Yield to other jobs on the worker thread before looking at the next event */
+        cy_wps_worker_schedule_step( workspace );
+        return;
+    }
+
+    cy_wps_event_loop_end( workspace );
+    host->host_workspace.completion_callback( workspace );
+}
+
+static void cy_wps_worker_schedule_step( cy_wps_agent_t* workspace )
+{
+    cy_host_workspace_t* host = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
+
+    if ( host->scheduler( cy_wps_worker_step, workspace ) != CY_RSLT_SUCCESS )
+    {
+        /* The event stays queued and is picked up by the next step. Make sure there is one */
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Unable to schedule WPS step\r\n");
+        cy_rtos_start_timer( &host->wakeup_timer, 10 );
+    }
+}
+
+static void cy_wps_worker_wakeup( cy_timer_callback_arg_t arg )
+{
+    cy_wps_worker_schedule_step( (cy_wps_agent_t*) arg );
+}
+
+static cy_rslt_t cy_wps_post_event( cy_wps_agent_t* workspace, cy_event_message_t* message, cy_time_t timeout )
+{
+    cy_host_workspace_t* host = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
+    cy_rslt_t            result;
+
+    result = cy_rtos_put_queue( &host->event_queue, message, timeout, false );
+    if ( ( result == CY_RSLT_SUCCESS ) && ( host->scheduler != NULL ) )
+    {
+        cy_wps_worker_schedule_step( workspace );
+    }
+    return result;
+}
+
+static void cy_wps_activate_workspace( cy_wps_agent_t* workspace )
+{
+    uint32_t state;
+    uint8_t  a;
+
+    CY_WPS_ENTER_CRITICAL( state );
+    for ( a = 0; a < ACTIVE_WPS_WORKSPACE_ARRAY_SIZE; ++a )
+    {
+        if ( active_wps_workspaces[a] == NULL )
+        {
+            active_wps_workspaces[a] = workspace;
+            break;
+        }
+    }
+    CY_WPS_EXIT_CRITICAL( state );
+}
+
+static void cy_wps_deactivate_workspace( cy_wps_agent_t* workspace )
+{
+    uint32_t state;
+    uint8_t  a;
+
+    CY_WPS_ENTER_CRITICAL( state );
+    for ( a = 0; a < ACTIVE_WPS_WORKSPACE_ARRAY_SIZE; ++a )
+    {
+        if ( active_wps_workspaces[a] == workspace )
+        {
+            active_wps_workspaces[a] = NULL;
+        }
+    }
+    CY_WPS_EXIT_CRITICAL( state );
+}
+
+static bool cy_wps_is_workspace_active( const void* workspace )
+{
+    uint32_t state;
+    uint8_t  a;
+    bool     is_active = false;
+
+    CY_WPS_ENTER_CRITICAL( state );
+    for ( a = 0; a < ACTIVE_WPS_WORKSPACE_ARRAY_SIZE; ++a )
+    {
+        if ( active_wps_workspaces[a] == workspace )
+        {
+            is_active = true;
+            break;
+        }
+    }
+    CY_WPS_EXIT_CRITICAL( state );
+    return is_active;
+}
+
+/* Returns the active workspace on the interface. Sessions of the multi-enrollee registrar are looked up by enrollee instead */
+static cy_wps_agent_t* cy_wps_find_workspace( whd_interface_t interface )
+{
+    cy_wps_agent_t* workspace;
+    cy_wps_agent_t* found = NULL;
+    uint32_t        state;
+    uint8_t         a;
+
+    CY_WPS_ENTER_CRITICAL( state );
+    for ( a = 0; a < ACTIVE_WPS_WORKSPACE_ARRAY_SIZE; ++a )
+    {
+        workspace = active_wps_workspaces[a];
+        if ( ( workspace != NULL ) && ( workspace->interface == interface ) && ( workspace->is_multi_enrollee_registrar == 0 ) )
+        {
+            found = workspace;
+            break;
+        }
+    }
+    CY_WPS_EXIT_CRITICAL( state );
+    return found;
+}
+
+/* The count and the registration change together, so that a release racing with an acquire cannot leave the handler unregistered */
+static void cy_wps_eapol_handler_acquire( void )
+{
+    uint32_t state;
+
+    CY_WPS_ENTER_CRITICAL( state );
+    if ( eapol_handler_users++ == 0 )
+    {
+        cy_wifimwcore_eapol_register_receive_handler( (cy_wifimwcore_eapol_packet_handler_t) cy_network_process_wps_eapol_data );
+    }
+    CY_WPS_EXIT_CRITICAL( state );
+}
+
+static void cy_wps_eapol_handler_release( void )
+{
+    uint32_t state;
+
+    CY_WPS_ENTER_CRITICAL( state );
+    if ( ( eapol_handler_users != 0 ) && ( --eapol_handler_users == 0 ) )
+    {
+        cy_wifimwcore_eapol_register_receive_handler( NULL );
+    }
+    CY_WPS_EXIT_CRITICAL( state );
+}
+
 static void cy_network_process_wps_eapol_data( /*@only@*/ whd_interface_t interface, whd_buffer_t buffer )
 {
-    cy_wps_agent_t* workspace = IF_TO_WORKSPACE( interface );
+    cy_wps_agent_t* workspace;
+
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+    if ( cy_wps_registrar_pool_process_eapol( interface, buffer ) == CY_RSLT_SUCCESS )
+    {
+        return;
+    }
+#endif
+
+    workspace = cy_wps_find_workspace( interface );
     if ( workspace != NULL )
     {
         /* Don't queue the packet unless the WPS thread is running */
         if( workspace->wps_result == CY_RSLT_WPS_IN_PROGRESS)
         {
-            cy_host_workspace_t* host = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
             cy_event_message_t message;
             message.event_type = CY_EVENT_EAPOL_PACKET_RECEIVED;
             message.data.packet = buffer;
-            if ( cy_rtos_put_queue( &host->event_queue, &message, 0, false ) != CY_RSLT_SUCCESS )
+            if ( cy_wps_post_event( workspace, &message, 0 ) != CY_RSLT_SUCCESS )
             {
                 whd_buffer_release( workspace->interface->whd_driver, buffer, WHD_NETWORK_RX );
             }
@@ -760,15 +1198,328 @@ int cy_wps_validate_pin_checksum( const char* str )
 }
 #endif
 
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+/* RF band the interface is operating on, as advertised in the WPS IE and messages */
+static uint8_t cy_wps_get_rf_band( whd_interface_t interface )
+{
+    uint32_t channel = 0;
+
+    /* Channels above 14 are in the 5 GHz band */
+    if ( ( whd_wifi_get_channel( interface, &channel ) == WHD_SUCCESS ) && ( channel > 14 ) )
+    {
+        return WPS_RFBAND_50GHZ;
+    }
+    return WPS_RFBAND_24GHZ;
+}
+
+cy_rslt_t cy_wps_registrar_pool_start( whd_interface_t interface, const cy_wps_device_detail_t* details, cy_wps_mode_t mode, const char* password,
+                                       const cy_wps_credential_t* ap_details, uint8_t max_sessions, cy_wps_scheduler_t scheduler,
+                                       cy_wps_registrar_session_callback_t callback, void* user_data )
+{
+    cy_rslt_t result;
+    uint16_t  device_password_id;
+
+    if ( ( details == NULL ) || ( ap_details == NULL ) || ( scheduler == NULL ) ||
+         ( ( mode == CY_WPS_PIN_MODE ) && ( ( password == NULL ) || ( strlen( password ) > WPS_PIN_MAX_LENGTH ) ) ) ||
+         ( max_sessions == 0 ) || ( max_sessions > CY_WPS_REGISTRAR_MAX_SESSIONS ) )
+    {
+        return CY_RSLT_WPS_BADARG;
+    }
+
+    /* The mutex is also taken from the EAPOL receive path so it is never deleted */
+    if ( registrar_pool.mutex_initialized == false )
+    {
+        result = cy_rtos_init_mutex( &registrar_pool.mutex );
+        if ( result != CY_RSLT_SUCCESS )
+        {
+            return result;
+        }
+        registrar_pool.mutex_initialized = true;
+    }
+
+    cy_rtos_get_mutex( &registrar_pool.mutex, CY_RTOS_NEVER_TIMEOUT );
+    if ( registrar_pool.state != CY_WPS_REGISTRAR_POOL_IDLE )
+    {
+        cy_rtos_set_mutex( &registrar_pool.mutex );
+        return CY_RSLT_WPS_IN_PROGRESS;
+    }
+    registrar_pool.state = CY_WPS_REGISTRAR_POOL_STARTING;
+    cy_rtos_set_mutex( &registrar_pool.mutex );
+
+    registrar_pool.interface    = interface;
+    registrar_pool.details      = details;
+    registrar_pool.mode         = mode;
+    registrar_pool.scheduler    = scheduler;
+    registrar_pool.callback     = callback;
+    registrar_pool.user_data    = user_data;
+    registrar_pool.max_sessions = max_sessions;
+    memcpy( &registrar_pool.ap_details, ap_details, sizeof(cy_wps_credential_t) );
+    memset( registrar_pool.password, 0, sizeof(registrar_pool.password) );
+    if ( mode == CY_WPS_PIN_MODE )
+    {
+        memcpy( registrar_pool.password, password, strlen( password ) );
+    }
+    memset( registrar_pool.sessions, 0, sizeof(registrar_pool.sessions) );
+
+    registrar_pool.rf_band = cy_wps_get_rf_band( interface );
+
+    device_password_id = ( mode == CY_WPS_PBC_MODE ) ? CY_WPS_PUSH_BTN_DEVICEPWDID : CY_WPS_DEFAULT_DEVICEPWDID;
+    result = cy_wps_registrar_add_ie( interface, details, device_password_id, registrar_pool.rf_band, &registrar_pool.ie );
+    if ( result != CY_RSLT_SUCCESS )
+    {
+        cy_rtos_get_mutex( &registrar_pool.mutex, CY_RTOS_NEVER_TIMEOUT );
+        registrar_pool.state = CY_WPS_REGISTRAR_POOL_IDLE;
+        cy_rtos_set_mutex( &registrar_pool.mutex );
+        return result;
+    }
+
+    cy_wps_eapol_handler_acquire();
+
+    cy_rtos_get_mutex( &registrar_pool.mutex, CY_RTOS_NEVER_TIMEOUT );
+    registrar_pool.state = CY_WPS_REGISTRAR_POOL_RUNNING;
+    cy_rtos_set_mutex( &registrar_pool.mutex );
+
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "WPS registrar started for up to %u enrollees\r\n", (unsigned int)max_sessions);
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wps_registrar_pool_stop( void )
+{
+    cy_event_message_t message;
+    cy_rslt_t          result;
+    bool               idle = true;
+    uint8_t            a;
+
+    if ( registrar_pool.mutex_initialized == false )
+    {
+        return CY_RSLT_SUCCESS;
+    }
+
+    cy_rtos_get_mutex( &registrar_pool.mutex, CY_RTOS_NEVER_TIMEOUT );
+    if ( registrar_pool.state != CY_WPS_REGISTRAR_POOL_RUNNING )
+    {
+        result = ( registrar_pool.state == CY_WPS_REGISTRAR_POOL_IDLE ) ? CY_RSLT_SUCCESS : CY_RSLT_WPS_IN_PROGRESS;
+        cy_rtos_set_mutex( &registrar_pool.mutex );
+        return result;
+    }
+
+    /* Sessions that are still queued give up when they see the pool stopping. Running ones are aborted */
+    message.event_type = CY_EVENT_ABORT_REQUESTED;
+    message.data.value = 0;
+    for ( a = 0; a < registrar_pool.max_sessions; ++a )
+    {
+        if ( registrar_pool.sessions[a].state == CY_WPS_REGISTRAR_SESSION_RUNNING )
+        {
+            cy_wps_post_event( registrar_pool.sessions[a].workspace, &message, 0 );
+        }
+        if ( registrar_pool.sessions[a].state != CY_WPS_REGISTRAR_SESSION_FREE )
+        {
+            idle = false;
+        }
+    }
+    registrar_pool.state = ( idle == true ) ? CY_WPS_REGISTRAR_POOL_IDLE : CY_WPS_REGISTRAR_POOL_STOPPING;
+    cy_rtos_set_mutex( &registrar_pool.mutex );
+
+    cy_wps_registrar_remove_ie( registrar_pool.interface, &registrar_pool.ie );
+    cy_wps_eapol_handler_release();
+
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "WPS registrar stopped\r\n");
+    return CY_RSLT_SUCCESS;
+}
+
+/* Returns CY_RSLT_SUCCESS if the packet was consumed by the multi-enrollee registrar */
+static cy_rslt_t cy_wps_registrar_pool_process_eapol( whd_interface_t interface, whd_buffer_t buffer )
+{
+    cy_eapol_packet_header_t*   header;
+    cy_wps_registrar_session_t* session = NULL;
+    cy_event_message_t          message;
+    uint8_t                     a;
+
+    /* Unlocked check so that EAPOL traffic on other interfaces does not wait on the mutex */
+    if ( ( registrar_pool.state != CY_WPS_REGISTRAR_POOL_RUNNING ) || ( interface != registrar_pool.interface ) )
+    {
+        return CY_RSLT_WPS_UNPROCESSED;
+    }
+
+    header = (cy_eapol_packet_header_t*) whd_buffer_get_current_piece_data_pointer( interface->whd_driver, buffer );
+
+    cy_rtos_get_mutex( &registrar_pool.mutex, CY_RTOS_NEVER_TIMEOUT );
+    if ( registrar_pool.state != CY_WPS_REGISTRAR_POOL_RUNNING )
+    {
+        cy_rtos_set_mutex( &registrar_pool.mutex );
+        return CY_RSLT_WPS_UNPROCESSED;
+    }
+
+    for ( a = 0; a < registrar_pool.max_sessions; ++a )
+    {
+        if ( ( registrar_pool.sessions[a].state != CY_WPS_REGISTRAR_SESSION_FREE ) &&
+             ( memcmp( &registrar_pool.sessions[a].enrollee_mac, header->ethernet.ether_shost, sizeof(whd_mac_t) ) == 0 ) )
+        {
+            session = &registrar_pool.sessions[a];
+            break;
+        }
+    }
+
+    if ( session != NULL )
+    {
+        if ( session->state == CY_WPS_REGISTRAR_SESSION_RUNNING )
+        {
+            message.event_type  = CY_EVENT_EAPOL_PACKET_RECEIVED;
+            message.data.packet = buffer;
+            if ( cy_wps_post_event( session->workspace, &message, 0 ) == CY_RSLT_SUCCESS )
+            {
+                buffer = NULL;
+            }
+        }
+        /* A session that is still starting replies to the EAPOL start it was created for */
+    }
+    else if ( header->eapol.type == CY_EAPOL_START )
+    {
+        /* New enrollee. If all sessions are busy it is served once one finishes and it sends its next EAPOL start */
+        for ( a = 0; a < registrar_pool.max_sessions; ++a )
+        {
+            if ( registrar_pool.sessions[a].state == CY_WPS_REGISTRAR_SESSION_FREE )
+            {
+                session = &registrar_pool.sessions[a];
+                break;
+            }
+        }
+
+        if ( session != NULL )
+        {
+            session->state     = CY_WPS_REGISTRAR_SESSION_STARTING;
+            session->workspace = NULL;
+            memcpy( &session->enrollee_mac, header->ethernet.ether_shost, sizeof(whd_mac_t) );
+            if ( registrar_pool.scheduler( cy_wps_registrar_session_begin, session ) != CY_RSLT_SUCCESS )
+            {
+                session->state = CY_WPS_REGISTRAR_SESSION_FREE;
+            }
+        }
+    }
+    cy_rtos_set_mutex( &registrar_pool.mutex );
+
+    if ( buffer != NULL )
+    {
+        whd_buffer_release( interface->whd_driver, buffer, WHD_NETWORK_RX );
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+static void cy_wps_registrar_session_begin( void* arg )
+{
+    cy_wps_registrar_session_t* session = (cy_wps_registrar_session_t*) arg;
+    cy_wps_agent_t*             workspace;
+    cy_event_message_t          message;
+    cy_rslt_t                   result;
+
+    if ( registrar_pool.state != CY_WPS_REGISTRAR_POOL_RUNNING )
+    {
+        cy_wps_registrar_session_finish( session, CY_RSLT_WPS_ABORTED );
+        return;
+    }
+
+    workspace = (cy_wps_agent_t*) cy_wps_calloc( "wps", 1, sizeof(cy_wps_agent_t) );
+    if ( workspace == NULL )
+    {
+        cy_wps_registrar_session_finish( session, CY_RSLT_WPS_OUT_OF_HEAP_SPACE );
+        return;
+    }
+
+    result = cy_wps_init( workspace, registrar_pool.details, CY_WPS_REGISTRAR_AGENT, registrar_pool.interface );
+    if ( result == CY_RSLT_SUCCESS )
+    {
+        workspace->is_multi_enrollee_registrar = 1;
+        workspace->rfBand                      = registrar_pool.rf_band;
+        memcpy( &workspace->their_data.mac_address, &session->enrollee_mac, sizeof(whd_mac_t) );
+
+        result = cy_wps_start_on_worker( workspace, registrar_pool.mode, registrar_pool.password, &registrar_pool.ap_details, NULL,
+                                         registrar_pool.scheduler, cy_wps_registrar_session_complete );
+    }
+
+    if ( result != CY_RSLT_SUCCESS )
+    {
+        cy_wps_deinit( workspace );
+        cy_wps_free( workspace );
+        cy_wps_registrar_session_finish( session, result );
+        return;
+    }
+
+    cy_rtos_get_mutex( &registrar_pool.mutex, CY_RTOS_NEVER_TIMEOUT );
+    session->workspace = workspace;
+    session->state     = CY_WPS_REGISTRAR_SESSION_RUNNING;
+    cy_rtos_set_mutex( &registrar_pool.mutex );
+
+    /* The enrollee's EAPOL start was consumed when the session was created */
+    message.event_type = CY_WPS_EVENT_RECEIVED_EAPOL_START;
+    message.data.value = 0;
+    cy_wps_post_event( workspace, &message, 0 );
+}
+
+static void cy_wps_registrar_session_complete( cy_wps_agent_t* workspace )
+{
+    cy_rslt_t result = cy_wps_get_result( workspace );
+    uint8_t   a;
+
+    for ( a = 0; a < registrar_pool.max_sessions; ++a )
+    {
+        if ( registrar_pool.sessions[a].workspace == workspace )
+        {
+            cy_wps_registrar_session_finish( &registrar_pool.sessions[a], result );
+            break;
+        }
+    }
+
+    cy_wps_deinit( workspace );
+    cy_wps_free( workspace );
+}
+
+/* Frees the session slot and reports the result of the session */
+static void cy_wps_registrar_session_finish( cy_wps_registrar_session_t* session, cy_rslt_t result )
+{
+    whd_mac_t enrollee_mac;
+    bool      idle = true;
+    uint8_t   a;
+
+    cy_rtos_get_mutex( &registrar_pool.mutex, CY_RTOS_NEVER_TIMEOUT );
+    memcpy( &enrollee_mac, &session->enrollee_mac, sizeof(whd_mac_t) );
+    session->state     = CY_WPS_REGISTRAR_SESSION_FREE;
+    session->workspace = NULL;
+
+    if ( registrar_pool.state == CY_WPS_REGISTRAR_POOL_STOPPING )
+    {
+        for ( a = 0; a < registrar_pool.max_sessions; ++a )
+        {
+            if ( registrar_pool.sessions[a].state != CY_WPS_REGISTRAR_SESSION_FREE )
+            {
+                idle = false;
+            }
+        }
+        if ( idle == true )
+        {
+            registrar_pool.state = CY_WPS_REGISTRAR_POOL_IDLE;
+        }
+    }
+    cy_rtos_set_mutex( &registrar_pool.mutex );
+
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "WPS session with %02X:%02X:%02X:%02X:%02X:%02X finished with result 0x%lx\r\n",
+                   enrollee_mac.octet[0], enrollee_mac.octet[1], enrollee_mac.octet[2], enrollee_mac.octet[3], enrollee_mac.octet[4], enrollee_mac.octet[5], (unsigned long)result);
+
+    if ( registrar_pool.callback != NULL )
+    {
+        registrar_pool.callback( &enrollee_mac, result, registrar_pool.user_data );
+    }
+}
+#endif
+
 
 /******************************************************
  *               WPS Host API Definitions
  ******************************************************/
 
 
-cy_rslt_t cy_wps_host_join( void* workspace, cy_wps_ap_t* ap, whd_interface_t interface )
+cy_rslt_t cy_wps_host_join( cy_wps_agent_t* workspace, cy_wps_ap_t* ap, whd_interface_t interface )
 {
-    cy_host_workspace_t* host = &((cy_wps_workspace_t*) workspace)->host_workspace;
+    cy_host_workspace_t* host = &((cy_wps_workspace_t*) workspace->wps_host_workspace)->host_workspace;
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Joining '%.*s'\r\n", ap->scan_result.SSID.length, ap->scan_result.SSID.value);
 
@@ -798,7 +1549,7 @@ cy_rslt_t cy_wps_host_join( void* workspace, cy_wps_ap_t* ap, whd_interface_t in
     cy_event_message_t message;
     message.event_type = CY_WPS_EVENT_ENROLLEE_ASSOCIATED;
     message.data.value = 0;
-    cy_rtos_put_queue(&host->event_queue, &message, 0, false);
+    cy_wps_post_event( workspace, &message, 0 );
 
     return CY_RSLT_SUCCESS;
 }
@@ -1022,30 +1773,23 @@ void cy_wps_host_retrieve_credential( void* workspace, cy_wps_internal_credentia
 
 static void cy_wps_whd_scan_result_handler( whd_scan_result_t** result_ptr, void* user_data, whd_scan_status_t status )
 {
-    uint8_t a;
-
     /* Verify the workspace is still valid */
-    for ( a = 0; a < ACTIVE_WPS_WORKSPACE_ARRAY_SIZE; ++a )
+    if ( cy_wps_is_workspace_active( user_data ) )
     {
-        if (active_wps_workspaces[a] == user_data)
-        {
-            /* Get the host workspace now that we know the workspace is still valid */
-            cy_wps_workspace_t* host = (cy_wps_workspace_t*) ( (cy_wps_agent_t*) ( user_data ) )->wps_host_workspace;
-
-            /* Check if scan is complete */
-            if ( result_ptr == NULL )
-            {
-                cy_event_message_t message;
-                message.event_type = CY_WPS_EVENT_DISCOVER_COMPLETE;
-                message.data.value = 0;
-                cy_rtos_put_queue( &host->host_workspace.event_queue, &message, 0, false );
-            }
-            else if ( status == WHD_SCAN_INCOMPLETE )
-            {
-                host->stuff.enrollee.scan_handler_ptr( *result_ptr, user_data );
-            }
+        /* Get the host workspace now that we know the workspace is still valid */
+        cy_wps_workspace_t* host = (cy_wps_workspace_t*) ( (cy_wps_agent_t*) ( user_data ) )->wps_host_workspace;
 
-            break;
+        /* Check if scan is complete */
+        if ( result_ptr == NULL )
+        {
+            cy_event_message_t message;
+            message.event_type = CY_WPS_EVENT_DISCOVER_COMPLETE;
+            message.data.value = 0;
+            cy_wps_post_event( (cy_wps_agent_t*) user_data, &message, 0 );
+        }
+        else if ( status == WHD_SCAN_INCOMPLETE )
+        {
+            host->stuff.enrollee.scan_handler_ptr( *result_ptr, user_data );
         }
     }
 }
@@ -1176,7 +1920,6 @@ void cy_wps_update_pbc_overlap_array(cy_wps_agent_t* workspace, const whd_mac_t*
     int i;
     cy_time_t              rx_time;
     cy_event_message_t   message;
-    cy_host_workspace_t* host = &((cy_wps_workspace_t*)workspace->wps_host_workspace)->host_workspace;
     whd_mac_t             mac;
 
     cy_rtos_get_time(&rx_time);
@@ -1240,7 +1983,7 @@ return_with_notify:
     {
         message.event_type  = CY_WPS_EVENT_PBC_OVERLAP_NOTIFY_USER;
         message.data.packet = &mac;
-        if (cy_rtos_put_queue(&host->event_queue, &message, 0, false) != CY_RSLT_SUCCESS)
+        if (cy_wps_post_event(workspace, &message, 0) != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "No room in the WPS event queue\r\n");
         }
@@ -1338,10 +2081,3 @@ void cy_wps_register_internal_result_callback( cy_wps_agent_t* workspace, void (
 {
     workspace->cy_wps_internal_result_callback = wps_internal_result_callback;
 }
-
-/* Note that there is an identical function in wwd_wifi.c which can't be used currently because making it non-static causes build errors related to the tlv8 structs. */
-static tlv8_header_t* cy_wps_parse_dot11_tlvs( const tlv8_header_t* tlv_buf, uint32_t buflen, dot11_ie_id_t key )
-{
-
-    return (tlv8_header_t*) tlv_find_tlv8( (const uint8_t*) tlv_buf, buflen, key );
-}
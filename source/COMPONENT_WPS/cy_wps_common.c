@@ -87,6 +87,9 @@
 #define WPS_LENGTH_FIELD_MASK        (0x02)
 #define WPS_MORE_FRAGMENTS_MASK      (0x01)
 #define WPS_MESSAGE_TYPE_M1          (0x04)
+
+#define WPS_TX_BUFFER_SIZE           (1024 + WHD_LINK_HEADER)
+
 #ifndef TRUE
 #define TRUE   (1)
 #endif /* ifndef TRUE */
@@ -158,6 +161,31 @@ typedef enum
     CY_WPS_UUID_INDEX,
 } cy_wps_agent_specific_tlv_index_t;
 
+/* Index slots of the attributes handled by cy_wps_process_message_content().
+ * The slots are contiguous so that every slot has a type to match. Slots 0-15 match the bit position
+ * of the corresponding CY_WPS_TLV_xxx flag; the MAC address flag is bit 20 */
+typedef enum
+{
+    CY_WPS_TLV_SLOT_VERSION             = 0,
+    CY_WPS_TLV_SLOT_ENROLLEE_NONCE      = 1,
+    CY_WPS_TLV_SLOT_E_HASH1             = 2,
+    CY_WPS_TLV_SLOT_E_HASH2             = 3,
+    CY_WPS_TLV_SLOT_ENCRYPTION_SETTINGS = 4,
+    CY_WPS_TLV_SLOT_AUTHENTICATOR       = 5,
+    CY_WPS_TLV_SLOT_REGISTRAR_NONCE     = 6,
+    CY_WPS_TLV_SLOT_AUTH_TYPE_FLAGS     = 7,
+    CY_WPS_TLV_SLOT_ENCR_TYPE_FLAGS     = 8,
+    CY_WPS_TLV_SLOT_UUID_R              = 9,
+    CY_WPS_TLV_SLOT_PUBLIC_KEY          = 10,
+    CY_WPS_TLV_SLOT_MSG_TYPE            = 11,
+    CY_WPS_TLV_SLOT_X509_CERT           = 12,
+    CY_WPS_TLV_SLOT_VENDOR_EXT          = 13,
+    CY_WPS_TLV_SLOT_R_HASH1             = 14,
+    CY_WPS_TLV_SLOT_R_HASH2             = 15,
+    CY_WPS_TLV_SLOT_MAC_ADDR            = 16,
+    CY_WPS_TLV_SLOT_COUNT,
+} cy_wps_message_tlv_slot_t;
+
 /******************************************************
  *                 Type Definitions
  ******************************************************/
@@ -182,8 +210,8 @@ static uint8_t*     cy_wps_write_common_header         ( cy_wps_agent_t* workspa
 static uint8_t*     cy_wps_write_vendor_extension      ( uint8_t* iter, cy_wps_agent_t* workspace );
 static uint8_t*     cy_wps_start_encrypted_tlv         ( uint8_t* iter);
 static uint8_t*     cy_wps_end_encrypted_tlv           ( cy_wps_agent_t* workspace, uint8_t* start_of_encrypted_tlv_header, uint8_t* end_of_data );
-static void         cy_wps_send_protocol_message       ( cy_wps_agent_t* workspace, cy_packet_t* packet, uint8_t* start_of_packet, uint8_t* iter );
-static void         cy_wps_encrypt_data                ( uint8_t* input, uint16_t input_length, cy_key_wrap_key_t* encr_key, uint8_t* output, cy_wps_iv_t* iv );
+static cy_rslt_t    cy_wps_send_protocol_message       ( cy_wps_agent_t* workspace, cy_packet_t* packet, uint8_t* start_of_packet, uint8_t* iter );
+static void         cy_wps_encrypt_data                ( uint8_t* input, uint16_t input_length, cy_aes_cbc_context_t* encr_ctx, uint8_t* output, cy_wps_iv_t* iv );
 static cy_rslt_t    cy_wps_send_wsc_nack               ( cy_wps_agent_t* workspace, uint16_t config_error);
 static cy_rslt_t    cy_wps_send_done                   ( cy_wps_agent_t* workspace );
 
@@ -191,7 +219,7 @@ static cy_rslt_t    cy_wps_send_done                   ( cy_wps_agent_t* workspa
 static cy_rslt_t    cy_wps_process_message_content     ( cy_wps_agent_t* workspace, uint8_t* content, uint16_t content_length, uint32_t tlv_mask );
 static cy_rslt_t    cy_wps_process_encrypted_tlvs      ( cy_wps_agent_t* workspace, cy_wps_encryption_data_t* encrypted_data, uint16_t encrypted_data_length, uint32_t valid_tlv_mask );
 static cy_rslt_t    cy_wps_process_credential          ( cy_wps_agent_t* workspace, uint8_t* data, uint16_t data_length );
-static int          cy_wps_decrypt_data                ( cy_wps_encryption_data_t* encrypted_data, uint16_t encrypted_data_length, cy_key_wrap_key_t* encr_key, uint8_t* plain_text);
+static int          cy_wps_decrypt_data                ( cy_wps_encryption_data_t* encrypted_data, uint16_t encrypted_data_length, cy_aes_cbc_context_t* encr_ctx, uint8_t* plain_text);
 static cy_rslt_t    cy_wps_validate_secret_nonce       ( cy_wps_agent_t* workspace, cy_wps_agent_data_t* agent_data, uint8_t* data, uint8_t which_nonce);
 static uint8_t*     cy_get_wps_packet_data             ( cy_wps_msg_packet_t* packet);
 
@@ -214,6 +242,11 @@ static cy_rslt_t    cy_wps_calculate_psk               ( cy_wps_agent_t* workspa
 
 static void         cy_wps_cleanup_workspace           ( cy_wps_agent_t* workspace );
 
+/* TX buffer pool functions */
+static void         cy_wps_prepare_tx_templates        ( cy_wps_agent_t* workspace );
+static void         cy_wps_refill_tx_buffer_pool       ( cy_wps_agent_t* workspace, uint32_t wait );
+static void         cy_wps_release_tx_buffer_pool      ( cy_wps_agent_t* workspace );
+
 #ifdef COMPONENT_4390X
 extern cy_rslt_t cy_prng_get_random( void* buffer, uint32_t buffer_length );
 #endif
@@ -245,6 +278,28 @@ static const uint16_t agent_specific_tlv_id[2][6] =
     }
 };
 
+/* Attribute ID of each slot of cy_wps_message_tlv_slot_t, every slot has one */
+static const uint16_t message_tlv_id[CY_WPS_TLV_SLOT_COUNT] =
+{
+    [CY_WPS_TLV_SLOT_VERSION]             = WPS_ID_VERSION,
+    [CY_WPS_TLV_SLOT_ENROLLEE_NONCE]      = WPS_ID_ENROLLEE_NONCE,
+    [CY_WPS_TLV_SLOT_E_HASH1]             = WPS_ID_E_HASH1,
+    [CY_WPS_TLV_SLOT_E_HASH2]             = WPS_ID_E_HASH2,
+    [CY_WPS_TLV_SLOT_ENCRYPTION_SETTINGS] = WPS_ID_ENCR_SETTINGS,
+    [CY_WPS_TLV_SLOT_AUTHENTICATOR]       = WPS_ID_AUTHENTICATOR,
+    [CY_WPS_TLV_SLOT_REGISTRAR_NONCE]     = WPS_ID_REGISTRAR_NONCE,
+    [CY_WPS_TLV_SLOT_AUTH_TYPE_FLAGS]     = WPS_ID_AUTH_TYPE_FLAGS,
+    [CY_WPS_TLV_SLOT_ENCR_TYPE_FLAGS]     = WPS_ID_ENCR_TYPE_FLAGS,
+    [CY_WPS_TLV_SLOT_UUID_R]              = WPS_ID_UUID_R,
+    [CY_WPS_TLV_SLOT_PUBLIC_KEY]          = WPS_ID_PUBLIC_KEY,
+    [CY_WPS_TLV_SLOT_MSG_TYPE]            = WPS_ID_MSG_TYPE,
+    [CY_WPS_TLV_SLOT_X509_CERT]           = WPS_ID_X509_CERT,
+    [CY_WPS_TLV_SLOT_VENDOR_EXT]          = WPS_ID_VENDOR_EXT,
+    [CY_WPS_TLV_SLOT_R_HASH1]             = WPS_ID_R_HASH1,
+    [CY_WPS_TLV_SLOT_R_HASH2]             = WPS_ID_R_HASH2,
+    [CY_WPS_TLV_SLOT_MAC_ADDR]            = WPS_ID_MAC_ADDR,
+};
+
 const cy_wps_state_machine_state_t wps_states[2][4] =
 {
     [CY_WPS_ENROLLEE_AGENT] =
@@ -360,6 +415,29 @@ uint32_t cy_host_get_timer( void* workspace )
     return host->timer_timeout;
 }
 
+#ifdef WCM_ENABLE_WPS_TIMELINE
+void cy_wps_record_phase( cy_wps_agent_t* workspace, cy_wps_phase_t phase, uint32_t detail )
+{
+    cy_wps_phase_record_t* record;
+    cy_time_t              now;
+
+    cy_rtos_get_time( &now );
+
+    /* A new session starts with an empty timeline */
+    if ( phase == CY_WPS_PHASE_STARTED )
+    {
+        workspace->timeline_count = 0;
+        workspace->timeline_start = now;
+    }
+
+    record         = &workspace->timeline[workspace->timeline_count % CY_WPS_TIMELINE_SIZE];
+    record->time   = now - workspace->timeline_start;
+    record->detail = detail;
+    record->phase  = phase;
+    ++workspace->timeline_count;
+}
+#endif /* WCM_ENABLE_WPS_TIMELINE */
+
 cy_rslt_t cy_host_random_bytes( void* buffer, size_t buffer_length, size_t* output_length )
 {
 #ifndef COMPONENT_4390X
@@ -530,6 +608,7 @@ static cy_rslt_t cy_wps_common_event_handler(cy_wps_agent_t* workspace, cy_event
                 result = CY_RSLT_WPS_ERROR_MESSAGE_MISSING_TLV;
                 goto return_with_packet_and_maybe_fragment;
             }
+            cy_wps_record_phase( workspace, CY_WPS_PHASE_MESSAGE_RECEIVED, message_type );
 
             // Reverse registrar mode check
             if ( workspace->in_reverse_registrar_mode != 0 && message_type == WPS_ID_MESSAGE_M2D )
@@ -629,6 +708,7 @@ static cy_rslt_t cy_wps_common_event_handler(cy_wps_agent_t* workspace, cy_event
             break;
 
         case CY_WPS_EVENT_RECEIVED_WPS_START:
+            cy_wps_record_phase( workspace, CY_WPS_PHASE_WSC_START_RECEIVED, 0 );
             workspace->current_sub_stage = CY_WPS_SENDING_PUBLIC_KEYS;
             break;
 
@@ -657,14 +737,22 @@ static cy_rslt_t cy_wps_common_event_handler(cy_wps_agent_t* workspace, cy_event
     if (workspace->current_main_stage == CY_WPS_IN_WPS_HANDSHAKE)
     {
         /* Send the packet for the current state */
-        whd_host_buffer_get( workspace->interface->whd_driver, &outgoing_packet, WHD_NETWORK_TX, 1024 + WHD_LINK_HEADER, true );
-        whd_buffer_add_remove_at_front( workspace->interface->whd_driver, &outgoing_packet, WHD_LINK_HEADER );
+        outgoing_packet = cy_wps_get_tx_buffer( workspace );
+        if ( outgoing_packet == NULL )
+        {
+            return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
+        }
         packet_header = (cy_wps_msg_packet_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, outgoing_packet );
         memset(packet_header, 0, whd_buffer_get_current_piece_size( workspace->interface->whd_driver, outgoing_packet));
         iter = packet_header->data;
         iter = cy_wps_write_common_header( workspace, iter, wps_states[workspace->agent_type][workspace->current_sub_stage].outgoing_message_type );
         iter = wps_states[workspace->agent_type][workspace->current_sub_stage].packet_generator( workspace, iter );
-        cy_wps_send_protocol_message( workspace, outgoing_packet, (uint8_t*) &packet_header->data, iter );
+        result = cy_wps_send_protocol_message( workspace, outgoing_packet, (uint8_t*) &packet_header->data, iter );
+        if ( result != CY_RSLT_SUCCESS )
+        {
+            return result;
+        }
+        cy_wps_record_phase( workspace, CY_WPS_PHASE_MESSAGE_SENT, wps_states[workspace->agent_type][workspace->current_sub_stage].outgoing_message_type );
     }
 
     return CY_RSLT_SUCCESS;
@@ -681,12 +769,12 @@ cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Free host pkt\r\n");
 
 static uint8_t* cy_wps_write_common_header(cy_wps_agent_t* workspace, uint8_t* start_of_packet, uint8_t message_type)
 {
-    uint8_t version           = WPS_VERSION;
     uint8_t temp_message_type = message_type;
 
     // Write the version and message type
     uint8_t* iter = start_of_packet;
-    iter = tlv_write_value( iter, WPS_ID_VERSION,  WPS_ID_VERSION_S,  &version,           TLV_UINT8 );
+    memcpy( iter, &workspace->tx_templates.version, sizeof(tlv16_uint8_t) );
+    iter += sizeof(tlv16_uint8_t);
     iter = tlv_write_value( iter, WPS_ID_MSG_TYPE, WPS_ID_MSG_TYPE_S, &temp_message_type, TLV_UINT8 );
 
     // Write their nonce (if we have it)
@@ -698,36 +786,47 @@ static uint8_t* cy_wps_write_common_header(cy_wps_agent_t* workspace, uint8_t* s
     return iter;
 }
 
-static void cy_wps_send_protocol_message(cy_wps_agent_t* workspace, cy_packet_t* packet, uint8_t* start_of_packet, uint8_t* iter)
+static cy_rslt_t cy_wps_send_protocol_message(cy_wps_agent_t* workspace, cy_packet_t* packet, uint8_t* start_of_packet, uint8_t* iter)
 {
     cy_wps_hash_t hmac_output;
     uint16_t eap_length;
     cy_wps_msg_packet_t* packet_header;
     uint16_t aligned_length;
-    uint32_t aligned_vendor_type;
 
     // Check if we have auth key
     if ( ( workspace->available_crypto_material & CY_WPS_CRYPTO_MATERIAL_AUTH_KEY ) != 0 )
     {
         /* Calculate and add HMAC. The HMAC should have been started with the processing of the previous message */
         cy_sha2_hmac_update( &workspace->hmac, start_of_packet, (uint32_t)( iter - start_of_packet ) );
-        cy_sha2_hmac_finish( &workspace->hmac, (unsigned char*) &hmac_output );
+        cy_sha2_hmac_finish_with_key( &workspace->hmac, &workspace->auth_key_hmac, (unsigned char*) &hmac_output );
         iter = tlv_write_value( iter, WPS_ID_AUTHENTICATOR, SIZE_64_BITS, &hmac_output, TLV_UINT8_PTR );
 
         /* Start calculating the authenticator for the next message */
-        cy_sha2_hmac_starts( &workspace->hmac, (unsigned char*) &workspace->auth_key, SIZE_256_BITS, WPS_HASH_ALGO );
+        cy_sha2_hmac_starts_with_key( &workspace->hmac, &workspace->auth_key_hmac );
         cy_sha2_hmac_update( &workspace->hmac, start_of_packet, (uint32_t)( iter - start_of_packet ) );
     }
     else
     {
         /* We should only get here when the agent is an enrollee and is sending M1
-         * Create a copy of the message so it can be used to verify the M2 HMAC when we receive their nonce and public key */
-        if ( workspace->m1_copy != NULL )
+         * Keep the bytes as sent so they can be used to verify the M2 HMAC when we receive their nonce and public key.
+         * A retransmitted M1 has the same length and reuses the copy. Without the copy M2 cannot be verified, so M1 is not sent */
+        if ( ( workspace->m1_copy != NULL ) && ( workspace->m1_copy_length != (uint16_t)( iter - start_of_packet ) ) )
         {
             cy_wps_free( workspace->m1_copy );
+            workspace->m1_copy = NULL;
         }
         workspace->m1_copy_length = (uint16_t)( iter - start_of_packet );
-        workspace->m1_copy = (uint8_t*) cy_wps_malloc( "wps m1 copy", workspace->m1_copy_length );
+        if ( workspace->m1_copy == NULL )
+        {
+            workspace->m1_copy = (uint8_t*) cy_wps_malloc( "wps m1 copy", workspace->m1_copy_length );
+        }
+        if ( workspace->m1_copy == NULL )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to allocate the copy of M1\r\n");
+            workspace->m1_copy_length = 0;
+            whd_buffer_release( workspace->interface->whd_driver, (whd_buffer_t) packet, WHD_NETWORK_TX );
+            return CY_RSLT_WPS_ERROR_OUT_OF_MEMORY;
+        }
         memcpy( workspace->m1_copy, start_of_packet, workspace->m1_copy_length );
     }
 
@@ -740,11 +839,7 @@ static void cy_wps_send_protocol_message(cy_wps_agent_t* workspace, cy_packet_t*
     CY_WPS_HOST_WRITE_16_BE(&aligned_length, eap_length);
     packet_header->eap.length = aligned_length;
     packet_header->eap.type             = CY_EAP_TYPE_WPS;
-    packet_header->eap_expanded.flags   = 0;
-    packet_header->eap_expanded.op_code = 4; /* WSC message */
-    memcpy( packet_header->eap_expanded.vendor_id, WFA_VENDOR_EXT_ID, 3 );
-    CY_WPS_HOST_WRITE_32_BE(&aligned_vendor_type, 1);
-    packet_header->eap_expanded.vendor_type = aligned_vendor_type;
+    memcpy( &packet_header->eap_expanded, &workspace->tx_templates.eap_expanded, sizeof(cy_eap_expanded_header_t) ); /* WSC message */
 
     /* Send EAPOL frame */
     if ( ( workspace->current_main_stage != CY_WPS_CLOSING_EAP ) && ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT ) )
@@ -760,6 +855,8 @@ static void cy_wps_send_protocol_message(cy_wps_agent_t* workspace, cy_packet_t*
         }
     }
     cy_wps_send_eapol_packet( packet, workspace, CY_EAP_PACKET, &workspace->their_data.mac_address, eap_length );
+
+    return CY_RSLT_SUCCESS;
 }
 
 static cy_rslt_t cy_wps_calculate_kdk(cy_wps_agent_t* workspace)
@@ -779,7 +876,7 @@ static cy_rslt_t cy_wps_calculate_kdk(cy_wps_agent_t* workspace)
 
     nn_workspace.len  = 48;
     shared_secret.len = 48;
-    NN_ExpModMont( (NN_t*) &shared_secret, (NN_t*) &their_public_key, (NN_t*) &workspace->my_private_key, (NN_t*) &wps_prime, (NN_t*) &nn_workspace );
+    NN_ExpModMont( (NN_t*) &shared_secret, (NN_t*) &their_public_key, (NN_t*) &workspace->my_private_key, (NN_t*) &wps_prime, (NN_t*) &nn_workspace, workspace->nn_scratch );
 
     /* Compute the Diffie-Hellman key based on the shared secret */
     wps_NN_get( &shared_secret, (uint8_t*) nn_workspace.num );
@@ -798,6 +895,16 @@ static cy_rslt_t cy_wps_calculate_kdk(cy_wps_agent_t* workspace)
     memcpy( &workspace->key_wrap_key, &kdf_output.keys.key_wrap_key, sizeof(cy_key_wrap_key_t) );
     memcpy( &workspace->emsk,         &kdf_output.keys.emsk,         SIZE_256_BITS );
 
+    /* All further HMACs in this session are keyed with auth_key so hash the padded key only once */
+    cy_sha2_hmac_key_setup( &workspace->auth_key_hmac, (unsigned char*) &workspace->auth_key, SIZE_256_BITS, WPS_HASH_ALGO );
+
+    /* Expand key_wrap_key once for the encrypted settings of the remaining messages */
+    if ( cy_aes_cbc_context_init( &workspace->key_wrap_aes, workspace->key_wrap_key.octet, (SIZE_128_BITS * 8) ) != CY_RSLT_SUCCESS )
+    {
+        cy_sha2_hmac_key_free( &workspace->auth_key_hmac );
+        return CY_RSLT_WPS_ERROR_CRYPTO;
+    }
+
     workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_AUTH_KEY | CY_WPS_CRYPTO_MATERIAL_KEY_WRAP_KEY;
 
     return CY_RSLT_SUCCESS;
@@ -828,10 +935,23 @@ void cy_wps_init_workspace(cy_wps_agent_t* workspace)
     workspace->m1_copy                      = NULL;
     workspace->m1_copy_length               = 0;
 
+    /*
+     * Serialize the static headers and preallocate the TX buffers used for the rest of the session.
+     * cy_wps_init() zeroes a new workspace; a reused P2P workspace keeps the buffers still in its pool and is only topped up.
+     */
+    cy_wps_prepare_tx_templates( workspace );
+    cy_wps_refill_tx_buffer_pool( workspace, true );
+
     if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
     {
         cy_wps_enrollee_init( workspace );
     }
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+    else
+    {
+        cy_wps_registrar_init( workspace );
+    }
+#endif
 }
 
 void cy_wps_reset_workspace( cy_wps_agent_t* workspace, whd_interface_t interface )
@@ -852,12 +972,34 @@ void cy_wps_reset_workspace( cy_wps_agent_t* workspace, whd_interface_t interfac
     {
         cy_wps_enrollee_reset( workspace, interface );
     }
-
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+    else
+    {
+        cy_wps_registrar_reset( workspace );
+    }
+#endif
 
     cy_wps_prepare_workspace_crypto( workspace );
 }
 
 void cy_wps_prepare_workspace_crypto( cy_wps_agent_t* workspace )
+{
+    size_t      output_length = 0;
+
+    /* Public nonce generation */
+    cy_host_random_bytes( (uint8_t*) &workspace->my_data.nonce, SIZE_128_BITS, &output_length );
+
+    /* Public-Private key generation. Every session, including each session of the multi-enrollee registrar, gets
+     * its own key pair: a pair shared across the registrar's lifetime would let one leaked private key expose the
+     * DHKey, and so the credentials, of every session it was used in */
+    cy_wps_generate_dh_key_pair( &workspace->my_private_key, &workspace->my_data.public_key, workspace->nn_scratch );
+
+    /* Secret nonce generation */
+    cy_host_random_bytes( (uint8_t*) workspace->my_data.secret_nonce[0].nonce, SIZE_128_BITS, &output_length );
+    cy_host_random_bytes( (uint8_t*) workspace->my_data.secret_nonce[1].nonce, SIZE_128_BITS, &output_length );
+}
+
+void cy_wps_generate_dh_key_pair( cy_wps_NN_t* private_key, cy_public_key_t* public_key_output, uint32_t* nn_scratch )
 {
     cy_wps_NN_t wps_generator;
     cy_wps_NN_t wps_prime;
@@ -865,12 +1007,8 @@ void cy_wps_prepare_workspace_crypto( cy_wps_agent_t* workspace )
     cy_wps_NN_t public_key;
     size_t      output_length = 0;
 
-    /* Public nonce generation */
-    cy_host_random_bytes( (uint8_t*) &workspace->my_data.nonce, SIZE_128_BITS, &output_length );
-
-    /* Public-Private key generation */
-    workspace->my_private_key.len = PRIVATE_KEY_NN_LENGTH;
-    cy_host_random_bytes( (uint8_t*) workspace->my_private_key.num, PRIVATE_KEY_BYTE_LENGTH, &output_length );
+    private_key->len = PRIVATE_KEY_NN_LENGTH;
+    cy_host_random_bytes( (uint8_t*) private_key->num, PRIVATE_KEY_BYTE_LENGTH, &output_length );
 
     // Create public key
     wps_generator.len = 48;
@@ -882,12 +1020,8 @@ void cy_wps_prepare_workspace_crypto( cy_wps_agent_t* workspace )
     calculation_workspace.len = 48;
 
     public_key.len = 48;
-    NN_ExpModMont( (NN_t*) &public_key, (NN_t*) &wps_generator, (NN_t*) &workspace->my_private_key, (NN_t*) &wps_prime, (NN_t*) &calculation_workspace );
-    wps_NN_get( &public_key, workspace->my_data.public_key.key );
-
-    /* Secret nonce generation */
-    cy_host_random_bytes( (uint8_t*) workspace->my_data.secret_nonce[0].nonce, SIZE_128_BITS, &output_length );
-    cy_host_random_bytes( (uint8_t*) workspace->my_data.secret_nonce[1].nonce, SIZE_128_BITS, &output_length );
+    NN_ExpModMont( (NN_t*) &public_key, (NN_t*) &wps_generator, (NN_t*) private_key, (NN_t*) &wps_prime, (NN_t*) &calculation_workspace, nn_scratch );
+    wps_NN_get( &public_key, public_key_output->key );
 }
 
 static cy_rslt_t cy_wps_calculate_hash(cy_wps_agent_t* workspace, cy_wps_agent_data_t* source, cy_wps_hash_t* output, uint8_t hash)
@@ -901,7 +1035,7 @@ static cy_rslt_t cy_wps_calculate_hash(cy_wps_agent_t* workspace, cy_wps_agent_d
     memcpy( &hash_input.enrollee_public_key,  &workspace->enrollee_data->public_key,  sizeof(cy_public_key_t) );
     memcpy( &hash_input.registrar_public_key, &workspace->registrar_data->public_key, sizeof(cy_public_key_t) );
 
-    cy_sha2_hmac( (unsigned char *)&workspace->auth_key, SIZE_256_BITS, (uint8_t*) &hash_input, sizeof( hash_input ), output->octet, WPS_HASH_ALGO );
+    cy_sha2_hmac_with_key( &workspace->auth_key_hmac, (uint8_t*) &hash_input, sizeof( hash_input ), output->octet );
 
     return CY_RSLT_SUCCESS;
 }
@@ -914,12 +1048,12 @@ static cy_rslt_t cy_wps_calculate_psk(cy_wps_agent_t* workspace)
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS password %s\r\n", workspace->password);
 
     /* Hash 1st half of password and copy first 128 bits into psk1. If it is an odd length, the extra byte goes along with the first half */
-    cy_sha2_hmac( (unsigned char *)&workspace->auth_key, SIZE_256_BITS, (uint8_t*) workspace->password, (uint32_t) ( ( password_length / 2 ) + ( password_length % 2 ) ), (uint8_t*) &hmac_output, WPS_HASH_ALGO );
+    cy_sha2_hmac_with_key( &workspace->auth_key_hmac, (uint8_t*) workspace->password, (uint32_t) ( ( password_length / 2 ) + ( password_length % 2 ) ), (uint8_t*) &hmac_output );
 
     memcpy( &workspace->psk[0], &hmac_output, SIZE_128_BITS );
 
     /* Hash 2nd half of password and copy fist 128 bits into psk2 */
-    cy_sha2_hmac( (unsigned char *)&workspace->auth_key, SIZE_256_BITS, (uint8_t*) ( workspace->password + ( password_length / 2 ) + ( password_length % 2 ) ), password_length / 2, (uint8_t*) &hmac_output, WPS_HASH_ALGO );
+    cy_sha2_hmac_with_key( &workspace->auth_key_hmac, (uint8_t*) ( workspace->password + ( password_length / 2 ) + ( password_length % 2 ) ), password_length / 2, (uint8_t*) &hmac_output );
 
     memcpy( &workspace->psk[1], &hmac_output, SIZE_128_BITS );
 
@@ -936,193 +1070,196 @@ static cy_rslt_t cy_wps_process_message_content( cy_wps_agent_t* workspace, uint
     uint32_t              valid_tlv_mask = wps_states[workspace->agent_type][workspace->current_sub_stage].tlv_mask;
     cy_wps_encryption_data_t* encrypted_data = NULL;
     uint8_t*              authenticator  = NULL;
+    tlv_index_t           tlv_index;
 
     /* Note that the P2P registrar can't do the overlap check for p2p clients because they can change their MAC address between sending the probe request and sending M1 */
     if ( ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT) && ( workspace->wps_mode == CY_WPS_PBC_MODE ) && ( workspace->is_p2p_registrar == 0 ) &&
-         ( cy_wps_pbc_overlap_check( &workspace->their_data.mac_address ) == CY_RSLT_WPS_PBC_OVERLAP ) )
+         ( workspace->is_multi_enrollee_registrar == 0 ) && ( cy_wps_pbc_overlap_check( &workspace->their_data.mac_address ) == CY_RSLT_WPS_PBC_OVERLAP ) )
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "PBC overlap during message processing\r\n");
         workspace->wps_result = CY_RSLT_WPS_PBC_OVERLAP;
         return CY_RSLT_WPS_PBC_OVERLAP;
     }
 
-    /* Process TLVs contained in message */
-    for ( tlv = (tlv16_data_t*) content; ( (uint8_t*) tlv - content ) < content_length; tlv = (tlv16_data_t*) ( (uint8_t*) tlv + sizeof(tlv16_header_t) + cy_hton16(tlv->length) ) )
+    /* Locate all the attributes of interest with a single pass over the message. No message carries all of them,
+     * so the pass always walks the whole message: every attribute present has to be checked, not only the
+     * ones required by tlv_mask */
+    tlv_build_index16( &tlv_index, content, content_length, message_tlv_id, CY_WPS_TLV_SLOT_COUNT );
+
+    /* The X509 certificate and vendor extension are optional and the MAC address is only consumed by the registrar */
+    parsed_tlvs = tlv_index.found_mask & ~( (uint32_t) ( CY_WPS_TLV_X509_CERT | CY_WPS_TLV_VENDOR_EXT ) | ( 1UL << CY_WPS_TLV_SLOT_MAC_ADDR ) );
+    if ( ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT ) && ( ( tlv_index.found_mask & ( 1UL << CY_WPS_TLV_SLOT_MAC_ADDR ) ) != 0 ) )
     {
-#if 1
-        tlv16_header_t temp_tlv;
-        tlv16_header_t* aligned_tlv = &temp_tlv;
-        memcpy(aligned_tlv, tlv, sizeof(tlv16_header_t));
-#else
-#define aligned_tlv     tlv
-#endif
-        switch ( cy_hton16(aligned_tlv->type) )
-        {
-            case WPS_ID_VERSION:
-                parsed_tlvs |= CY_WPS_TLV_VERSION;
-                if ( ( tlv->data[0] & 0xF0 ) != WPS_VERSION )
-                {
-                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS version mismatch\r\n");
-                    return CY_RSLT_WPS_ERROR_VERSION_MISMATCH;
-                }
-                break;
+        parsed_tlvs |= CY_WPS_TLV_MAC_ADDR;
+    }
 
-            case WPS_ID_ENROLLEE_NONCE:
-                parsed_tlvs |= CY_WPS_TLV_ENROLLEE_NONCE;
-                workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_NONCE;
-                if ( (valid_tlv_mask & CY_WPS_TLV_ENROLLEE_NONCE) != 0 )
-                {
-                    if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
-                    {
-                        if ( memcmp( &workspace->enrollee_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) ) != 0 )
-                        {
-                            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS enrollee nonce mismatch\r\n");
-                            return CY_RSLT_WPS_ERROR_ENROLLEE_NONCE_MISMATCH;
-                        }
-                    }
-                    else if ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT )
-                    {
-                        memcpy( &workspace->enrollee_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) );
-                    }
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_VERSION );
+    if ( ( tlv != NULL ) && ( ( tlv->data[0] & 0xF0 ) != WPS_VERSION ) )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS version mismatch\r\n");
+        return CY_RSLT_WPS_ERROR_VERSION_MISMATCH;
+    }
 
-            case WPS_ID_REGISTRAR_NONCE:
-                parsed_tlvs |= CY_WPS_TLV_REGISTRAR_NONCE;
-                workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_REGISTRAR_NONCE;
-                if (( valid_tlv_mask & CY_WPS_TLV_REGISTRAR_NONCE ) != 0 )
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_ENROLLEE_NONCE );
+    if ( tlv != NULL )
+    {
+        workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_NONCE;
+        if ( (valid_tlv_mask & CY_WPS_TLV_ENROLLEE_NONCE) != 0 )
+        {
+            if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
+            {
+                if ( memcmp( &workspace->enrollee_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) ) != 0 )
                 {
-                    if ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT )
-                    {
-                        if ( memcmp( &workspace->registrar_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) ) != 0 )
-                        {
-                            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS registrar nonce mismatch\r\n");
-                            return CY_RSLT_WPS_ERROR_REGISTRAR_NONCE_MISMATCH;
-                        }
-                    }
-                    else if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
-                    {
-                        memcpy( &workspace->registrar_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) );
-                    }
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS enrollee nonce mismatch\r\n");
+                    return CY_RSLT_WPS_ERROR_ENROLLEE_NONCE_MISMATCH;
                 }
-                break;
+            }
+            else if ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT )
+            {
+                memcpy( &workspace->enrollee_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) );
+            }
+        }
+    }
 
-            case WPS_ID_E_HASH1:
-                parsed_tlvs |= CY_WPS_TLV_E_HASH1;
-                workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_HASH1;
-                if (( valid_tlv_mask & CY_WPS_TLV_E_HASH1 ) != 0 )
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_REGISTRAR_NONCE );
+    if ( tlv != NULL )
+    {
+        workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_REGISTRAR_NONCE;
+        if (( valid_tlv_mask & CY_WPS_TLV_REGISTRAR_NONCE ) != 0 )
+        {
+            if ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT )
+            {
+                if ( memcmp( &workspace->registrar_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) ) != 0 )
                 {
-                    memcpy( &workspace->enrollee_data->secret_hash[0], tlv->data, sizeof(cy_wps_hash_t) );
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS registrar nonce mismatch\r\n");
+                    return CY_RSLT_WPS_ERROR_REGISTRAR_NONCE_MISMATCH;
                 }
-                break;
+            }
+            else if ( workspace->agent_type == CY_WPS_ENROLLEE_AGENT )
+            {
+                memcpy( &workspace->registrar_data->nonce, tlv->data, sizeof(cy_wps_nonce_t) );
+            }
+        }
+    }
 
-            case WPS_ID_E_HASH2:
-                parsed_tlvs |= CY_WPS_TLV_E_HASH2;
-                workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_HASH2;
-                if ( (valid_tlv_mask & CY_WPS_TLV_E_HASH2) != 0 )
-                {
-                    memcpy( &workspace->enrollee_data->secret_hash[1], tlv->data, sizeof(cy_wps_hash_t) );
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_E_HASH1 );
+    if ( tlv != NULL )
+    {
+        workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_HASH1;
+        if (( valid_tlv_mask & CY_WPS_TLV_E_HASH1 ) != 0 )
+        {
+            memcpy( &workspace->enrollee_data->secret_hash[0], tlv->data, sizeof(cy_wps_hash_t) );
+        }
+    }
 
-            case WPS_ID_R_HASH1:
-                parsed_tlvs |= CY_WPS_TLV_R_HASH1;
-                workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_REGISTRAR_HASH1;
-                if ( (valid_tlv_mask & CY_WPS_TLV_R_HASH1) != 0 )
-                {
-                    memcpy( &workspace->registrar_data->secret_hash[0], tlv->data, sizeof(cy_wps_hash_t) );
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_E_HASH2 );
+    if ( tlv != NULL )
+    {
+        workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_HASH2;
+        if ( (valid_tlv_mask & CY_WPS_TLV_E_HASH2) != 0 )
+        {
+            memcpy( &workspace->enrollee_data->secret_hash[1], tlv->data, sizeof(cy_wps_hash_t) );
+        }
+    }
 
-            case WPS_ID_R_HASH2:
-                parsed_tlvs |= CY_WPS_TLV_R_HASH2;
-                workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_REGISTRAR_HASH2;
-                if ( (valid_tlv_mask & CY_WPS_TLV_R_HASH2 )!= 0 )
-                {
-                    memcpy( &workspace->registrar_data->secret_hash[1], tlv->data, sizeof(cy_wps_hash_t) );
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_R_HASH1 );
+    if ( tlv != NULL )
+    {
+        workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_REGISTRAR_HASH1;
+        if ( (valid_tlv_mask & CY_WPS_TLV_R_HASH1) != 0 )
+        {
+            memcpy( &workspace->registrar_data->secret_hash[0], tlv->data, sizeof(cy_wps_hash_t) );
+        }
+    }
 
-            case WPS_ID_ENCR_SETTINGS:
-                parsed_tlvs |= CY_WPS_TLV_ENCRYPTION_SETTINGS;
-                if ( cy_hton16(aligned_tlv->length) >= sizeof(cy_wps_iv_t) + WPS_ENCRYPTION_BLOCK_SIZE )
-                {
-                    encrypted_data        = (cy_wps_encryption_data_t*) tlv->data;
-                    encrypted_data_length = (uint16_t) ( cy_hton16(aligned_tlv->length) - sizeof(cy_wps_iv_t) );
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_R_HASH2 );
+    if ( tlv != NULL )
+    {
+        workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_REGISTRAR_HASH2;
+        if ( (valid_tlv_mask & CY_WPS_TLV_R_HASH2 )!= 0 )
+        {
+            memcpy( &workspace->registrar_data->secret_hash[1], tlv->data, sizeof(cy_wps_hash_t) );
+        }
+    }
 
-            case WPS_ID_AUTHENTICATOR:
-                parsed_tlvs |= CY_WPS_TLV_AUTHENTICATOR;
-                authenticator = tlv->data;
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_ENCRYPTION_SETTINGS );
+    if ( ( tlv != NULL ) && ( tlv_index_get_length( &tlv_index, CY_WPS_TLV_SLOT_ENCRYPTION_SETTINGS ) >= sizeof(cy_wps_iv_t) + WPS_ENCRYPTION_BLOCK_SIZE ) )
+    {
+        encrypted_data        = (cy_wps_encryption_data_t*) tlv->data;
+        encrypted_data_length = (uint16_t) ( tlv_index_get_length( &tlv_index, CY_WPS_TLV_SLOT_ENCRYPTION_SETTINGS ) - sizeof(cy_wps_iv_t) );
+    }
 
-            case WPS_ID_AUTH_TYPE_FLAGS:
-                parsed_tlvs |= CY_WPS_TLV_AUTH_TYPE_FLAGS;
-                workspace->their_data.authTypeFlags = CY_WPS_HOST_READ_16_BE(tlv->data);
-                if ( ( workspace->their_data.authTypeFlags & workspace->my_data.authTypeFlags ) == 0 )
-                {
-                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS authentication type not supported\r\n");
-                    return CY_RSLT_WPS_ERROR_AUTHENTICATION_TYPE_ERROR;
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_AUTHENTICATOR );
+    if ( tlv != NULL )
+    {
+        authenticator = tlv->data;
+    }
 
-            case WPS_ID_ENCR_TYPE_FLAGS:
-                parsed_tlvs |= CY_WPS_TLV_ENCR_TYPE_FLAGS;
-                workspace->their_data.encrTypeFlags = CY_WPS_HOST_READ_16_BE(tlv->data);
-                if ( ( workspace->their_data.encrTypeFlags & workspace->my_data.encrTypeFlags ) == 0 )
-                {
-                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS encryption type not supported\r\n");
-                    return CY_RSLT_WPS_ERROR_ENCRYPTION_TYPE_ERROR;
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_AUTH_TYPE_FLAGS );
+    if ( tlv != NULL )
+    {
+        workspace->their_data.authTypeFlags = CY_WPS_HOST_READ_16_BE(tlv->data);
+        if ( ( workspace->their_data.authTypeFlags & workspace->my_data.authTypeFlags ) == 0 )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS authentication type not supported\r\n");
+            return CY_RSLT_WPS_ERROR_AUTHENTICATION_TYPE_ERROR;
+        }
+    }
 
-            case WPS_ID_MAC_ADDR:
-                if (workspace->agent_type == CY_WPS_REGISTRAR_AGENT)
-                {
-                    parsed_tlvs |= CY_WPS_TLV_MAC_ADDR;
-                    workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_MAC_ADDRESS;
-                    memcpy(&workspace->enrollee_data->mac_address, tlv->data, sizeof(whd_mac_t));
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_ENCR_TYPE_FLAGS );
+    if ( tlv != NULL )
+    {
+        workspace->their_data.encrTypeFlags = CY_WPS_HOST_READ_16_BE(tlv->data);
+        if ( ( workspace->their_data.encrTypeFlags & workspace->my_data.encrTypeFlags ) == 0 )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS encryption type not supported\r\n");
+            return CY_RSLT_WPS_ERROR_ENCRYPTION_TYPE_ERROR;
+        }
+    }
 
-            case WPS_ID_UUID_R:
-                parsed_tlvs |= CY_WPS_TLV_UUID_R;
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_MAC_ADDR );
+    if ( ( tlv != NULL ) && ( workspace->agent_type == CY_WPS_REGISTRAR_AGENT ) )
+    {
+        workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_ENROLLEE_MAC_ADDRESS;
+        memcpy(&workspace->enrollee_data->mac_address, tlv->data, sizeof(whd_mac_t));
+    }
 
-            case WPS_ID_PUBLIC_KEY:
-                parsed_tlvs |= CY_WPS_TLV_PUBLIC_KEY;
-                workspace->available_crypto_material |= (workspace->agent_type == CY_WPS_ENROLLEE_AGENT) ? CY_WPS_CRYPTO_MATERIAL_ENROLLEE_PUBLIC_KEY : CY_WPS_CRYPTO_MATERIAL_REGISTRAR_PUBLIC_KEY;
-                memcpy( &workspace->their_data.public_key, tlv->data, sizeof(cy_public_key_t) );
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_PUBLIC_KEY );
+    if ( tlv != NULL )
+    {
+        workspace->available_crypto_material |= (workspace->agent_type == CY_WPS_ENROLLEE_AGENT) ? CY_WPS_CRYPTO_MATERIAL_ENROLLEE_PUBLIC_KEY : CY_WPS_CRYPTO_MATERIAL_REGISTRAR_PUBLIC_KEY;
+        memcpy( &workspace->their_data.public_key, tlv->data, sizeof(cy_public_key_t) );
+    }
 
-            case WPS_ID_MSG_TYPE:
-                parsed_tlvs |= CY_WPS_TLV_MSG_TYPE;
-                if (*(tlv->data) == WPS_MESSAGE_TYPE_M1)
-                {
-                    // Catchall for Enrollees that don't include the WPS element in their Probe Request, add their MAC address to the overlap array
-                    if ( ( workspace->wps_mode == CY_WPS_PBC_MODE) && ( workspace->is_p2p_registrar == 0 ) && ( workspace->is_p2p_enrollee == 0 ) )
-                    {
-                        cy_wps_update_pbc_overlap_array( workspace, &workspace->their_data.mac_address );
-                    }
-                }
-                break;
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_MSG_TYPE );
+    if ( ( tlv != NULL ) && ( *(tlv->data) == WPS_MESSAGE_TYPE_M1 ) )
+    {
+        // Catchall for Enrollees that don't include the WPS element in their Probe Request, add their MAC address to the overlap array
+        if ( ( workspace->wps_mode == CY_WPS_PBC_MODE) && ( workspace->is_p2p_registrar == 0 ) && ( workspace->is_p2p_enrollee == 0 ) )
+        {
+            cy_wps_update_pbc_overlap_array( workspace, &workspace->their_data.mac_address );
+        }
+    }
 
-            case WPS_ID_X509_CERT:
-                /* XXX: Add X509 certificate support */
-                break;
+    /* XXX: Add X509 certificate support */
 
-            case WPS_ID_VENDOR_EXT:
-                if ( memcmp( tlv->data, WFA_VENDOR_EXT_ID, 3 ) == 0 )
-                {
-                    tlv8_uint8_t* tlv8 = (tlv8_uint8_t*) tlv_find_tlv8( &tlv->data[3], (uint32_t)( aligned_tlv->length - 3 ), WPS_WFA_SUBID_VERSION2 );
-                    if ((tlv8 != NULL) && (workspace->their_data.supported_version == 0 ))
-                    {
-                        workspace->their_data.supported_version = tlv8->data;
-                    }
-                }
-                break;
+    /* Only the first vendor extension is indexed. Keep searching if it is not the WFA one */
+    tlv = (tlv16_data_t*) tlv_index_get( &tlv_index, CY_WPS_TLV_SLOT_VENDOR_EXT );
+    while ( tlv != NULL )
+    {
+        uint16_t tlv_length = CY_WPS_HOST_READ_16_BE( (uint8_t*) &tlv->length );
+        uint8_t* next_tlv   = tlv->data + tlv_length;
+
+        if ( ( tlv_length >= 3 ) && ( memcmp( tlv->data, WFA_VENDOR_EXT_ID, 3 ) == 0 ) )
+        {
+            tlv8_uint8_t* tlv8 = (tlv8_uint8_t*) tlv_find_tlv8( &tlv->data[3], (uint32_t)( tlv_length - 3 ), WPS_WFA_SUBID_VERSION2 );
+            if ((tlv8 != NULL) && (workspace->their_data.supported_version == 0 ))
+            {
+                workspace->their_data.supported_version = tlv8->data;
+            }
+            break;
         }
+        tlv = tlv_find_tlv16( next_tlv, (uint32_t) ( content_length - ( next_tlv - content ) ), WPS_ID_VENDOR_EXT );
     }
 
     if ( parsed_tlvs != tlv_mask )
@@ -1135,7 +1272,11 @@ static cy_rslt_t cy_wps_process_message_content( cy_wps_agent_t* workspace, uint
     if (((workspace->available_crypto_material & CY_WPS_CRYPTO_MATERIAL_AUTH_KEY) == 0) &&
         (workspace->available_crypto_material & KDK_REQUIRED_CRYPTO_MATERIAL) == KDK_REQUIRED_CRYPTO_MATERIAL)
     {
-        cy_wps_calculate_kdk(workspace);
+        result = cy_wps_calculate_kdk(workspace);
+        if ( result != CY_RSLT_SUCCESS )
+        {
+            return result;
+        }
         cy_wps_calculate_psk(workspace);
 
         /* Should now be able to calculate my hashes as well */
@@ -1146,7 +1287,7 @@ static cy_rslt_t cy_wps_process_message_content( cy_wps_agent_t* workspace, uint
                                                 CY_WPS_CRYPTO_MATERIAL_ENROLLEE_HASH1 | CY_WPS_CRYPTO_MATERIAL_ENROLLEE_HASH2 :
                                                 CY_WPS_CRYPTO_MATERIAL_REGISTRAR_HASH1 | CY_WPS_CRYPTO_MATERIAL_REGISTRAR_HASH2;
         /* Prepare the hmac for use */
-    cy_sha2_hmac_starts( &workspace->hmac, (unsigned char*) &workspace->auth_key, SIZE_256_BITS, WPS_HASH_ALGO );
+    cy_sha2_hmac_starts_with_key( &workspace->hmac, &workspace->auth_key_hmac );
 
     }
 
@@ -1167,7 +1308,7 @@ static cy_rslt_t cy_wps_process_message_content( cy_wps_agent_t* workspace, uint
             workspace->m1_copy_length = 0;
         }
         cy_sha2_hmac_update( &workspace->hmac, content, content_length - sizeof(tlv16_header_t) - WPS_AUTHENTICATOR_LEN );
-        cy_sha2_hmac_finish( &workspace->hmac, (unsigned char*) &hmac_output );
+        cy_sha2_hmac_finish_with_key( &workspace->hmac, &workspace->auth_key_hmac, (unsigned char*) &hmac_output );
         if ( memcmp( &hmac_output, authenticator, WPS_AUTHENTICATOR_LEN ) != 0 )
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Message HMAC error\r\n");
@@ -1179,7 +1320,7 @@ static cy_rslt_t cy_wps_process_message_content( cy_wps_agent_t* workspace, uint
         }
 
         /* Start the HMAC calculation for next message */
-        cy_sha2_hmac_starts  ( &workspace->hmac, (unsigned char*) &workspace->auth_key, SIZE_256_BITS, WPS_HASH_ALGO );
+        cy_sha2_hmac_starts_with_key( &workspace->hmac, &workspace->auth_key_hmac );
         cy_sha2_hmac_update( &workspace->hmac, content, content_length );
     }
 
@@ -1207,7 +1348,7 @@ static cy_rslt_t cy_wps_process_encrypted_tlvs( cy_wps_agent_t* workspace, cy_wp
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Processing encrypted TLV\r\n");
 
     /* Decrypt the encrypted data */
-    plain_text_length = cy_wps_decrypt_data( encrypted_data, encrypted_data_length, &workspace->key_wrap_key, plain_text );
+    plain_text_length = cy_wps_decrypt_data( encrypted_data, encrypted_data_length, &workspace->key_wrap_aes, plain_text );
 
     /* Find the key wrap auth element */
     if ( plain_text_length > 0 )
@@ -1221,7 +1362,7 @@ static cy_rslt_t cy_wps_process_encrypted_tlvs( cy_wps_agent_t* workspace, cy_wp
     }
 
     /* Calculate the HMAC of the data (data only, not the last auth TLV) and compare it against the received HMAC */
-    cy_sha2_hmac( (unsigned char *)&workspace->auth_key, SIZE_256_BITS, plain_text, (uint32_t) plain_text_length - sizeof(tlv16_header_t) - SIZE_64_BITS, (uint8_t*) &hmac_output, WPS_HASH_ALGO );
+    cy_sha2_hmac_with_key( &workspace->auth_key_hmac, plain_text, (uint32_t) plain_text_length - sizeof(tlv16_header_t) - SIZE_64_BITS, (uint8_t*) &hmac_output );
 
     if ( memcmp( &hmac_output, key_wrap_auth->data, SIZE_64_BITS ) != 0 )
     {
@@ -1419,6 +1560,7 @@ static cy_rslt_t cy_wps_calculate_kdf(uint8_t* key, uint16_t key_length, char* p
     uint16_t string_length;
     uint8_t input[4 + MAX_PERSONALIZATION_STRING_SIZE + 4];
     cy_wps_hash_t* hmac_output = (cy_wps_hash_t*) output;
+    cy_sha2_hmac_key_t hmac_key;
 
     iterations = output_length / PRF_DIGEST_SIZE;
 
@@ -1429,33 +1571,39 @@ static cy_rslt_t cy_wps_calculate_kdf(uint8_t* key, uint16_t key_length, char* p
     temp = cy_hton32( (uint32_t)( output_length * 8 ) );
     memcpy( &input[4 + string_length], &temp, 4 );
 
+    /* Every iteration uses the same key */
+    cy_sha2_hmac_key_setup( &hmac_key, key, key_length, WPS_HASH_ALGO );
+
     for ( i = 0; i < iterations; i++ )
     {
         /* Set the current value of i at the start of the input buffer */
         temp = cy_hton32( i + 1 ); /* i should start at 1 */
         memcpy( &input[0], &temp, 4 );
-        cy_sha2_hmac( key, key_length, input, (uint32_t)( 4 + string_length + 4 ), (uint8_t*) &hmac_output[i], WPS_HASH_ALGO );
+        cy_sha2_hmac_with_key( &hmac_key, input, (uint32_t)( 4 + string_length + 4 ), (uint8_t*) &hmac_output[i] );
     }
 
+    cy_sha2_hmac_key_free( &hmac_key );
+    memset( &hmac_key, 0, sizeof( hmac_key ) );
+
     return CY_RSLT_SUCCESS;
 }
 
 
-static void cy_wps_encrypt_data(uint8_t* input, uint16_t input_length, cy_key_wrap_key_t* encr_key, uint8_t* output, cy_wps_iv_t* iv)
+static void cy_wps_encrypt_data(uint8_t* input, uint16_t input_length, cy_aes_cbc_context_t* encr_ctx, uint8_t* output, cy_wps_iv_t* iv)
 {
     size_t output_length;
 
     /* Generate a random iv */
     cy_host_random_bytes( iv->octet, SIZE_128_BITS, &output_length );
 
-    cy_aes_cbc_encrypt( input, input_length, output, encr_key->octet, (SIZE_128_BITS * 8), iv->octet );
+    cy_aes_cbc_encrypt_with_context( encr_ctx, input, input_length, output, iv->octet );
 }
 
 /* Note: plain_text can point to the encryption_data->data */
-static int cy_wps_decrypt_data(cy_wps_encryption_data_t* encrypted_data, uint16_t encrypted_data_length, cy_key_wrap_key_t* encr_key, uint8_t* plain_text)
+static int cy_wps_decrypt_data(cy_wps_encryption_data_t* encrypted_data, uint16_t encrypted_data_length, cy_aes_cbc_context_t* encr_ctx, uint8_t* plain_text)
 {
     uint32_t output_length;
-    cy_aes_cbc_decrypt( encrypted_data->data, encrypted_data_length, plain_text, &output_length, encr_key->octet, (SIZE_128_BITS * 8), encrypted_data->iv );
+    cy_aes_cbc_decrypt_with_context( encr_ctx, encrypted_data->data, encrypted_data_length, plain_text, &output_length, encrypted_data->iv );
 
     return output_length;
 }
@@ -1689,7 +1837,7 @@ static uint8_t* cy_wps_end_encrypted_tlv( cy_wps_agent_t* workspace, uint8_t* st
     uint16_t encrypted_size;
 
     /* Hash existing content */
-    cy_sha2_hmac( (unsigned char *)&workspace->auth_key, SIZE_256_BITS, start_of_data, data_length, (uint8_t*) &hmac_output, WPS_HASH_ALGO );
+    cy_sha2_hmac_with_key( &workspace->auth_key_hmac, start_of_data, data_length, (uint8_t*) &hmac_output );
 
     /* Append a key wrap auth TLV */
     end_of_data = tlv_write_value( end_of_data, WPS_ID_KEY_WRAP_AUTH, SIZE_64_BITS, &hmac_output, TLV_UINT8_PTR );
@@ -1697,7 +1845,7 @@ static uint8_t* cy_wps_end_encrypted_tlv( cy_wps_agent_t* workspace, uint8_t* st
 
     /* Encrypt the entire block and put the IV at the right spot */
     encrypted_size = (uint16_t) WPS_PADDED_AES_ROUND_UP(data_length, AES_BLOCK_SZ);
-    cy_wps_encrypt_data( start_of_data, data_length, &workspace->key_wrap_key, start_of_data, (cy_wps_iv_t*)(start_of_encrypted_tlv_header + sizeof(tlv16_header_t)) );
+    cy_wps_encrypt_data( start_of_data, data_length, &workspace->key_wrap_aes, start_of_data, (cy_wps_iv_t*)(start_of_encrypted_tlv_header + sizeof(tlv16_header_t)) );
 
     /* Fill in the TLV header reserved at the start by wps_start_encrypted_tlv() */
     header->type   = cy_hton16(WPS_ID_ENCR_SETTINGS);
@@ -1721,6 +1869,7 @@ void cy_wps_deinit_workspace( cy_wps_agent_t* workspace )
     }
 
     cy_wps_cleanup_workspace( workspace );
+    cy_wps_release_tx_buffer_pool( workspace );
 }
 
 static void cy_wps_cleanup_workspace( cy_wps_agent_t* workspace )
@@ -1731,6 +1880,19 @@ static void cy_wps_cleanup_workspace( cy_wps_agent_t* workspace )
         workspace->m1_copy = NULL;
     }
 
+    if ( ( workspace->available_crypto_material & CY_WPS_CRYPTO_MATERIAL_AUTH_KEY ) != 0 )
+    {
+        cy_sha2_hmac_key_free( &workspace->auth_key_hmac );
+        memset( &workspace->auth_key_hmac, 0, sizeof( workspace->auth_key_hmac ) );
+        workspace->available_crypto_material &= ~( (uint32_t) CY_WPS_CRYPTO_MATERIAL_AUTH_KEY );
+    }
+
+    if ( ( workspace->available_crypto_material & CY_WPS_CRYPTO_MATERIAL_KEY_WRAP_KEY ) != 0 )
+    {
+        cy_aes_cbc_context_free( &workspace->key_wrap_aes );
+        workspace->available_crypto_material &= ~( (uint32_t) CY_WPS_CRYPTO_MATERIAL_KEY_WRAP_KEY );
+    }
+
     cy_wps_free_unfragmented_packet( workspace );
 }
 
@@ -1877,13 +2039,15 @@ static uint32_t cy_wps_send_frag_ack( cy_wps_agent_t* workspace )
     cy_packet_t packet;
     cy_wps_msg_packet_header_t* header;
     uint16_t aligned_length;
-    uint32_t aligned_vendor_type;
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Sending frag ACK\r\n");
 
     /* Create the packet and write the EAP header */
-    whd_host_buffer_get( workspace->interface->whd_driver, &packet, WHD_NETWORK_TX, 1024 + WHD_LINK_HEADER, true );
-    whd_buffer_add_remove_at_front( workspace->interface->whd_driver, &packet, WHD_LINK_HEADER );
+    packet = cy_wps_get_tx_buffer( workspace );
+    if ( packet == NULL )
+    {
+        return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
+    }
 
     header = (cy_wps_msg_packet_header_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, packet );
 
@@ -1900,13 +2064,11 @@ static uint32_t cy_wps_send_frag_ack( cy_wps_agent_t* workspace )
     header->eap.length = aligned_length;
     header->eap.type   = CY_EAP_TYPE_WPS;
 
-    header->eap_expanded.flags       = 0;
+    memcpy( &header->eap_expanded, &workspace->tx_templates.eap_expanded, sizeof(cy_eap_expanded_header_t) );
     header->eap_expanded.op_code     = 6;
-    CY_WPS_HOST_WRITE_32_BE(&aligned_vendor_type, 1);
-    header->eap_expanded.vendor_type = aligned_vendor_type;
-    memcpy( header->eap_expanded.vendor_id, WFA_VENDOR_EXT_ID, 3 );
 
     cy_wps_send_eapol_packet( packet, workspace, CY_EAP_PACKET, &workspace->their_data.mac_address, sizeof(cy_eap_header_t) + sizeof(cy_eap_expanded_header_t) );
+    cy_wps_record_phase( workspace, CY_WPS_PHASE_FRAG_ACK_SENT, workspace->last_received_id );
     return CY_RSLT_SUCCESS;
 }
 
@@ -1925,21 +2087,25 @@ static uint8_t* cy_get_wps_packet_data(cy_wps_msg_packet_t* packet)
 
 cy_rslt_t cy_wps_send_basic_packet( cy_wps_agent_t* workspace, uint8_t type, uint16_t optional_config_error )
 {
-    uint8_t               version;
     cy_packet_t           packet;
     cy_wps_msg_packet_t*  packet_header;
     uint8_t*              iter;
     uint16_t              eap_length;
     uint16_t              aligned_length;
-    uint32_t              aligned_vendor_type;
 
     /* Create the packet */
-    whd_host_buffer_get( workspace->interface->whd_driver, &packet, WHD_NETWORK_TX, 1024 + WHD_LINK_HEADER, true );
-    whd_buffer_add_remove_at_front( workspace->interface->whd_driver, &packet, WHD_LINK_HEADER );
+    packet = cy_wps_get_tx_buffer( workspace );
+    if ( packet == NULL )
+    {
+        return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
+    }
 
     packet_header = (cy_wps_msg_packet_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, packet );
     iter = packet_header->data;
 
+    /* Vendor ID and vendor type, the op code is filled in below */
+    memcpy( &packet_header->eap_expanded, &workspace->tx_templates.eap_expanded, sizeof(cy_eap_expanded_header_t) );
+
     switch ( type )
     {
         case WPS_PRIVATE_ID_FRAG_ACK:
@@ -1959,12 +2125,9 @@ cy_rslt_t cy_wps_send_basic_packet( cy_wps_agent_t* workspace, uint8_t type, uin
             break;
     }
 
-    memcpy( packet_header->eap_expanded.vendor_id, WFA_VENDOR_EXT_ID, 3 );
-    CY_WPS_HOST_WRITE_32_BE(&aligned_vendor_type, 1);
-    packet_header->eap_expanded.vendor_type = aligned_vendor_type;
     /* Version */
-    version = WPS_VERSION;
-    iter = tlv_write_value( iter, WPS_ID_VERSION, WPS_ID_VERSION_S, &version, TLV_UINT8 );
+    memcpy( iter, &workspace->tx_templates.version, sizeof(tlv16_uint8_t) );
+    iter += sizeof(tlv16_uint8_t);
 
     /* Message type */
     iter = tlv_write_value( iter, WPS_ID_MSG_TYPE, WPS_ID_MSG_TYPE_S, &type, TLV_UINT8 );
@@ -1991,24 +2154,17 @@ cy_rslt_t cy_wps_send_basic_packet( cy_wps_agent_t* workspace, uint8_t type, uin
     CY_WPS_HOST_WRITE_16_BE(&aligned_length, eap_length );
     packet_header->eap.length = aligned_length;
     packet_header->eap.type           = CY_EAP_TYPE_WPS;
-    packet_header->eap_expanded.flags = 0;
 
     cy_wps_send_eapol_packet( packet, workspace, CY_EAP_PACKET, &workspace->their_data.mac_address, eap_length );
+    cy_wps_record_phase( workspace, CY_WPS_PHASE_MESSAGE_SENT, type );
 
     return CY_RSLT_SUCCESS;
 }
 
 static uint8_t* cy_wps_write_vendor_extension( uint8_t* iter, cy_wps_agent_t* workspace )
 {
-    template_vendor_extension_t* vendor_ext = (template_vendor_extension_t*) iter;
-
-    vendor_ext->header.type     = cy_hton16(WPS_ID_VENDOR_EXT);
-    vendor_ext->header.length   = cy_hton16(6);
-    memcpy( vendor_ext->vendor_extension_id, WFA_VENDOR_EXT_ID, 3 );
-
-    vendor_ext->version2.type   = WPS_WFA_SUBID_VERSION2;
-    vendor_ext->version2.length = 1;
-    vendor_ext->version2.data   = workspace->my_data.supported_version;
+    /* The vendor extension header and body are stored back to back so they can be copied as one block */
+    memcpy( iter, &workspace->tx_templates.vendor_extension_header, sizeof(template_vendor_extension_t) );
 
     return iter + sizeof(template_vendor_extension_t);
 }
@@ -2047,6 +2203,85 @@ void cy_wps_send_eapol_packet(cy_packet_t packet, cy_wps_agent_t* workspace, cy_
     header->eapol.length  = cy_hton16( content_size );
     whd_buffer_set_size( wps_host_workspace->interface->whd_driver, packet, (uint16_t)( content_size + sizeof(cy_eapol_packet_header_t) ));
     whd_network_send_ethernet_data( wps_host_workspace->interface, packet );
+
+    /* Top up the TX buffer pool while waiting for the reply. Don't block here, cy_wps_get_tx_buffer() will fall back to a blocking allocation if the pool is empty */
+    cy_wps_refill_tx_buffer_pool( workspace, 0 );
+}
+
+cy_packet_t cy_wps_get_tx_buffer( cy_wps_agent_t* workspace )
+{
+    cy_packet_t packet = NULL;
+
+    if ( workspace->tx_buffer_pool_count > 0 )
+    {
+        --workspace->tx_buffer_pool_count;
+        packet = workspace->tx_buffer_pool[workspace->tx_buffer_pool_count];
+        workspace->tx_buffer_pool[workspace->tx_buffer_pool_count] = NULL;
+        return packet;
+    }
+
+    /* Pool is exhausted */
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "WPS TX buffer pool empty\r\n");
+    if ( whd_host_buffer_get( workspace->interface->whd_driver, &packet, WHD_NETWORK_TX, WPS_TX_BUFFER_SIZE, true ) != WHD_SUCCESS )
+    {
+        return NULL;
+    }
+    whd_buffer_add_remove_at_front( workspace->interface->whd_driver, &packet, WHD_LINK_HEADER );
+
+    return packet;
+}
+
+static void cy_wps_refill_tx_buffer_pool( cy_wps_agent_t* workspace, uint32_t wait )
+{
+    cy_packet_t packet;
+
+    while ( workspace->tx_buffer_pool_count < CY_WPS_TX_BUFFER_POOL_SIZE )
+    {
+        if ( whd_host_buffer_get( workspace->interface->whd_driver, &packet, WHD_NETWORK_TX, WPS_TX_BUFFER_SIZE, wait ) != WHD_SUCCESS )
+        {
+            break;
+        }
+        /* Reserve the link header up front so the buffer is ready to be written to */
+        whd_buffer_add_remove_at_front( workspace->interface->whd_driver, &packet, WHD_LINK_HEADER );
+        workspace->tx_buffer_pool[workspace->tx_buffer_pool_count] = packet;
+        ++workspace->tx_buffer_pool_count;
+    }
+}
+
+static void cy_wps_release_tx_buffer_pool( cy_wps_agent_t* workspace )
+{
+    while ( workspace->tx_buffer_pool_count > 0 )
+    {
+        --workspace->tx_buffer_pool_count;
+        whd_buffer_release( workspace->interface->whd_driver, workspace->tx_buffer_pool[workspace->tx_buffer_pool_count], WHD_NETWORK_TX );
+        workspace->tx_buffer_pool[workspace->tx_buffer_pool_count] = NULL;
+    }
+}
+
+static void cy_wps_prepare_tx_templates( cy_wps_agent_t* workspace )
+{
+    cy_wps_tx_templates_t* templates = &workspace->tx_templates;
+    uint32_t               aligned_vendor_type;
+
+    /* EAP expanded header for a WSC message. The op code is overwritten for ACK, NACK, Done and Frag ACK */
+    memcpy( templates->eap_expanded.vendor_id, WFA_VENDOR_EXT_ID, 3 );
+    CY_WPS_HOST_WRITE_32_BE( &aligned_vendor_type, 1 );
+    templates->eap_expanded.vendor_type = aligned_vendor_type;
+    templates->eap_expanded.op_code     = 4;
+    templates->eap_expanded.flags       = 0;
+
+    /* Version TLV */
+    templates->version.type   = cy_hton16( WPS_ID_VERSION );
+    templates->version.length = cy_hton16( WPS_ID_VERSION_S );
+    templates->version.data   = WPS_VERSION;
+
+    /* WSC 2.0 vendor extension TLV */
+    templates->vendor_extension_header.type   = cy_hton16( WPS_ID_VENDOR_EXT );
+    templates->vendor_extension_header.length = cy_hton16( sizeof(cy_vendor_ext_t) );
+    memcpy( templates->vendor_extension.vendor_id, WFA_VENDOR_EXT_ID, 3 );
+    templates->vendor_extension.subid_version2.type   = WPS_WFA_SUBID_VERSION2;
+    templates->vendor_extension.subid_version2.length = 1;
+    templates->vendor_extension.subid_version2.data   = workspace->my_data.supported_version;
 }
 
 static cy_rslt_t cy_wps_send_done( cy_wps_agent_t* workspace )
@@ -172,6 +172,7 @@ static cy_rslt_t cy_wps_enrollee_event_handler(cy_wps_agent_t* workspace, cy_eve
             break;
 
         case CY_WPS_EVENT_DISCOVER_COMPLETE:
+            cy_wps_record_phase( workspace, CY_WPS_PHASE_SCAN_COMPLETE, cy_wps_host_get_ap_list_size( workspace->wps_host_workspace ) );
             if ( workspace->wps_mode == CY_WPS_PBC_MODE )
             {
                 if ( cy_wps_enrollee_pbc_overlap_check( workspace) != CY_RSLT_SUCCESS )
@@ -313,17 +314,16 @@ static cy_rslt_t cy_wps_send_eapol_start( cy_wps_agent_t *workspace, whd_interfa
     cy_packet_t packet;
     UNUSED_PARAMETER( interface );
 
-    whd_host_buffer_get( workspace->interface->whd_driver, &packet, WHD_NETWORK_TX, sizeof(cy_eapol_packet_t) + WHD_LINK_HEADER, true );
+    packet = cy_wps_get_tx_buffer( workspace );
     if (packet == 0)
     {
         return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
     }
 
-    whd_buffer_add_remove_at_front( workspace->interface->whd_driver, &packet, WHD_LINK_HEADER );
-
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Sending EAPOL start\r\n");
     cy_host_start_timer( workspace->wps_host_workspace, WPS_EAPOL_PACKET_TIMEOUT );
     cy_wps_send_eapol_packet( packet, workspace, CY_EAPOL_START, &workspace->their_data.mac_address,0);
+    cy_wps_record_phase( workspace, CY_WPS_PHASE_EAPOL_START_SENT, 0 );
 
     return CY_RSLT_SUCCESS;
 }
@@ -335,8 +335,11 @@ static cy_rslt_t cy_wps_send_identity( cy_wps_agent_t* workspace, whd_interface_
     UNUSED_PARAMETER( interface );
     uint16_t aligned_length;
 
-    whd_host_buffer_get( workspace->interface->whd_driver, &packet, WHD_NETWORK_TX, sizeof(cy_eap_packet_t) + (sizeof( ENROLLEE_ID_STRING ) - 1) + WHD_LINK_HEADER, true );
-    whd_buffer_add_remove_at_front( workspace->interface->whd_driver, &packet, WHD_LINK_HEADER );
+    packet = cy_wps_get_tx_buffer( workspace );
+    if (packet == 0)
+    {
+        return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
+    }
     header             = (cy_eap_packet_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, packet );
     header->eap.code   = CY_EAP_CODE_RESPONSE;
     header->eap.id     = workspace->last_received_id;
@@ -348,6 +351,7 @@ static cy_rslt_t cy_wps_send_identity( cy_wps_agent_t* workspace, whd_interface_
 
     cy_host_start_timer( workspace->wps_host_workspace, WPS_EAPOL_PACKET_TIMEOUT );
     cy_wps_send_eapol_packet( packet, workspace, CY_EAP_PACKET, &workspace->their_data.mac_address, sizeof(cy_eap_header_t) + sizeof(ENROLLEE_ID_STRING) - 1 );
+    cy_wps_record_phase( workspace, CY_WPS_PHASE_IDENTITY_SENT, 0 );
 
     return CY_RSLT_SUCCESS;
 }
@@ -383,6 +387,7 @@ static cy_rslt_t cy_wps_find_and_join_ap( cy_wps_agent_t* workspace, whd_interfa
             }
             /* Run discovery */
             workspace->current_sub_stage = WPS_ENROLLEE_DISCOVER;
+            cy_wps_record_phase( workspace, CY_WPS_PHASE_SCAN_STARTED, 0 );
             cy_wps_host_scan( workspace, cy_wps_scan_result_handler, interface );
             result = CY_RSLT_SUCCESS;
         }
@@ -396,11 +401,17 @@ static cy_rslt_t cy_wps_find_and_join_ap( cy_wps_agent_t* workspace, whd_interfa
 
             /* Join the AP */
             ++workspace->ap_join_attempts;
-            result = cy_wps_host_join( workspace->wps_host_workspace, workspace->ap, interface );
+            cy_wps_record_phase( workspace, CY_WPS_PHASE_JOIN_STARTED, workspace->ap->scan_result.channel );
+            result = cy_wps_host_join( workspace, workspace->ap, interface );
             if (result == CY_RSLT_SUCCESS)
             {
+                cy_wps_record_phase( workspace, CY_WPS_PHASE_JOIN_COMPLETE, workspace->ap->scan_result.channel );
                 memcpy(&workspace->their_data.mac_address, &workspace->ap->scan_result.BSSID, sizeof(whd_mac_t));
             }
+            else
+            {
+                cy_wps_record_phase( workspace, CY_WPS_PHASE_JOIN_FAILED, result );
+            }
         }
     } while (result != CY_RSLT_SUCCESS);
     return CY_RSLT_SUCCESS;
@@ -0,0 +1,389 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ *
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/**
+* @file cy_wps_registrar.c
+* @brief WPS Registrar implementation
+*/
+
+#include "cy_wps_common.h"
+#include "cy_wps_constants.h"
+#include "cy_wps_structures.h"
+#include "cy_wcm_log.h"
+#include "string.h" /* For memcpy() */
+#include "whd_types.h"
+#include "whd_wifi_api.h"
+#include "whd_buffer_api.h"
+
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+
+/******************************************************
+ *                      Macros
+ ******************************************************/
+
+/******************************************************
+ *                    Constants
+ ******************************************************/
+
+#define BROADCAST_ETHERNET_ADDRESS          "\xff\xff\xff\xff\xff\xff"
+
+#define VNDR_IE_BEACON_FLAG                 0x01
+#define VNDR_IE_PRBRSP_FLAG                 0x02
+
+/* Size of the fixed length attributes written by cy_wps_registrar_add_ie(), including their TLV headers */
+#define WPS_REGISTRAR_IE_FIXED_SIZE         (128)
+
+/* EAP-Failure carries no type field */
+#define EAP_FAILURE_LENGTH                  (sizeof(cy_eap_header_t) - 1)
+
+#ifdef ENABLE_WCM_LOGS
+#define cy_wcm_log_msg cy_log_msg
+#else
+#define cy_wcm_log_msg(a,b,c,...)
+#endif
+
+/******************************************************
+ *                   Enumerations
+ ******************************************************/
+
+/******************************************************
+ *                 Type Definitions
+ ******************************************************/
+
+/******************************************************
+ *                    Structures
+ ******************************************************/
+
+/******************************************************
+ *               Static Function Declarations
+ ******************************************************/
+
+static cy_rslt_t    cy_wps_registrar_event_handler  ( cy_wps_agent_t* workspace, cy_event_message_t* message );
+static cy_rslt_t    cy_wps_send_identity_request    ( cy_wps_agent_t* workspace );
+static cy_rslt_t    cy_wps_send_wsc_start           ( cy_wps_agent_t* workspace );
+static cy_rslt_t    cy_wps_send_eap_failure         ( cy_wps_agent_t* workspace );
+
+/******************************************************
+ *               Variable Definitions
+ ******************************************************/
+
+/******************************************************
+ *               Function Definitions
+ ******************************************************/
+
+static cy_rslt_t cy_wps_registrar_event_handler( cy_wps_agent_t* workspace, cy_event_message_t* message )
+{
+    cy_wps_msg_packet_t* packet;
+    cy_eap_packet_t*     eap_packet;
+    uint16_t             aligned_length;
+    cy_rslt_t            result = CY_RSLT_SUCCESS;
+
+    switch ( message->event_type )
+    {
+        case CY_WPS_EVENT_RECEIVED_EAPOL_START:
+            /* Posted when a session is started for an enrollee that has already sent its EAPOL start */
+            return cy_wps_send_identity_request( workspace );
+
+        case CY_EVENT_EAPOL_PACKET_RECEIVED:
+            packet     = (cy_wps_msg_packet_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, message->data.packet );
+            eap_packet = (cy_eap_packet_t*) packet;
+
+            /* Check for EAPOL start. The enrollee may restart at any point so go back to the beginning */
+            if ( packet->eapol.type == CY_EAPOL_START )
+            {
+                if ( workspace->current_main_stage != CY_WPS_INITIALISING )
+                {
+                    cy_wps_reset_workspace( workspace, workspace->interface );
+                }
+                memcpy( &workspace->their_data.mac_address, packet->ethernet.ether_shost, sizeof(whd_mac_t) );
+                result = cy_wps_send_identity_request( workspace );
+            }
+            else if ( workspace->current_main_stage == CY_WPS_IN_WPS_HANDSHAKE )
+            {
+                /* The common handler has no state after M8 so WSC Done and NACK are handled here */
+                if ( packet->eap.code == CY_EAP_CODE_RESPONSE && packet->eap.type == CY_EAP_TYPE_WPS && packet->eap_expanded.op_code == CY_WPS_MESSAGE_TYPE_DONE &&
+                     workspace->current_sub_stage == CY_WPS_SENDING_CREDENTIALS )
+                {
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Received WSC Done\r\n");
+                    cy_host_stop_timer( workspace->wps_host_workspace );
+                    workspace->current_main_stage = CY_WPS_CLOSING_EAP;
+                    cy_wps_send_eap_failure( workspace );
+                    workspace->wps_result = CY_RSLT_WPS_COMPLETE;
+                }
+                else if ( packet->eap.code == CY_EAP_CODE_RESPONSE && packet->eap.type == CY_EAP_TYPE_WPS && packet->eap_expanded.op_code == CY_WPS_MESSAGE_TYPE_NACK )
+                {
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Received WSC NACK\r\n");
+                    cy_wps_send_eap_failure( workspace );
+                    result = CY_RSLT_WPS_ERROR_INCORRECT_MESSAGE;
+                }
+                else
+                {
+                    /* Pass this packet to the common WPS handshake code and expect the next message in time */
+                    cy_host_start_timer( workspace->wps_host_workspace, WPS_EAPOL_PACKET_TIMEOUT );
+                    return CY_RSLT_WPS_UNPROCESSED;
+                }
+            }
+            /* Check for identity response */
+            else if ( packet->eap.code == CY_EAP_CODE_RESPONSE && packet->eap.type == CY_EAP_TYPE_IDENTITY && workspace->current_sub_stage == CY_WPS_EAP_IDENTITY )
+            {
+                aligned_length = packet->eap.length;
+                if ( ( CY_WPS_HOST_READ_16_BE( (uint8_t*) &aligned_length ) == sizeof(cy_eap_header_t) + sizeof(ENROLLEE_ID_STRING) - 1 ) &&
+                     ( memcmp( eap_packet->data, ENROLLEE_ID_STRING, sizeof(ENROLLEE_ID_STRING) - 1 ) == 0 ) )
+                {
+                    ++workspace->last_received_id;
+                    workspace->current_main_stage = CY_WPS_IN_WPS_HANDSHAKE;
+                    workspace->current_sub_stage  = CY_WPS_SENDING_PUBLIC_KEYS;
+                    result = cy_wps_send_wsc_start( workspace );
+                }
+                else
+                {
+                    /* Not a WPS enrollee */
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Identity is not a WPS enrollee\r\n");
+                    cy_wps_send_eap_failure( workspace );
+                }
+            }
+            whd_buffer_release( workspace->interface->whd_driver, message->data.packet, WHD_NETWORK_RX );
+            break;
+
+        case CY_EVENT_TIMER_TIMEOUT:
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Timeout...\r\n");
+            cy_host_stop_timer( workspace->wps_host_workspace );
+            if ( workspace->current_main_stage == CY_WPS_INITIALISING && workspace->current_sub_stage == CY_WPS_EAP_START )
+            {
+                /* Still waiting for an enrollee, nothing to restart */
+                return CY_RSLT_SUCCESS;
+            }
+            return CY_RSLT_WPS_ERROR_NO_RESPONSE;
+
+        case CY_EVENT_NO_EVENT:
+        case CY_EVENT_ABORT_REQUESTED:
+        case CY_EVENT_RECEIVED_IDENTITY_REQUEST:
+        case CY_EVENT_COMPLETE:
+        case CY_WPS_EVENT_DISCOVER_COMPLETE:
+        case CY_WPS_EVENT_ENROLLEE_ASSOCIATED:
+        case CY_WPS_EVENT_RECEIVED_IDENTITY:
+        case CY_WPS_EVENT_RECEIVED_WPS_START:
+        case CY_WPS_EVENT_PBC_OVERLAP_NOTIFY_USER:
+        default:
+            return CY_RSLT_WPS_UNPROCESSED;
+            break;
+    }
+
+    return result;
+}
+
+void cy_wps_registrar_init( cy_wps_agent_t* workspace )
+{
+    size_t output_length = 0;
+
+    workspace->event_handler = cy_wps_registrar_event_handler;
+
+    workspace->enrollee_data  = &workspace->their_data;
+    workspace->registrar_data = &workspace->my_data;
+    workspace->available_crypto_material |= CY_WPS_CRYPTO_MATERIAL_REGISTRAR_NONCE |
+                                            CY_WPS_CRYPTO_MATERIAL_REGISTRAR_PUBLIC_KEY;
+
+    workspace->current_main_stage = CY_WPS_INITIALISING;
+    workspace->current_sub_stage  = CY_WPS_EAP_START;
+
+    /* The registrar picks the EAP identifiers. Start from a random one */
+    cy_host_random_bytes( &workspace->last_received_id, sizeof(workspace->last_received_id), &output_length );
+}
+
+void cy_wps_registrar_reset( cy_wps_agent_t* workspace )
+{
+    cy_wps_registrar_init( workspace );
+}
+
+void cy_wps_registrar_start( cy_wps_agent_t* workspace )
+{
+    workspace->wps_result = CY_RSLT_WPS_IN_PROGRESS;
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Waiting for enrollee\r\n");
+}
+
+cy_rslt_t cy_wps_registrar_add_ie( whd_interface_t interface, const cy_wps_device_detail_t* details, uint16_t device_password_id, uint8_t rf_band, cy_ie_t* ie )
+{
+    uint8_t                      version          = WPS_VERSION;
+    uint8_t                      sc_state         = WPS_SCSTATE_CONFIGURED;
+    uint8_t                      selected         = 1;
+    uint8_t                      response_type    = WPS_MSGTYPE_AP_WLAN_MGR;
+    cy_wps_primary_device_type_t primary_device;
+    cy_wps_uuid_t                uuid;
+    whd_mac_t                    mac;
+    uint8_t*                     iter;
+    uint16_t                     size_of_ie = (uint16_t)( WPS_REGISTRAR_IE_FIXED_SIZE + 5 * sizeof(tlv16_header_t) +
+                                                          strlen( details->manufacturer ) +
+                                                          strlen( details->model_name ) +
+                                                          strlen( details->model_number ) +
+                                                          strlen( details->serial_number ) +
+                                                          strlen( details->device_name ) );
+
+    whd_wifi_get_mac_address( interface, &mac );
+    memcpy( &uuid, WPS_TEMPLATE_UUID, sizeof(WPS_TEMPLATE_UUID) );
+    memcpy( &uuid.octet[sizeof(cy_wps_uuid_t) - sizeof(whd_mac_t)], &mac, sizeof(whd_mac_t) );
+
+    primary_device.category     = cy_hton16( details->device_category );
+    primary_device.oui          = cy_hton32( WIFI_ALLIANCE_OUI );
+    primary_device.sub_category = cy_hton16( details->sub_category );
+
+    ie->data = cy_wps_malloc( "wps", size_of_ie );
+    if ( ie->data == NULL )
+    {
+        return CY_RSLT_WPS_ERROR_OUT_OF_MEMORY;
+    }
+
+    /* The same IE is used in beacons and probe responses */
+    iter = ie->data;
+    iter = tlv_write_value( iter, WPS_ID_VERSION,             WPS_ID_VERSION_S,             &version,                  TLV_UINT8 );
+    iter = tlv_write_value( iter, WPS_ID_SC_STATE,            WPS_ID_SC_STATE_S,            &sc_state,                 TLV_UINT8 );
+    iter = tlv_write_value( iter, WPS_ID_SEL_REGISTRAR,       WPS_ID_SEL_REGISTRAR_S,       &selected,                 TLV_UINT8 );
+    iter = tlv_write_value( iter, WPS_ID_DEVICE_PWD_ID,       WPS_ID_DEVICE_PWD_ID_S,       &device_password_id,       TLV_UINT16 );
+    iter = tlv_write_value( iter, WPS_ID_SEL_REG_CFG_METHODS, WPS_ID_SEL_REG_CFG_METHODS_S, &details->config_methods,  TLV_UINT16 );
+    iter = tlv_write_value( iter, WPS_ID_RESP_TYPE,           WPS_ID_RESP_TYPE_S,           &response_type,            TLV_UINT8 );
+    iter = tlv_write_value( iter, WPS_ID_UUID_E,              WPS_ID_UUID_S,                &uuid,                     TLV_UINT8_PTR );
+
+    iter = tlv_write_value( iter, WPS_ID_MANUFACTURER,  (uint16_t) strlen( details->manufacturer ),  details->manufacturer,  TLV_UINT8_PTR );
+    iter = tlv_write_value( iter, WPS_ID_MODEL_NAME,    (uint16_t) strlen( details->model_name ),    details->model_name,    TLV_UINT8_PTR );
+    iter = tlv_write_value( iter, WPS_ID_MODEL_NUMBER,  (uint16_t) strlen( details->model_number ),  details->model_number,  TLV_UINT8_PTR );
+    iter = tlv_write_value( iter, WPS_ID_SERIAL_NUM,    (uint16_t) strlen( details->serial_number ), details->serial_number, TLV_UINT8_PTR );
+    iter = tlv_write_value( iter, WPS_ID_PRIM_DEV_TYPE, WPS_ID_PRIM_DEV_TYPE_S, &primary_device, TLV_UINT8_PTR );
+    iter = tlv_write_value( iter, WPS_ID_DEVICE_NAME,   (uint16_t) strlen( details->device_name ),   details->device_name,   TLV_UINT8_PTR );
+    iter = tlv_write_value( iter, WPS_ID_CONFIG_METHODS, WPS_ID_CONFIG_METHODS_S, &details->config_methods, TLV_UINT16 );
+    iter = tlv_write_value( iter, WPS_ID_RF_BAND,        WPS_ID_RF_BAND_S,        &rf_band,                TLV_UINT8 );
+
+    /* WFA Vendor Extension. Any enrollee is authorized */
+    iter = tlv_write_header( iter, WPS_ID_VENDOR_EXT, 3 + sizeof(tlv8_uint8_t) + sizeof(tlv8_header_t) + sizeof(whd_mac_t) );
+    memcpy( iter, WFA_VENDOR_EXT_ID, 3 );
+    iter += 3;
+    *iter++ = WPS_WFA_SUBID_VERSION2;
+    *iter++ = 1;
+    *iter++ = WPS_VERSION2;
+    *iter++ = WPS_WFA_SUBID_AUTHORIZED_MACS;
+    *iter++ = sizeof(whd_mac_t);
+    memcpy( iter, BROADCAST_ETHERNET_ADDRESS, sizeof(whd_mac_t) );
+    iter += sizeof(whd_mac_t);
+
+    ie->length      = (uint16_t)( iter - ie->data );
+    ie->packet_mask = VNDR_IE_BEACON_FLAG | VNDR_IE_PRBRSP_FLAG;
+    cy_wps_host_add_vendor_ie( (uint32_t) interface, ie->data, ie->length, ie->packet_mask );
+
+    return CY_RSLT_SUCCESS;
+}
+
+void cy_wps_registrar_remove_ie( whd_interface_t interface, cy_ie_t* ie )
+{
+    if ( ie->data != NULL )
+    {
+        cy_wps_host_remove_vendor_ie( (uint32_t) interface, ie->data, ie->length, ie->packet_mask );
+        cy_wps_free( ie->data );
+        ie->data = NULL;
+    }
+}
+
+static cy_rslt_t cy_wps_send_identity_request( cy_wps_agent_t* workspace )
+{
+    cy_packet_t      packet;
+    cy_eap_packet_t* header;
+    uint16_t         aligned_length;
+
+    packet = cy_wps_get_tx_buffer( workspace );
+    if ( packet == 0 )
+    {
+        return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
+    }
+    header             = (cy_eap_packet_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, packet );
+    header->eap.code   = CY_EAP_CODE_REQUEST;
+    header->eap.id     = workspace->last_received_id;
+    CY_WPS_HOST_WRITE_16_BE(&aligned_length, sizeof(cy_eap_header_t));
+    header->eap.length = aligned_length;
+    header->eap.type   = CY_EAP_TYPE_IDENTITY;
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Sending Identity Request\r\n");
+
+    workspace->current_sub_stage = CY_WPS_EAP_IDENTITY;
+    cy_host_start_timer( workspace->wps_host_workspace, WPS_EAPOL_PACKET_TIMEOUT );
+    cy_wps_send_eapol_packet( packet, workspace, CY_EAP_PACKET, &workspace->their_data.mac_address, sizeof(cy_eap_header_t) );
+
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t cy_wps_send_wsc_start( cy_wps_agent_t* workspace )
+{
+    cy_packet_t                 packet;
+    cy_wps_msg_packet_header_t* header;
+    uint16_t                    aligned_length;
+
+    packet = cy_wps_get_tx_buffer( workspace );
+    if ( packet == 0 )
+    {
+        return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
+    }
+    header             = (cy_wps_msg_packet_header_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, packet );
+    header->eap.code   = CY_EAP_CODE_REQUEST;
+    header->eap.id     = workspace->last_received_id;
+    CY_WPS_HOST_WRITE_16_BE(&aligned_length, (sizeof(cy_eap_header_t) + sizeof(cy_eap_expanded_header_t)));
+    header->eap.length = aligned_length;
+    header->eap.type   = CY_EAP_TYPE_WPS;
+
+    memcpy( &header->eap_expanded, &workspace->tx_templates.eap_expanded, sizeof(cy_eap_expanded_header_t) );
+    header->eap_expanded.op_code = CY_WPS_MESSAGE_TYPE_START;
+    header->eap_expanded.flags   = 0;
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Sending WSC Start\r\n");
+
+    /* The enrollee computes its public key before sending M1 */
+    cy_host_start_timer( workspace->wps_host_workspace, WPS_PUBLIC_KEY_MESSAGE_TIMEOUT );
+    cy_wps_send_eapol_packet( packet, workspace, CY_EAP_PACKET, &workspace->their_data.mac_address, sizeof(cy_eap_header_t) + sizeof(cy_eap_expanded_header_t) );
+
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t cy_wps_send_eap_failure( cy_wps_agent_t* workspace )
+{
+    cy_packet_t      packet;
+    cy_eap_packet_t* header;
+    uint16_t         aligned_length;
+
+    packet = cy_wps_get_tx_buffer( workspace );
+    if ( packet == 0 )
+    {
+        return CY_RSLT_WPS_ERROR_CREATING_EAPOL_PACKET;
+    }
+    header             = (cy_eap_packet_t*) whd_buffer_get_current_piece_data_pointer( workspace->interface->whd_driver, packet );
+    header->eap.code   = CY_EAP_CODE_FAILURE;
+    header->eap.id     = workspace->last_received_id;
+    CY_WPS_HOST_WRITE_16_BE(&aligned_length, EAP_FAILURE_LENGTH);
+    header->eap.length = aligned_length;
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Sending EAP Fail\r\n");
+
+    cy_wps_send_eapol_packet( packet, workspace, CY_EAP_PACKET, &workspace->their_data.mac_address, EAP_FAILURE_LENGTH );
+
+    return CY_RSLT_SUCCESS;
+}
+
+#endif /* WCM_ENABLE_WPS_REGISTRAR */
@@ -35,6 +35,7 @@
 #pragma once
 
 #include "cy_wps_structures.h"
+#include "cy_wps_common.h"
 #include "cy_chip_constants.h"
 #include "whd_types.h"
 #include "cyabs_rtos_impl.h"
@@ -88,6 +89,8 @@ extern cy_rslt_t cy_wps_init( cy_wps_agent_t* workspace, const cy_wps_device_det
 extern cy_rslt_t cy_wps_get_result( cy_wps_agent_t* workspace );
 extern cy_rslt_t cy_wps_deinit( cy_wps_agent_t* workspace );
 extern cy_rslt_t cy_wps_start( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length );
+extern cy_rslt_t cy_wps_start_on_worker( cy_wps_agent_t* workspace, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length,
+                                         cy_wps_scheduler_t scheduler, cy_wps_completion_callback_t completion_callback );
 extern cy_rslt_t cy_p2p_wps_start( cy_wps_agent_t* workspace );
 extern cy_rslt_t cy_wps_restart( cy_wps_agent_t* workspace );
 extern cy_rslt_t cy_wps_reset_registrar( cy_wps_agent_t* workspace, whd_mac_t* mac );
@@ -95,9 +98,20 @@ extern cy_rslt_t cy_wps_wait_till_complete( cy_wps_agent_t* workspace );
 extern cy_rslt_t cy_wps_abort( cy_wps_agent_t* workspace );
 extern cy_rslt_t cy_wps_management_set_event_handler( cy_wps_agent_t* workspace, bool enable );
 extern cy_rslt_t cy_wps_set_directed_wps_target( cy_wps_agent_t* workspace, cy_wps_ap_t* ap, uint32_t maximum_join_attempts );
+#ifdef WCM_ENABLE_WPS_REGISTRAR
+/* Runs one registrar session per enrollee on the given worker until cy_wps_registrar_pool_stop() is called.
+ * details and the scheduler's worker must stay valid until then */
+extern cy_rslt_t cy_wps_registrar_pool_start( whd_interface_t interface, const cy_wps_device_detail_t* details, cy_wps_mode_t mode, const char* password,
+                                              const cy_wps_credential_t* ap_details, uint8_t max_sessions, cy_wps_scheduler_t scheduler,
+                                              cy_wps_registrar_session_callback_t callback, void* user_data );
+extern cy_rslt_t cy_wps_registrar_pool_stop( void );
+#endif
 
 
 int              cy_wps_get_stored_credential_count( cy_wps_agent_t* workspace );
+#ifdef WCM_ENABLE_WPS_TIMELINE
+uint32_t         cy_wps_get_timeline( cy_wps_agent_t* workspace, cy_wps_phase_record_t* records, uint32_t max_records, uint32_t* dropped );
+#endif
 extern void      cy_wps_thread_main( cy_thread_arg_t arg );
 extern cy_rslt_t cy_wps_internal_init( cy_wps_agent_t* workspace, uint32_t interface, cy_wps_mode_t mode, const char* password, cy_wps_credential_t* credentials, uint16_t* credential_length );
 
@@ -104,6 +104,11 @@ static inline ALWAYS_INLINE uint32_t CY_WPS_HOST_READ_32_BE(uint8_t* ptr_in)
 /* Maximum number of APs to be added after scan into the list */
 #define AP_LIST_SIZE             10
 
+/* Maximum number of enrollees a multi-enrollee registrar serves at the same time */
+#ifndef CY_WPS_REGISTRAR_MAX_SESSIONS
+#define CY_WPS_REGISTRAR_MAX_SESSIONS  (8)
+#endif
+
 /******************************************************
  *                   Enumerations
  ******************************************************/
@@ -292,6 +297,15 @@ typedef struct
     cy_wps_packet_generator_t packet_generator;
 } cy_wps_state_machine_state_t;
 
+/* Runs step( arg ) as a job on an external worker thread */
+typedef cy_rslt_t (*cy_wps_scheduler_t)( void (*step)( void* arg ), void* arg );
+
+/* Called on the worker thread once a WPS session started with cy_wps_start_on_worker() has finished */
+typedef void (*cy_wps_completion_callback_t)( cy_wps_agent_t* workspace );
+
+/* Called on the worker thread each time a session of the multi-enrollee registrar has finished */
+typedef void (*cy_wps_registrar_session_callback_t)( const whd_mac_t* enrollee_mac, cy_rslt_t result, void* user_data );
+
 typedef struct
 {
     cy_thread_t           thread;
@@ -301,6 +315,11 @@ typedef struct
     cy_time_t             timer_reference;
     uint32_t              timer_timeout;
     whd_interface_t       interface;
+
+    /* Only used when the event loop runs on an external worker thread instead of the WPS thread */
+    cy_wps_scheduler_t           scheduler;
+    cy_wps_completion_callback_t completion_callback;
+    cy_timer_t                   wakeup_timer;
 } cy_host_workspace_t;
 
 typedef struct
@@ -323,12 +342,15 @@ typedef struct
 
 extern void         cy_wps_send_eapol_packet       ( cy_packet_t packet, cy_wps_agent_t* workspace, cy_eapol_packet_type_t type, whd_mac_t* their_mac_address, uint16_t content_size );
 extern cy_rslt_t    cy_wps_send_basic_packet       ( cy_wps_agent_t* workspace, uint8_t type, uint16_t optional_config_error );
+extern cy_packet_t  cy_wps_get_tx_buffer           ( cy_wps_agent_t* workspace );
 extern void         cy_wps_enrollee_init           ( cy_wps_agent_t* workspace );
 extern void         cy_wps_enrollee_start          ( cy_wps_agent_t* workspace, whd_interface_t interface );
 extern void         cy_wps_enrollee_reset          ( cy_wps_agent_t* workspace, whd_interface_t interface );
 extern void         cy_wps_registrar_init          ( cy_wps_agent_t* workspace );
 extern void         cy_wps_registrar_start         ( cy_wps_agent_t* workspace );
 extern void         cy_wps_registrar_reset         ( cy_wps_agent_t* workspace );
+extern cy_rslt_t    cy_wps_registrar_add_ie        ( whd_interface_t interface, const cy_wps_device_detail_t* details, uint16_t device_password_id, uint8_t rf_band, cy_ie_t* ie );
+extern void         cy_wps_registrar_remove_ie     ( whd_interface_t interface, cy_ie_t* ie );
 extern cy_rslt_t    cy_wps_pbc_overlap_check       ( const whd_mac_t* data );
 extern void         cy_wps_clear_pbc_overlap_array ( void );
 extern void         cy_wps_record_last_pbc_enrollee( const whd_mac_t* mac );
@@ -344,14 +366,22 @@ extern void         cy_wps_deinit_workspace     ( cy_wps_agent_t* workspace );
 extern void         cy_wps_reset_workspace      ( cy_wps_agent_t* workspace, whd_interface_t interface );
 extern void         cy_wps_scan_result_handler  ( whd_scan_result_t* result, void* user_data );
 extern void         cy_wps_prepare_workspace_crypto   ( cy_wps_agent_t* workspace );
+extern void         cy_wps_generate_dh_key_pair       ( cy_wps_NN_t* private_key, cy_public_key_t* public_key, uint32_t* nn_scratch );
 extern cy_rslt_t    cy_wps_advertise_registrar( cy_wps_agent_t* workspace, uint8_t selected_registrar );
 extern void         cy_wps_register_result_callback( cy_wps_agent_t* workspace, void (*wps_result_callback)(cy_rslt_t*) );
 
 void                cy_wps_register_internal_result_callback( cy_wps_agent_t* workspace, void (*wps_internal_result_callback)(cy_rslt_t*) );
 
+/* Timeline functions */
+#ifdef WCM_ENABLE_WPS_TIMELINE
+extern void         cy_wps_record_phase( cy_wps_agent_t* workspace, cy_wps_phase_t phase, uint32_t detail );
+#else
+#define             cy_wps_record_phase( workspace, phase, detail )
+#endif
+
 
 /* Association functions */
-extern cy_rslt_t    cy_wps_host_join( void* workspace, cy_wps_ap_t* ap, whd_interface_t interface );
+extern cy_rslt_t    cy_wps_host_join( cy_wps_agent_t* workspace, cy_wps_ap_t* ap, whd_interface_t interface );
 extern cy_rslt_t    cy_wps_host_leave( whd_interface_t interface );
 
 /* Timing functions */
@@ -48,6 +48,17 @@ extern "C" {
  ******************************************************/
 #define CY_WPS_SSID_LENGTH             32
 #define CY_WPS_PASSPHRASE_LENGTH       63
+
+/* Number of EAPOL TX buffers preallocated for each WPS session */
+#ifndef CY_WPS_TX_BUFFER_POOL_SIZE
+#define CY_WPS_TX_BUFFER_POOL_SIZE     2
+#endif
+
+/* Number of phase records kept for each WPS session when WCM_ENABLE_WPS_TIMELINE is defined.
+ * When full, the oldest records are overwritten */
+#ifndef CY_WPS_TIMELINE_SIZE
+#define CY_WPS_TIMELINE_SIZE           48
+#endif
 /******************************************************
  *                   Enumerations
  ******************************************************/
@@ -110,6 +121,25 @@ typedef enum
     CY_WPS_CLOSING_EAP,
 } cy_wps_main_stage_t;
 
+/* Phases recorded in the WPS session timeline. The meaning of the record detail is given for each phase */
+typedef enum
+{
+    CY_WPS_PHASE_STARTED,               /* WPS thread started, detail is unused                             */
+    CY_WPS_PHASE_SCAN_STARTED,          /* Discovery scan started, detail is unused                         */
+    CY_WPS_PHASE_SCAN_COMPLETE,         /* Discovery scan complete, detail is the number of WPS APs found   */
+    CY_WPS_PHASE_JOIN_STARTED,          /* Joining an AP, detail is the channel of the AP                   */
+    CY_WPS_PHASE_JOIN_COMPLETE,         /* Joined the AP, detail is the channel of the AP                   */
+    CY_WPS_PHASE_JOIN_FAILED,           /* Failed to join the AP, detail is the result code                 */
+    CY_WPS_PHASE_EAPOL_START_SENT,      /* EAPOL-Start sent, detail is unused                               */
+    CY_WPS_PHASE_IDENTITY_SENT,         /* EAP identity response sent, detail is unused                     */
+    CY_WPS_PHASE_WSC_START_RECEIVED,    /* WSC start received, detail is unused                             */
+    CY_WPS_PHASE_MESSAGE_SENT,          /* WPS message sent, detail is the message type (M1 to M8, ACK, NACK, DONE) */
+    CY_WPS_PHASE_MESSAGE_RECEIVED,      /* WPS message received, detail is the message type                 */
+    CY_WPS_PHASE_FRAG_ACK_SENT,         /* Fragment ACK sent, detail is the EAP identifier being acknowledged */
+    CY_WPS_PHASE_RESTARTED,             /* Handshake failed and was restarted, detail is the failure result */
+    CY_WPS_PHASE_FINISHED,              /* WPS thread finished, detail is the WPS result                    */
+} cy_wps_phase_t;
+
 
 /******************************************************
  *                 Type Definitions
@@ -314,6 +344,15 @@ typedef struct
     cy_eap_expanded_header_t eap_expanded;
 } cy_wps_msg_packet_header_t;
 
+/* Session constant blocks serialized once and copied into every outgoing WPS message */
+typedef struct
+{
+    cy_eap_expanded_header_t eap_expanded;
+    tlv16_uint8_t            version;
+    tlv16_header_t           vendor_extension_header;
+    cy_vendor_ext_t          vendor_extension;
+} cy_wps_tx_templates_t;
+
 #pragma pack()
 
 
@@ -346,6 +385,13 @@ typedef struct
     cy_wps_uuid_t     uuid;
 } cy_wps_ap_t;
 
+typedef struct
+{
+    uint32_t          time;     /* Milliseconds since the WPS thread started */
+    uint32_t          detail;   /* Phase specific, see cy_wps_phase_t */
+    cy_wps_phase_t    phase;
+} cy_wps_phase_record_t;
+
 typedef struct _wps_agent_t cy_wps_agent_t;
 
 typedef cy_rslt_t (*cy_wps_event_handler_t)(cy_wps_agent_t* workspace, cy_event_message_t* message);
@@ -386,6 +432,10 @@ struct _wps_agent_t
     /* Natural Number versions of keys used for quick calculations */
     cy_wps_NN_t                     my_private_key;
 
+    /* Scratch for the Montgomery multiplies of the Diffie-Hellman calculations, 4 words per word of the modulus.
+     * Kept here rather than on the stack of the thread running the exponentiation */
+    uint32_t                        nn_scratch[ 4 * 48 ];
+
     /* Password and derived PSK */
     const char*                     password;
     uint16_t                        device_password_id;
@@ -398,6 +448,12 @@ struct _wps_agent_t
     cy_key_wrap_key_t               key_wrap_key;
     cy_emsk_t                       emsk;
 
+    /* HMAC key schedule for auth_key. Valid while CY_WPS_CRYPTO_MATERIAL_AUTH_KEY is set */
+    cy_sha2_hmac_key_t              auth_key_hmac;
+
+    /* AES context keyed with key_wrap_key. Valid while CY_WPS_CRYPTO_MATERIAL_KEY_WRAP_KEY is set */
+    cy_aes_cbc_context_t            key_wrap_aes;
+
     /* Progressive HMAC workspace */
     cy_sha2_hmac_context            hmac;
 
@@ -417,6 +473,11 @@ struct _wps_agent_t
     uint16_t                        fragmented_packet_length;
     uint16_t                        fragmented_packet_length_max;
 
+    /* Preallocated EAPOL TX buffers and pre-serialized static headers for outgoing packets */
+    cy_packet_t                     tx_buffer_pool[CY_WPS_TX_BUFFER_POOL_SIZE];
+    uint8_t                         tx_buffer_pool_count;
+    cy_wps_tx_templates_t           tx_templates;
+
     /* Event handler for all events that occur during the INITIALIZING and IN_EAP_HANDSHAKE stages */
     cy_wps_event_handler_t          event_handler;
 
@@ -444,6 +505,13 @@ struct _wps_agent_t
 
     uint32_t                        start_time;
 
+#ifdef WCM_ENABLE_WPS_TIMELINE
+    /* Session timeline, kept as a ring of the most recent CY_WPS_TIMELINE_SIZE records */
+    cy_wps_phase_record_t           timeline[CY_WPS_TIMELINE_SIZE];
+    uint32_t                        timeline_count; /* Total number of records, including overwritten ones */
+    uint32_t                        timeline_start;
+#endif
+
     /*
      * Enrollee only variables
      */
@@ -462,6 +530,12 @@ struct _wps_agent_t
     uint8_t                         is_p2p_enrollee;
     uint8_t                         is_p2p_registrar;
 
+    /*
+     * Multi-enrollee registrar variables
+     */
+    /* Set for the sessions of a registrar that serves several enrollees at once. PBC overlap detection is not done for these sessions */
+    uint8_t                         is_multi_enrollee_registrar;
+
     void                            (*cy_wps_result_callback)         (cy_rslt_t*); /*!< WPS result callback for applications */
     void                            (*cy_wps_internal_result_callback)(cy_rslt_t*); /*!< WPS internal result callback for use by P2P and other BESL features */
 };
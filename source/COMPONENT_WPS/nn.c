@@ -208,6 +208,23 @@ on the multiplies. The best known such situation is exponentiation.
 
 #define MAX_NN              16          // Max. number of NNs
 
+// Largest operand (in words) NN_Mul hands to the product-scanning kernels
+// below. It sizes NN_Mul's on-stack scratch, 48 words covers the 1536-bit WPS
+// group. NN_MulModMont takes its scratch from the caller instead.
+#define NN_FAST_MUL_MAX_WORDS       48
+
+// Below this many words a single Comba pass is faster than a Karatsuba split.
+#define NN_KARATSUBA_MIN_WORDS      16
+
+// Define NN_REFERENCE_MUL to build NN_Mul and NN_MulModMont with the original
+// operand-scanning loops only, e.g. to cross-check the kernels below.
+
+#ifndef __sparc__
+#define NN_MUL32X32( a, b )         ( (uint64_t) (a) * (b) )
+#else
+#define NN_MUL32X32( a, b )         NN_Mul32x32u64( (a), (b) )
+#endif
+
 typedef signed int          sint32;     // Signed 32 bit integer
 typedef signed long long    sint64;     // Signed 64 bit integer
 
@@ -229,6 +246,375 @@ void NN_Clr( NN_t* m )
 }
 
 
+#ifndef NN_REFERENCE_MUL
+/****************************************************************************/
+/*                      Multiplication kernels                              */
+/****************************************************************************/
+
+/*
+These work on raw big-endian word arrays rather than on NN_t so that the
+Karatsuba split can point into the middle of an operand.
+
+The schoolbook loops in NN_Mul and NN_MulModMont scan the operands: every
+partial product is added into the result in memory straight away, which costs
+a load and a store of r per multiply. Product scanning (Comba) instead walks
+the result one column at a time and keeps the column sum in registers, so each
+result word is written exactly once. The 96-bit column accumulator is a 64-bit
+value plus a 32-bit carry count, so the inner loops are a load of each operand
+and a multiply-accumulate (UMLAL, or UMULL/ADDS/ADCS, on Cortex-M4/M33) with
+no stores at all.
+*/
+
+/*!
+******************************************************************************
+Comba multiplication
+
+Calculates r = x * y where x and y are n words long and r is 2n words long.
+The result must be distinct (in memory) from the inputs.
+*/
+
+static void nn_mul_comba( uint32_t* r, const uint32_t* x, const uint32_t* y, uint32_t n )
+{
+    const uint32_t *xp, *yp;
+    uint32_t *rp;
+    uint32_t  k, lo, j, c2;
+    uint64_t  acc, pr;
+
+    rp  = r + 2 * n - 1;
+    acc = 0;
+
+    for ( k = 0 ; k < 2 * n - 1 ; k++ )
+    {
+        // Column k is the sum of x(i) * y(k-i) for all valid i.
+        // x(i) is x[ n-1-i ] so x is walked towards its top while y is
+        // walked towards its bottom.
+
+        lo = ( k < n ) ? 0 : k - n + 1;
+        xp = x + n - 1 - lo;
+        yp = y + n - 1 - ( k - lo );
+        c2 = 0;
+
+        for ( j = ( ( k < n ) ? k : n - 1 ) - lo + 1 ; j-- ; xp--, yp++ )
+        {
+            pr   = NN_MUL32X32( *xp, *yp );
+            acc += pr;
+            c2  += ( acc < pr );
+        }
+
+        *rp-- = (uint32_t) acc;
+        acc   = ( acc >> 32 ) | ( (uint64_t) c2 << 32 );
+    }
+
+    *rp = (uint32_t) acc;
+}
+
+
+/*!
+******************************************************************************
+Comba squaring
+
+Calculates r = x * x where x is n words long and r is 2n words long.
+The result must be distinct (in memory) from the input.
+
+Every product x(i) * x(j) with i != j appears twice in a column, so only
+the i < j half is summed, the sum is doubled and the square x(k/2)^2 is added
+to the even columns. That is n(n+1)/2 multiplies instead of n^2, and squaring
+is what NN_ExpModMont spends most of its time on.
+*/
+
+static void nn_sqr_comba( uint32_t* r, const uint32_t* x, uint32_t n )
+{
+    const uint32_t *xp, *yp;
+    uint32_t *rp;
+    uint32_t  k, lo, j, c2, s2;
+    uint64_t  acc, sum, pr;
+
+    rp  = r + 2 * n - 1;
+    acc = 0;
+    c2  = 0;
+
+    for ( k = 0 ; k < 2 * n - 1 ; k++ )
+    {
+        // Cross products x(i) * x(k-i) for i < k-i
+
+        lo  = ( k < n ) ? 0 : k - n + 1;
+        xp  = x + n - 1 - lo;
+        yp  = x + n - 1 - ( k - lo );
+        sum = 0;
+        s2  = 0;
+
+        for ( j = ( k + 1 ) / 2 - lo ; j-- ; xp--, yp++ )
+        {
+            pr   = NN_MUL32X32( *xp, *yp );
+            sum += pr;
+            s2  += ( sum < pr );
+        }
+
+        // acc += 2 * ( s2:sum ) + x(k/2)^2
+
+        s2   = ( s2 << 1 ) | (uint32_t) ( sum >> 63 );
+        sum <<= 1;
+
+        if ( ( k & 1 ) == 0 )
+        {
+            pr   = NN_MUL32X32( *xp, *xp );
+            sum += pr;
+            s2  += ( sum < pr );
+        }
+
+        acc += sum;
+        c2  += s2 + ( acc < sum );
+
+        *rp-- = (uint32_t) acc;
+        acc   = ( acc >> 32 ) | ( (uint64_t) c2 << 32 );
+        c2    = 0;
+    }
+
+    *rp = (uint32_t) acc;
+}
+
+
+/*!
+******************************************************************************
+Calculates r = x * y for two n-word numbers using squaring when x is y.
+*/
+
+static void nn_mul_half( uint32_t* r, const uint32_t* x, const uint32_t* y, uint32_t n )
+{
+    if ( x == y )
+    {
+        nn_sqr_comba( r, x, n );
+    }
+    else
+    {
+        nn_mul_comba( r, x, y, n );
+    }
+}
+
+
+/*!
+******************************************************************************
+Absolute difference
+
+Calculates d = | a - b | for two n-word numbers without branching on their
+values.
+
+\return     uint32_t  1 if a < b, 0 otherwise
+*/
+
+static uint32_t nn_abs_diff( uint32_t* d, const uint32_t* a, const uint32_t* b, uint32_t n )
+{
+    uint32_t i, mask;
+    sint64   tr;
+    uint64_t cr;
+
+    for ( tr = 0, i = n ; i-- ; )
+    {
+        tr  += a[ i ];
+        tr  -= b[ i ];
+        d[ i ] = (uint32_t) tr;
+        tr >>= 32;
+    }
+
+    // If a < b then tr is -1 and d holds the 2's complement of b - a.
+    // Negate it: flip all bits and add one.
+
+    mask = (uint32_t) tr;
+
+    for ( cr = mask & 1, i = n ; i-- ; )
+    {
+        cr    += d[ i ] ^ mask;
+        d[ i ] = (uint32_t) cr;
+        cr   >>= 32;
+    }
+
+    return ( mask & 1 );
+}
+
+
+/*!
+******************************************************************************
+One level Karatsuba multiplication
+
+Calculates r = x * y where x and y are n words long, n is even and r is 2n
+words long. s is 2n words of scratch. The result and the scratch must be
+distinct (in memory) from the inputs and from each other.
+
+With B = 2^(32*n/2), x = x1*B + x0 and y = y1*B + y0 the product is
+
+x * y = z2*B^2 + ( z2 + z0 - ( x0 - x1 ) * ( y0 - y1 ) ) * B + z0
+
+where z2 = x1*y1 and z0 = x0*y0. That is three half size products instead of
+four. The subtractive form keeps all the temporaries n/2 words long, only the
+sign of the middle product needs tracking.
+*/
+
+static void nn_mul_karatsuba( uint32_t* r, const uint32_t* x, const uint32_t* y, uint32_t n, uint32_t* s )
+{
+    uint32_t *dx, *dy, *p;
+    uint32_t  h, i, neg, top;
+    uint32_t *rp;
+    sint64    tr;
+    uint64_t  cr;
+
+    h  = n / 2;
+    dx = s;
+    dy = s + h;
+    p  = s + n;
+
+    // z2 goes to the upper half of r, z0 to the lower half.
+
+    nn_mul_half( r,     x,     y,     h );
+    nn_mul_half( r + n, x + h, y + h, h );
+
+    // When squaring, dx and dy would be the same, so the middle product is
+    // a square and never negative.
+
+    neg = nn_abs_diff( dx, x + h, x, h );
+
+    if ( x == y )
+    {
+        neg = 0;
+        nn_sqr_comba( p, dx, h );
+    }
+    else
+    {
+        neg ^= nn_abs_diff( dy, y + h, y, h );
+        nn_mul_comba( p, dx, dy, h );
+    }
+
+    // Middle term into p: z2 + z0 - (x0-x1)*(y0-y1). The product is negative
+    // (i.e. it must be added) if exactly one of the differences was negative.
+    // The middle term is x0*y1 + x1*y0, so it is never negative and has at
+    // most one more word than p.
+
+    for ( tr = 0, i = n ; i-- ; )
+    {
+        tr  += r[ i ];
+        tr  += r[ i + n ];
+        tr  += neg ? (sint64) p[ i ] : -(sint64) p[ i ];
+        p[ i ] = (uint32_t) tr;
+        tr >>= 32;
+    }
+
+    top = (uint32_t) tr;
+
+    // Add the middle term to r shifted up by h words.
+
+    rp = r + 2 * n - 1 - h;
+
+    for ( cr = 0, i = n ; i-- ; rp-- )
+    {
+        cr  += *rp;
+        cr  += p[ i ];
+        *rp  = (uint32_t) cr;
+        cr >>= 32;
+    }
+
+    for ( cr += top ; rp >= r ; rp-- )
+    {
+        cr  += *rp;
+        *rp  = (uint32_t) cr;
+        cr >>= 32;
+    }
+}
+
+
+/*!
+******************************************************************************
+Calculates r = x * y for two n-word numbers. s is 2n words of scratch for
+the Karatsuba split.
+*/
+
+static void nn_mul_words( uint32_t* r, const uint32_t* x, const uint32_t* y, uint32_t n, uint32_t* s )
+{
+    if ( ( n >= NN_KARATSUBA_MIN_WORDS ) && ( ( n & 1 ) == 0 ) )
+    {
+        nn_mul_karatsuba( r, x, y, n, s );
+    }
+    else
+    {
+        nn_mul_half( r, x, y, n );
+    }
+}
+
+
+/*!
+******************************************************************************
+Montgomery reduction
+
+Calculates r = t * R^-1 mod m (up to one final subtraction of m) where t is
+2n words long and m is n words long. t is destroyed.
+This is the reduction half of the product scanning method in Koc's paper,
+i.e. the same column-wise walk as nn_mul_comba():
+
+for k from 0 to n-1 do
+    s <- s + t(k) + sum of u(j) * m(k-j) for j < k
+    u(k) <- ( s(0) * m' ) % 2^32
+    s <- ( s + u(k) * m(0) ) >> 32
+done
+for k from n to 2n-1 do
+    s <- s + t(k) + sum of u(j) * m(k-j) for k-n < j < n
+    r(k-n) <- s(0)
+    s <- s >> 32
+done
+
+The low half of t is no longer needed once its column has been processed,
+so u(k) is stored in place of t(k).
+
+\return     uint32_t  The overflow word of r, 0 or 1
+*/
+
+static uint32_t nn_mont_reduce( uint32_t* r, uint32_t* t, const uint32_t* m, uint32_t n, uint32_t mt )
+{
+    const uint32_t *up, *mp;
+    uint32_t *tp, *rp;
+    uint32_t  k, lo, j, c2, ui;
+    uint64_t  acc, pr;
+
+    tp  = t + 2 * n - 1;
+    rp  = r + n - 1;
+    acc = 0;
+
+    for ( k = 0 ; k < 2 * n ; k++, tp-- )
+    {
+        acc += *tp;
+        c2   = ( acc < *tp );
+
+        lo = ( k < n ) ? 0 : k - n + 1;
+        up = t + 2 * n - 1 - lo;
+        mp = m + n - 1 - ( k - lo );
+
+        for ( j = ( k < n ) ? k : 2 * n - 1 - k ; j-- ; up--, mp++ )
+        {
+            pr   = NN_MUL32X32( *up, *mp );
+            acc += pr;
+            c2  += ( acc < pr );
+        }
+
+        if ( k < n )
+        {
+            // Pick u(k) so that the low word of the column becomes zero.
+
+            ui   = (uint32_t) acc * mt;
+            *tp  = ui;
+            pr   = NN_MUL32X32( ui, m[ n - 1 ] );
+            acc += pr;
+            c2  += ( acc < pr );
+        }
+        else
+        {
+            *rp-- = (uint32_t) acc;
+        }
+
+        acc = ( acc >> 32 ) | ( (uint64_t) c2 << 32 );
+    }
+
+    return (uint32_t) acc;
+}
+#endif /* NN_REFERENCE_MUL */
+
+
 #ifdef ENABLE_UNUSED_NN_FUNCTIONS
 /*!
 ******************************************************************************
@@ -333,6 +719,10 @@ The result must be distinct (in memory) from the inputs x and y.
 The multiplicands can be of any length, the result must be as long as
 the sum of the length of the multiplicands. If the provided result buffer
 is shorter, then the result will be truncated.
+
+Equal length multiplicands of up to NN_FAST_MUL_MAX_WORDS words with a full
+length result go through the Comba/Karatsuba kernels, everything else (and
+everything when NN_REFERENCE_MUL is defined) uses the schoolbook loop below.
 */
 
 void NN_Mul( NN_t* r, const NN_t* x, const NN_t* y )
@@ -341,6 +731,15 @@ uint32_t  i, j, xi;
 uint32_t  *rs, *rp;
 const uint32_t *yp;
 uint64_t  tr;
+#ifndef NN_REFERENCE_MUL
+uint32_t  s[ 2 * NN_FAST_MUL_MAX_WORDS ];
+
+    if ( ( x->len == y->len ) && ( x->len <= NN_FAST_MUL_MAX_WORDS ) && ( r->len == 2 * x->len ) )
+    {
+        nn_mul_words( r->num, x->num, y->num, x->len, s );
+        return;
+    }
+#endif
 
     NN_Clr( r );
 
@@ -901,82 +1300,113 @@ Leon core.
 \param[in]  y   Pointer to the other multiplicand
 \param[in]  m   Pointer to the modulus
 \param[in]  t   The m' = -m^-1 mod 2^32 value
+\param[in]  s   Scratch of NN_MONT_SCRATCH_WORDS( m->len ) words, or NULL
 
 The result must be distinct (in memory) from the inputs x, y and m.
 The 'x' multiplicand can be of any length, 'y' must be less than the modulus
 but the same length as the modulus, 'r' must be as large as the modulus.
+
+When x, y and m are all the same length (as they are in NN_ExpModMont) and
+the caller provides the scratch, the product is calculated in full into the
+scratch with nn_mul_words() and then reduced with nn_mont_reduce(). For the
+1536-bit WPS modulus the product takes 3 * 24^2 = 1728 multiplies instead of
+48^2, or 3 * 300 when squaring. The scratch comes from the caller so that the
+768 bytes it takes for that modulus need not be on the stack of the thread
+running the exponentiation. Without scratch, or when NN_REFERENCE_MUL is
+defined, the interleaved loop is used.
 */
 
-void NN_MulModMont( NN_t* r, const NN_t* x, const NN_t* y, const NN_t* m, uint32_t t )
+void NN_MulModMont( NN_t* r, const NN_t* x, const NN_t* y, const NN_t* m, uint32_t t, uint32_t* s )
 {
 uint32_t  r0, y0, i, j, n;
-uint32_t  ui, rn, xi;
-uint64_t  pr;
+uint32_t  ui, xi;
+uint64_t  pr, rn;
 const uint32_t  *cp1;
 uint32_t *p2;
 
-    NN_Clr( r );
     n  = m->len - 1;
-    y0 = y->num[ n ];
-    rn = 0;
 
-    for ( i = x->len ; i-- ; )
+#ifdef NN_REFERENCE_MUL
+    (void) s;
+#else
+    if ( ( s != NULL ) && ( x->len == m->len ) && ( y->len == m->len ) )
     {
-        r0 = r->num[ n ];
-        xi = x->num[ i ];
-        ui = ( r0 + xi * y0 ) * t;
-
-        // This loop calculates the r <- r + x(i) * y bit. The x(i) value
-        // is in xi. We go though y(j) and r(j) using the pointers p1 and
-        // p2. We use the 64 bit variable p to hold the carry from one
-        // digit to the next. Note that since pr is always shifted to
-        // the right, the pr = pr + *pr + xi*p1 will not overflow, because
-        // 0xffffffff * 0xffffffff = fffffffe00000001 and if you add
-        // 2 * 0xffffffff = 0x1fffffffe to that you get 0xffffffffffffffff.
+        // Separated form: full product first, then the reduction. This lets
+        // the product use Karatsuba and the column-wise Comba kernel, which
+        // the interleaved loop below can not. The product takes the first
+        // 2n words of the scratch, the Karatsuba split the other 2n.
 
-        cp1 = y->num + n;
-        p2 = r->num + n;
-        pr = 0;
+        nn_mul_words( s, x->num, y->num, m->len, s + 2 * m->len );
+        rn = nn_mont_reduce( r->num, s, m->num, m->len, t );
+    }
+    else
+#endif
+    {
+        NN_Clr( r );
+        y0 = y->num[ n ];
+        rn = 0;
 
-        for ( j = n + 2 ; --j ; cp1--, p2-- )
+        for ( i = x->len ; i-- ; )
         {
-            pr   += NN_Mul32x32u64( xi, *cp1 ) + *p2;
-            *p2   = pr;
-            pr  >>= 32;
-        }
+            r0 = r->num[ n ];
+            xi = x->num[ i ];
+            ui = ( r0 + xi * y0 ) * t;
+
+            // This loop calculates the r <- r + x(i) * y bit. The x(i) value
+            // is in xi. We go though y(j) and r(j) using the pointers p1 and
+            // p2. We use the 64 bit variable p to hold the carry from one
+            // digit to the next. Note that since pr is always shifted to
+            // the right, the pr = pr + *pr + xi*p1 will not overflow, because
+            // 0xffffffff * 0xffffffff = fffffffe00000001 and if you add
+            // 2 * 0xffffffff = 0x1fffffffe to that you get 0xffffffffffffffff.
+
+            cp1 = y->num + n;
+            p2 = r->num + n;
+            pr = 0;
+
+            for ( j = n + 2 ; --j ; cp1--, p2-- )
+            {
+                pr   += NN_Mul32x32u64( xi, *cp1 ) + *p2;
+                *p2   = pr;
+                pr  >>= 32;
+            }
 
-        // Keep track of the overflow
+            // Keep track of the overflow. It is 64 bits wide: with an
+            // overflow of 1 left from the previous round and a carry of
+            // 0xffffffff (e.g. a modulus of all ones, or the top word of the
+            // WPS prime, with operands close to it) it reaches 2^32.
 
-        rn += pr;
+            rn += pr;
 
-        // Set up the pointers and do the first round of the loop outside
-        // of the loop, as we must not store the result (that will be the
-        // one that gets discarded by the shift right operation).
+            // Set up the pointers and do the first round of the loop outside
+            // of the loop, as we must not store the result (that will be the
+            // one that gets discarded by the shift right operation).
 
-        cp1 = m->num + n;
-        p2 = r->num + n;
-        pr = NN_Mul32x32u64( ui, *cp1-- ) + *p2--;
+            cp1 = m->num + n;
+            p2 = r->num + n;
+            pr = NN_Mul32x32u64( ui, *cp1-- ) + *p2--;
 
-        // This loop calculates the r <- ( r + u * m ) >> 32 bit. Note that
-        // lowest 32 bits or m and r are already processed and the result
-        // is in pr. The upper 32 bits, that were not written to r in the
-        // previous round are stored in rn while ui contains the value of
-        // u. The pointers cp1 and p2 are used to go through the words of
-        // m(j) and r(j) where j starts at 1, not zero.
+            // This loop calculates the r <- ( r + u * m ) >> 32 bit. Note that
+            // lowest 32 bits or m and r are already processed and the result
+            // is in pr. The upper 32 bits, that were not written to r in the
+            // previous round are stored in rn while ui contains the value of
+            // u. The pointers cp1 and p2 are used to go through the words of
+            // m(j) and r(j) where j starts at 1, not zero.
 
-        for ( j = n + 1 ; --j ; cp1--, p2-- )
-        {
-            pr  >>= 32;
-            pr   += NN_Mul32x32u64( ui, *cp1 ) + *p2;
-            p2[1] = pr;
-        }
+            for ( j = n + 1 ; --j ; cp1--, p2-- )
+            {
+                pr  >>= 32;
+                pr   += NN_Mul32x32u64( ui, *cp1 ) + *p2;
+                p2[1] = pr;
+            }
 
-        // The final 32 bits go to r(n-1), i.e r[0].
+            // The final 32 bits go to r(n-1), i.e r[0].
 
-        pr >>= 32;
-        pr  += rn;
-        r->num[0] = pr;
-        rn   = pr >> 32;
+            pr >>= 32;
+            pr  += rn;
+            r->num[0] = pr;
+            rn   = pr >> 32;
+        }
     }
 
     // This is the comparison loop. We go from MSB to LSB. If at any
@@ -1044,11 +1474,13 @@ WARNING: The function destroys x!
 \param[in]  e   The exponent.
 \param[in]  m   The modulus.
 \param[in]  w   Workspace, the same size as r, x or m.
+\param[in]  s   Scratch for NN_MulModMont, NN_MONT_SCRATCH_WORDS( m->len )
+                words, or NULL to use the interleaved multiply.
 */
 
 /* TODO: This should be have const parameters x, e, m, w  however the impementation does not lend itself to this */
 
-void NN_ExpModMont( NN_t* r, NN_t* x, NN_t* e, NN_t* m, NN_t* w )
+void NN_ExpModMont( NN_t* r, NN_t* x, NN_t* e, NN_t* m, NN_t* w, uint32_t* s )
 {
     uint32_t eb;
     uint32_t mt;
@@ -1091,7 +1523,7 @@ void NN_ExpModMont( NN_t* r, NN_t* x, NN_t* e, NN_t* m, NN_t* w )
         {
             if ( i )
             {
-                NN_MulModMont( pt2, pt1, pt1, m, mt );
+                NN_MulModMont( pt2, pt1, pt1, m, mt, s );
             }
             else
             {
@@ -1104,7 +1536,7 @@ void NN_ExpModMont( NN_t* r, NN_t* x, NN_t* e, NN_t* m, NN_t* w )
             {
                 if ( i )
                 {
-                    NN_MulModMont( pt1, pt2, r, m, mt );
+                    NN_MulModMont( pt1, pt2, r, m, mt, s );
                 }
                 else
                 {
@@ -1145,7 +1577,7 @@ void NN_ExpModMont( NN_t* r, NN_t* x, NN_t* e, NN_t* m, NN_t* w )
        This is only a programming technique.
     */
     pt2->num[ pt2->len - 1 ] = 1;
-    NN_MulModMont( r, pt1, pt2, m, mt );
+    NN_MulModMont( r, pt1, pt2, m, mt, s );
 }
 
 
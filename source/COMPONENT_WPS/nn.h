@@ -52,6 +52,9 @@ typedef struct
     uint32_t num[1];
 } NN_t;
 
+/* Words of scratch NN_MulModMont and NN_ExpModMont need for an n-word modulus */
+#define NN_MONT_SCRATCH_WORDS( n )      ( 4 * (n) )
+
 void     NN_Clr          ( NN_t* number );
 uint32_t NN_Add          ( NN_t* result, const NN_t*x, const NN_t*y );
 uint32_t NN_Sub          ( NN_t* result, const NN_t*x, const NN_t*y );
@@ -60,8 +63,8 @@ void     NN_AddMod       ( NN_t* result, const NN_t*x, const NN_t*y, const NN_t*
 void     NN_SubMod       ( NN_t* result, const NN_t*x, const NN_t*y, const NN_t*modulus );
 void     NN_MulMod       ( NN_t* result, const NN_t*x, const NN_t*y, const NN_t*modulus );
 void     NN_ExpMod       ( NN_t* result, NN_t*x, NN_t*modulus, NN_t*e, NN_t*w );
-void     NN_MulModMont   ( NN_t* result, const NN_t*x, const NN_t*y, const NN_t*m, uint32_t t );
-void     NN_ExpModMont   ( NN_t* result, NN_t*x, NN_t*m, NN_t*e, NN_t*w );
+void     NN_MulModMont   ( NN_t* result, const NN_t*x, const NN_t*y, const NN_t*m, uint32_t t, uint32_t* s );
+void     NN_ExpModMont   ( NN_t* result, NN_t*x, NN_t*m, NN_t*e, NN_t*w, uint32_t* s );
 uint32_t NN_EmTick       ( const NN_t* mod );
 void     NN_ErModEm      ( NN_t* result, const NN_t*m );
 uint64_t NN_Mul32x32u64  ( uint32_t a, uint32_t b );
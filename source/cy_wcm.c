@@ -37,6 +37,7 @@
 */
 
 #include <stdlib.h>
+#include <stddef.h>
 
 #include "cy_wcm.h"
 #include "cy_wcm_log.h"
@@ -46,6 +47,7 @@
 #include "whd_chip_constants.h"
 #include "whd_wlioctl.h"
 #include "cybsp_wifi.h"
+#include "cmsis_compiler.h"
 
 /*****************************************************************************
  * Macros
@@ -61,6 +63,14 @@
 #define DEFAULT_PM2_SLEEP_RET_TIME       (200)
 #endif
 
+/*
+ * Orders accesses to memory that is read without a lock: the state block shared between the cores and the trace ring.
+ * The CMSIS intrinsic is used rather than a compiler builtin so that GCC, Arm Compiler and IAR all build it.
+ */
+#ifndef WCM_MEMORY_BARRIER
+#define WCM_MEMORY_BARRIER()             __DMB()
+#endif
+
 #if defined(ENABLE_MULTICORE_CONN_MW) && defined(USE_VIRTUAL_API)
 
 #include <stdbool.h>
@@ -76,6 +86,66 @@ static cy_wcm_event_callback_t   virtual_wcm_event_handler[CY_WCM_MAXIMUM_CALLBA
 static bool                      is_virtual_event_handler_registered = false;
 static cy_mutex_t                event_handler_mutex;
 
+/* Bounds the retries of a reader that keeps seeing the primary core in the middle of an update */
+#define WCM_SHARED_STATE_READ_RETRIES    (8)
+
+static const cy_wcm_shared_state_t *wcm_shared_state = NULL;
+
+void cy_wcm_set_shared_state(const cy_wcm_shared_state_t *state)
+{
+    wcm_shared_state = state;
+}
+
+/*
+ * Used by the getters that VCM has no request for when the state block cannot be read. The connection state
+ * still comes from the primary core, over IPC if need be, so that a disconnected STA is reported as such.
+ */
+static cy_rslt_t shared_state_unavailable(const char *api)
+{
+    if( !cy_wcm_is_connected_to_ap() )
+    {
+        return CY_RSLT_WCM_STA_NETWORK_DOWN;
+    }
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "%s needs the shared state of the primary core \n", api);
+    return CY_RSLT_WCM_UNSUPPORTED_API;
+}
+
+/*
+ * Copies a consistent snapshot of the state published by the primary core.
+ * Returns false if no compatible block has been handed over or the primary core kept updating it.
+ */
+static bool read_shared_state(cy_wcm_shared_state_t *snapshot)
+{
+    const cy_wcm_shared_state_t *state = wcm_shared_state;
+    uint32_t sequence;
+    uint8_t  retry;
+
+    if(state == NULL)
+    {
+        return false;
+    }
+
+    for(retry = 0; retry < WCM_SHARED_STATE_READ_RETRIES; retry++)
+    {
+        sequence = state->sequence;
+        if(sequence & 1UL)
+        {
+            /* Let the primary core finish the update */
+            cy_rtos_delay_milliseconds(1);
+            continue;
+        }
+        WCM_MEMORY_BARRIER();
+        memcpy(snapshot, (const void *)state, sizeof(cy_wcm_shared_state_t));
+        WCM_MEMORY_BARRIER();
+        if(state->sequence == sequence)
+        {
+            return ((snapshot->magic == CY_WCM_SHARED_STATE_MAGIC) && (snapshot->version == CY_WCM_SHARED_STATE_VERSION));
+        }
+    }
+
+    return false;
+}
+
 static void virtual_event_handler(void *arg)
 {
     cy_rslt_t                       res;
@@ -199,6 +269,14 @@ cy_rslt_t cy_wcm_init(cy_wcm_config_t *config)
         virtual_wcm_event_handler[i] = NULL;
     }
 
+#ifdef WCM_SHARED_STATE_ADDRESS
+    /* Both images place the block at this address, see WCM_SHARED_STATE_SECTION on the primary core */
+    if( wcm_shared_state == NULL )
+    {
+        cy_wcm_set_shared_state((const cy_wcm_shared_state_t *)(WCM_SHARED_STATE_ADDRESS));
+    }
+#endif
+
     is_wcm_initialized = true;
 
     return res;
@@ -210,6 +288,7 @@ uint8_t cy_wcm_is_connected_to_ap(void)
     cy_vcm_response_t  api_response;
     cy_rslt_t          res = CY_RSLT_SUCCESS;
     uint8_t            is_connected = 0;
+    cy_wcm_shared_state_t state;
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "cy_wcm_is_connected_to_ap starts in secondary core\n");
 
@@ -219,6 +298,12 @@ uint8_t cy_wcm_is_connected_to_ap(void)
         return is_connected;
     }
 
+    /* Answer locally when the primary core publishes its state */
+    if( read_shared_state(&state) )
+    {
+        return state.is_connected;
+    }
+
     /* Set API request */
     memset(&api_request, 0, sizeof(cy_vcm_request_t));
     api_request.api_id = CY_VCM_API_WCM_IS_CONNECTED_AP;
@@ -240,6 +325,137 @@ uint8_t cy_wcm_is_connected_to_ap(void)
     return is_connected;
 }
 
+cy_rslt_t cy_wcm_get_ip_addr(cy_wcm_interface_t interface_type, cy_wcm_ip_address_t *ip_addr)
+{
+    cy_wcm_shared_state_t state;
+
+    if( !is_wcm_initialized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if( ip_addr == NULL )
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if( interface_type != CY_WCM_INTERFACE_TYPE_STA )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Only the STA interface is supported on secondary core \n");
+        return CY_RSLT_WCM_UNSUPPORTED_API;
+    }
+
+    if( !read_shared_state(&state) )
+    {
+        return shared_state_unavailable(__FUNCTION__);
+    }
+
+    if( !state.is_connected )
+    {
+        return CY_RSLT_WCM_STA_NETWORK_DOWN;
+    }
+    memcpy(ip_addr, &state.ip_addr, sizeof(cy_wcm_ip_address_t));
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_get_gateway_ip_address(cy_wcm_interface_t interface_type, cy_wcm_ip_address_t *gateway_addr)
+{
+    cy_wcm_shared_state_t state;
+
+    if( !is_wcm_initialized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if( gateway_addr == NULL )
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if( interface_type != CY_WCM_INTERFACE_TYPE_STA )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Only the STA interface is supported on secondary core \n");
+        return CY_RSLT_WCM_UNSUPPORTED_API;
+    }
+
+    if( !read_shared_state(&state) )
+    {
+        return shared_state_unavailable(__FUNCTION__);
+    }
+
+    if( !state.is_connected )
+    {
+        return CY_RSLT_WCM_STA_NETWORK_DOWN;
+    }
+    memcpy(gateway_addr, &state.gateway_addr, sizeof(cy_wcm_ip_address_t));
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_get_mac_addr(cy_wcm_interface_t interface_type, cy_wcm_mac_t *mac_addr)
+{
+    cy_wcm_shared_state_t state;
+
+    if( !is_wcm_initialized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if( mac_addr == NULL )
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if( interface_type != CY_WCM_INTERFACE_TYPE_STA )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Only the STA interface is supported on secondary core \n");
+        return CY_RSLT_WCM_UNSUPPORTED_API;
+    }
+
+    if( !read_shared_state(&state) )
+    {
+        /* The MAC address does not depend on the connection, and VCM has no request for it */
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "cy_wcm_get_mac_addr needs the shared state of the primary core \n");
+        return CY_RSLT_WCM_UNSUPPORTED_API;
+    }
+    memcpy(mac_addr, state.sta_mac, sizeof(cy_wcm_mac_t));
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_get_associated_ap_info(cy_wcm_associated_ap_info_t *ap_info)
+{
+    cy_wcm_shared_state_t state;
+
+    if( !is_wcm_initialized )
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if( ap_info == NULL )
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if( !read_shared_state(&state) )
+    {
+        return shared_state_unavailable(__FUNCTION__);
+    }
+
+    if( !state.is_connected )
+    {
+        return CY_RSLT_WCM_STA_NETWORK_DOWN;
+    }
+    memcpy(ap_info, &state.ap_info, sizeof(cy_wcm_associated_ap_info_t));
+
+    return CY_RSLT_SUCCESS;
+}
+
 cy_rslt_t cy_wcm_register_event_callback(cy_wcm_event_callback_t event_callback)
 {
     cy_rslt_t         result;
@@ -435,6 +651,9 @@ cy_rslt_t cy_wcm_get_whd_interface(cy_wcm_interface_t interface_type, whd_interf
 
 #include "whd_debug.h"
 #include "cy_nw_helper.h"
+#ifdef ENABLE_MULTICORE_CONN_MW
+#include "cy_wcm_internal.h"
+#endif
 
 extern cy_rslt_t wpa3_supplicant_sae_start (uint8_t *ssid, uint8_t ssid_len, uint8_t *passphrase, uint8_t passphrase_len);
 extern void wpa3_supplicant_sae_cleanup(void);
@@ -463,16 +682,51 @@ extern void wpa3_supplicant_sae_cleanup(void);
 #define CY_WCM_MAX_MUTEX_WAIT_TIME_MS               (120000)
 #define CY_WCM_INTERFACE_TYPE_UNKNOWN               (4)
 #define CY_WCM_DEFAULT_STA_CHANNEL                  (0)
+#define CY_WCM_MAX_2_4GHZ_CHANNEL                   (14)
 #define WCM_WORKER_THREAD_PRIORITY                  (CY_RTOS_PRIORITY_ABOVENORMAL)
 #ifndef WCM_WORKER_THREAD_STACK_SIZE
 #define WCM_WORKER_THREAD_STACK_SIZE                (10 * 1024)
 #endif
+#ifndef WCM_WORKER_CONTROL_LANE_SIZE
+#define WCM_WORKER_CONTROL_LANE_SIZE                (16)
+#endif
+#ifndef WCM_WORKER_BULK_LANE_SIZE
+#define WCM_WORKER_BULK_LANE_SIZE                   (32)
+#endif
+#ifndef WCM_ROAM_MAX_CHANNELS
+#define WCM_ROAM_MAX_CHANNELS                       (8)
+#endif
+#ifndef WCM_ROAM_MAX_RESULTS
+#define WCM_ROAM_MAX_RESULTS                        (8)
+#endif
+#ifndef WCM_ROAM_SCAN_ABORT_TIMEOUT_MS
+#define WCM_ROAM_SCAN_ABORT_TIMEOUT_MS              (1000)
+#endif
+#ifndef WCM_AP_CLIENT_TABLE_SIZE
+#define WCM_AP_CLIENT_TABLE_SIZE                    (16)
+#endif
+#ifndef WCM_AP_CLIENT_RECONCILE_INTERVAL_MS
+#define WCM_AP_CLIENT_RECONCILE_INTERVAL_MS         (60000)   /* 0 to reconcile only on cy_wcm_refresh_associated_clients() */
+#endif
+#ifndef WCM_PING_THREAD_STACK_SIZE
+#define WCM_PING_THREAD_STACK_SIZE                  (4 * 1024)
+#endif
+#ifndef WCM_ROAM_THREAD_STACK_SIZE
+#define WCM_ROAM_THREAD_STACK_SIZE                  (4 * 1024)
+#endif
+#ifndef WCM_WPS_THREAD_STACK_SIZE
+#define WCM_WPS_THREAD_STACK_SIZE                   (4 * 1024)
+#endif
+#define WCM_ROAM_FULL_SCAN_INTERVAL                 (4)     /* Every n-th roam scan covers all channels to find new ones */
+#define WCM_ROAM_RSSI_SCALE                         (16)    /* Fixed point scale of the smoothed RSSI */
+#define WCM_ROAM_MAX_SMOOTHING_SHIFT                (4)
 #define WCM_HANDSHAKE_TIMEOUT_MS                    (3000)
 #define WLC_EVENT_MSG_LINK                          (0x01)
 #define JOIN_RETRY_ATTEMPTS                         (3)
 #define DEFAULT_RETRY_BACKOFF_TIMEOUT_IN_MS         (1000)
 #define MAX_RETRY_BACKOFF_TIMEOUT_IN_MS             (DEFAULT_RETRY_BACKOFF_TIMEOUT_IN_MS * 32)
 #define DHCP_TIMEOUT_COUNT                          (6000) /* 6000 times */
+#define REASSOC_LINK_UP_TIMEOUT_COUNT               (100)  /* 100 * 10 ms = 1 second */
 #define UNKNOWN_BAND_WIDTH                          (0)
 #define ARP_WAIT_TIME_IN_MSEC                       (30000)
 #define ARP_CACHE_CHECK_INTERVAL_IN_MSEC            (5)
@@ -485,25 +739,22 @@ extern void wpa3_supplicant_sae_cleanup(void);
 #define PING_RESPONSE_LEN                           (64)
 #define SCAN_BSSID_ARR_LENGTH                       (50)
 #define MAX_SCAN_RETRY                              (20)
+#define WCM_SECURITY_CACHE_SIZE                     (4)
+#define WCM_SECURITY_PROBE_TIMEOUT_MS               (10000)   /* Bounds one security probe, or the wait for a scan in progress to end */
 
 /* Macro for 43012 statistics */
 #define WL_CNT_VER_30                               (30)
 #define WL_CNT_VER_10                               (10)
-#define CHK_CNTBUF_DATALEN(cntbuf, ioctl_buflen) do { \
-if (((wl_cnt_info_t *)cntbuf)->datalen + \
-OFFSETOF(wl_cnt_info_t, data) > ioctl_buflen) \
-printf("%s: IOVAR buffer short!\n", __FUNCTION__); \
-} while (0)
+#define WCM_CNT_XTLV_WLC                            (0x100)   /* XTLV id of the wl_cnt_ver_30_t counters */
 
 #define NEVER_TIMEOUT                              ((uint32_t) 0xFFFFFFFF)
 #define MAX_SEMA_COUNT                             (1)
-#define XTLV_OPTION_ALIGN32                        0x0001 /* 32bit alignment of type.len.data */
-#define XTLV_OPTION_IDU8                           0x0002 /* shorter id */
-#define XTLV_OPTION_LENU8                          0x0004 /* shorted length */
 #define WCM_ALIGN_SIZE(size, boundary) (((size) + (boundary) - 1) \
                                              & ~((boundary) - 1))
 #define OFFSETOF(type, member)  ( (uintptr_t)&( (type *)0 )->member )
 #define _LTOH16_UA(cp) ((cp)[0] | ((cp)[1] << 8))
+#define WCM_XTLV_HDR_SIZE                          (OFFSETOF(xtlv_t, data))
+#define WCM_COUNTER_FIELD(type, field, counter)    { (uint16_t)offsetof(type, field), (uint8_t)(counter) }
 
 /* TWT definitions */
 #define CY_WCM_TWT_SETUP_CMD                        TWT_SETUP_CMD_SUGGEST_TWT
@@ -516,6 +767,8 @@ printf("%s: IOVAR buffer short!\n", __FUNCTION__); \
 
 #define CY_WCM_TWT_MANTISSA_ACTIVE_PROF             (50000)
 #define CY_WCM_TWT_EXPONENT_ACTIVE_PROF             (0)
+#define WCM_ITWT_MAX_FLOWS                          (8)
+#define WCM_ITWT_WAKE_DURATION_UNIT_US              (256)
 
 
 /******************************************************
@@ -524,16 +777,35 @@ printf("%s: IOVAR buffer short!\n", __FUNCTION__); \
 typedef struct
 {
     cy_wcm_scan_result_callback_t p_scan_calback;       /* Callback handler to be invoked to inform caller */
+    cy_wcm_scan_view_callback_t   p_scan_view_callback; /* Set instead of p_scan_calback for a scan started with cy_wcm_start_scan_view */
     void*                         user_data;            /* Argument to be passed back to the user while invoking the callback */
     whd_scan_result_t             scan_res;             /* Scan result */
     whd_scan_status_t             scan_status;          /* Scan status */
     cy_wcm_scan_filter_t          scan_filter;          /* Scan filtering type */
-    bool                          is_scanning;          /* Indicates if scanning is ongoing */
+    cy_wcm_scan_request_t         scan_request;         /* Combined filters of cy_wcm_start_scan_request; zero for the other scans */
+    volatile bool                 is_scanning;          /* Indicates if scanning is ongoing */
     bool                          is_stop_scan_req;     /* Indicates if stop scan was requested */
-    bool                          get_security_type;    /* Indicates if cy_wcm_connect_ap is trying to find the security type */
+    volatile bool                 get_security_type;    /* Indicates if cy_wcm_connect_ap is trying to find the security type */
+    bool                          is_probe_waiting;     /* cy_wcm_connect_ap waits for the scan in progress to end before probing */
 }wcm_internal_scan_t;
 
+typedef struct
+{
+    cy_wcm_ssid_t                 SSID;                 /* SSID whose security was probed */
+    cy_wcm_security_t             security;             /* Security found by the probe */
+    uint32_t                      last_used;            /* security_cache_clock at the last lookup or store */
+    bool                          in_use;               /* Entry is valid */
+} wcm_security_cache_entry_t;
+
+/* Borrowed view handed to cy_wcm_scan_view_callback_t; lives on the WHD thread's stack for one callback */
+struct cy_wcm_scan_result_view
+{
+    const whd_scan_result_t       *result;              /* Result in the WHD receive buffer */
+};
+
 static wcm_internal_scan_t scan_handler;
+static wcm_security_cache_entry_t security_cache[WCM_SECURITY_CACHE_SIZE];
+static uint32_t security_cache_clock = 0;
 
 typedef struct
 {
@@ -548,12 +820,139 @@ typedef struct
 
 static wcm_ap_details connected_ap_details;
 
+typedef struct
+{
+    whd_mac_t                     BSSID;
+    int16_t                       signal_strength;
+    uint8_t                       channel;
+    whd_802_11_band_t             band;
+}wcm_roam_result_t;
+
+typedef struct
+{
+    cy_wcm_roam_config_t          config;
+    bool                          is_enabled;
+    volatile bool                 is_scanning;
+    bool                          is_stop_scan_req;     /* Set when a scan of the application aborts the roam scan */
+    volatile bool                 is_joining;           /* Set while joining the roam target, the link-down of the old AP is expected */
+    bool                          has_samples;
+    int32_t                       smoothed_rssi;        /* RSSI in dBm scaled by WCM_ROAM_RSSI_SCALE */
+    bool                          has_scanned;
+    cy_time_t                     last_scan_time;
+    uint32_t                      scan_count;
+    whd_ssid_t                    SSID;                 /* Network the known channels belong to */
+    whd_mac_t                     current_bssid;
+    uint16_t                      channels[WCM_ROAM_MAX_CHANNELS + 1];  /* Known channels of the network, zero terminated */
+    uint8_t                       channel_count;
+    wcm_roam_result_t             results[WCM_ROAM_MAX_RESULTS];  /* APs of the network seen by the last roam scan, written only while it runs */
+    uint8_t                       result_count;
+}wcm_roam_handler_t;
+
+static wcm_roam_handler_t roam_handler;
+
+/* State of the ping session started with cy_wcm_ping_start(), protected by ping_mutex */
+typedef struct
+{
+    cy_wcm_ping_config_t          config;
+    cy_wcm_ping_callback_t        callback;
+    void                          *user_data;
+    bool                          is_active;
+    volatile bool                 is_round_queued;      /* Not protected by ping_mutex, set with interrupts masked in ping_timer_handler() */
+    uint32_t                      session_id;           /* Changes with every start, so that a round of an old session cannot update a new one */
+    uint32_t                      rounds;
+    uint64_t                      rtt_sum_ms[CY_WCM_PING_MAX_TARGETS];
+    cy_wcm_ping_target_stats_t    stats[CY_WCM_PING_MAX_TARGETS];
+}wcm_ping_session_t;
+
+static wcm_ping_session_t ping_session;
+
+/* Individual TWT agreement of the STA, indexed by flow ID. Protected by wcm_sta_mutex. */
+typedef struct
+{
+    bool                          is_active;            /* Agreement in place with the current AP */
+    bool                          restore;              /* Agreement ended with the link and is set up again after the STA reconnects */
+    cy_wcm_itwt_setup_params_t    params;               /* Parameters the agreement was requested with */
+    cy_time_t                     active_since;
+    cy_wcm_itwt_flow_stats_t      stats;
+}wcm_itwt_flow_t;
+
+static wcm_itwt_flow_t itwt_flows[WCM_ITWT_MAX_FLOWS];
+
+/* Payload of WLC_E_TWT_TEARDOWN, laid out as the firmware sends it */
+typedef struct
+{
+    uint16_t                      version;
+    uint16_t                      length;
+    uint8_t                       config_id;
+    uint8_t                       pad[3];
+    uint32_t                      status;
+    uint8_t                       negotiation_type;
+    uint8_t                       flow_id;
+    uint8_t                       bid;
+    uint8_t                       all_twt;              /* Non-zero when all agreements are torn down */
+}wcm_itwt_teardown_event_t;
+
 typedef struct
 {
   cy_wcm_event_t   event;
   cy_wcm_mac_t     mac_addr;
+  bool             notify;          /* False if the event only updates the client table */
 } wcm_ap_link_event;
 
+/* Client of the SoftAP, maintained from the AP link events. Protected by wcm_ap_mutex. */
+typedef struct
+{
+    bool                         in_use;
+    cy_wcm_mac_t                 mac_addr;
+    int16_t                      rssi;
+    cy_time_t                    join_time;
+    cy_time_t                    last_seen_time;
+} wcm_ap_client_t;
+
+/* Buffer with the layout of whd_maclist_t for a full client table */
+typedef struct
+{
+    uint32_t                     count;
+    whd_mac_t                    mac_list[WCM_AP_CLIENT_TABLE_SIZE];
+} wcm_ap_maclist_t;
+
+/* One registered event callback. Exactly one of callback and callback_ex is set. */
+typedef struct
+{
+    cy_wcm_event_callback_t      callback;       /* Registered with cy_wcm_register_event_callback() */
+    cy_wcm_event_callback_ex_t   callback_ex;    /* Registered with cy_wcm_register_event_callback_ex() */
+    uint32_t                     event_mask;
+    void                         *user_data;
+} wcm_event_subscriber_t;
+
+/*
+ * Immutable list of event callbacks. Registration builds a new list and swaps the pointer,
+ * see invoke_app_callbacks() for why the dispatch does not need a lock.
+ */
+typedef struct
+{
+    uint32_t                     count;
+    wcm_event_subscriber_t       subscriber[1];
+} wcm_event_registry_t;
+
+
+/* Work item waiting in a lane of the WCM worker thread */
+typedef struct
+{
+    cy_worker_thread_func_t      *work_func;
+    void                         *arg;
+    cy_time_t                    queued_time;
+} wcm_worker_job_t;
+
+/* Ring of pending work items. Pending work in a lane runs in the order it was queued. */
+typedef struct
+{
+    wcm_worker_job_t             *jobs;
+    uint16_t                     size;
+    uint16_t                     head;
+    uint16_t                     count;
+    cy_wcm_worker_lane_stats_t   stats;
+} wcm_worker_lane_t;
 
 typedef struct xtlv
 {
@@ -573,6 +972,37 @@ typedef enum
     WCM_WIFI_CHANSPEC_6GHZ   = 0x80     /**< 6-GHz radio band.   */
 } wcm_wifi_band_chanspec_t;
 
+/* Firmware counters kept as 64-bit totals */
+typedef enum
+{
+    WCM_CNT_RX_BYTES = 0,
+    WCM_CNT_TX_BYTES,
+    WCM_CNT_RX_PACKETS,
+    WCM_CNT_TX_PACKETS,
+    WCM_CNT_TX_RETRIES,
+    WCM_CNT_TX_FAILED,
+    WCM_CNT_TX_ERRORS,
+    WCM_CNT_RX_FCS_ERRORS,
+    WCM_CNT_RX_DROPPED,
+    WCM_CNT_RX_ERRORS,
+    WCM_CNT_MAX
+} wcm_counter_t;
+
+/* Location of one 32-bit counter in a firmware counters structure */
+typedef struct
+{
+    uint16_t                     offset;
+    uint8_t                      counter;       /* wcm_counter_t */
+} wcm_counter_field_t;
+
+/* 64-bit totals of the counters of one interface, and the firmware values they were last updated from */
+typedef struct
+{
+    bool                         has_snapshot;
+    uint32_t                     last[WCM_CNT_MAX];
+    uint64_t                     total[WCM_CNT_MAX];
+} wcm_counter_totals_t;
+
 /******************************************************
  *               Variable Definitions
  ******************************************************/
@@ -585,10 +1015,32 @@ whd_interface_t whd_ifs[MAX_WHD_INTERFACE];
 bool is_wcm_initalized                 = false;
 bool is_tcp_initialized                = false;
 bool is_itwt_enabled                   = false;
-static cy_mutex_t wcm_mutex;
+bool is_soft_ap_up                     = false;
+/*
+ * WCM state is split into lock domains:
+ *   wcm_scan_mutex   - scan_handler and the scan result filter/callback
+ *   wcm_sta_mutex    - STA connection: connect/disconnect, link up/down, handshake retry, connected_ap_details
+ *   wcm_ap_mutex     - SoftAP: start/stop, client list, AP IP settings
+ *   wcm_config_mutex - event callback registry and interface configuration
+ *   wcm_wps_mutex    - WPS enrollment session and the timeline of the last enrollment (cy_wcm_wps.c)
+ * When more than one is needed they must be taken in the order listed above; for example, a scan
+ * callback (scan held) may call cy_wcm_connect_ap (takes STA). A lock is never held while calling
+ * into an earlier domain. All of them are recursive.
+ */
+static cy_mutex_t wcm_scan_mutex;
+static cy_mutex_t wcm_sta_mutex;
+static cy_mutex_t wcm_ap_mutex;
+static cy_mutex_t wcm_config_mutex;
+#ifdef COMPONENT_WPS
+/* Not static as it is used by cy_wcm_wps.c */
+cy_mutex_t wcm_wps_mutex;
+static cy_worker_thread_info_t wps_worker_thread;
+/* Number of enrollments and registrars using the WPS thread, and whether the thread is being deleted. Both under wcm_wps_mutex */
+static uint8_t wps_worker_users = 0;
+static bool is_wps_thread_deleting = false;
+#endif
 static cy_wcm_interface_t                current_interface;
 static bool wcm_sta_link_up            = false;
-static bool is_soft_ap_up              = false;
 static bool is_sta_network_up          = false;
 static bool is_ap_network_up           = false;
 static bool is_sta_interface_created   = false;
@@ -598,6 +1050,7 @@ static bool is_olm_initialized         = false;
 static void *olm_instance              = NULL;
 static bool is_disconnect_triggered    = false;
 static bool is_connect_triggered       = false;
+static volatile bool is_reassoc_triggered = false;   /* Set while cy_wcm_connect_ap() reassociates, the link-down of the old AP is expected */
 
 whd_scan_result_t scan_result;
 cy_wcm_scan_result_callback_t p_scan_calback;
@@ -605,10 +1058,52 @@ cy_wcm_scan_filter_t *p_scan_filter = NULL;
 
 static cy_timer_t sta_handshake_timer;
 static cy_timer_t sta_retry_timer;
-static cy_wcm_event_callback_t wcm_event_handler[CY_WCM_MAXIMUM_CALLBACKS_COUNT];
+static cy_timer_t sta_roam_timer;
+static cy_timer_t ap_client_reconcile_timer;
+static wcm_ap_client_t ap_clients[WCM_AP_CLIENT_TABLE_SIZE];
+static whd_scan_result_t roam_scan_result;
+static wcm_event_registry_t * volatile wcm_event_registry = NULL;
+static cy_mutex_t                        worker_lane_mutex;
+static wcm_worker_job_t                  control_lane_jobs[WCM_WORKER_CONTROL_LANE_SIZE];
+static wcm_worker_job_t                  bulk_lane_jobs[WCM_WORKER_BULK_LANE_SIZE];
+static wcm_worker_lane_t                 worker_lanes[CY_WCM_WORKER_LANE_MAX] =
+{
+    { control_lane_jobs, WCM_WORKER_CONTROL_LANE_SIZE, 0, 0, { 0 } },
+    { bulk_lane_jobs,    WCM_WORKER_BULK_LANE_SIZE,    0, 0, { 0 } }
+};
+static bool is_worker_dispatch_queued  = false;
+static cy_mutex_t                        ping_mutex;
+#ifdef ENABLE_MULTICORE_CONN_MW
+/* Placed in a section of its own when the secondary core finds the block at a fixed address (WCM_SHARED_STATE_ADDRESS) */
+#ifdef WCM_SHARED_STATE_SECTION
+CY_SECTION(WCM_SHARED_STATE_SECTION)
+#else
+CY_SECTION_SHAREDMEM
+#endif
+static cy_wcm_shared_state_t             wcm_shared_state;
+#endif
+#ifdef ENABLE_WCM_TRACE
+#if (CY_WCM_TRACE_BUFFER_SIZE & (CY_WCM_TRACE_BUFFER_SIZE - 1)) != 0
+#error "CY_WCM_TRACE_BUFFER_SIZE must be a power of two"
+#endif
+/* Not static, so that a debugger can find and dump it by name */
+cy_wcm_trace_buffer_t cy_wcm_trace_buffer =
+{
+    CY_WCM_TRACE_MAGIC, CY_WCM_TRACE_VERSION, sizeof(cy_wcm_trace_record_t), CY_WCM_TRACE_BUFFER_SIZE, 0, { { 0 } }
+};
+#endif
+static cy_timer_t                        ping_timer;
+static cy_worker_thread_info_t           ping_worker_thread;
+static bool is_ping_thread_created     = false;
+static cy_worker_thread_info_t           roam_worker_thread;
+static bool is_roam_thread_created     = false;
 static uint16_t sta_event_handler_index   = 0xFF;
 static uint16_t ap_event_handler_index    = 0xFF;
+#ifdef COMPONENT_55900
+static const whd_event_num_t  sta_link_events[] = {WLC_E_LINK, WLC_E_DEAUTH_IND, WLC_E_DISASSOC_IND, WLC_E_PSK_SUP, WLC_E_CSA_COMPLETE_IND, WLC_E_TWT_TEARDOWN, WLC_E_NONE};
+#else
 static const whd_event_num_t  sta_link_events[] = {WLC_E_LINK, WLC_E_DEAUTH_IND, WLC_E_DISASSOC_IND, WLC_E_PSK_SUP, WLC_E_CSA_COMPLETE_IND, WLC_E_NONE};
+#endif
 static const whd_event_num_t  ap_link_events[]  = {WLC_E_DISASSOC_IND, WLC_E_DEAUTH_IND, WLC_E_ASSOC_IND, WLC_E_REASSOC_IND, WLC_E_AUTHORIZED, WLC_E_NONE};
 static bool too_many_ie_error          = false;
 static bool link_up_event_received     = false;
@@ -616,13 +1111,45 @@ static uint32_t retry_backoff_timeout  = DEFAULT_RETRY_BACKOFF_TIMEOUT_IN_MS;
 
 static whd_mac_t *mac_addr_arr = NULL;
 static int current_bssid_arr_length = 0;
+/*
+ * BSSIDs reported by a view scan. The array is only written on the WHD thread while the scan runs and is never freed,
+ * so a view scan does not depend on mac_addr_arr, which the worker frees when it handles the scan completion.
+ */
+static whd_mac_t scan_view_bssid_arr[SCAN_BSSID_ARR_LENGTH];
+static int scan_view_bssid_arr_length = 0;
 static cy_semaphore_t stop_scan_semaphore;
+static wcm_counter_totals_t wlan_counter_totals[MAX_WHD_INTERFACE];
+static const wcm_counter_field_t cnt_ver_10_fields[] =
+{
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, rxbyte,  WCM_CNT_RX_BYTES),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, txbyte,  WCM_CNT_TX_BYTES),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, rxfrag,  WCM_CNT_RX_PACKETS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, txfrag,  WCM_CNT_TX_PACKETS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, txretry, WCM_CNT_TX_RETRIES),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, txfail,  WCM_CNT_TX_FAILED),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, txerror, WCM_CNT_TX_ERRORS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, rxcrc,   WCM_CNT_RX_FCS_ERRORS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, rxnobuf, WCM_CNT_RX_DROPPED),
+    WCM_COUNTER_FIELD(wl_cnt_ver_ten_t, rxerror, WCM_CNT_RX_ERRORS)
+};
+static const wcm_counter_field_t cnt_ver_30_fields[] =
+{
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, rxbyte,  WCM_CNT_RX_BYTES),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, txbyte,  WCM_CNT_TX_BYTES),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, rxfrag,  WCM_CNT_RX_PACKETS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, txfrag,  WCM_CNT_TX_PACKETS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, txretry, WCM_CNT_TX_RETRIES),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, txfail,  WCM_CNT_TX_FAILED),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, txerror, WCM_CNT_TX_ERRORS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, rxcrc,   WCM_CNT_RX_FCS_ERRORS),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, rxnobuf, WCM_CNT_RX_DROPPED),
+    WCM_COUNTER_FIELD(wl_cnt_ver_30_t, rxerror, WCM_CNT_RX_ERRORS)
+};
 static cy_semaphore_t security_type_start_scan_semaphore;
 static cy_wcm_security_t ap_security;
 static cy_network_interface_context *nw_ap_if_ctx;
 static cy_network_interface_context *nw_sta_if_ctx;
 
-typedef uint16_t xtlv_opts_t;
 
 /******************************************************
  *               Static Function Declarations
@@ -630,6 +1157,9 @@ typedef uint16_t xtlv_opts_t;
 static cy_rslt_t check_ap_credentials(const cy_wcm_connect_params_t *connect_params);
 static cy_rslt_t convert_connect_params(const cy_wcm_connect_params_t *connect_params, whd_ssid_t *ssid, whd_mac_t *bssid, uint8_t **key, uint8_t *keylen, whd_security_t *security, cy_network_static_ip_addr_t *static_ip_addr);
 static bool is_connected_to_same_ap(const cy_wcm_connect_params_t *connect_params);
+static bool is_same_ap_credentials(whd_security_t security, const uint8_t *key, uint8_t keylen);
+static void save_connected_ap_details(const cy_wcm_connect_params_t *connect_params, const whd_ssid_t *ssid, const whd_mac_t *bssid,
+                                      const uint8_t *key, uint8_t keylen, whd_security_t security, const cy_network_static_ip_addr_t *static_ip);
 static bool check_wcm_security(cy_wcm_security_t sec);
 static void internal_scan_callback(whd_scan_result_t **result_ptr, void *user_data, whd_scan_status_t status);
 static void *link_events_handler(whd_interface_t ifp, const whd_event_header_t *event_header, const uint8_t *event_data, void *handler_user_data);
@@ -647,9 +1177,48 @@ static cy_rslt_t network_up(whd_interface_t interface, cy_network_hw_interface_t
 static void network_down(whd_interface_t interface, cy_network_hw_interface_type_t iface_type);
 static void hanshake_retry_timer(cy_timer_callback_arg_t arg);
 static void invoke_app_callbacks(cy_wcm_event_t event_type, cy_wcm_event_data_t* arg);
+#ifdef ENABLE_MULTICORE_CONN_MW
+static void publish_shared_state(bool is_valid);
+#endif
+static cy_rslt_t update_event_registry(const wcm_event_subscriber_t *subscriber, bool add);
+static void free_event_registry(void *arg);
+static cy_rslt_t wcm_worker_enqueue(cy_wcm_worker_lane_t lane, cy_worker_thread_func_t *work_func, void *arg, bool coalesce);
+static void wcm_worker_dispatch(void *arg);
+static void reset_worker_lanes(void);
+static uint16_t take_worker_jobs(wcm_worker_job_t *jobs);
+static void free_worker_jobs(const wcm_worker_job_t *jobs, uint16_t count);
+static cy_rslt_t init_wcm_locks(void);
+static void roam_timer_handler(cy_timer_callback_arg_t arg);
+static void roam_sample_handler(void *arg);
+static void roam_start_scan(void);
+static void roam_scan_callback(whd_scan_result_t **result_ptr, void *user_data, whd_scan_status_t status);
+static void roam_join_handler(void *arg);
+static void roam_add_channel(uint16_t channel);
+static void roam_record_result(const whd_scan_result_t *result);
+static void abort_roam_scan(void);
+static wcm_ap_client_t *ap_client_table_find(const uint8_t *mac_addr);
+static wcm_ap_client_t *ap_client_table_update(const uint8_t *mac_addr);
+static cy_rslt_t ap_client_table_reconcile(void);
+static void ap_client_reconcile_timer_handler(cy_timer_callback_arg_t arg);
+static void ap_client_reconcile_handler(void *arg);
+static uint32_t itwt_wake_interval_us(uint16_t mantissa, uint8_t exponent);
+static cy_rslt_t itwt_setup_flow(uint8_t flow_id);
+static void itwt_read_negotiated(uint8_t flow_id);
+static void itwt_flow_down(uint8_t flow_id, bool restore);
+static void itwt_link_lost(void);
+static void itwt_restore_handler(void *arg);
+#ifdef COMPONENT_55900
+static void itwt_teardown_event_handler(void *arg);
+#endif
+static cy_rslt_t ping_check_interface(cy_wcm_interface_t interface);
+static uint8_t ping_histogram_bin(uint32_t rtt_ms);
+static void ping_timer_handler(cy_timer_callback_arg_t arg);
+static void ping_round_handler(void *arg);
+static void deinit_wcm_locks(void);
 static cy_wcm_bss_type_t  whd_to_wcm_bss_type(whd_bss_type_t bss_type);
-static cy_wcm_wifi_band_t whd_to_wcm_band(whd_802_11_band_t band);
-static whd_security_t wcm_to_whd_security(cy_wcm_security_t sec);
+cy_wcm_wifi_band_t whd_to_wcm_band(whd_802_11_band_t band);
+whd_security_t wcm_to_whd_security(cy_wcm_security_t sec);
+cy_rslt_t cy_wcm_connect_ap_on_channel(cy_wcm_connect_params_t *connect_params, uint8_t channel, cy_wcm_ip_address_t *ip_addr);
 static uint16_t channel_to_bandwidth(wl_chanspec_t chanspec);
 static void notify_connection_status(void* arg);
 static cy_rslt_t check_soft_ap_config(const cy_wcm_ap_config_t *ap_config_params);
@@ -658,18 +1227,27 @@ static void* ap_link_events_handler(whd_interface_t ifp, const whd_event_header_
 static cy_rslt_t init_whd_wifi_interface(cy_wcm_config_t *config);
 static bool check_if_ent_auth_types(cy_wcm_security_t auth_type);
 
-static void unpack_xtlv_buf(const uint8_t *tlv_buf, uint16_t buflen,cy_wcm_wlan_statistics_t *stat);
-static cy_rslt_t wl_counters(const uint8_t *data, cy_wcm_wlan_statistics_t *stat);
-static void xtlv_unpack_xtlv(const xtlv_t *xtlv, uint16_t *type, uint16_t *len, const uint8_t **data, xtlv_opts_t opts);
-static int xtlv_hdr_size(xtlv_opts_t opts, const uint8_t **data);
-static int xtlv_id(const xtlv_t *elt, xtlv_opts_t opts);
-static int xtlv_len(const xtlv_t *elt, xtlv_opts_t opts);
-static int xtlv_size_for_data(int dlen, xtlv_opts_t opts, const uint8_t **data);
-static int ltoh16_ua(const uint8_t * bytes);
+static const uint8_t *find_xtlv(const uint8_t *buf, uint32_t buflen, uint16_t id, uint16_t *len);
+static void accumulate_counters(wcm_counter_totals_t *totals, const uint8_t *data, uint32_t len, const wcm_counter_field_t *fields, uint8_t field_count);
+static cy_rslt_t read_wlan_counters(cy_wcm_interface_t interface, cy_wcm_wlan_counters_t *counters);
 static void process_scan_data(void *arg);
 static void notify_scan_completed(void *arg);
+static cy_rslt_t start_scan(cy_wcm_scan_result_callback_t callback, cy_wcm_scan_view_callback_t view_callback, void *user_data,
+                            cy_wcm_scan_filter_t *scan_filter, const cy_wcm_scan_request_t *request);
+static cy_rslt_t set_scan_band(cy_wcm_wifi_band_t band);
+static bool scan_request_accept(const whd_scan_result_t *whd_scan_res);
+static bool scan_result_accept(const whd_scan_result_t *whd_scan_res, whd_mac_t *bssid_arr, int *bssid_arr_length);
+static void deliver_scan_view(const whd_scan_result_t *whd_scan_res);
+static bool security_cache_lookup(const uint8_t *ssid, cy_wcm_security_t *security);
+static void security_cache_store(const uint8_t *ssid, cy_wcm_security_t security);
+static void wake_security_probe(void);
 
 cy_wcm_security_t whd_to_wcm_security(whd_security_t sec);
+cy_rslt_t cy_wcm_enqueue_worker_job(cy_worker_thread_func_t *work_func, void *arg);
+#ifdef COMPONENT_WPS
+cy_rslt_t cy_wcm_create_wps_worker(void);
+cy_rslt_t cy_wcm_enqueue_wps_job(cy_worker_thread_func_t *work_func, void *arg);
+#endif
 
 /******************************************************
  *               Function Definitions
@@ -772,7 +1350,7 @@ cy_rslt_t cy_wcm_init(cy_wcm_config_t *config)
         is_tcp_initialized = true;
     }
 
-    if (cy_rtos_init_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (init_wcm_locks() != CY_RSLT_SUCCESS)
     {
         return CY_RSLT_WCM_MUTEX_ERROR;
     }
@@ -780,14 +1358,14 @@ cy_rslt_t cy_wcm_init(cy_wcm_config_t *config)
     /* Initialize semaphore */
     if(cy_rtos_init_semaphore(&stop_scan_semaphore, MAX_SEMA_COUNT, 0) != CY_RSLT_SUCCESS)
     {
-        cy_rtos_deinit_mutex(&wcm_mutex);
+        deinit_wcm_locks();
         return CY_RSLT_WCM_SEMAPHORE_ERROR;
     }
 
     if(cy_rtos_init_semaphore(&security_type_start_scan_semaphore, MAX_SEMA_COUNT, 0) != CY_RSLT_SUCCESS)
     {
         cy_rtos_deinit_semaphore(&stop_scan_semaphore);
-        cy_rtos_deinit_mutex(&wcm_mutex);
+        deinit_wcm_locks();
         return CY_RSLT_WCM_SEMAPHORE_ERROR;
     }
 
@@ -796,10 +1374,30 @@ cy_rslt_t cy_wcm_init(cy_wcm_config_t *config)
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error : Initializing Wi-Fi interface \n");
         cy_rtos_deinit_semaphore(&security_type_start_scan_semaphore);
         cy_rtos_deinit_semaphore(&stop_scan_semaphore);
-        cy_rtos_deinit_mutex(&wcm_mutex);
+        deinit_wcm_locks();
         return res;
     }
 
+    if(cy_rtos_init_mutex(&worker_lane_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_semaphore(&security_type_start_scan_semaphore);
+        cy_rtos_deinit_semaphore(&stop_scan_semaphore);
+        deinit_wcm_locks();
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    reset_worker_lanes();
+    memset(wlan_counter_totals, 0, sizeof(wlan_counter_totals));
+
+    if(cy_rtos_init_mutex(&ping_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&worker_lane_mutex);
+        cy_rtos_deinit_semaphore(&security_type_start_scan_semaphore);
+        cy_rtos_deinit_semaphore(&stop_scan_semaphore);
+        deinit_wcm_locks();
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    memset(&ping_session, 0, sizeof(ping_session));
+
     memset(&params, 0, sizeof(params));
     params.name = "WCM- Worker";
     params.priority = WCM_WORKER_THREAD_PRIORITY;
@@ -809,17 +1407,25 @@ cy_rslt_t cy_wcm_init(cy_wcm_config_t *config)
     /* create a worker thread */
     if(cy_worker_thread_create(&cy_wcm_worker_thread, &params) != CY_RSLT_SUCCESS)
     {
+        cy_rtos_deinit_mutex(&ping_mutex);
+        cy_rtos_deinit_mutex(&worker_lane_mutex);
         cy_rtos_deinit_semaphore(&security_type_start_scan_semaphore);
         cy_rtos_deinit_semaphore(&stop_scan_semaphore);
-        cy_rtos_deinit_mutex(&wcm_mutex);
+        deinit_wcm_locks();
         return CY_RSLT_WCM_MUTEX_ERROR;
     }
+    cy_rtos_init_timer(&ping_timer, CY_TIMER_TYPE_PERIODIC, ping_timer_handler, 0);
+    cy_rtos_init_timer(&ap_client_reconcile_timer, CY_TIMER_TYPE_PERIODIC, ap_client_reconcile_timer_handler, 0);
 
     if(config->interface != CY_WCM_INTERFACE_TYPE_AP)
     {
         cy_rtos_init_timer(&sta_handshake_timer, CY_TIMER_TYPE_ONCE, handshake_timeout_handler, 0);
         cy_rtos_init_timer(&sta_retry_timer, CY_TIMER_TYPE_ONCE, hanshake_retry_timer, 0);
+        cy_rtos_init_timer(&sta_roam_timer, CY_TIMER_TYPE_PERIODIC, roam_timer_handler, 0);
+        memset(&roam_handler, 0, sizeof(roam_handler));
+        memset(security_cache, 0, sizeof(security_cache));
         scan_handler.is_scanning = false;
+        scan_handler.is_probe_waiting = false;
         olm_instance = cy_get_olm_instance();
         if(olm_instance != NULL)
         {
@@ -836,15 +1442,20 @@ cy_rslt_t cy_wcm_init(cy_wcm_config_t *config)
         cy_network_register_ip_change_cb(nw_sta_if_ctx, lwip_ip_change_callback, NULL);
     }
 
-    memset(wcm_event_handler, 0, sizeof(wcm_event_handler));
+    wcm_event_registry = NULL;
     current_interface = config->interface;
     is_wcm_initalized = true;
+#ifdef ENABLE_MULTICORE_CONN_MW
+    publish_shared_state(true);
+#endif
     return res;
 }
 
 cy_rslt_t cy_wcm_deinit()
 {
     cy_rslt_t res = CY_RSLT_SUCCESS;
+    wcm_worker_job_t pending_jobs[WCM_WORKER_CONTROL_LANE_SIZE + WCM_WORKER_BULK_LANE_SIZE];
+    uint16_t pending_count;
 
     if(!is_wcm_initalized)
     {
@@ -852,6 +1463,32 @@ cy_rslt_t cy_wcm_deinit()
         return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
+    /* Stop pinging before the interfaces go down. Deleting the thread waits for a round in flight to finish. */
+    cy_wcm_ping_stop();
+    if(is_ping_thread_created)
+    {
+        cy_worker_thread_delete(&ping_worker_thread);
+        is_ping_thread_created = false;
+    }
+    cy_rtos_deinit_timer(&ping_timer);
+
+    /* A roam join in flight must end before the interfaces go down. Deleting the thread waits for it. */
+    if(is_roam_thread_created)
+    {
+        cy_worker_thread_delete(&roam_worker_thread);
+        is_roam_thread_created = false;
+    }
+
+#ifdef COMPONENT_WPS
+    /* The registrar sessions run on the WPS thread, so they are ended before it is deleted */
+    cy_wcm_wps_registrar_stop();
+    if(wps_worker_users != 0)
+    {
+        cy_worker_thread_delete(&wps_worker_thread);
+        wps_worker_users = 0;
+    }
+#endif
+
     /** Check if there are any active connections and disconnect **/
     if ((res = cy_wcm_disconnect_ap()) != CY_RSLT_SUCCESS)
     {
@@ -879,12 +1516,11 @@ cy_rslt_t cy_wcm_deinit()
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error while de initializing security_type_start_scan_semaphore semaphore \n");
     }
+#ifdef ENABLE_MULTICORE_CONN_MW
+    publish_shared_state(false);
+#endif
 
-
-    if((res = cy_rtos_deinit_mutex(&wcm_mutex)) != CY_RSLT_SUCCESS)
-    {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error while de initializing mutex \n");
-    }
+    deinit_wcm_locks();
 
     if(current_interface != CY_WCM_INTERFACE_TYPE_AP_STA)
     {
@@ -911,9 +1547,25 @@ cy_rslt_t cy_wcm_deinit()
     {
         cy_rtos_deinit_timer(&sta_handshake_timer);
         cy_rtos_deinit_timer(&sta_retry_timer);
+        cy_rtos_deinit_timer(&sta_roam_timer);
+        roam_handler.is_enabled = false;
         retry_backoff_timeout = DEFAULT_RETRY_BACKOFF_TIMEOUT_IN_MS;
     }
+    cy_rtos_deinit_timer(&ap_client_reconcile_timer);
+
+    /*
+     * Work still waiting in the lanes must not start now that the locks are gone, so it is taken out before the
+     * worker is deleted. The arguments it owns are freed only after the delete, once the item that may be running
+     * meanwhile has returned.
+     */
+    pending_count = take_worker_jobs(pending_jobs);
     cy_worker_thread_delete(&cy_wcm_worker_thread);
+    free_worker_jobs(pending_jobs, pending_count);
+    cy_rtos_deinit_mutex(&worker_lane_mutex);
+    cy_rtos_deinit_mutex(&ping_mutex);
+    /* Registries replaced earlier were freed with the pending work above, this is the current one */
+    free(wcm_event_registry);
+    wcm_event_registry = NULL;
     is_wcm_initalized = false;
 
     return res;
@@ -921,24 +1573,67 @@ cy_rslt_t cy_wcm_deinit()
 
 cy_rslt_t cy_wcm_start_scan(cy_wcm_scan_result_callback_t callback, void *user_data, cy_wcm_scan_filter_t *scan_filter)
 {
-    cy_rslt_t res = CY_RSLT_SUCCESS;
-    whd_ssid_t *ssid = NULL;
-    whd_mac_t *mac = NULL;
-    uint32_t band;
-
-    if(!is_wcm_initalized)
+    if (callback == NULL)
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
-        return CY_RSLT_WCM_NOT_INITIALIZED;
+        return (is_wcm_initalized ? CY_RSLT_WCM_BAD_ARG : CY_RSLT_WCM_NOT_INITIALIZED);
     }
+    return start_scan(callback, NULL, user_data, scan_filter, NULL);
+}
 
-    if (callback == NULL)
+cy_rslt_t cy_wcm_start_scan_view(cy_wcm_scan_view_callback_t scan_callback, void *user_data, cy_wcm_scan_filter_t *scan_filter)
+{
+    if (scan_callback == NULL)
+    {
+        return (is_wcm_initalized ? CY_RSLT_WCM_BAD_ARG : CY_RSLT_WCM_NOT_INITIALIZED);
+    }
+    return start_scan(NULL, scan_callback, user_data, scan_filter, NULL);
+}
+
+cy_rslt_t cy_wcm_start_scan_request(cy_wcm_scan_result_callback_t scan_callback, void *user_data, const cy_wcm_scan_request_t *request)
+{
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+    if((scan_callback == NULL) || (request == NULL) || (request->ssid_count > CY_WCM_SCAN_MAX_SSIDS) ||
+       (request->channel_count > CY_WCM_SCAN_MAX_CHANNELS) ||
+       ((request->scan_type != CY_WCM_SCAN_TYPE_ACTIVE) && (request->scan_type != CY_WCM_SCAN_TYPE_PASSIVE)))
     {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments \n");
         return CY_RSLT_WCM_BAD_ARG;
     }
+    return start_scan(scan_callback, NULL, user_data, NULL, request);
+}
+
+/*
+ * Exactly one of callback and view_callback is set; it selects how results are delivered.
+ * scan_filter comes from cy_wcm_start_scan and cy_wcm_start_scan_view, request from cy_wcm_start_scan_request; at most one is set.
+ */
+static cy_rslt_t start_scan(cy_wcm_scan_result_callback_t callback, cy_wcm_scan_view_callback_t view_callback, void *user_data,
+                            cy_wcm_scan_filter_t *scan_filter, const cy_wcm_scan_request_t *request)
+{
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+    whd_ssid_t *ssid = NULL;
+    whd_mac_t *mac = NULL;
+    whd_scan_type_t scan_type = WHD_SCAN_TYPE_ACTIVE;
+    uint16_t channel_list[CY_WCM_SCAN_MAX_CHANNELS + 1];
+    uint16_t *channels = NULL;
+    whd_scan_extended_params_t extended_params;
+    whd_scan_extended_params_t *extended_params_ptr = NULL;
+    bool is_sta_locked = false;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    /* The scan of the application has priority over a roam scan */
+    abort_roam_scan();
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
@@ -950,27 +1645,58 @@ cy_rslt_t cy_wcm_start_scan(cy_wcm_scan_result_callback_t callback, void *user_d
         goto exit;
     }
 
-    if(scan_handler.is_scanning)
+    if(scan_handler.is_scanning || roam_handler.is_scanning)
     {
         res = CY_RSLT_WCM_SCAN_IN_PROGRESS;
         goto exit;
     }
 
-    /* Reset mac_addr_arr before each scan and set current_bssid_arr_length to 0 */
-    mac_addr_arr = (whd_mac_t *)malloc(SCAN_BSSID_ARR_LENGTH * sizeof(whd_mac_t) );
-    if (mac_addr_arr == NULL)
+    /*
+     * Do not start the scan in the middle of a join. A connect holds wcm_sta_mutex until its join has finished,
+     * and holding it here until the scan has started keeps a new join from starting meanwhile.
+     */
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        res = CY_RSLT_WCM_WAIT_TIMEOUT;
+        goto exit;
+    }
+    is_sta_locked = true;
+    if(is_connect_triggered || roam_handler.is_joining)
     {
-        res = CY_RSLT_WCM_OUT_OF_MEMORY;
+        /* Scan requested from the thread that is connecting, or WCM is joining another AP of the network */
+        res = CY_RSLT_WCM_CONNECT_IN_PROGRESS;
         goto exit;
     }
-    current_bssid_arr_length = 0;
+
+    /* No scan is running, so neither the WHD thread nor the worker uses the duplicate tables now */
+    if(view_callback != NULL)
+    {
+        scan_view_bssid_arr_length = 0;
+    }
+    else
+    {
+        /* Reset mac_addr_arr before each scan and set current_bssid_arr_length to 0 */
+        if(mac_addr_arr == NULL)
+        {
+            mac_addr_arr = (whd_mac_t *)malloc(SCAN_BSSID_ARR_LENGTH * sizeof(whd_mac_t) );
+        }
+        if (mac_addr_arr == NULL)
+        {
+            res = CY_RSLT_WCM_OUT_OF_MEMORY;
+            goto exit;
+        }
+        current_bssid_arr_length = 0;
+    }
 
     /* reset previous filter and by default set band to AUTO */
     memset(&scan_handler.scan_filter, 0, sizeof(cy_wcm_scan_filter_t));
+    memset(&scan_handler.scan_request, 0, sizeof(cy_wcm_scan_request_t));
     whd_wifi_set_ioctl_value(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WLC_SET_BAND, WLC_BAND_AUTO);
 
     /* Store the scan callback and user data */
     scan_handler.p_scan_calback = callback;
+    scan_handler.p_scan_view_callback = view_callback;
     scan_handler.user_data = user_data;
     if(scan_filter != NULL)
     {
@@ -1000,30 +1726,10 @@ cy_rslt_t cy_wcm_start_scan(cy_wcm_scan_result_callback_t callback, void *user_d
                 memcpy(mac->octet, scan_filter->param.BSSID, CY_WCM_MAC_ADDR_LEN);
                 break;
             case CY_WCM_SCAN_FILTER_TYPE_BAND:
-                 /* check if the platform supports the requested band */
-                if(!check_if_platform_supports_band(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], scan_filter->param.band))
+                if((res = set_scan_band(scan_filter->param.band)) != CY_RSLT_SUCCESS)
                 {
-                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "band not supported \n");
-                    res = CY_RSLT_WCM_BAND_NOT_SUPPORTED;
                     goto exit;
                 }
-                if(scan_filter->param.band == CY_WCM_WIFI_BAND_5GHZ)
-                {
-                    band = WLC_BAND_5G;
-                }
-                else if(scan_filter->param.band == CY_WCM_WIFI_BAND_2_4GHZ)
-                {
-                    band = WLC_BAND_2G;
-                }
-                else if(scan_filter->param.band == CY_WCM_WIFI_BAND_6GHZ)
-                {
-                    band = WLC_BAND_6G;
-                }
-                else
-                {
-                    band = WLC_BAND_AUTO;
-                }
-                whd_wifi_set_ioctl_value(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WLC_SET_BAND, band);
                 break;
             case CY_WCM_SCAN_FILTER_TYPE_RSSI:
                     /**
@@ -1035,17 +1741,62 @@ cy_rslt_t cy_wcm_start_scan(cy_wcm_scan_result_callback_t callback, void *user_d
                 break;
         }
     }
+    if(request != NULL)
+    {
+        /** copy the request to filter the results in the worker thread **/
+        memcpy(&scan_handler.scan_request, request, sizeof(cy_wcm_scan_request_t));
+        if((res = set_scan_band(request->band)) != CY_RSLT_SUCCESS)
+        {
+            goto exit;
+        }
+        /* WHD sends probe requests for one SSID only; several SSIDs are looked for with a broadcast scan */
+        if(request->ssid_count == 1)
+        {
+            ssid = (whd_ssid_t*)malloc(sizeof(whd_ssid_t));
+            if(ssid == NULL)
+            {
+                res =  CY_RSLT_WCM_OUT_OF_MEMORY;
+                goto exit;
+            }
+            ssid->length = (uint8_t)strnlen((char*)request->SSID[0], CY_WCM_MAX_SSID_LEN);
+            memcpy(ssid->value, request->SSID[0], ssid->length);
+        }
+        if(request->scan_type == CY_WCM_SCAN_TYPE_PASSIVE)
+        {
+            scan_type = WHD_SCAN_TYPE_PASSIVE;
+        }
+        if(request->channel_count != 0)
+        {
+            /* WHD takes a zero terminated list */
+            memcpy(channel_list, request->channel_list, request->channel_count * sizeof(uint16_t));
+            channel_list[request->channel_count] = 0;
+            channels = channel_list;
+        }
+        if((request->active_dwell_time_ms != 0) || (request->passive_dwell_time_ms != 0) ||
+           (request->home_dwell_time_ms != 0) || (request->probes_per_channel != 0))
+        {
+            /* -1 keeps the firmware default of a value that is not set */
+            extended_params.number_of_probes_per_channel = (request->probes_per_channel != 0) ? request->probes_per_channel : -1;
+            extended_params.scan_active_dwell_time_per_channel_ms = (request->active_dwell_time_ms != 0) ? request->active_dwell_time_ms : -1;
+            extended_params.scan_passive_dwell_time_per_channel_ms = (request->passive_dwell_time_ms != 0) ? request->passive_dwell_time_ms : -1;
+            extended_params.scan_home_channel_dwell_time_between_channels_ms = (request->home_dwell_time_ms != 0) ? request->home_dwell_time_ms : -1;
+            extended_params_ptr = &extended_params;
+        }
+    }
 
-    res = whd_wifi_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WHD_SCAN_TYPE_ACTIVE, WHD_BSS_TYPE_ANY,
-                                 ssid, mac, NULL, NULL, internal_scan_callback, &scan_result, user_data);
+    /* Set before the scan starts, as results of a view scan are delivered on the WHD thread without the scan mutex */
+    scan_handler.is_scanning = true;
+    scan_handler.is_stop_scan_req = false;
+    res = whd_wifi_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], scan_type, WHD_BSS_TYPE_ANY,
+                                 ssid, mac, channels, extended_params_ptr, internal_scan_callback, &scan_result, user_data);
+    cy_wcm_trace(CY_WCM_TRACE_SCAN_START, res, 0, 0);
     if(res != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_scan error. Result = %d \n", res);
+        scan_handler.is_scanning = false;
         res = CY_RSLT_WCM_SCAN_ERROR;
         goto exit;
     }
-    scan_handler.is_scanning = true;
-    scan_handler.is_stop_scan_req = false;
 
 exit:
     /* Free the allocated memory in case of SSID or MAC based scan */
@@ -1059,7 +1810,11 @@ exit:
         free(mac);
         mac = NULL;
     }
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if(is_sta_locked && (cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS))
+    {
+        res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
+    }
+    if (cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
     {
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
     }
@@ -1080,7 +1835,7 @@ cy_rslt_t cy_wcm_stop_scan()
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
@@ -1108,7 +1863,7 @@ cy_rslt_t cy_wcm_stop_scan()
     wait_on_sema = true;
 
 exit:
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
     {
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
     }
@@ -1130,8 +1885,7 @@ exit:
 
 cy_rslt_t cy_wcm_register_event_callback(cy_wcm_event_callback_t event_callback)
 {
-    uint8_t i;
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+    wcm_event_subscriber_t subscriber;
 
     if( !is_wcm_initalized )
     {
@@ -1145,44 +1899,62 @@ cy_rslt_t cy_wcm_register_event_callback(cy_wcm_event_callback_t event_callback)
         return CY_RSLT_WCM_BAD_ARG;
     }
 
-    cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n wcm_mutex - Acquiring Mutex %p \n", wcm_mutex );
-    result = cy_rtos_get_mutex( &wcm_mutex, CY_RTOS_NEVER_TIMEOUT );
-    if( result != CY_RSLT_SUCCESS )
+    memset(&subscriber, 0, sizeof(subscriber));
+    subscriber.callback   = event_callback;
+    subscriber.event_mask = CY_WCM_EVENT_MASK_ALL;
+
+    return update_event_registry(&subscriber, true);
+}
+
+cy_rslt_t cy_wcm_deregister_event_callback(cy_wcm_event_callback_t event_callback)
+{
+    wcm_event_subscriber_t subscriber;
+
+    if( !is_wcm_initalized )
     {
-        cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] ", wcm_mutex, (unsigned int)result );
-        return CY_RSLT_WCM_MUTEX_ERROR;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
-    for ( i = 0; i < CY_WCM_MAXIMUM_CALLBACKS_COUNT; i++ )
+    if( event_callback == NULL )
     {
-        if ( wcm_event_handler[i] == NULL )
-        {
-            wcm_event_handler[i] = event_callback;
-            break;
-        }
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments to cy_wcm_deregister_event_callback(). \n");
+        return CY_RSLT_WCM_BAD_ARG;
     }
 
-    if( i == CY_WCM_MAXIMUM_CALLBACKS_COUNT )
+    memset(&subscriber, 0, sizeof(subscriber));
+    subscriber.callback = event_callback;
+
+    return update_event_registry(&subscriber, false);
+}
+
+cy_rslt_t cy_wcm_register_event_callback_ex(cy_wcm_event_callback_ex_t event_callback, uint32_t event_mask, void *user_data)
+{
+    wcm_event_subscriber_t subscriber;
+
+    if( !is_wcm_initalized )
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Out of CY_WCM_MAXIMUM_CALLBACKS_COUNT \r\n");
-        result = CY_RSLT_WCM_OUT_OF_MEMORY;
-        goto exit;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
-exit:
-    if( cy_rtos_set_mutex( &wcm_mutex ) != CY_RSLT_SUCCESS )
+    if( event_callback == NULL || event_mask == 0 )
     {
-        cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] ", wcm_mutex, (unsigned int)result );
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments to cy_wcm_register_event_callback_ex(). \n");
+        return CY_RSLT_WCM_BAD_ARG;
     }
-    cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n wcm_mutex - Releasing Mutex %p ", wcm_mutex );
 
-    return result;
+    memset(&subscriber, 0, sizeof(subscriber));
+    subscriber.callback_ex = event_callback;
+    subscriber.event_mask  = event_mask;
+    subscriber.user_data   = user_data;
+
+    return update_event_registry(&subscriber, true);
 }
 
-cy_rslt_t cy_wcm_deregister_event_callback(cy_wcm_event_callback_t event_callback)
+cy_rslt_t cy_wcm_deregister_event_callback_ex(cy_wcm_event_callback_ex_t event_callback, void *user_data)
 {
-    uint8_t i;
-    cy_rslt_t result = CY_RSLT_SUCCESS;
+    wcm_event_subscriber_t subscriber;
 
     if( !is_wcm_initalized )
     {
@@ -1192,40 +1964,115 @@ cy_rslt_t cy_wcm_deregister_event_callback(cy_wcm_event_callback_t event_callbac
 
     if( event_callback == NULL )
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments to cy_wcm_register_event_callback(). \n");
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments to cy_wcm_deregister_event_callback_ex(). \n");
         return CY_RSLT_WCM_BAD_ARG;
     }
 
-    cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n wcm_mutex - Acquiring Mutex %p \n", wcm_mutex );
-    result = cy_rtos_get_mutex( &wcm_mutex, CY_RTOS_NEVER_TIMEOUT );
+    memset(&subscriber, 0, sizeof(subscriber));
+    subscriber.callback_ex = event_callback;
+    subscriber.user_data   = user_data;
+
+    return update_event_registry(&subscriber, false);
+}
+
+static void free_event_registry(void *arg)
+{
+    free(arg);
+}
+
+/*
+ * Adds the subscriber to, or removes the first matching subscriber from, the event registry.
+ * The current list is never modified: a new one is published and the old one is freed on the
+ * WCM worker thread once any dispatch that may still be reading it has returned.
+ */
+static cy_rslt_t update_event_registry(const wcm_event_subscriber_t *subscriber, bool add)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    wcm_event_registry_t *old_registry;
+    wcm_event_registry_t *new_registry = NULL;
+    uint32_t old_count;
+    uint32_t new_count;
+    uint32_t i, j;
+
+    cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n wcm_config_mutex - Acquiring Mutex %p \n", wcm_config_mutex );
+    result = cy_rtos_get_mutex( &wcm_config_mutex, CY_RTOS_NEVER_TIMEOUT );
     if( result != CY_RSLT_SUCCESS )
     {
-        cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] ", wcm_mutex, (unsigned int)result );
+        cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_get_mutex for Mutex %p failed with Error : [0x%X] ", wcm_config_mutex, (unsigned int)result );
         return CY_RSLT_WCM_MUTEX_ERROR;
     }
 
-    for ( i = 0; i < CY_WCM_MAXIMUM_CALLBACKS_COUNT; i++ )
+    old_registry = wcm_event_registry;
+    old_count    = (old_registry != NULL) ? old_registry->count : 0;
+
+    if( add )
+    {
+        new_count = old_count + 1;
+    }
+    else
     {
-        if ( wcm_event_handler[i] == event_callback )
+        for ( i = 0; i < old_count; i++ )
         {
-            memset( &wcm_event_handler[i], 0, sizeof( cy_wcm_event_callback_t ) );
-            break;
+            if ( old_registry->subscriber[i].callback == subscriber->callback &&
+                 old_registry->subscriber[i].callback_ex == subscriber->callback_ex &&
+                 old_registry->subscriber[i].user_data == subscriber->user_data )
+            {
+                break;
+            }
         }
+
+        if( i == old_count )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to find callback to deregister \r\n");
+            result = CY_RSLT_WCM_BAD_ARG;
+            goto exit;
+        }
+        new_count = old_count - 1;
     }
 
-    if( i == CY_WCM_MAXIMUM_CALLBACKS_COUNT )
+    if( new_count > 0 )
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to find callback to deregister \r\n");
-        result = CY_RSLT_WCM_BAD_ARG;
-        goto exit;
+        new_registry = (wcm_event_registry_t *)malloc(sizeof(wcm_event_registry_t) + (new_count - 1) * sizeof(wcm_event_subscriber_t));
+        if( new_registry == NULL )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "malloc failed %s %d\r\n", __FILE__, __LINE__);
+            result = CY_RSLT_WCM_OUT_OF_MEMORY;
+            goto exit;
+        }
+
+        /* Copy everything except the subscriber being removed; i is its index */
+        for ( j = 0, new_count = 0; j < old_count; j++ )
+        {
+            if( add || j != i )
+            {
+                new_registry->subscriber[new_count++] = old_registry->subscriber[j];
+            }
+        }
+        if( add )
+        {
+            new_registry->subscriber[new_count++] = *subscriber;
+        }
+        new_registry->count = new_count;
+    }
+
+    if( old_registry != NULL )
+    {
+        /* The free runs on the worker like every dispatch, so it cannot run while one is reading the old list */
+        if( (result = cy_wcm_enqueue_worker_job(free_event_registry, old_registry)) != CY_RSLT_SUCCESS )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to queue the event registry release. Err = [%lu]\r\n", __LINE__, __FUNCTION__, result);
+            free(new_registry);
+            goto exit;
+        }
     }
+    wcm_event_registry = new_registry;
 
 exit:
-    if( cy_rtos_set_mutex( &wcm_mutex ) != CY_RSLT_SUCCESS )
+    if( cy_rtos_set_mutex( &wcm_config_mutex ) != CY_RSLT_SUCCESS )
     {
-        cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] ", wcm_mutex, (unsigned int)result );
+        cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_ERR, "\ncy_rtos_set_mutex for Mutex %p failed with Error : [0x%X] ", wcm_config_mutex, (unsigned int)result );
     }
-    cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n wcm_mutex - Releasing Mutex %p ", wcm_mutex );
+    cy_wcm_log_msg( CYLF_MIDDLEWARE, CY_LOG_DEBUG, "\n wcm_config_mutex - Releasing Mutex %p ", wcm_config_mutex );
 
     return result;
 }
@@ -1235,42 +2082,44 @@ exit:
  */
 static void internal_scan_cb_get_security_type(whd_scan_result_t **result_ptr, void *user_data, whd_scan_status_t status)
 {
-    if(status == WHD_SCAN_ABORTED)
-    {
-        return;
-    }
-    if(status == WHD_SCAN_COMPLETED_SUCCESSFULLY)
-    {
-        goto exit;
-    }
-    else if(status == WHD_SCAN_INCOMPLETE)
+    if(status == WHD_SCAN_INCOMPLETE)
     {
-        if((**result_ptr).SSID.length != 0)
-        {
-            cy_wcm_connect_params_t *connect_params = (cy_wcm_connect_params_t *)user_data;
+        cy_wcm_connect_params_t *connect_params = (cy_wcm_connect_params_t *)user_data;
 
-            if(strcmp((char *)(**result_ptr).SSID.value, (char *)connect_params->ap_credentials.SSID) != 0)
-            {
-                cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Scanned SSID did not match SSID passed by user \n");
-                return;
-            }
-            if (connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN)
-            {
-                connect_params->ap_credentials.security = whd_to_wcm_security((**result_ptr).security);
-            }
+        if((**result_ptr).SSID.length == 0)
+        {
+            return;
+        }
+        if(strcmp((char *)(**result_ptr).SSID.value, (char *)connect_params->ap_credentials.SSID) != 0)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Scanned SSID did not match SSID passed by user \n");
+            return;
+        }
+        if (connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN)
+        {
+            connect_params->ap_credentials.security = whd_to_wcm_security((**result_ptr).security);
         }
+        if (connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN)
+        {
+            return;
+        }
+        /* The first matching BSS is enough; end the probe without waiting for the remaining channels */
     }
 
-exit:
-    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    /*
+     * No lock is taken here: cy_wcm_scan_security_type() holds wcm_scan_mutex across whd_wifi_scan(), whose
+     * IOCTL is serviced by this (WHD) thread, and the first match may arrive before it returns. Only this
+     * thread calls the callback, so the flag is enough to make the first end of a probe (match, completion
+     * or abort) the only one that wakes cy_wcm_connect_ap. A wake-up that races with its timeout is dropped
+     * before the next probe starts.
+     */
+    if(!scan_handler.get_security_type)
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return;
     }
 
-    scan_handler.is_scanning = false;
     scan_handler.get_security_type = false;
+    scan_handler.is_scanning = false;
 
     if(cy_rtos_set_semaphore(&security_type_start_scan_semaphore, false) != CY_RSLT_SUCCESS)
     {
@@ -1286,12 +2135,6 @@ exit:
     {
         *result_ptr = NULL;
     }
-
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
-    {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlock error %s %d\r\n", __FILE__, __LINE__);
-    }
-    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlocked %s %d\r\n", __FILE__, __LINE__);
 }
 
 cy_rslt_t cy_wcm_scan_security_type(void *user_data)
@@ -1306,35 +2149,49 @@ cy_rslt_t cy_wcm_scan_security_type(void *user_data)
         return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
+    /* The probe of cy_wcm_connect_ap has priority over a roam scan */
+    abort_roam_scan();
+
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
     }
 
-    if(scan_handler.is_scanning)
+    if(scan_handler.is_scanning || roam_handler.is_scanning)
     {
+        /* Ask for a wake-up when the scan in progress ends */
+        scan_handler.is_probe_waiting = true;
         res = CY_RSLT_WCM_SCAN_IN_PROGRESS;
         goto exit;
     }
 
+    /* Drop a wake-up left over from an earlier probe or wait that timed out */
+    while(cy_rtos_get_semaphore(&security_type_start_scan_semaphore, 0, false) == CY_RSLT_SUCCESS)
+    {
+    }
+
     optional_ssid.length = (uint8_t)strlen((char*)connect_params->ap_credentials.SSID);
     memcpy(optional_ssid.value, connect_params->ap_credentials.SSID, optional_ssid.length + 1);
 
+    /* Set before the scan starts, as the first matching BSS may be reported before whd_wifi_scan() returns */
+    scan_handler.is_scanning = true;
+    scan_handler.get_security_type = true;
     res = whd_wifi_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WHD_SCAN_TYPE_ACTIVE, WHD_BSS_TYPE_ANY,
                         &optional_ssid , NULL, NULL, NULL, internal_scan_cb_get_security_type, &scan_result, user_data);
+    cy_wcm_trace(CY_WCM_TRACE_SCAN_START, res, 1, 0);
     if(res != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_scan error. Result = %d \n", res);
+        scan_handler.is_scanning = false;
+        scan_handler.get_security_type = false;
         res = CY_RSLT_WCM_SCAN_ERROR;
         goto exit;
     }
-    scan_handler.is_scanning = true;
-    scan_handler.get_security_type = true;
 
 exit:
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlock error %s %d\r\n", __FILE__, __LINE__);
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
@@ -1343,44 +2200,150 @@ exit:
 
     return res;
 }
-cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_address_t *ip_addr)
+/*
+ * Security types learned by probing, so that connecting again to the same SSID with CY_WCM_SECURITY_UNKNOWN
+ * does not scan. Protected by wcm_config_mutex.
+ */
+static bool security_cache_lookup(const uint8_t *ssid, cy_wcm_security_t *security)
 {
-    cy_rslt_t res = CY_RSLT_SUCCESS;
-    whd_ssid_t ssid;
-    whd_mac_t bssid;
-    uint8_t *key;
-    uint8_t keylen;
-    whd_security_t security;
-    cy_network_static_ip_addr_t static_ip, *static_ip_ptr;
-    static_ip_ptr = NULL;
-    uint32_t retry_count = 0;
-    cy_nw_ip_address_t ipv4_addr;
-    uint32_t connection_status;
-    uint8_t num_scan = 0;
-#ifdef ENABLE_WCM_LOGS
-    char ip_str[15];
-#endif
-    uint32_t ext_sae_support = 0;
-    bool ext_sae_started = false;
+    bool found = false;
+    uint8_t i;
 
-    if(!is_wcm_initalized)
+    if(cy_rtos_get_mutex(&wcm_config_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
-        return CY_RSLT_WCM_NOT_INITIALIZED;
+        return false;
+    }
+    for(i = 0; i < WCM_SECURITY_CACHE_SIZE; i++)
+    {
+        if(security_cache[i].in_use && (strcmp((const char *)security_cache[i].SSID, (const char *)ssid) == 0))
+        {
+            *security = security_cache[i].security;
+            security_cache[i].last_used = ++security_cache_clock;
+            found = true;
+            break;
+        }
+    }
+    if(cy_rtos_set_mutex(&wcm_config_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
     }
 
-    /* Security type not specified by user then scan to figure out the security type */
-    if(connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN)
+    return found;
+}
+
+/* Remembers the security of ssid, replacing the least recently used entry; CY_WCM_SECURITY_UNKNOWN forgets it */
+static void security_cache_store(const uint8_t *ssid, cy_wcm_security_t security)
+{
+    wcm_security_cache_entry_t *entry = NULL;
+    uint8_t i;
+
+    if(cy_rtos_get_mutex(&wcm_config_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
-        while(connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN && num_scan < MAX_SCAN_RETRY )
+        return;
+    }
+    for(i = 0; i < WCM_SECURITY_CACHE_SIZE; i++)
+    {
+        if(security_cache[i].in_use && (strcmp((const char *)security_cache[i].SSID, (const char *)ssid) == 0))
         {
+            entry = &security_cache[i];
+            break;
+        }
+        if((entry == NULL) || !security_cache[i].in_use ||
+           (entry->in_use && (security_cache[i].last_used < entry->last_used)))
+        {
+            entry = &security_cache[i];
+        }
+    }
+
+    if(security == CY_WCM_SECURITY_UNKNOWN)
+    {
+        if(entry->in_use && (strcmp((const char *)entry->SSID, (const char *)ssid) == 0))
+        {
+            entry->in_use = false;
+        }
+    }
+    else
+    {
+        memcpy(entry->SSID, ssid, sizeof(entry->SSID));
+        entry->SSID[CY_WCM_MAX_SSID_LEN] = 0;
+        entry->security = security;
+        entry->last_used = ++security_cache_clock;
+        entry->in_use = true;
+    }
+
+    if(cy_rtos_set_mutex(&wcm_config_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+}
+
+/* Called with the scan mutex held when a scan ends; wakes a connect that is waiting to start its security probe */
+static void wake_security_probe(void)
+{
+    if(scan_handler.is_probe_waiting)
+    {
+        scan_handler.is_probe_waiting = false;
+        if(cy_rtos_set_semaphore(&security_type_start_scan_semaphore, false) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "unable to set security_type_start_scan_semaphore \n");
+        }
+    }
+}
+
+cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_address_t *ip_addr)
+{
+    return cy_wcm_connect_ap_on_channel(connect_params, CY_WCM_DEFAULT_STA_CHANNEL, ip_addr);
+}
+
+/*
+ * Same as cy_wcm_connect_ap(), but when the BSSID is given and the channel is known
+ * (e.g. from the WPS registrar's scan result) the join is restricted to that chanspec
+ * instead of letting the firmware scan every channel for the BSSID.
+ */
+cy_rslt_t cy_wcm_connect_ap_on_channel(cy_wcm_connect_params_t *connect_params, uint8_t channel, cy_wcm_ip_address_t *ip_addr)
+{
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+    whd_ssid_t ssid;
+    whd_mac_t bssid;
+    uint8_t *key;
+    uint8_t keylen;
+    whd_security_t security;
+    cy_network_static_ip_addr_t static_ip, *static_ip_ptr;
+    static_ip_ptr = NULL;
+    uint32_t retry_count = 0;
+    cy_nw_ip_address_t ipv4_addr;
+    uint32_t connection_status;
+    uint8_t num_scan = 0;
+#ifdef ENABLE_WCM_LOGS
+    char ip_str[15];
+#endif
+    uint32_t ext_sae_support = 0;
+    bool ext_sae_started = false;
+    bool is_security_probed = false;
+    bool is_reassoc = false;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+    cy_wcm_trace(CY_WCM_TRACE_CONNECT_START, connect_params->ap_credentials.security, connect_params->band, channel);
+
+    /* Security type not specified by user: use the one found for this SSID before, or scan to figure it out */
+    if(connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN)
+    {
+        is_security_probed = true;
+        security_cache_lookup(connect_params->ap_credentials.SSID, &connect_params->ap_credentials.security);
+        while(connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN && num_scan < MAX_SCAN_RETRY )
+        {
+            num_scan++;
             res = cy_wcm_scan_security_type(connect_params);
             if (res != CY_RSLT_SUCCESS)
             {
                 if (res == CY_RSLT_WCM_SCAN_IN_PROGRESS)
                 {
-                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Scan in progress...wait and try again \n");
-                    cy_rtos_delay_milliseconds(500);
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Scan in progress...waiting for it to end \n");
+                    cy_rtos_get_semaphore(&security_type_start_scan_semaphore, WCM_SECURITY_PROBE_TIMEOUT_MS, false);
                     continue;
                 }
                 else
@@ -1389,13 +2352,22 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                     return res;
                 }
             }
-            if(cy_rtos_get_semaphore(&security_type_start_scan_semaphore, NEVER_TIMEOUT, false) != CY_RSLT_SUCCESS)
+            if(cy_rtos_get_semaphore(&security_type_start_scan_semaphore, WCM_SECURITY_PROBE_TIMEOUT_MS, false) != CY_RSLT_SUCCESS)
             {
-                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error unable to set the security type semaphore \n");
+                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Security type probe timed out \n");
             }
-            /* Stop scan before starting the next scan */
+            /* Stop the probe; the remaining channels are not needed once a matching BSS was seen */
             whd_wifi_stop_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA]);
-            num_scan++;
+            if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) == CY_RSLT_SUCCESS)
+            {
+                if(scan_handler.get_security_type)
+                {
+                    /* Timed out and WHD did not report the abort */
+                    scan_handler.is_scanning = false;
+                    scan_handler.get_security_type = false;
+                }
+                cy_rtos_set_mutex(&wcm_scan_mutex);
+            }
         }
 
         if(connect_params->ap_credentials.security == CY_WCM_SECURITY_UNKNOWN)
@@ -1404,6 +2376,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to get the security type of network \n");
             return CY_RSLT_WCM_SECURITY_NOT_FOUND;
         }
+        security_cache_store(connect_params->ap_credentials.SSID, connect_params->ap_credentials.security);
     }
 
     if((res = check_ap_credentials(connect_params)) != CY_RSLT_SUCCESS)
@@ -1412,18 +2385,24 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if (cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) == CY_RSLT_SUCCESS)
+    if (cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) == CY_RSLT_SUCCESS)
     {
         whd_scan_result_t ap;
-#ifdef COMPONENT_WIFI6
         whd_mac_t whd_bssid;
-#endif
+        bool is_same_ssid;
+
+        if(roam_handler.is_joining)
+        {
+            /* The roam join runs without the STA lock, see roam_join_handler() */
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is joining another AP of the network, try again \n");
+            cy_rtos_set_mutex(&wcm_sta_mutex);
+            return CY_RSLT_WCM_CONNECT_IN_PROGRESS;
+        }
+
         is_disconnect_triggered = false;
         is_connect_triggered = true;
         convert_connect_params(connect_params, &ssid, &bssid, &key, &keylen, &security, &static_ip);
 
-        memset(&connected_ap_details, 0, sizeof(connected_ap_details));
-#ifdef COMPONENT_WIFI6
         if (wcm_sta_link_up && !NULL_MAC(bssid.octet))
         {
              res = whd_wifi_get_bssid(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &whd_bssid);
@@ -1432,11 +2411,9 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
         {
             memset(&whd_bssid, 0, sizeof(whd_mac_t));
         }
-        if (is_connected_to_same_ap(connect_params) &&
-            memcmp(connect_params->BSSID, whd_bssid.octet, ETHER_ADDR_LEN) == 0)
-#else
-        if (is_connected_to_same_ap(connect_params))
-#endif
+        is_same_ssid = is_connected_to_same_ap(connect_params);
+        if (is_same_ssid && is_same_ap_credentials(security, key, keylen) &&
+            memcmp(bssid.octet, whd_bssid.octet, ETHER_ADDR_LEN) == 0)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "already connected to same AP \n");
             /* Store the IP address before returning */
@@ -1455,12 +2432,15 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
 
             goto exit;
         }
-#ifdef COMPONENT_WIFI6
-        if (wcm_sta_link_up && (!is_connected_to_same_ap(connect_params)) &&
-                        (cy_wcm_disconnect_ap() != CY_RSLT_SUCCESS))
-#else
-        if (wcm_sta_link_up  && (cy_wcm_disconnect_ap() != CY_RSLT_SUCCESS))
-#endif
+
+        /*
+         * Only the credentials or the BSSID change: reassociate and keep the network interface up, instead of
+         * leaving the AP and bringing up the network stack again. A new static IP needs the full connect.
+         */
+        is_reassoc = (is_same_ssid && is_sta_network_up &&
+                      (memcmp(&static_ip, &connected_ap_details.static_ip, sizeof(static_ip)) == 0));
+
+        if (wcm_sta_link_up && (!is_reassoc) && (cy_wcm_disconnect_ap() != CY_RSLT_SUCCESS))
         {
             /**
              *  Notify user disconnection error occurred and
@@ -1471,12 +2451,13 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
             goto exit;
         }
 
+        memset(&connected_ap_details, 0, sizeof(connected_ap_details));
         sta_security_type = security;
 
         connection_status = CY_WCM_EVENT_CONNECTING;
         whd_wifi_get_fwcap(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &ext_sae_support);
 
-        if((res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status)) != CY_RSLT_SUCCESS)
+        if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false)) != CY_RSLT_SUCCESS)
         {
              cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
              goto exit;
@@ -1497,17 +2478,40 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wpa3_supplicant_sae_start returned res=%d\n", res);
         }
 
+        if(is_reassoc)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Reassociating to %s \n", ssid.value);
+            is_reassoc_triggered = true;
+        }
+
         if(!NULL_MAC(bssid.octet))
         {
             memset(&ap, 0, sizeof(whd_scan_result_t));
             ap.security = security;
             ap.SSID.length = ssid.length;
-            ap.channel = CY_WCM_DEFAULT_STA_CHANNEL;
+            ap.channel = channel;
             memcpy(ap.SSID.value, ssid.value, ap.SSID.length + 1);
             memcpy(ap.BSSID.octet, bssid.octet, CY_WCM_MAC_ADDR_LEN);
+            if(channel != CY_WCM_DEFAULT_STA_CHANNEL)
+            {
+                if(connect_params->band == CY_WCM_WIFI_BAND_6GHZ)
+                {
+                    ap.band = WHD_802_11_BAND_6GHZ;
+                }
+                else if((connect_params->band == CY_WCM_WIFI_BAND_5GHZ) ||
+                        ((connect_params->band == CY_WCM_WIFI_BAND_ANY) && (channel > CY_WCM_MAX_2_4GHZ_CHANNEL)))
+                {
+                    ap.band = WHD_802_11_BAND_5GHZ;
+                }
+                else
+                {
+                    ap.band = WHD_802_11_BAND_2_4GHZ;
+                }
+            }
             /*
-             * If MAC address of a AP is know there is no need to populate channel or band
-             * instead we can set the band to auto and invoke whd join
+             * The BSSID is known, so join it directly. When the channel is known as well it is passed in ap
+             * together with its band so that the join does not have to scan for the AP. The band is left
+             * on auto as the channel already selects it.
              */
             whd_wifi_set_ioctl_value(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WLC_SET_BAND, WLC_BAND_AUTO);
             res = whd_wifi_join_specific(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &ap, key, keylen);
@@ -1530,7 +2534,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "band not supported \n");
                     res =  CY_RSLT_WCM_BAND_NOT_SUPPORTED;
                     connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-                    if((cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status)) != CY_RSLT_SUCCESS)
+                    if((wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false)) != CY_RSLT_SUCCESS)
                     {
                         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
                     }
@@ -1545,11 +2549,26 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
             /** Join to Wi-Fi AP **/
             res = whd_wifi_join(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &ssid, security, key, keylen);
         }
+        cy_wcm_trace(CY_WCM_TRACE_CONNECT_JOIN, res, 0, 0);
         if (res != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "whd_wifi join failed : %ld \n", res);
+            if(is_security_probed)
+            {
+                /* The AP may have changed its security; probe again on the next connect */
+                security_cache_store(connect_params->ap_credentials.SSID, CY_WCM_SECURITY_UNKNOWN);
+            }
+            if(is_reassoc)
+            {
+                /* The firmware has left the old AP; bring the network down as a disconnect would */
+                if(cy_wcm_disconnect_ap() != CY_RSLT_SUCCESS)
+                {
+                    wcm_sta_link_up = false;
+                }
+                is_reassoc_triggered = false;
+            }
             connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-            if((cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status)) != CY_RSLT_SUCCESS)
+            if((wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false)) != CY_RSLT_SUCCESS)
             {
                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
             }
@@ -1561,6 +2580,54 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
             goto exit;
         }
 
+        if (is_reassoc)
+        {
+            save_connected_ap_details(connect_params, &ssid, &bssid, key, keylen, security, &static_ip);
+            /*
+             * The events of the old and the new AP may still be queued behind the return of the join. The link-up
+             * of the new AP clears is_reassoc_triggered and renews the lease (link_up()); until then a link down
+             * of the old AP is ignored. The DHCP server confirms the current address when the subnet is unchanged.
+             */
+            while(is_reassoc_triggered && (retry_count < REASSOC_LINK_UP_TIMEOUT_COUNT))
+            {
+                cy_rtos_delay_milliseconds(10);
+                retry_count++;
+            }
+            if(is_reassoc_triggered)
+            {
+                cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "No link up event after the reassociation \n");
+                link_up();
+            }
+            /* The agreements and the roaming trend were with the old AP */
+            roam_handler.has_samples = false;
+            itwt_link_lost();
+            if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, itwt_restore_handler, NULL, true)) != CY_RSLT_SUCCESS)
+            {
+                cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to queue the iTWT restore. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+            }
+            /* The renewal runs on the worker; a different address from the server is reported with CY_WCM_EVENT_IP_CHANGED */
+            if(ip_addr != NULL)
+            {
+                res = cy_network_get_ip_address(nw_sta_if_ctx, &ipv4_addr);
+                if(res == CY_RSLT_SUCCESS)
+                {
+                    ip_addr->version = CY_WCM_IP_VER_V4;
+                    ip_addr->ip.v4 = ipv4_addr.ip.v4;
+                }
+                else
+                {
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to get the IP address\n");
+                    res = CY_RSLT_WCM_IP_ADDR_ERROR;
+                }
+            }
+            connection_status = CY_WCM_EVENT_CONNECTED;
+            if(wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false) != CY_RSLT_SUCCESS)
+            {
+                cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+            }
+            goto exit;
+        }
+
         if (!is_sta_network_up)
         {
             if(connect_params->static_ip_settings != NULL)
@@ -1573,7 +2640,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to bring up the network stack\n");
                 res = CY_RSLT_WCM_STA_NETWORK_DOWN;
                 connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-                if((cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status)) != CY_RSLT_SUCCESS)
+                if((wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false)) != CY_RSLT_SUCCESS)
                 {
                     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
                 }
@@ -1616,7 +2683,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                         wcm_sta_link_up = false;
                         res = CY_RSLT_WCM_STA_DISCONNECT_ERROR;
                         connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-                        if(cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status) != CY_RSLT_SUCCESS)
+                        if(wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false) != CY_RSLT_SUCCESS)
                         {
                             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
                         }
@@ -1625,7 +2692,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                     /* Return DHCP Timeout Error when DHCP discover failed and disconnect done properly */
                     res = CY_RSLT_WCM_DHCP_TIMEOUT;
                     connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-                    if(cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status) != CY_RSLT_SUCCESS)
+                    if(wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false) != CY_RSLT_SUCCESS)
                     {
                         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
                     }
@@ -1649,7 +2716,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                 network_down(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], CY_NETWORK_WIFI_STA_INTERFACE);
                 whd_wifi_leave(whd_ifs[CY_WCM_INTERFACE_TYPE_STA]);
                 connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-                if(cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status) != CY_RSLT_SUCCESS)
+                if(wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false) != CY_RSLT_SUCCESS)
                 {
                     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
                 }
@@ -1664,6 +2731,8 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
             }
 #endif
 
+            /* Agreements of an earlier connection are not carried over */
+            memset(itwt_flows, 0, sizeof(itwt_flows));
             if(connect_params->itwt_profile != CY_WCM_ITWT_PROFILE_NONE)
             {
                 wl_bss_info_t  bss_info;
@@ -1673,17 +2742,18 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                 if(res == CY_RSLT_SUCCESS)
                 {
                     uint8_t band = 0;
-                    whd_itwt_setup_params_t twt_params;
-
-                    twt_params.setup_cmd     = CY_WCM_TWT_SETUP_CMD;
-                    twt_params.trigger       = true;
-                    twt_params.flow_type     = true;
-                    twt_params.flow_id       = 0;
-                    twt_params.wake_duration = CY_WCM_TWT_WAKE_DURATION_DEAFULT;
-                    twt_params.exponent      = CY_WCM_TWT_EXPONENT;
-                    twt_params.mantissa      = CY_WCM_TWT_MANTISSA;
-                    twt_params.wake_time_h   = 0;
-                    twt_params.wake_time_l   = 0;
+                    cy_wcm_itwt_setup_params_t *twt_params = &itwt_flows[0].params;
+
+                    /* The profile agreement is tracked as flow 0, so that it is set up again after a reconnect */
+                    twt_params->setup_cmd     = CY_WCM_TWT_SETUP_CMD;
+                    twt_params->trigger       = true;
+                    twt_params->flow_type     = true;
+                    twt_params->flow_id       = 0;
+                    twt_params->wake_duration = CY_WCM_TWT_WAKE_DURATION_DEAFULT;
+                    twt_params->exponent      = CY_WCM_TWT_EXPONENT;
+                    twt_params->mantissa      = CY_WCM_TWT_MANTISSA;
+                    twt_params->wake_time_h   = 0;
+                    twt_params->wake_time_l   = 0;
 
                     band = (bss_info.chanspec & 0xC000) >> 8;
                     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "band : [0x%X]\n",band);
@@ -1692,50 +2762,30 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
                     {
                         if( (band == WCM_WIFI_CHANSPEC_5GHZ) || (band == WCM_WIFI_CHANSPEC_6GHZ) )
                         {
-                            twt_params.wake_duration = CY_WCM_TWT_WAKE_DURATION_IDLE_PROF_5G_6G;
+                            twt_params->wake_duration = CY_WCM_TWT_WAKE_DURATION_IDLE_PROF_5G_6G;
                         }
                     }
                     else if(connect_params->itwt_profile == CY_WCM_ITWT_PROFILE_ACTIVE)
                     {
-                        twt_params.wake_duration = CY_WCM_TWT_WAKE_DURATION_ACTIVE_PROF;
-                        twt_params.exponent      = CY_WCM_TWT_EXPONENT_ACTIVE_PROF;
-                        twt_params.mantissa      = CY_WCM_TWT_MANTISSA_ACTIVE_PROF;
-                    }
-                    res = whd_wifi_itwt_setup(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &twt_params);
-                    if( res == CY_RSLT_SUCCESS )
-                    {
-                        is_itwt_enabled = true;
-                    }
-                    else
-                    {
-                        if( res == WHD_WLAN_UNSUPPORTED )
-                        {
-                            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "iTWT Not supported for this capabilities\n");
-                        }
-
-                        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_itwt_setup failed %x\r\n", res);
+                        twt_params->wake_duration = CY_WCM_TWT_WAKE_DURATION_ACTIVE_PROF;
+                        twt_params->exponent      = CY_WCM_TWT_EXPONENT_ACTIVE_PROF;
+                        twt_params->mantissa      = CY_WCM_TWT_MANTISSA_ACTIVE_PROF;
                     }
+                    res = itwt_setup_flow(0);
                 }
             }
 
             /* save current AP credentials to reuse during retry in case handshake fails occurs */
-            connected_ap_details.security = security;
-            connected_ap_details.SSID.length = ssid.length;
-            connected_ap_details.keylen = keylen;
-            connected_ap_details.band = connect_params->band;
-            memcpy(connected_ap_details.key, key, keylen+1);
-            memcpy(connected_ap_details.SSID.value, ssid.value, connected_ap_details.SSID.length+1);
-            memcpy(connected_ap_details.sta_mac.octet, bssid.octet, CY_WCM_MAC_ADDR_LEN);
-            memcpy(&connected_ap_details.static_ip, &static_ip, sizeof(static_ip));
+            save_connected_ap_details(connect_params, &ssid, &bssid, key, keylen, security, &static_ip);
             wcm_sta_link_up = true;
             connection_status = CY_WCM_EVENT_CONNECTED;
-            if((res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status)) != CY_RSLT_SUCCESS)
+            if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false)) != CY_RSLT_SUCCESS)
             {
                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
                 goto exit;
             }
             /* post IP change callback */
-            if((res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_ip_change, NULL)) != CY_RSLT_SUCCESS)
+            if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_ip_change, NULL, true)) != CY_RSLT_SUCCESS)
             {
                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : Failed to notify IP change. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
                 goto exit;
@@ -1746,7 +2796,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
     {
         res = CY_RSLT_WCM_WAIT_TIMEOUT;
         connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-        if(cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status) != CY_RSLT_SUCCESS)
+        if(wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false) != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send connection status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
         }
@@ -1754,7 +2804,7 @@ cy_rslt_t cy_wcm_connect_ap(cy_wcm_connect_params_t *connect_params, cy_wcm_ip_a
 
 exit:
     is_connect_triggered = false;
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Mutex release error \n");
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
@@ -1764,6 +2814,7 @@ exit:
         wpa3_supplicant_sae_cleanup();
     }
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlocked %s %d\r\n", __FILE__, __LINE__);
+    cy_wcm_trace(CY_WCM_TRACE_CONNECT_DONE, res, 0, 0);
 
     return res;
 }
@@ -1785,7 +2836,7 @@ cy_rslt_t cy_wcm_disconnect_ap()
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
@@ -1800,6 +2851,8 @@ cy_rslt_t cy_wcm_disconnect_ap()
         goto exit;
     }
     wcm_sta_link_up = false;
+    /* Agreements ended by the application are not set up again */
+    memset(itwt_flows, 0, sizeof(itwt_flows));
 
 #ifdef COMPONENT_55900
     /* TWT deinit */
@@ -1826,11 +2879,15 @@ exit:
     is_connect_triggered = false;
     /* clear the saved ap credentials */
     memset(&connected_ap_details, 0, sizeof(connected_ap_details));
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
     {
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
     }
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlocked %s %d\r\n", __FILE__, __LINE__);
+#ifdef ENABLE_MULTICORE_CONN_MW
+    /* No link down event follows a disconnect requested by the application */
+    publish_shared_state(true);
+#endif
 
     return res;
 }
@@ -2129,7 +3186,7 @@ cy_rslt_t cy_wcm_get_mac_addr(cy_wcm_interface_t interface_type, cy_wcm_mac_t *m
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_config_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
@@ -2188,7 +3245,7 @@ cy_rslt_t cy_wcm_get_mac_addr(cy_wcm_interface_t interface_type, cy_wcm_mac_t *m
         }
     }
  exit:
-    if(cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if(cy_rtos_set_mutex(&wcm_config_mutex) != CY_RSLT_SUCCESS)
     {
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
     }
@@ -2481,138 +3538,207 @@ cy_rslt_t cy_wcm_get_associated_ap_info(cy_wcm_associated_ap_info_t *ap_info)
     return res;
 }
 
-static int ltoh16_ua(const uint8_t * bytes)
-{
-    const uint8_t *_bytes = (const uint8_t *)(bytes);
-    return _LTOH16_UA(_bytes);
-
-}
-
-static int xtlv_size_for_data(int dlen, xtlv_opts_t opts, const uint8_t **data)
+#ifdef ENABLE_MULTICORE_CONN_MW
+const cy_wcm_shared_state_t *cy_wcm_get_shared_state(void)
 {
-    int hsz;
-    hsz = xtlv_hdr_size(opts, data);
-    return ((opts & XTLV_OPTION_ALIGN32) ? WCM_ALIGN_SIZE(dlen + hsz, 4) : (dlen + hsz));
+    return &wcm_shared_state;
 }
 
-static int xtlv_len(const xtlv_t *elt, xtlv_opts_t opts)
+/*
+ * Publishes the STA state for the virtual getters on the secondary core. When is_valid is false the block is
+ * withdrawn, so that the secondary core stops trusting it.
+ * The values are gathered and published under the STA lock, so that a snapshot taken by one writer cannot be
+ * published over a newer one. They are gathered before the sequence is bumped, which keeps the window in which
+ * readers retry short.
+ */
+static void publish_shared_state(bool is_valid)
 {
-    const uint8_t *lenp;
-    int len;
+    cy_wcm_shared_state_t state;
 
-    lenp = (const uint8_t *)&elt->len; /* nominal */
-    if (opts & XTLV_OPTION_IDU8)
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
-        --lenp;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
     }
-    if (opts & XTLV_OPTION_LENU8)
+
+    memset(&state, 0, sizeof(state));
+    if(is_valid)
     {
-        len = *lenp;
+        state.is_connected = cy_wcm_is_connected_to_ap();
+        cy_wcm_get_mac_addr(CY_WCM_INTERFACE_TYPE_STA, &state.sta_mac);
+        if(state.is_connected)
+        {
+            cy_wcm_get_ip_addr(CY_WCM_INTERFACE_TYPE_STA, &state.ip_addr);
+            cy_wcm_get_gateway_ip_address(CY_WCM_INTERFACE_TYPE_STA, &state.gateway_addr);
+            cy_wcm_get_associated_ap_info(&state.ap_info);
+        }
     }
-    else
+
+    /* Writers on the worker and on application threads must not interleave their updates */
+    if(cy_rtos_get_mutex(&wcm_config_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
-        len = ltoh16_ua(lenp);
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        goto exit;
     }
-    return len;
-}
 
-static int xtlv_id(const xtlv_t *elt, xtlv_opts_t opts)
-{
-    int id = 0;
-    if (opts & XTLV_OPTION_IDU8)
+    wcm_shared_state.sequence++;
+    WCM_MEMORY_BARRIER();
+    wcm_shared_state.magic = (is_valid ? CY_WCM_SHARED_STATE_MAGIC : 0);
+    wcm_shared_state.version = CY_WCM_SHARED_STATE_VERSION;
+    wcm_shared_state.is_connected = state.is_connected;
+    memcpy(wcm_shared_state.sta_mac, state.sta_mac, sizeof(cy_wcm_mac_t));
+    memcpy(&wcm_shared_state.ip_addr, &state.ip_addr, sizeof(cy_wcm_ip_address_t));
+    memcpy(&wcm_shared_state.gateway_addr, &state.gateway_addr, sizeof(cy_wcm_ip_address_t));
+    memcpy(&wcm_shared_state.ap_info, &state.ap_info, sizeof(cy_wcm_associated_ap_info_t));
+    WCM_MEMORY_BARRIER();
+    wcm_shared_state.sequence++;
+
+    if(cy_rtos_set_mutex(&wcm_config_mutex) != CY_RSLT_SUCCESS)
     {
-        id =  *(const uint8_t *)elt;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
     }
-    else
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
     {
-        id = ltoh16_ua((const uint8_t *)elt);
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
     }
-    return id;
 }
+#endif
 
-static int xtlv_hdr_size(xtlv_opts_t opts, const uint8_t **data)
+/*
+ * Returns the value of the first XTLV element with the given id, or NULL if there is none.
+ * Elements have a 16-bit id and a 16-bit length and are padded to 32 bits.
+ */
+static const uint8_t *find_xtlv(const uint8_t *buf, uint32_t buflen, uint16_t id, uint16_t *len)
 {
-    int len = (int)OFFSETOF(xtlv_t, data); /* nominal */
-    if (opts & XTLV_OPTION_LENU8)
-    {
-        --len;
-    }
-    if (opts & XTLV_OPTION_IDU8)
+    uint32_t elt_len;
+    uint32_t size;
+
+    while (buflen >= WCM_XTLV_HDR_SIZE)
     {
-        --len;
+        elt_len = _LTOH16_UA(buf + sizeof(uint16_t));
+        if ((elt_len + WCM_XTLV_HDR_SIZE) > buflen)
+        {
+            break;
+        }
+        if (_LTOH16_UA(buf) == id)
+        {
+            *len = (uint16_t)elt_len;
+            return buf + WCM_XTLV_HDR_SIZE;
+        }
+        size = WCM_ALIGN_SIZE(elt_len + WCM_XTLV_HDR_SIZE, 4);
+        if (size >= buflen)
+        {
+            break;
+        }
+        buf    += size;
+        buflen -= size;
     }
-    return len;
+    return NULL;
 }
 
-static void xtlv_unpack_xtlv(const xtlv_t *xtlv, uint16_t *type, uint16_t *len,
-    const uint8_t **data, xtlv_opts_t opts)
+/*
+ * Adds the change of each 32-bit firmware counter since the previous snapshot to its 64-bit total.
+ * The unsigned difference is also correct if the firmware counter wrapped once in between.
+ * Counters that lie beyond len, because the firmware structure is shorter, are left unchanged.
+ */
+static void accumulate_counters(wcm_counter_totals_t *totals, const uint8_t *data, uint32_t len,
+                                const wcm_counter_field_t *fields, uint8_t field_count)
 {
-    if (type)
-    {
-        *type = (uint16_t)xtlv_id(xtlv, opts);
-    }
-    if (len)
-    {
-        *len = (uint16_t)xtlv_len(xtlv, opts);
-    }
-    if (data)
+    uint32_t value;
+    uint8_t counter;
+    uint8_t i;
+
+    for (i = 0; i < field_count; i++)
     {
-        *data = (const uint8_t *)xtlv + xtlv_hdr_size(opts, data);
+        if ((fields[i].offset + sizeof(uint32_t)) > len)
+        {
+            continue;
+        }
+        memcpy(&value, data + fields[i].offset, sizeof(value));
+        counter = fields[i].counter;
+        if (totals->has_snapshot)
+        {
+            totals->total[counter] += (uint32_t)(value - totals->last[counter]);
+        }
+        else
+        {
+            totals->total[counter] = value;
+        }
+        totals->last[counter] = value;
     }
+    totals->has_snapshot = true;
 }
 
-static void unpack_xtlv_buf(const uint8_t *tlv_buf, uint16_t buflen,cy_wcm_wlan_statistics_t *stat)
+static cy_rslt_t read_wlan_counters(cy_wcm_interface_t interface, cy_wcm_wlan_counters_t *counters)
 {
-    uint16_t len;
-    uint16_t type;
-    int size;
-    const xtlv_t *ptlv;
-    int sbuflen = buflen;
+    /* 32-bit aligned so that the counters are read in place */
+    uint32_t buffer[WLC_IOCTL_MEDLEN / sizeof(uint32_t)];
+    const wl_cnt_info_t *wl_cnt_info = (const wl_cnt_info_t *)buffer;
+    wcm_counter_totals_t *totals = &wlan_counter_totals[interface];
     const uint8_t *data;
-    int hdr_size;
+    uint32_t datalen;
+    uint16_t len;
+    cy_rslt_t res;
 
-    hdr_size = xtlv_hdr_size(XTLV_OPTION_ALIGN32, &data);
-    while (sbuflen >= hdr_size) {
-        ptlv = (const xtlv_t *)tlv_buf;
+    /* The snapshot is taken under the lock too, so that two callers cannot fold their snapshots in the wrong order */
+    if (cy_rtos_get_mutex(&wcm_config_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
 
-        xtlv_unpack_xtlv(ptlv, &type, &len, &data, XTLV_OPTION_ALIGN32);
-        size = xtlv_size_for_data(len, XTLV_OPTION_ALIGN32, &data);
+    res = whd_wifi_get_iovar_buffer(whd_ifs[interface], IOVAR_STR_COUNTERS, (uint8_t *)buffer, sizeof(buffer));
+    if (res != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to read the counters. Err = [%lu] \n", res);
+        goto exit;
+    }
 
-        sbuflen -= size;
-        if (sbuflen < 0) /* check for buffer overrun */
+    if (wl_cnt_info->version == WL_CNT_VER_30)
+    {
+        /* 43012 board - The counters are in an XTLV element */
+        datalen = wl_cnt_info->datalen;
+        if ((datalen + OFFSETOF(wl_cnt_info_t, data)) > sizeof(buffer))
         {
-            break;
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "IOVAR buffer short! \n");
+            datalen = sizeof(buffer) - OFFSETOF(wl_cnt_info_t, data);
         }
-        if (type == 0x100)
+        data = find_xtlv(wl_cnt_info->data, datalen, WCM_CNT_XTLV_WLC, &len);
+        if (data != NULL)
         {
-            if(wl_counters(data, stat) == CY_RSLT_SUCCESS)
-            {
-                break;
-            }
+            accumulate_counters(totals, data, len, cnt_ver_30_fields, sizeof(cnt_ver_30_fields) / sizeof(cnt_ver_30_fields[0]));
         }
-        tlv_buf += size;
     }
-    return;
-}
+    else if (wl_cnt_info->version == WL_CNT_VER_10)
+    {
+        accumulate_counters(totals, (const uint8_t *)buffer, sizeof(buffer), cnt_ver_10_fields, sizeof(cnt_ver_10_fields) / sizeof(cnt_ver_10_fields[0]));
+    }
 
-static cy_rslt_t wl_counters(const uint8_t *data, cy_wcm_wlan_statistics_t *stat)
-{
-    wl_cnt_ver_30_t *cnt = (wl_cnt_ver_30_t *)data;
-    stat->rx_bytes   = cnt->rxbyte;
-    stat->tx_bytes   = cnt->txbyte;
-    stat->rx_packets = cnt->rxfrag;
-    stat->tx_packets = cnt->txfrag;
-    stat->tx_failed  = cnt->txfail;
-    stat->tx_retries = cnt->txretry;
-    return CY_RSLT_SUCCESS;
+    counters->rx_bytes      = totals->total[WCM_CNT_RX_BYTES];
+    counters->tx_bytes      = totals->total[WCM_CNT_TX_BYTES];
+    counters->rx_packets    = totals->total[WCM_CNT_RX_PACKETS];
+    counters->tx_packets    = totals->total[WCM_CNT_TX_PACKETS];
+    counters->tx_retries    = totals->total[WCM_CNT_TX_RETRIES];
+    counters->tx_failed     = totals->total[WCM_CNT_TX_FAILED];
+    counters->tx_errors     = totals->total[WCM_CNT_TX_ERRORS];
+    counters->rx_fcs_errors = totals->total[WCM_CNT_RX_FCS_ERRORS];
+    counters->rx_dropped    = totals->total[WCM_CNT_RX_DROPPED];
+    counters->rx_errors     = totals->total[WCM_CNT_RX_ERRORS];
+
+exit:
+    if (cy_rtos_set_mutex(&wcm_config_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+    return res;
 }
 
-cy_rslt_t cy_wcm_get_wlan_statistics(cy_wcm_interface_t interface, cy_wcm_wlan_statistics_t *stat)
+cy_rslt_t cy_wcm_get_wlan_counters(cy_wcm_interface_t interface, cy_wcm_wlan_counters_t *counters)
 {
+    cy_rslt_t res;
     uint32_t data_rate;
-    wl_cnt_ver_ten_t* received_counters;
-    uint8_t buffer[WLC_IOCTL_MEDLEN];
-    wl_cnt_info_t* wl_cnt_info ;
 
     if(!is_wcm_initalized)
     {
@@ -2620,64 +3746,49 @@ cy_rslt_t cy_wcm_get_wlan_statistics(cy_wcm_interface_t interface, cy_wcm_wlan_s
         return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
-    if(interface != CY_WCM_INTERFACE_TYPE_STA)
+    if((interface != CY_WCM_INTERFACE_TYPE_STA) && (interface != CY_WCM_INTERFACE_TYPE_AP))
     {
         return CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
     }
 
-    if(stat == NULL)
+    if(counters == NULL)
     {
         return CY_RSLT_WCM_BAD_ARG;
     }
 
-    if(!cy_wcm_is_connected_to_ap())
+    memset(counters, 0, sizeof(cy_wcm_wlan_counters_t));
+
+    if((interface == CY_WCM_INTERFACE_TYPE_STA) && !cy_wcm_is_connected_to_ap())
     {
-        memset(stat, 0, sizeof(cy_wcm_wlan_statistics_t));
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not connected. \n");
         return CY_RSLT_WCM_NOT_CONNECTED_TO_AP;
     }
 
-    CHECK_RETURN(whd_wifi_get_iovar_buffer(whd_ifs[ CY_WCM_INTERFACE_TYPE_STA], IOVAR_STR_COUNTERS, buffer, WLC_IOCTL_MEDLEN));
-    wl_cnt_info = (wl_cnt_info_t * )buffer;
-
-    if (wl_cnt_info->version == WL_CNT_VER_30)
+    if((interface == CY_WCM_INTERFACE_TYPE_AP) && !is_soft_ap_up)
     {
-        /* 43012 board - Process xtlv buffer data to get statistics */
-        uint8_t *cntdata;
-        cntdata = (uint8_t *)malloc(wl_cnt_info->datalen);
-
-        CHK_CNTBUF_DATALEN(wl_cnt_info, WLC_IOCTL_MEDLEN);
-        if (cntdata == NULL) {
-            return CY_RSLT_TYPE_ERROR;
-        }
-        memcpy(cntdata, wl_cnt_info->data, wl_cnt_info->datalen);
-        unpack_xtlv_buf(cntdata, wl_cnt_info->datalen, stat);
-        free(cntdata);
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "AP not up \r\n");
+        return CY_RSLT_WCM_AP_NOT_UP;
     }
-    else if (wl_cnt_info->version == WL_CNT_VER_10)
-    {
-        received_counters =(wl_cnt_ver_ten_t*)  wl_cnt_info;
 
-        /* Copy the required statistics */
-        stat->rx_bytes   = received_counters->rxbyte;
-        stat->tx_bytes   = received_counters->txbyte;
-        stat->rx_packets = received_counters->rxfrag;
-        stat->tx_packets = received_counters->txfrag;
-        stat->tx_failed  = received_counters->txfail;
-        stat->tx_retries = received_counters->txretry;
+    if((res = read_wlan_counters(interface, counters)) != CY_RSLT_SUCCESS)
+    {
+        return res;
     }
 
-    /* get data rate */
-    CHECK_RETURN (whd_wifi_get_ioctl_value(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WLC_GET_RATE, &data_rate));
-    /* The data rate received is in units of 500Kbits per sec, convert to Kbits per sec*/
-    stat->tx_bitrate = (data_rate * TX_BIT_RATE_CONVERTER);
+    if(interface == CY_WCM_INTERFACE_TYPE_STA)
+    {
+        /* get data rate */
+        CHECK_RETURN (whd_wifi_get_ioctl_value(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WLC_GET_RATE, &data_rate));
+        /* The data rate received is in units of 500Kbits per sec, convert to Kbits per sec*/
+        counters->tx_bitrate = (data_rate * TX_BIT_RATE_CONVERTER);
+    }
     return CY_RSLT_SUCCESS;
 }
 
-cy_rslt_t cy_wcm_get_gateway_mac_address(cy_wcm_mac_t *mac_addr)
+cy_rslt_t cy_wcm_get_wlan_statistics(cy_wcm_interface_t interface, cy_wcm_wlan_statistics_t *stat)
 {
-    cy_rslt_t res = CY_RSLT_SUCCESS;
-    cy_nw_ip_mac_t nw_mac_addr;
+    cy_wcm_wlan_counters_t counters;
+    cy_rslt_t res;
 
     if(!is_wcm_initalized)
     {
@@ -2685,24 +3796,88 @@ cy_rslt_t cy_wcm_get_gateway_mac_address(cy_wcm_mac_t *mac_addr)
         return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
-    if(mac_addr == NULL)
+    if(stat == NULL)
     {
         return CY_RSLT_WCM_BAD_ARG;
     }
 
-    if(current_interface == CY_WCM_INTERFACE_TYPE_AP)
+    res = cy_wcm_get_wlan_counters(interface, &counters);
+    if((res != CY_RSLT_SUCCESS) && (res != CY_RSLT_WCM_NOT_CONNECTED_TO_AP))
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "feature not supported for AP interface \r\n");
-        return CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
+        return res;
     }
 
-    if(!is_sta_network_up)
-    {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Network is not up, call cy_wcm_connect_ap API to bring network up \r\n");
-        return CY_RSLT_WCM_NETIF_DOES_NOT_EXIST;
-    }
+    stat->rx_bytes   = (uint32_t)counters.rx_bytes;
+    stat->tx_bytes   = (uint32_t)counters.tx_bytes;
+    stat->rx_packets = (uint32_t)counters.rx_packets;
+    stat->tx_packets = (uint32_t)counters.tx_packets;
+    stat->tx_failed  = (uint32_t)counters.tx_failed;
+    stat->tx_retries = (uint32_t)counters.tx_retries;
+    stat->tx_bitrate = counters.tx_bitrate;
+    return res;
+}
 
-    memset(mac_addr , 0, sizeof(*mac_addr));
+cy_rslt_t cy_wcm_get_worker_stats(cy_wcm_worker_lane_t lane, cy_wcm_worker_lane_stats_t *stats, bool reset)
+{
+    wcm_worker_lane_t *worker_lane;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if((stats == NULL) || (lane >= CY_WCM_WORKER_LANE_MAX))
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if(cy_rtos_get_mutex(&worker_lane_mutex, CY_RTOS_NEVER_TIMEOUT) != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    worker_lane = &worker_lanes[lane];
+    *stats = worker_lane->stats;
+    stats->pending = worker_lane->count;
+    if(reset)
+    {
+        memset(&worker_lane->stats, 0, sizeof(worker_lane->stats));
+        worker_lane->stats.high_water_mark = worker_lane->count;
+    }
+    cy_rtos_set_mutex(&worker_lane_mutex);
+
+    return CY_RSLT_SUCCESS;
+}
+
+cy_rslt_t cy_wcm_get_gateway_mac_address(cy_wcm_mac_t *mac_addr)
+{
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+    cy_nw_ip_mac_t nw_mac_addr;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if(mac_addr == NULL)
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if(current_interface == CY_WCM_INTERFACE_TYPE_AP)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "feature not supported for AP interface \r\n");
+        return CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
+    }
+
+    if(!is_sta_network_up)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Network is not up, call cy_wcm_connect_ap API to bring network up \r\n");
+        return CY_RSLT_WCM_NETIF_DOES_NOT_EXIST;
+    }
+
+    memset(mac_addr , 0, sizeof(*mac_addr));
     res = cy_network_get_gateway_mac_address(nw_sta_if_ctx, &nw_mac_addr);
     if(res != CY_RSLT_SUCCESS)
     {
@@ -2721,6 +3896,8 @@ cy_rslt_t cy_wcm_get_gateway_mac_address(cy_wcm_mac_t *mac_addr)
 cy_rslt_t cy_wcm_ping(cy_wcm_interface_t interface, cy_wcm_ip_address_t* address, uint32_t timeout_ms, uint32_t* elapsed_time_ms)
 {
     cy_rslt_t res = CY_RSLT_SUCCESS;
+    cy_mutex_t *interface_mutex;
+    void *nw_if_ctx;
 
     if(!is_wcm_initalized)
     {
@@ -2740,6 +3917,160 @@ cy_rslt_t cy_wcm_ping(cy_wcm_interface_t interface, cy_wcm_ip_address_t* address
         return CY_RSLT_WCM_BAD_ARG;
     }
 
+    /* The interface state and network context are read under the interface lock, which is released before pinging
+     * so that connect, disconnect and link event handling are not held up for the whole ping timeout */
+    interface_mutex = (interface == CY_WCM_INTERFACE_TYPE_AP) ? &wcm_ap_mutex : &wcm_sta_mutex;
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
+    if(cy_rtos_get_mutex(interface_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+
+    if((interface == CY_WCM_INTERFACE_TYPE_STA) && (wcm_sta_link_up == false))
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "STA network down \r\n");
+        res = CY_RSLT_WCM_STA_NETWORK_DOWN;
+    }
+    else if((interface == CY_WCM_INTERFACE_TYPE_AP) && (is_soft_ap_up == false))
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "AP not up \r\n");
+        res = CY_RSLT_WCM_AP_NOT_UP;
+    }
+    nw_if_ctx = (interface == CY_WCM_INTERFACE_TYPE_AP) ? (void *)nw_ap_if_ctx : (void *)nw_sta_if_ctx;
+
+    if(cy_rtos_set_mutex(interface_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+        res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
+    }
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlocked %s %d\r\n", __FILE__, __LINE__);
+
+    if(res != CY_RSLT_SUCCESS)
+    {
+        return res;
+    }
+
+    /* If the interface goes down meanwhile, the ping times out or fails in the network stack */
+    return cy_network_ping(nw_if_ctx, (cy_nw_ip_address_t *) address, timeout_ms, elapsed_time_ms);
+}
+
+cy_rslt_t cy_wcm_ping_start(const cy_wcm_ping_config_t *config, cy_wcm_ping_callback_t callback, void *user_data)
+{
+    cy_worker_thread_params_t params;
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+    uint8_t i;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if((config == NULL) || (callback == NULL) || (config->target_count == 0) ||
+       (config->target_count > CY_WCM_PING_MAX_TARGETS) || (config->interval_ms == 0))
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "BAD arguments \r\n");
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if((config->interface != CY_WCM_INTERFACE_TYPE_STA) && (config->interface != CY_WCM_INTERFACE_TYPE_AP))
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "interface not supported \r\n");
+        return CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
+    }
+
+    if((res = ping_check_interface(config->interface)) != CY_RSLT_SUCCESS)
+    {
+        return res;
+    }
+
+    if(cy_rtos_get_mutex(&ping_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+
+    if(ping_session.is_active)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Ping session already in progress \r\n");
+        res = CY_RSLT_WCM_PING_IN_PROGRESS;
+        goto exit;
+    }
+
+    /* The thread is only created by the first session, applications that never use it do not pay for its stack */
+    if(!is_ping_thread_created)
+    {
+        memset(&params, 0, sizeof(params));
+        params.name = "WCM- Ping";
+        params.priority = WCM_WORKER_THREAD_PRIORITY;
+        params.stack = NULL;
+        params.stack_size = WCM_PING_THREAD_STACK_SIZE;
+        params.num_entries = 0;
+        if((res = cy_worker_thread_create(&ping_worker_thread, &params)) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to create the ping thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+            goto exit;
+        }
+        is_ping_thread_created = true;
+    }
+
+    ping_session.config = *config;
+    ping_session.callback = callback;
+    ping_session.user_data = user_data;
+    ping_session.session_id++;
+    ping_session.rounds = 0;
+    memset(ping_session.rtt_sum_ms, 0, sizeof(ping_session.rtt_sum_ms));
+    memset(ping_session.stats, 0, sizeof(ping_session.stats));
+    for(i = 0; i < config->target_count; i++)
+    {
+        ping_session.stats[i].address = config->targets[i];
+    }
+    ping_session.is_active = true;
+
+    if((res = cy_rtos_start_timer(&ping_timer, config->interval_ms)) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to start the ping timer. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+        ping_session.is_active = false;
+        goto exit;
+    }
+    /* The first round starts right away, the timer paces the following ones */
+    ping_timer_handler(0);
+
+exit:
+    if(cy_rtos_set_mutex(&ping_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+    return res;
+}
+
+cy_rslt_t cy_wcm_ping_stop(void)
+{
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    /* The callback runs with ping_mutex held, so once the lock is taken no callback of the session is running */
+    if(cy_rtos_get_mutex(&ping_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+    cy_rtos_stop_timer(&ping_timer);
+    ping_session.is_active = false;
+    if(cy_rtos_set_mutex(&ping_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+static cy_rslt_t ping_check_interface(cy_wcm_interface_t interface)
+{
     if((interface == CY_WCM_INTERFACE_TYPE_STA) && (wcm_sta_link_up == false))
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "STA network down \r\n");
@@ -2751,32 +4082,156 @@ cy_rslt_t cy_wcm_ping(cy_wcm_interface_t interface, cy_wcm_ip_address_t* address
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "AP not up \r\n");
         return CY_RSLT_WCM_AP_NOT_UP;
     }
+    return CY_RSLT_SUCCESS;
+}
 
-    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+/* Histogram bin of a round-trip time: bin n holds 2^n to 2^(n+1) - 1 ms, bin 0 also holds 0 ms */
+static uint8_t ping_histogram_bin(uint32_t rtt_ms)
+{
+    uint8_t bin = 0;
+
+    while((rtt_ms > 1) && (bin < (CY_WCM_PING_HISTOGRAM_BINS - 1)))
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
-        return CY_RSLT_WCM_WAIT_TIMEOUT;
+        rtt_ms >>= 1;
+        bin++;
     }
+    return bin;
+}
 
-    /* Call cy_network_ping() */
-    if(interface == CY_WCM_INTERFACE_TYPE_AP)
+static void ping_timer_handler(cy_timer_callback_arg_t arg)
+{
+    cy_rslt_t result;
+    uint32_t primask;
+    bool is_queued;
+
+    UNUSED_PARAMETER(arg);
+
+    /*
+     * Runs on the timer service and, for the first round, in cy_wcm_ping_start(). It must not block on ping_mutex,
+     * which the round handler holds while the callback runs, so the flag is tested and set with interrupts masked.
+     */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    is_queued = ping_session.is_round_queued;
+    ping_session.is_round_queued = true;
+    __set_PRIMASK(primask);
+
+    /* A round that is still waiting for the thread already covers this tick */
+    if(is_queued)
     {
-        res = cy_network_ping((void *)nw_ap_if_ctx, (cy_nw_ip_address_t *) address, timeout_ms, elapsed_time_ms);
+        return;
     }
-    else
+    if((result = cy_worker_thread_enqueue(&ping_worker_thread, ping_round_handler, NULL)) != CY_RSLT_SUCCESS)
     {
-        res = cy_network_ping((void *)nw_sta_if_ctx, (cy_nw_ip_address_t *) address, timeout_ms, elapsed_time_ms);
+        ping_session.is_round_queued = false;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to queue the ping round. Err = [%lu]\r\n", __LINE__, __FUNCTION__, result);
     }
+}
+
+/*
+ * Sends one echo request to each target of the session. The requests are sent without any lock held;
+ * the session is only locked to copy its configuration and to fold in the results.
+ */
+static void ping_round_handler(void *arg)
+{
+    cy_wcm_ip_address_t targets[CY_WCM_PING_MAX_TARGETS];
+    uint32_t rtt_ms[CY_WCM_PING_MAX_TARGETS];
+    bool replied[CY_WCM_PING_MAX_TARGETS];
+    cy_wcm_ping_target_stats_t *stats;
+    cy_wcm_interface_t interface;
+    uint32_t timeout_ms;
+    uint32_t session_id;
+    uint8_t target_count;
+    uint8_t pinged;
+    uint8_t i;
+    bool is_complete = false;
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+
+    UNUSED_PARAMETER(arg);
+
+    ping_session.is_round_queued = false;
 
-    if(cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&ping_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+    if(!ping_session.is_active)
+    {
+        cy_rtos_set_mutex(&ping_mutex);
+        return;
+    }
+    interface = ping_session.config.interface;
+    timeout_ms = ping_session.config.timeout_ms;
+    target_count = ping_session.config.target_count;
+    memcpy(targets, ping_session.config.targets, sizeof(targets));
+    session_id = ping_session.session_id;
+    if(cy_rtos_set_mutex(&ping_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
-        res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
+        return;
     }
-    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlocked %s %d\r\n", __FILE__, __LINE__);
 
-    return res;
+    for(pinged = 0; pinged < target_count; pinged++)
+    {
+        if((result = ping_check_interface(interface)) != CY_RSLT_SUCCESS)
+        {
+            break;
+        }
+        rtt_ms[pinged] = 0;
+        replied[pinged] = (cy_network_ping((interface == CY_WCM_INTERFACE_TYPE_AP) ? (void *)nw_ap_if_ctx : (void *)nw_sta_if_ctx,
+                                           (cy_nw_ip_address_t *)&targets[pinged], timeout_ms, &rtt_ms[pinged]) == CY_RSLT_SUCCESS);
+    }
+
+    if(cy_rtos_get_mutex(&ping_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+    /* The session may have been stopped, or stopped and restarted, while the requests were in flight */
+    if(!ping_session.is_active || (ping_session.session_id != session_id))
+    {
+        goto exit;
+    }
+
+    for(i = 0; i < pinged; i++)
+    {
+        stats = &ping_session.stats[i];
+        stats->sent++;
+        if(!replied[i])
+        {
+            continue;
+        }
+        if((stats->received == 0) || (rtt_ms[i] < stats->min_rtt_ms))
+        {
+            stats->min_rtt_ms = rtt_ms[i];
+        }
+        if(rtt_ms[i] > stats->max_rtt_ms)
+        {
+            stats->max_rtt_ms = rtt_ms[i];
+        }
+        stats->received++;
+        ping_session.rtt_sum_ms[i] += rtt_ms[i];
+        stats->avg_rtt_ms = (uint32_t)(ping_session.rtt_sum_ms[i] / stats->received);
+        stats->histogram[ping_histogram_bin(rtt_ms[i])]++;
+    }
+    ping_session.rounds++;
+
+    if((result != CY_RSLT_SUCCESS) || ((ping_session.config.count != 0) && (ping_session.rounds >= ping_session.config.count)))
+    {
+        cy_rtos_stop_timer(&ping_timer);
+        ping_session.is_active = false;
+        is_complete = true;
+    }
+
+    /* Called with ping_mutex held so that cy_wcm_ping_stop() returns only after the callback has finished */
+    ping_session.callback(result, ping_session.stats, target_count, is_complete, ping_session.user_data);
+
+exit:
+    if(cy_rtos_set_mutex(&ping_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
 }
 
 cy_rslt_t cy_wcm_start_ap(const cy_wcm_ap_config_t *ap_config)
@@ -2803,7 +4258,7 @@ cy_rslt_t cy_wcm_start_ap(const cy_wcm_ap_config_t *ap_config)
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
@@ -2895,6 +4350,7 @@ cy_rslt_t cy_wcm_start_ap(const cy_wcm_ap_config_t *ap_config)
     }
 
     /* Register for AP Link events*/
+    memset(ap_clients, 0, sizeof(ap_clients));
     if((res = whd_management_set_event_handler(whd_ifs[CY_WCM_INTERFACE_TYPE_AP], ap_link_events, ap_link_events_handler, NULL, &ap_event_handler_index)) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to set the Event handler \n");
@@ -2903,9 +4359,12 @@ cy_rslt_t cy_wcm_start_ap(const cy_wcm_ap_config_t *ap_config)
         goto exit;
     }
     is_soft_ap_up = true;
+#if (WCM_AP_CLIENT_RECONCILE_INTERVAL_MS != 0)
+    cy_rtos_start_timer(&ap_client_reconcile_timer, WCM_AP_CLIENT_RECONCILE_INTERVAL_MS);
+#endif
 
 exit:
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
@@ -2926,7 +4385,7 @@ cy_rslt_t cy_wcm_stop_ap(void)
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
@@ -2934,6 +4393,8 @@ cy_rslt_t cy_wcm_stop_ap(void)
 
     if(is_soft_ap_up)
     {
+        cy_rtos_stop_timer(&ap_client_reconcile_timer);
+        memset(ap_clients, 0, sizeof(ap_clients));
         network_down(whd_ifs[CY_WCM_INTERFACE_TYPE_AP], CY_NETWORK_WIFI_AP_INTERFACE);
         /* De-register of AP link event handler */
         whd_wifi_deregister_event_handler(whd_ifs[CY_WCM_INTERFACE_TYPE_AP], ap_event_handler_index);
@@ -2946,7 +4407,7 @@ cy_rslt_t cy_wcm_stop_ap(void)
         is_soft_ap_up = false;
     }
 exit:
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
     {
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
     }
@@ -2959,9 +4420,8 @@ exit:
 cy_rslt_t cy_wcm_get_associated_client_list(cy_wcm_mac_t *client_list, uint8_t num_clients)
 {
     cy_rslt_t res = CY_RSLT_SUCCESS;
-
-    whd_maclist_t *mac_list_ptr;
-    uint32_t      buf_length;
+    uint8_t count = 0;
+    uint8_t i;
 
     if(!is_wcm_initalized)
     {
@@ -2976,7 +4436,7 @@ cy_rslt_t cy_wcm_get_associated_client_list(cy_wcm_mac_t *client_list, uint8_t n
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return CY_RSLT_WCM_WAIT_TIMEOUT;
@@ -2996,29 +4456,18 @@ cy_rslt_t cy_wcm_get_associated_client_list(cy_wcm_mac_t *client_list, uint8_t n
         goto exit;
     }
 
-    buf_length   = (sizeof(whd_mac_t) * num_clients) + sizeof(mac_list_ptr->count);
-    mac_list_ptr = (whd_maclist_t*)malloc(buf_length);
-    if(mac_list_ptr == NULL)
-    {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Heap space error \n");
-        res = CY_RSLT_WCM_OUT_OF_MEMORY;
-        goto exit;
-    }
-    memset(mac_list_ptr, 0, buf_length);
-    mac_list_ptr->count = num_clients;
-
-    if((res = whd_wifi_get_associated_client_list(whd_ifs[CY_WCM_INTERFACE_TYPE_AP], mac_list_ptr, buf_length)) != CY_RSLT_SUCCESS)
+    /* Served from the client table kept up to date by the AP link events, no firmware access needed */
+    memset(client_list, 0, (sizeof(cy_wcm_mac_t) * num_clients));
+    for(i = 0; (i < WCM_AP_CLIENT_TABLE_SIZE) && (count < num_clients); i++)
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error while getting associated client list, error = %d \n", res);
-        free(mac_list_ptr);
-        goto exit;
+        if(ap_clients[i].in_use)
+        {
+            memcpy(client_list[count++], ap_clients[i].mac_addr, CY_WCM_MAC_ADDR_LEN);
+        }
     }
 
-    memcpy(client_list, mac_list_ptr->mac_list, (sizeof(whd_mac_t) * num_clients));
-    free(mac_list_ptr);
-
 exit:
-    if(cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if(cy_rtos_set_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
     {
         res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
     }
@@ -3027,20 +4476,249 @@ exit:
     return res;
 }
 
-static uint16_t channel_to_bandwidth(wl_chanspec_t chanspec)
+cy_rslt_t cy_wcm_get_associated_client_info(cy_wcm_ap_client_info_t *client_info, uint8_t max_clients, uint8_t *num_clients)
 {
-    uint16_t band_width;
-    switch(chanspec & WL_CHANSPEC_BW_MASK)
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+    uint8_t count = 0;
+    uint8_t i;
+
+    if(!is_wcm_initalized)
     {
-        case WL_CHANSPEC_BW_5 :
-            band_width = 5;
-            break;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
 
-        case WL_CHANSPEC_BW_10 :
-            band_width = 10;
-            break;
+    if(client_info == NULL || max_clients == 0 || num_clients == NULL)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad arguments \n");
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+    *num_clients = 0;
 
-        case WL_CHANSPEC_BW_20 :
+    if(cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+
+    if(current_interface == CY_WCM_INTERFACE_TYPE_STA)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "operation not allowed for STA Interface \n");
+        res = CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
+        goto exit;
+    }
+
+    if(!is_ap_network_up)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "AP is not Up !!\n");
+        res = CY_RSLT_WCM_AP_NOT_UP;
+        goto exit;
+    }
+
+    for(i = 0; (i < WCM_AP_CLIENT_TABLE_SIZE) && (count < max_clients); i++)
+    {
+        if(ap_clients[i].in_use)
+        {
+            memcpy(client_info[count].mac_addr, ap_clients[i].mac_addr, CY_WCM_MAC_ADDR_LEN);
+            client_info[count].rssi = ap_clients[i].rssi;
+            client_info[count].join_time_ms = ap_clients[i].join_time;
+            client_info[count].last_seen_ms = ap_clients[i].last_seen_time;
+            count++;
+        }
+    }
+    *num_clients = count;
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
+    {
+        res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
+    }
+    return res;
+}
+
+cy_rslt_t cy_wcm_refresh_associated_clients(void)
+{
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if(cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+
+    if(current_interface == CY_WCM_INTERFACE_TYPE_STA)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "operation not allowed for STA Interface \n");
+        res = CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
+        goto exit;
+    }
+
+    if(!is_soft_ap_up)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "AP is not Up !!\n");
+        res = CY_RSLT_WCM_AP_NOT_UP;
+        goto exit;
+    }
+
+    res = ap_client_table_reconcile();
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
+    {
+        res = ((res != CY_RSLT_SUCCESS) ? res : CY_RSLT_WCM_MUTEX_ERROR);
+    }
+    return res;
+}
+
+/* Returns the client table entry of the given MAC address, or NULL. Called with wcm_ap_mutex held. */
+static wcm_ap_client_t *ap_client_table_find(const uint8_t *mac_addr)
+{
+    uint8_t i;
+
+    for(i = 0; i < WCM_AP_CLIENT_TABLE_SIZE; i++)
+    {
+        if(ap_clients[i].in_use && (memcmp(ap_clients[i].mac_addr, mac_addr, CY_WCM_MAC_ADDR_LEN) == 0))
+        {
+            return &ap_clients[i];
+        }
+    }
+    return NULL;
+}
+
+/* Adds the client to the table if it is not in it yet and marks it as seen now. Called with wcm_ap_mutex held. */
+static wcm_ap_client_t *ap_client_table_update(const uint8_t *mac_addr)
+{
+    wcm_ap_client_t *client;
+    cy_time_t now = 0;
+    uint8_t i;
+
+    cy_rtos_get_time(&now);
+    client = ap_client_table_find(mac_addr);
+    for(i = 0; (client == NULL) && (i < WCM_AP_CLIENT_TABLE_SIZE); i++)
+    {
+        if(!ap_clients[i].in_use)
+        {
+            client = &ap_clients[i];
+            memset(client, 0, sizeof(wcm_ap_client_t));
+            memcpy(client->mac_addr, mac_addr, CY_WCM_MAC_ADDR_LEN);
+            client->join_time = now;
+            client->in_use = true;
+        }
+    }
+    if(client == NULL)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "SoftAP client table full, client not tracked \n");
+        return NULL;
+    }
+    client->last_seen_time = now;
+    return client;
+}
+
+/*
+ * Brings the client table in line with the association list of the firmware, in case a join or leave event was lost,
+ * and refreshes the RSSI of every client. Called with wcm_ap_mutex held.
+ */
+static cy_rslt_t ap_client_table_reconcile(void)
+{
+    wcm_ap_maclist_t assoc_list;
+    wcm_ap_client_t *client;
+    int32_t rssi;
+    uint32_t count;
+    uint32_t i;
+    uint32_t j;
+    cy_rslt_t res;
+
+    memset(&assoc_list, 0, sizeof(assoc_list));
+    assoc_list.count = WCM_AP_CLIENT_TABLE_SIZE;
+    if((res = whd_wifi_get_associated_client_list(whd_ifs[CY_WCM_INTERFACE_TYPE_AP], (whd_maclist_t *)&assoc_list, sizeof(assoc_list))) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error while getting associated client list, error = %d \n", res);
+        return res;
+    }
+    count = (assoc_list.count < WCM_AP_CLIENT_TABLE_SIZE) ? assoc_list.count : WCM_AP_CLIENT_TABLE_SIZE;
+
+    for(i = 0; i < WCM_AP_CLIENT_TABLE_SIZE; i++)
+    {
+        if(!ap_clients[i].in_use)
+        {
+            continue;
+        }
+        for(j = 0; j < count; j++)
+        {
+            if(memcmp(ap_clients[i].mac_addr, assoc_list.mac_list[j].octet, CY_WCM_MAC_ADDR_LEN) == 0)
+            {
+                break;
+            }
+        }
+        if(j == count)
+        {
+            ap_clients[i].in_use = false;
+        }
+    }
+
+    for(j = 0; j < count; j++)
+    {
+        client = ap_client_table_update(assoc_list.mac_list[j].octet);
+        if((client != NULL) && (whd_wifi_get_ap_client_rssi(whd_ifs[CY_WCM_INTERFACE_TYPE_AP], &rssi, &assoc_list.mac_list[j]) == WHD_SUCCESS))
+        {
+            client->rssi = (int16_t)rssi;
+        }
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+static void ap_client_reconcile_timer_handler(cy_timer_callback_arg_t arg)
+{
+    cy_rslt_t result;
+
+    UNUSED_PARAMETER(arg);
+
+    result = wcm_worker_enqueue(CY_WCM_WORKER_LANE_BULK, ap_client_reconcile_handler, NULL, true);
+    if(result != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to queue the client table refresh. Err = [%lu]\r\n", __LINE__, __FUNCTION__, result);
+    }
+}
+
+static void ap_client_reconcile_handler(void *arg)
+{
+    UNUSED_PARAMETER(arg);
+
+    if(cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+    if(is_soft_ap_up)
+    {
+        ap_client_table_reconcile();
+    }
+    if(cy_rtos_set_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+}
+
+static uint16_t channel_to_bandwidth(wl_chanspec_t chanspec)
+{
+    uint16_t band_width;
+    switch(chanspec & WL_CHANSPEC_BW_MASK)
+    {
+        case WL_CHANSPEC_BW_5 :
+            band_width = 5;
+            break;
+
+        case WL_CHANSPEC_BW_10 :
+            band_width = 10;
+            break;
+
+        case WL_CHANSPEC_BW_20 :
             band_width = 20;
             break;
 
@@ -3162,6 +4840,25 @@ static bool is_connected_to_same_ap(const cy_wcm_connect_params_t *connect_param
     return false;
 }
 
+static bool is_same_ap_credentials(whd_security_t security, const uint8_t *key, uint8_t keylen)
+{
+    return ((connected_ap_details.security == security) && (connected_ap_details.keylen == keylen) &&
+            (memcmp(connected_ap_details.key, key, keylen) == 0));
+}
+
+static void save_connected_ap_details(const cy_wcm_connect_params_t *connect_params, const whd_ssid_t *ssid, const whd_mac_t *bssid,
+                                      const uint8_t *key, uint8_t keylen, whd_security_t security, const cy_network_static_ip_addr_t *static_ip)
+{
+    connected_ap_details.security = security;
+    connected_ap_details.SSID.length = ssid->length;
+    connected_ap_details.keylen = keylen;
+    connected_ap_details.band = connect_params->band;
+    memcpy(connected_ap_details.key, key, keylen+1);
+    memcpy(connected_ap_details.SSID.value, ssid->value, connected_ap_details.SSID.length+1);
+    memcpy(connected_ap_details.sta_mac.octet, bssid->octet, CY_WCM_MAC_ADDR_LEN);
+    memcpy(&connected_ap_details.static_ip, static_ip, sizeof(*static_ip));
+}
+
 
 
 static bool check_wcm_security(cy_wcm_security_t sec)
@@ -3219,8 +4916,9 @@ void internal_scan_callback(whd_scan_result_t **result_ptr,
         /* Check for scan complete */
         if (status == WHD_SCAN_COMPLETED_SUCCESSFULLY || status == WHD_SCAN_ABORTED)
         {
+            cy_wcm_trace(CY_WCM_TRACE_SCAN_COMPLETE, status, 0, 0);
             /* Notify scan complete */
-            if(cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_scan_completed, (void *)scan_status) != CY_RSLT_SUCCESS)
+            if(wcm_worker_enqueue(CY_WCM_WORKER_LANE_BULK, notify_scan_completed, (void *)scan_status, false) != CY_RSLT_SUCCESS)
             {
                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error in calling the worker thread func \n");
             }
@@ -3228,6 +4926,13 @@ void internal_scan_callback(whd_scan_result_t **result_ptr,
         return;
     }
 
+    cy_wcm_trace(CY_WCM_TRACE_SCAN_RESULT, (*result_ptr)->channel, (*result_ptr)->signal_strength, (*result_ptr)->security);
+    if (scan_handler.p_scan_view_callback != NULL)
+    {
+        deliver_scan_view(*result_ptr);
+        goto exit;
+    }
+
     whd_scan_result = (whd_scan_result_t *)malloc(sizeof(whd_scan_result_t));
     if (whd_scan_result == NULL)
     {
@@ -3235,7 +4940,7 @@ void internal_scan_callback(whd_scan_result_t **result_ptr,
         goto exit;
     }
     memcpy(whd_scan_result, *result_ptr, sizeof(whd_scan_result_t));
-    if(cy_worker_thread_enqueue(&cy_wcm_worker_thread, process_scan_data, whd_scan_result) != CY_RSLT_SUCCESS)
+    if(wcm_worker_enqueue(CY_WCM_WORKER_LANE_BULK, process_scan_data, whd_scan_result, false) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error in calling the worker thread func \n");
         free(whd_scan_result);
@@ -3256,7 +4961,7 @@ static void notify_scan_completed(void *arg)
     memset(&scan_res, 0, sizeof(scan_res));
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return;
@@ -3273,6 +4978,7 @@ static void notify_scan_completed(void *arg)
 
     /* Scan is completed, reset the flag */
     scan_handler.is_scanning = false;
+    wake_security_probe();
 
     if(mac_addr_arr != NULL)
     {
@@ -3285,6 +4991,10 @@ static void notify_scan_completed(void *arg)
     {
        scan_handler.p_scan_calback(NULL, scan_handler.user_data, CY_WCM_SCAN_COMPLETE);
     }
+    if((scan_handler.p_scan_view_callback != NULL) && (invoke_application_callback == true))
+    {
+       scan_handler.p_scan_view_callback(NULL, scan_handler.user_data, CY_WCM_SCAN_COMPLETE);
+    }
 
     if(scan_handler.is_stop_scan_req)
     {
@@ -3296,7 +5006,7 @@ static void notify_scan_completed(void *arg)
         scan_handler.is_stop_scan_req = false;
     }
 
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to release the WCM mutex \n");
         if(scan_res.ie_ptr != NULL)
@@ -3313,10 +5023,9 @@ static void process_scan_data(void *arg)
 {
     whd_scan_result_t *whd_scan_res = (whd_scan_result_t*)arg;
     cy_wcm_scan_result_t wcm_scan_res;
-    whd_mac_t *mac_iter = NULL;
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         free(whd_scan_res);
@@ -3329,35 +5038,19 @@ static void process_scan_data(void *arg)
         goto exit;
     }
 
-    /* Check for duplicate SSID */
-    for (mac_iter = mac_addr_arr; (mac_iter < mac_addr_arr + current_bssid_arr_length); ++mac_iter)
+    /* The completion of the scan has been handled already */
+    if (mac_addr_arr == NULL)
     {
-        if(CMP_MAC(mac_iter->octet, whd_scan_res->BSSID.octet))
-        {
-            /* The scanned result is a duplicate; just return */
-            goto exit;
-        }
+        goto exit;
     }
 
-    /* If scanned Wi-Fi is not a duplicate then populate the array */
-    if(current_bssid_arr_length < SCAN_BSSID_ARR_LENGTH)
+    if (!scan_result_accept(whd_scan_res, mac_addr_arr, &current_bssid_arr_length))
     {
-        memcpy(&mac_iter->octet, whd_scan_res->BSSID.octet, sizeof(whd_mac_t) );
-        current_bssid_arr_length++;
+        goto exit;
     }
 
     memset(&wcm_scan_res, 0, sizeof(wcm_scan_res));
 
-    if(scan_handler.scan_filter.mode == CY_WCM_SCAN_FILTER_TYPE_RSSI)
-    {
-         int16_t requested_range = scan_handler.scan_filter.param.rssi_range;
-         int16_t signal_strength = whd_scan_res->signal_strength;
-         if(signal_strength <= requested_range)
-         {
-             goto exit;
-         }
-    }
-
     /** copy all the parameters to scan_res **/
     memcpy(wcm_scan_res.SSID, whd_scan_res->SSID.value, whd_scan_res->SSID.length);
     memcpy(wcm_scan_res.BSSID, whd_scan_res->BSSID.octet, sizeof(wcm_scan_res.BSSID));
@@ -3393,7 +5086,7 @@ static void process_scan_data(void *arg)
 exit:
     free(whd_scan_res);
 
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to release the WCM mutex \n");
         return;
@@ -3401,92 +5094,343 @@ exit:
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex unlocked %s %d\r\n", __FILE__, __LINE__);
 }
 
-static void invoke_app_callbacks(cy_wcm_event_t event_type, cy_wcm_event_data_t* arg)
+/*
+ * Bookkeeping shared by both scan delivery modes: drops duplicates of a BSSID already reported in this scan
+ * and results that fail the RSSI filter. Called with the scan mutex held and mac_addr_arr, or on the WHD thread
+ * with scan_view_bssid_arr for a view scan.
+ */
+static bool scan_result_accept(const whd_scan_result_t *whd_scan_res, whd_mac_t *bssid_arr, int *bssid_arr_length)
 {
-    int i = 0;
+    whd_mac_t *mac_iter = NULL;
 
-    for ( i = 0; i < CY_WCM_MAXIMUM_CALLBACKS_COUNT; i++ )
+    /* Check for duplicate SSID */
+    for (mac_iter = bssid_arr; (mac_iter < bssid_arr + *bssid_arr_length); ++mac_iter)
     {
-        if ( wcm_event_handler[i] != NULL )
+        if(CMP_MAC(mac_iter->octet, whd_scan_res->BSSID.octet))
         {
-            wcm_event_handler[i](event_type, arg);
+            /* The scanned result is a duplicate */
+            return false;
         }
     }
-}
 
-static void ap_callback_handler(void* arg)
-{
-    cy_wcm_event_data_t link_event_data;
-    wcm_ap_link_event *event_data = (wcm_ap_link_event*)arg;
+    if(scan_handler.scan_filter.mode == CY_WCM_SCAN_FILTER_TYPE_RSSI)
+    {
+         int16_t requested_range = scan_handler.scan_filter.param.rssi_range;
+         int16_t signal_strength = whd_scan_res->signal_strength;
+         if(signal_strength <= requested_range)
+         {
+             return false;
+         }
+    }
 
-    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Notify application about AP events \n");
-    memset(&link_event_data, 0, sizeof(cy_wcm_event_data_t));
-    memcpy(link_event_data.sta_mac, event_data->mac_addr, CY_WCM_MAC_ADDR_LEN);
-    invoke_app_callbacks(event_data->event, &link_event_data);
-    free(arg);
+    if(!scan_request_accept(whd_scan_res))
+    {
+        return false;
+    }
+
+    /*
+     * Only a reported BSSID is recorded. A filtered result may come back from the same AP, for example with
+     * a stronger signal or on another band, and must then still be reported.
+     */
+    if(*bssid_arr_length < SCAN_BSSID_ARR_LENGTH)
+    {
+        memcpy(&mac_iter->octet, whd_scan_res->BSSID.octet, sizeof(whd_mac_t) );
+        (*bssid_arr_length)++;
+    }
+
+    return true;
 }
 
-static void* ap_link_events_handler(whd_interface_t ifp, const whd_event_header_t *event_header, const uint8_t *event_data, void *handler_user_data)
+/* Applies the combined filters of cy_wcm_start_scan_request; the zero request of the other scans accepts every result */
+static bool scan_request_accept(const whd_scan_result_t *whd_scan_res)
 {
-    cy_rslt_t res = CY_RSLT_SUCCESS;
-    UNUSED_PARAMETER(res);
-    wcm_ap_link_event *ap_event_data;
+    const cy_wcm_scan_request_t *request = &scan_handler.scan_request;
+    uint8_t i;
 
-    ap_event_data = (wcm_ap_link_event*)malloc(sizeof(wcm_ap_link_event));
-    if(ap_event_data == NULL)
+    if((request->min_signal_strength != 0) && (whd_scan_res->signal_strength <= request->min_signal_strength))
     {
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "malloc failed %s %d\r\n", __FILE__, __LINE__);
-        return handler_user_data;
+        return false;
     }
-
-    if (event_header->event_type == WLC_E_DISASSOC_IND || event_header->event_type == WLC_E_DEAUTH_IND)
+    /* WLC_SET_BAND restricts the scan already; this also drops results reported from another band */
+    if((request->band != CY_WCM_WIFI_BAND_ANY) && (whd_to_wcm_band(whd_scan_res->band) != request->band))
     {
-#ifdef PROTO_MSGBUF
-        whd_wifi_delete_peer(ifp, (uint8_t *)event_header->addr.octet);
-#endif /* PROTO_MSGBUF */
-        ap_event_data->event = CY_WCM_EVENT_STA_LEFT_SOFTAP;
+        return false;
     }
-    else if (event_header->event_type == WLC_E_ASSOC_IND || event_header->event_type == WLC_E_REASSOC_IND)
+    if(request->ssid_count == 0)
     {
-        /* Set ap_event_data->event only if the security type of AP is CY_WCM_SECURITY_OPEN/CY_WCM_SECURITY_WEP_PSK/CY_WCM_SECURITY_WEP_SHARED.
-         * For all other security types wait for WLC_E_AUTHORIZED event to set ap_event_data->event to CY_WCM_EVENT_STA_JOINED_SOFTAP.
-         */
-        if(ap_security == CY_WCM_SECURITY_OPEN || ap_security == CY_WCM_SECURITY_WEP_PSK || ap_security == CY_WCM_SECURITY_WEP_SHARED)
-        {
-            ap_event_data->event = CY_WCM_EVENT_STA_JOINED_SOFTAP;
-        }
-        else
-        {
-            /* Ignore other security types */
-            free(ap_event_data);
-            return handler_user_data;
-        }
+        return true;
     }
-    else if(event_header->event_type == WLC_E_AUTHORIZED)
+    for(i = 0; i < request->ssid_count; i++)
     {
-        /* If the security type of AP is other than CY_WCM_SECURITY_OPEN, CY_WCM_SECURITY_WEP_PSK, CY_WCM_SECURITY_WEP_SHARED and
-         * WLC_E_AUTHORIZED event is received, then set ap_event_data->event to CY_WCM_EVENT_STA_JOINED_SOFTAP.
-         */
-        if(ap_security != CY_WCM_SECURITY_OPEN && ap_security != CY_WCM_SECURITY_WEP_PSK && ap_security != CY_WCM_SECURITY_WEP_SHARED)
-        {
-            ap_event_data->event = CY_WCM_EVENT_STA_JOINED_SOFTAP;
-        }
-        else
+        if((strnlen((const char *)request->SSID[i], CY_WCM_MAX_SSID_LEN) == whd_scan_res->SSID.length) &&
+           (memcmp(request->SSID[i], whd_scan_res->SSID.value, whd_scan_res->SSID.length) == 0))
         {
-            /* Ignore other security types */
-            free(ap_event_data);
-            return handler_user_data;
+            return true;
         }
     }
-    else
-    {
-        /* Ignore other events */
-        free(ap_event_data);
-        return handler_user_data;
-    }
 
-    memcpy(ap_event_data->mac_addr, event_header->addr.octet, CY_WCM_MAC_ADDR_LEN);
-    if((res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, ap_callback_handler, (void*)ap_event_data)) != CY_RSLT_SUCCESS)
+    return false;
+}
+
+/*
+ * Delivers a result of a view scan straight from the WHD buffer. No lock is taken on the WHD thread:
+ * the scan mutex may be held by a thread waiting for an IOCTL that this thread has to complete.
+ */
+static void deliver_scan_view(const whd_scan_result_t *whd_scan_res)
+{
+    cy_wcm_scan_result_view_t view;
+
+    if (!scan_handler.is_scanning || scan_handler.is_stop_scan_req)
+    {
+        return;
+    }
+
+    if (!scan_result_accept(whd_scan_res, scan_view_bssid_arr, &scan_view_bssid_arr_length))
+    {
+        return;
+    }
+
+    view.result = whd_scan_res;
+    scan_handler.p_scan_view_callback(&view, scan_handler.user_data, CY_WCM_SCAN_INCOMPLETE);
+}
+
+const uint8_t *cy_wcm_scan_view_get_ssid(const cy_wcm_scan_result_view_t *view, uint8_t *length)
+{
+    *length = view->result->SSID.length;
+    return view->result->SSID.value;
+}
+
+const uint8_t *cy_wcm_scan_view_get_bssid(const cy_wcm_scan_result_view_t *view)
+{
+    return view->result->BSSID.octet;
+}
+
+int16_t cy_wcm_scan_view_get_signal_strength(const cy_wcm_scan_result_view_t *view)
+{
+    return view->result->signal_strength;
+}
+
+uint8_t cy_wcm_scan_view_get_channel(const cy_wcm_scan_result_view_t *view)
+{
+    return view->result->channel;
+}
+
+cy_wcm_wifi_band_t cy_wcm_scan_view_get_band(const cy_wcm_scan_result_view_t *view)
+{
+    return whd_to_wcm_band(view->result->band);
+}
+
+cy_wcm_security_t cy_wcm_scan_view_get_security(const cy_wcm_scan_result_view_t *view)
+{
+    return whd_to_wcm_security(view->result->security);
+}
+
+cy_wcm_bss_type_t cy_wcm_scan_view_get_bss_type(const cy_wcm_scan_result_view_t *view)
+{
+    return whd_to_wcm_bss_type(view->result->bss_type);
+}
+
+uint8_t cy_wcm_scan_view_get_flags(const cy_wcm_scan_result_view_t *view, uint8_t ccode[2])
+{
+    if(ccode != NULL)
+    {
+        memcpy(ccode, view->result->ccode, sizeof(view->result->ccode));
+    }
+    return view->result->flags;
+}
+
+const uint8_t *cy_wcm_scan_view_get_ies(const cy_wcm_scan_result_view_t *view, uint32_t *ie_len)
+{
+    *ie_len = view->result->ie_len;
+    return view->result->ie_ptr;
+}
+
+const uint8_t *cy_wcm_scan_view_find_ie(const cy_wcm_scan_result_view_t *view, uint8_t ie_id, uint8_t *length)
+{
+    const uint8_t *ie = view->result->ie_ptr;
+    uint32_t remaining = view->result->ie_len;
+
+    while((ie != NULL) && (remaining >= 2) && ((uint32_t)ie[1] + 2 <= remaining))
+    {
+        if(ie[0] == ie_id)
+        {
+            *length = ie[1];
+            return ie + 2;
+        }
+        remaining -= (uint32_t)ie[1] + 2;
+        ie += (uint32_t)ie[1] + 2;
+    }
+
+    return NULL;
+}
+
+#ifdef ENABLE_WCM_TRACE
+/*
+ * Called from WHD event handlers, timer callbacks and application threads alike, so it takes no RTOS lock:
+ * the slot is claimed with interrupts masked for the increment only, and its sequence is written last, which
+ * lets the decoder drop a record that was overwritten or still being written when the buffer was dumped.
+ */
+void cy_wcm_trace_record(uint32_t event, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    cy_time_t now = 0;
+    uint32_t index;
+    uint32_t primask;
+    cy_wcm_trace_record_t *record;
+
+    cy_rtos_get_time(&now);
+    primask = __get_PRIMASK();
+    __disable_irq();
+    index = cy_wcm_trace_buffer.head++;
+    __set_PRIMASK(primask);
+    record = &cy_wcm_trace_buffer.records[index & (CY_WCM_TRACE_BUFFER_SIZE - 1)];
+
+    record->sequence = 0;
+    WCM_MEMORY_BARRIER();
+    record->timestamp = (uint32_t)now;
+    record->event = event;
+    record->arg[0] = arg0;
+    record->arg[1] = arg1;
+    record->arg[2] = arg2;
+    WCM_MEMORY_BARRIER();
+    record->sequence = index + 1;
+}
+#endif
+
+/*
+ * Must only be called on the WCM worker thread. A list replaced by update_event_registry() is
+ * freed by a job queued on the same thread, so the snapshot taken here stays valid until this
+ * returns, and callbacks may register or deregister callbacks without deadlocking.
+ */
+static void invoke_app_callbacks(cy_wcm_event_t event_type, cy_wcm_event_data_t* arg)
+{
+    const wcm_event_registry_t *registry = wcm_event_registry;
+    const wcm_event_subscriber_t *subscriber;
+    uint32_t event_mask = CY_WCM_EVENT_MASK(event_type);
+    uint32_t i;
+
+#ifdef ENABLE_MULTICORE_CONN_MW
+    /* Refresh the shared state before the application hears about the change */
+    if ( event_mask & (CY_WCM_EVENT_MASK(CY_WCM_EVENT_CONNECTED) | CY_WCM_EVENT_MASK(CY_WCM_EVENT_RECONNECTED) |
+                       CY_WCM_EVENT_MASK(CY_WCM_EVENT_DISCONNECTED) | CY_WCM_EVENT_MASK(CY_WCM_EVENT_IP_CHANGED)) )
+    {
+        publish_shared_state(true);
+    }
+#endif
+
+    if ( registry == NULL )
+    {
+        return;
+    }
+
+    for ( i = 0; i < registry->count; i++ )
+    {
+        subscriber = &registry->subscriber[i];
+        if ( (subscriber->event_mask & event_mask) == 0 )
+        {
+            continue;
+        }
+
+        if ( subscriber->callback_ex != NULL )
+        {
+            subscriber->callback_ex(event_type, arg, subscriber->user_data);
+        }
+        else
+        {
+            subscriber->callback(event_type, arg);
+        }
+    }
+}
+
+static void ap_callback_handler(void* arg)
+{
+    cy_wcm_event_data_t link_event_data;
+    wcm_ap_link_event *event_data = (wcm_ap_link_event*)arg;
+    wcm_ap_client_t *client;
+
+    if(cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) == CY_RSLT_SUCCESS)
+    {
+        /* Events that arrive after the AP was stopped must not refill the table */
+        if(is_soft_ap_up)
+        {
+            if(event_data->event == CY_WCM_EVENT_STA_LEFT_SOFTAP)
+            {
+                if((client = ap_client_table_find(event_data->mac_addr)) != NULL)
+                {
+                    client->in_use = false;
+                }
+            }
+            else
+            {
+                ap_client_table_update(event_data->mac_addr);
+            }
+        }
+        if(cy_rtos_set_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+        }
+    }
+    else
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+    }
+
+    if(event_data->notify)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Notify application about AP events \n");
+        memset(&link_event_data, 0, sizeof(cy_wcm_event_data_t));
+        memcpy(link_event_data.sta_mac, event_data->mac_addr, CY_WCM_MAC_ADDR_LEN);
+        invoke_app_callbacks(event_data->event, &link_event_data);
+    }
+    free(arg);
+}
+
+static void* ap_link_events_handler(whd_interface_t ifp, const whd_event_header_t *event_header, const uint8_t *event_data, void *handler_user_data)
+{
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+    UNUSED_PARAMETER(res);
+    wcm_ap_link_event *ap_event_data;
+
+    ap_event_data = (wcm_ap_link_event*)malloc(sizeof(wcm_ap_link_event));
+    if(ap_event_data == NULL)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "malloc failed %s %d\r\n", __FILE__, __LINE__);
+        return handler_user_data;
+    }
+
+    if (event_header->event_type == WLC_E_DISASSOC_IND || event_header->event_type == WLC_E_DEAUTH_IND)
+    {
+#ifdef PROTO_MSGBUF
+        whd_wifi_delete_peer(ifp, (uint8_t *)event_header->addr.octet);
+#endif /* PROTO_MSGBUF */
+        ap_event_data->event = CY_WCM_EVENT_STA_LEFT_SOFTAP;
+        ap_event_data->notify = true;
+    }
+    else if (event_header->event_type == WLC_E_ASSOC_IND || event_header->event_type == WLC_E_REASSOC_IND)
+    {
+        /* The client table is updated for every security type. The application is notified only if the security type of AP is
+         * CY_WCM_SECURITY_OPEN/CY_WCM_SECURITY_WEP_PSK/CY_WCM_SECURITY_WEP_SHARED.
+         * For all other security types it is notified on the WLC_E_AUTHORIZED event.
+         */
+        ap_event_data->event = CY_WCM_EVENT_STA_JOINED_SOFTAP;
+        ap_event_data->notify = (ap_security == CY_WCM_SECURITY_OPEN || ap_security == CY_WCM_SECURITY_WEP_PSK || ap_security == CY_WCM_SECURITY_WEP_SHARED);
+    }
+    else if(event_header->event_type == WLC_E_AUTHORIZED)
+    {
+        /* If the security type of AP is other than CY_WCM_SECURITY_OPEN, CY_WCM_SECURITY_WEP_PSK, CY_WCM_SECURITY_WEP_SHARED and
+         * WLC_E_AUTHORIZED event is received, then notify the application with CY_WCM_EVENT_STA_JOINED_SOFTAP.
+         */
+        ap_event_data->event = CY_WCM_EVENT_STA_JOINED_SOFTAP;
+        ap_event_data->notify = (ap_security != CY_WCM_SECURITY_OPEN && ap_security != CY_WCM_SECURITY_WEP_PSK && ap_security != CY_WCM_SECURITY_WEP_SHARED);
+    }
+    else
+    {
+        /* Ignore other events */
+        free(ap_event_data);
+        return handler_user_data;
+    }
+
+    memcpy(ap_event_data->mac_addr, event_header->addr.octet, CY_WCM_MAC_ADDR_LEN);
+    if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_BULK, ap_callback_handler, (void*)ap_event_data, false)) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to handle link up event. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
         free(ap_event_data);
@@ -3501,6 +5445,7 @@ static void* link_events_handler(whd_interface_t ifp, const whd_event_header_t *
     UNUSED_PARAMETER(res);
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Link event (type, status, reason, flags) %u %u %u %u\n", (unsigned int)event_header->event_type, (unsigned int)event_header->status,
         (unsigned int)event_header->reason, (unsigned int)event_header->flags);
+    cy_wcm_trace(CY_WCM_TRACE_LINK_EVENT, event_header->event_type, event_header->status, event_header->reason);
     switch (event_header->event_type)
     {
         case WLC_E_LINK:
@@ -3566,7 +5511,10 @@ static void* link_events_handler(whd_interface_t ifp, const whd_event_header_t *
                 if (too_many_ie_error)
                 {
                     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Notify application that WCM will retry to connect to the AP!\n");
-                    invoke_app_callbacks(CY_WCM_EVENT_INITIATED_RETRY, NULL);
+                    if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)CY_WCM_EVENT_INITIATED_RETRY, false)) != CY_RSLT_SUCCESS)
+                    {
+                        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send retry status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+                    }
                     /* Try to join the AP again */
                     handshake_timeout_handler(0);
 
@@ -3578,11 +5526,19 @@ static void* link_events_handler(whd_interface_t ifp, const whd_event_header_t *
                 {
                     link_down(event_header->reason);
                     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Beacon Lost notify application that WCM will retry to connect to the AP!\n");
-                    invoke_app_callbacks(CY_WCM_EVENT_INITIATED_RETRY, NULL);
+                    if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)CY_WCM_EVENT_INITIATED_RETRY, false)) != CY_RSLT_SUCCESS)
+                    {
+                        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send retry status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+                    }
 
                     /* Try to join the AP again */
                     handshake_timeout_handler(0);
                 }
+                else if (roam_handler.is_joining || is_reassoc_triggered)
+                {
+                    /* The old AP is being left for the roam or reassociation target; the joining code handles a failure */
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Link down while roaming or reassociating, reason %u \n", (unsigned int)event_header->reason);
+                }
                 else
                 {
                     /* WPA handshake is aborted because of link down. Stop handshake timer. */
@@ -3638,6 +5594,25 @@ static void* link_events_handler(whd_interface_t ifp, const whd_event_header_t *
                 handshake_timeout_handler(0);
                 break;
             }
+#ifdef COMPONENT_55900
+        case WLC_E_TWT_TEARDOWN:
+            {
+                const wcm_itwt_teardown_event_t *teardown = (const wcm_itwt_teardown_event_t *)event_data;
+                uint32_t flow_id = CY_WCM_TWT_FLOW_ID_ALL;
+
+                cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "recieved WLC_E_TWT_TEARDOWN \n");
+                /* Without a readable payload, all flows are checked against the session the firmware still reports */
+                if((event_data != NULL) && (event_header->datalen >= sizeof(wcm_itwt_teardown_event_t)) && !teardown->all_twt)
+                {
+                    flow_id = teardown->flow_id;
+                }
+                if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, itwt_teardown_event_handler, (void *)flow_id, false)) != CY_RSLT_SUCCESS)
+                {
+                    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to handle iTWT teardown event. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+                }
+                break;
+            }
+#endif
         /* Note - These are listed to keep gcc pedantic checking happy */
         case WLC_E_NONE:
         case WLC_E_ROAM:
@@ -3789,9 +5764,12 @@ static void link_up( void )
 {
     cy_rslt_t res = CY_RSLT_SUCCESS;
     UNUSED_PARAMETER(res);
+    cy_wcm_trace(CY_WCM_TRACE_LINK_UP, wcm_sta_link_up, 0, 0);
+    /* The link of a reassociation is up, a link down from here on is a real one */
+    is_reassoc_triggered = false;
     if(!wcm_sta_link_up)
     {
-        if((res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, sta_link_up_handler, NULL)) != CY_RSLT_SUCCESS)
+        if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, sta_link_up_handler, NULL, true)) != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to handle link up event. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
             return;
@@ -3807,7 +5785,7 @@ static void link_up( void )
         }
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Executing DHCP renewal \n");
         /* This condition will be hit when handshake fails and wcm reconnection is successful through retry timer*/
-        if((res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, sta_link_up_renew_handler, NULL)) != CY_RSLT_SUCCESS)
+        if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, sta_link_up_renew_handler, NULL, true)) != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to handle link up event. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
             return;
@@ -3820,7 +5798,7 @@ static void sta_link_up_handler(void* arg)
     UNUSED_PARAMETER(arg);
     cy_rslt_t res = CY_RSLT_SUCCESS;
 
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Link UP: Unable to acquire WCM mutex \n");
         return;
@@ -3830,7 +5808,7 @@ static void sta_link_up_handler(void* arg)
     {
         is_sta_network_up = true;
     }
-    if(cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Link UP: Unable to Release WCM mutex \n");
     }
@@ -3838,6 +5816,7 @@ static void sta_link_up_handler(void* arg)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Notify application that network is connected again!\n");
         invoke_app_callbacks(CY_WCM_EVENT_RECONNECTED, NULL);
+        itwt_restore_handler(NULL);
     }
     else
     {
@@ -3865,9 +5844,10 @@ static void link_down(uint32_t reason)
 {
     cy_rslt_t res = CY_RSLT_SUCCESS;
     UNUSED_PARAMETER(res);
+    cy_wcm_trace(CY_WCM_TRACE_LINK_DOWN, reason, wcm_sta_link_up, 0);
     if (wcm_sta_link_up)
     {
-        if((res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, sta_link_down_handler, (void *)reason)) != CY_RSLT_SUCCESS)
+        if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, sta_link_down_handler, (void *)reason, true)) != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to handle link down event. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
         }
@@ -3880,7 +5860,7 @@ static void sta_link_down_handler(void* arg)
     cy_rslt_t res = CY_RSLT_SUCCESS;
     cy_wcm_event_data_t event_data;
 
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Link Down: Unable to acquire WCM mutex \n");
         return;
@@ -3890,7 +5870,8 @@ static void sta_link_down_handler(void* arg)
     {
         is_sta_network_up = false;
     }
-    if(cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    itwt_link_lost();
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Link Down: Unable to Release WCM mutex \n");
     }
@@ -3907,7 +5888,7 @@ static void hanshake_retry_timer(cy_timer_callback_arg_t arg)
     UNUSED_PARAMETER(arg);
 #if defined(COMPONENT_55900) || defined(COMPONENT_PSE84)
     cy_rslt_t result;
-    result = cy_worker_thread_enqueue(&cy_wcm_worker_thread, handshake_error_callback, NULL);
+    result = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, handshake_error_callback, NULL, true);
     if (result != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : Failed to send async event to n/w worker thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, result);
@@ -3922,12 +5903,13 @@ static void handshake_timeout_handler(cy_timer_callback_arg_t arg)
     cy_rslt_t result;
 
     UNUSED_PARAMETER( arg );
+    cy_wcm_trace(CY_WCM_TRACE_HANDSHAKE_TIMEOUT, 0, 0, 0);
 
     cy_rtos_stop_timer(&sta_handshake_timer);
     cy_rtos_stop_timer(&sta_retry_timer);
     retry_backoff_timeout = DEFAULT_RETRY_BACKOFF_TIMEOUT_IN_MS;
 
-    result = cy_worker_thread_enqueue(&cy_wcm_worker_thread, handshake_error_callback, NULL);
+    result = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, handshake_error_callback, NULL, true);
     if (result != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : Failed to send async event to n/w worker thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, result);
@@ -3961,7 +5943,7 @@ static void handshake_error_callback(void *arg)
     cy_rtos_stop_timer(&sta_retry_timer);
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return;
@@ -3979,7 +5961,7 @@ static void handshake_error_callback(void *arg)
 
     /* Explicitly leave AP and then rejoin */
     whd_wifi_leave(whd_ifs[CY_WCM_INTERFACE_TYPE_STA]);
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Mutex release error \n");
         return;
@@ -3992,7 +5974,7 @@ static void handshake_error_callback(void *arg)
     {
         cy_rslt_t join_result;
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-        if(cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+        if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
             return;
@@ -4024,7 +6006,7 @@ static void handshake_error_callback(void *arg)
 
         /* Notify the application that WCM is trying to reconnect to AP. */
         connection_status = CY_WCM_EVENT_CONNECTING;
-        res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status);
+        res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false);
         if(res != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to send connection status. Err = [%lu]\r\n", res);
@@ -4069,6 +6051,7 @@ static void handshake_error_callback(void *arg)
             /** Join to Wi-Fi AP **/
             join_result = whd_wifi_join(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &connected_ap_details.SSID, connected_ap_details.security, connected_ap_details.key, connected_ap_details.keylen);
         }
+        cy_wcm_trace(CY_WCM_TRACE_RETRY_JOIN, join_result, connected_ap_details.security, 0);
 
         if(join_result == CY_RSLT_SUCCESS)
         {
@@ -4087,14 +6070,14 @@ static void handshake_error_callback(void *arg)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "whd_wifi_join failed : %ld \n", join_result);
             connection_status = CY_WCM_EVENT_CONNECT_FAILED;
-            res = cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_connection_status, (void *)connection_status);
+            res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)connection_status, false);
             if(res != CY_RSLT_SUCCESS)
             {
                 cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to send connection status. Err = [%lu]\r\n", res);
             }
         }
 
-        if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+        if (cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
         {
             cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Mutex release error \n");
             return;
@@ -4111,6 +6094,7 @@ static void handshake_error_callback(void *arg)
     /* Register retry with network worker thread */
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "L%d : %s() : Retrying to join with back-off [%ld milliseconds]\r\n", __LINE__, __FUNCTION__, retry_backoff_timeout);
     res = cy_rtos_start_timer(&sta_retry_timer, retry_backoff_timeout);
+    cy_wcm_trace(CY_WCM_TRACE_RETRY_SCHEDULED, retry_backoff_timeout, res, 0);
     if (res != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "L%d : %s() : ERROR : Failed in join retry with back-off. Err = [%ld]\r\n", __LINE__, __FUNCTION__, res);
@@ -4120,7 +6104,7 @@ static void handshake_error_callback(void *arg)
     return;
 
 exit:
-    if (cy_rtos_set_mutex(&wcm_mutex) != CY_RSLT_SUCCESS)
+    if (cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Mutex release error \n");
         return;
@@ -4140,7 +6124,7 @@ static void lwip_ip_change_callback(cy_network_interface_context *iface_context,
     {
         return;
     }
-    result = cy_worker_thread_enqueue(&cy_wcm_worker_thread, notify_ip_change, NULL);
+    result = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_ip_change, NULL, true);
     if (result != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : Failed to send async event to n/w worker thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, result);
@@ -4205,6 +6189,42 @@ void notify_ip_change(void *arg)
 }
 
 
+/* Restricts the next scan to band; CY_WCM_WIFI_BAND_ANY keeps the band set to AUTO by start_scan */
+static cy_rslt_t set_scan_band(cy_wcm_wifi_band_t band)
+{
+    uint32_t wlc_band;
+
+    if(band == CY_WCM_WIFI_BAND_ANY)
+    {
+        return CY_RSLT_SUCCESS;
+    }
+    /* check if the platform supports the requested band */
+    if(!check_if_platform_supports_band(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], band))
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "band not supported \n");
+        return CY_RSLT_WCM_BAND_NOT_SUPPORTED;
+    }
+    if(band == CY_WCM_WIFI_BAND_5GHZ)
+    {
+        wlc_band = WLC_BAND_5G;
+    }
+    else if(band == CY_WCM_WIFI_BAND_2_4GHZ)
+    {
+        wlc_band = WLC_BAND_2G;
+    }
+    else if(band == CY_WCM_WIFI_BAND_6GHZ)
+    {
+        wlc_band = WLC_BAND_6G;
+    }
+    else
+    {
+        wlc_band = WLC_BAND_AUTO;
+    }
+    whd_wifi_set_ioctl_value(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WLC_SET_BAND, wlc_band);
+
+    return CY_RSLT_SUCCESS;
+}
+
 static bool check_if_platform_supports_band(whd_interface_t interface, cy_wcm_wifi_band_t requested_band)
 {
     whd_band_list_t band_list;
@@ -4315,7 +6335,7 @@ static void network_down(whd_interface_t interface, cy_network_hw_interface_type
     }
 }
 
-static whd_security_t wcm_to_whd_security(cy_wcm_security_t sec)
+whd_security_t wcm_to_whd_security(cy_wcm_security_t sec)
 {
     switch(sec)
     {
@@ -4382,39 +6402,863 @@ static whd_security_t wcm_to_whd_security(cy_wcm_security_t sec)
         case CY_WCM_SECURITY_WPA2_TKIP_ENT:
             return WHD_SECURITY_WPA2_TKIP_ENT;
 
-        case CY_WCM_SECURITY_WPA2_AES_ENT:
-            return WHD_SECURITY_WPA2_AES_ENT;
+        case CY_WCM_SECURITY_WPA2_AES_ENT:
+            return WHD_SECURITY_WPA2_AES_ENT;
+
+#if defined(COMPONENT_55900) || defined(COMPONENT_PSE84)
+        case CY_WCM_SECURITY_WPA3_ENT:
+            return WHD_SECURITY_WPA3_ENT;
+
+        case CY_WCM_SECURITY_WPA3_ENT_AES_CCMP:
+            return WHD_SECURITY_WPA3_ENT_AES_CCMP;
+
+        case CY_WCM_SECURITY_WPA3_192BIT_ENT:
+            return WHD_SECURITY_WPA3_192BIT_ENT;
+#endif
+
+        case CY_WCM_SECURITY_WPA2_MIXED_ENT:
+            return WHD_SECURITY_WPA2_MIXED_ENT;
+
+        case CY_WCM_SECURITY_WPA2_FBT_ENT:
+            return WHD_SECURITY_WPA2_FBT_ENT;
+
+        case CY_WCM_SECURITY_IBSS_OPEN:
+            return WHD_SECURITY_IBSS_OPEN;
+
+        case CY_WCM_SECURITY_WPS_SECURE:
+            return WHD_SECURITY_WPS_SECURE;
+
+#ifdef COMPONENT_WIFI6
+        case CY_WCM_SECURITY_OWE:
+            return WHD_SECURITY_WPA3_OWE;
+#endif
+
+        default:
+            return WHD_SECURITY_UNKNOWN;
+    }
+}
+
+cy_rslt_t cy_wcm_start_roaming(const cy_wcm_roam_config_t *config)
+{
+    cy_worker_thread_params_t params;
+    cy_rslt_t res = CY_RSLT_SUCCESS;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if((config == NULL) || (config->sample_interval_ms == 0) || (config->smoothing_shift > WCM_ROAM_MAX_SMOOTHING_SHIFT))
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Bad argument \r\n");
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if(current_interface == CY_WCM_INTERFACE_TYPE_AP)
+    {
+        return CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
+    }
+
+    cy_rtos_stop_timer(&sta_roam_timer);
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+
+    /* The roam join blocks for the length of a join, so it runs on its own thread rather than on the WCM worker.
+     * The thread is only created when roaming is first started. */
+    if(!is_roam_thread_created)
+    {
+        memset(&params, 0, sizeof(params));
+        params.name = "WCM- Roam";
+        params.priority = WCM_WORKER_THREAD_PRIORITY;
+        params.stack = NULL;
+        params.stack_size = WCM_ROAM_THREAD_STACK_SIZE;
+        params.num_entries = 0;
+        if((res = cy_worker_thread_create(&roam_worker_thread, &params)) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to create the roam thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+            cy_rtos_set_mutex(&wcm_sta_mutex);
+            return res;
+        }
+        is_roam_thread_created = true;
+    }
+
+    roam_handler.config = *config;
+    roam_handler.has_samples = false;
+    roam_handler.has_scanned = false;
+    roam_handler.is_enabled = true;
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+
+    if((res = cy_rtos_start_timer(&sta_roam_timer, config->sample_interval_ms)) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to start the roam timer. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+        roam_handler.is_enabled = false;
+    }
+    return res;
+}
+
+cy_rslt_t cy_wcm_stop_roaming(void)
+{
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if(current_interface == CY_WCM_INTERFACE_TYPE_AP)
+    {
+        return CY_RSLT_WCM_INTERFACE_NOT_SUPPORTED;
+    }
+
+    cy_rtos_stop_timer(&sta_roam_timer);
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+    roam_handler.is_enabled = false;
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    return CY_RSLT_SUCCESS;
+}
+
+static void roam_timer_handler(cy_timer_callback_arg_t arg)
+{
+    cy_rslt_t result;
+
+    UNUSED_PARAMETER(arg);
+
+    /* Reading the RSSI needs an IOCTL, so the sample is taken on the worker thread. Samples that pile up behind other work are merged. */
+    result = wcm_worker_enqueue(CY_WCM_WORKER_LANE_BULK, roam_sample_handler, NULL, true);
+    if (result != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "L%d : %s() : Failed to send async event to n/w worker thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, result);
+    }
+}
+
+static void roam_add_channel(uint16_t channel)
+{
+    uint8_t i;
+
+    if(channel == 0)
+    {
+        return;
+    }
+    for(i = 0; i < roam_handler.channel_count; i++)
+    {
+        if(roam_handler.channels[i] == channel)
+        {
+            return;
+        }
+    }
+    if(roam_handler.channel_count < WCM_ROAM_MAX_CHANNELS)
+    {
+        roam_handler.channels[roam_handler.channel_count++] = channel;
+        roam_handler.channels[roam_handler.channel_count] = 0;
+    }
+}
+
+/* Called from roam_scan_callback() on the WHD thread; when the table is full the weakest AP makes room */
+static void roam_record_result(const whd_scan_result_t *result)
+{
+    wcm_roam_result_t *slot = NULL;
+    uint8_t i;
+
+    if(roam_handler.result_count < WCM_ROAM_MAX_RESULTS)
+    {
+        slot = &roam_handler.results[roam_handler.result_count++];
+    }
+    else
+    {
+        for(i = 0; i < WCM_ROAM_MAX_RESULTS; i++)
+        {
+            if((slot == NULL) || (roam_handler.results[i].signal_strength < slot->signal_strength))
+            {
+                slot = &roam_handler.results[i];
+            }
+        }
+        if(result->signal_strength <= slot->signal_strength)
+        {
+            return;
+        }
+    }
+
+    memcpy(slot->BSSID.octet, result->BSSID.octet, CY_WCM_MAC_ADDR_LEN);
+    slot->signal_strength = result->signal_strength;
+    slot->channel = result->channel;
+    slot->band = result->band;
+}
+
+/*
+ * Aborts the roam scan in progress, if any, and waits for WHD to report the abort so that it does not end the
+ * scan started next. Must be called without the scan mutex held. A new roam scan is not started before
+ * min_roam_interval_ms has elapsed, so the scan of the caller gets the radio.
+ */
+static void abort_roam_scan(void)
+{
+    bool wait_on_sema = false;
+
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+    if(roam_handler.is_scanning && !roam_handler.is_stop_scan_req)
+    {
+        if(whd_wifi_stop_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA]) == CY_RSLT_SUCCESS)
+        {
+            roam_handler.is_stop_scan_req = true;
+            wait_on_sema = true;
+        }
+    }
+    if(cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+
+    if(wait_on_sema)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Aborting the roam scan \n");
+        if(cy_rtos_get_semaphore(&stop_scan_semaphore, WCM_ROAM_SCAN_ABORT_TIMEOUT_MS, false) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Roam scan abort timed out \n");
+            if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) == CY_RSLT_SUCCESS)
+            {
+                if(roam_handler.is_stop_scan_req)
+                {
+                    /* WHD did not report the abort */
+                    roam_handler.is_stop_scan_req = false;
+                    roam_handler.is_scanning = false;
+                }
+                cy_rtos_set_mutex(&wcm_scan_mutex);
+            }
+        }
+    }
+}
+
+/*
+ * Updates the smoothed RSSI and decides whether to look for a better AP. The decision is taken under the
+ * STA lock; the scan is started after it is released so that the scan lock is never taken after the STA lock.
+ */
+static void roam_sample_handler(void *arg)
+{
+    int32_t rssi;
+    cy_time_t now;
+    wl_bss_info_t bss_info;
+    whd_security_t security;
+    uint32_t fwcap = 0;
+    bool start_scan = false;
+
+    UNUSED_PARAMETER(arg);
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+
+    if(!wcm_sta_link_up)
+    {
+        roam_handler.has_samples = false;
+        goto exit;
+    }
+
+    if(!roam_handler.is_enabled || is_disconnect_triggered || roam_handler.is_scanning || roam_handler.is_joining)
+    {
+        goto exit;
+    }
+
+    if(whd_wifi_get_rssi(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &rssi) != CY_RSLT_SUCCESS)
+    {
+        goto exit;
+    }
+
+    if(!roam_handler.has_samples)
+    {
+        roam_handler.smoothed_rssi = rssi * WCM_ROAM_RSSI_SCALE;
+        roam_handler.has_samples = true;
+    }
+    else
+    {
+        roam_handler.smoothed_rssi += (rssi * WCM_ROAM_RSSI_SCALE - roam_handler.smoothed_rssi) / (1 << roam_handler.config.smoothing_shift);
+    }
+
+    if(roam_handler.smoothed_rssi > (roam_handler.config.trigger_rssi * WCM_ROAM_RSSI_SCALE))
+    {
+        goto exit;
+    }
+
+    cy_rtos_get_time(&now);
+    if(roam_handler.has_scanned && ((uint32_t)(now - roam_handler.last_scan_time) < roam_handler.config.min_roam_interval_ms))
+    {
+        goto exit;
+    }
+
+    /* WCM can only join another AP on its own if the application did not pin the BSSID and the firmware runs the handshake */
+    if(!NULL_MAC(connected_ap_details.sta_mac.octet) ||
+       check_if_ent_auth_types(whd_to_wcm_security(connected_ap_details.security)))
+    {
+        goto exit;
+    }
+    whd_wifi_get_fwcap(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &fwcap);
+    if((fwcap & (1 << WHD_FWCAP_SAE_EXT)) &&
+       ((connected_ap_details.security == WHD_SECURITY_WPA3_SAE) || (connected_ap_details.security == WHD_SECURITY_WPA3_WPA2_PSK)))
+    {
+        goto exit;
+    }
+
+    if(whd_wifi_get_ap_info(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &bss_info, &security) != CY_RSLT_SUCCESS)
+    {
+        goto exit;
+    }
+
+    if((roam_handler.SSID.length != connected_ap_details.SSID.length) ||
+       (memcmp(roam_handler.SSID.value, connected_ap_details.SSID.value, connected_ap_details.SSID.length) != 0))
+    {
+        /* Connected to a different network, the known channels no longer apply */
+        memcpy(&roam_handler.SSID, &connected_ap_details.SSID, sizeof(roam_handler.SSID));
+        memset(roam_handler.channels, 0, sizeof(roam_handler.channels));
+        roam_handler.channel_count = 0;
+        roam_handler.scan_count = 0;
+    }
+    roam_add_channel(bss_info.ctl_ch);
+    memcpy(roam_handler.current_bssid.octet, bss_info.BSSID.octet, CY_WCM_MAC_ADDR_LEN);
+
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Smoothed RSSI %ld dBm, looking for a better AP \n", (long)(roam_handler.smoothed_rssi / WCM_ROAM_RSSI_SCALE));
+    roam_handler.last_scan_time = now;
+    roam_handler.has_scanned = true;
+    start_scan = true;
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+    if(start_scan)
+    {
+        roam_start_scan();
+    }
+}
+
+static void roam_start_scan(void)
+{
+    cy_rslt_t res;
+    const uint16_t *channel_list = NULL;
+
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+
+    /* A scan of the application or of cy_wcm_connect_ap has priority; the next sample after the rate limit tries again */
+    if(scan_handler.is_scanning)
+    {
+        goto exit;
+    }
+
+    if((roam_handler.channel_count > 0) && ((roam_handler.scan_count % WCM_ROAM_FULL_SCAN_INTERVAL) != 0))
+    {
+        channel_list = roam_handler.channels;
+    }
+    roam_handler.scan_count++;
+
+    roam_handler.result_count = 0;
+    roam_handler.is_scanning = true;
+    res = whd_wifi_scan(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WHD_SCAN_TYPE_ACTIVE, WHD_BSS_TYPE_INFRASTRUCTURE,
+                        &roam_handler.SSID, NULL, channel_list, NULL, roam_scan_callback, &roam_scan_result, NULL);
+    if(res != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_scan error. Result = %d \n", res);
+        roam_handler.is_scanning = false;
+    }
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+}
+
+static void roam_scan_callback(whd_scan_result_t **result_ptr, void *user_data, whd_scan_status_t status)
+{
+    whd_scan_result_t *result;
+    cy_rslt_t res;
+
+    UNUSED_PARAMETER(user_data);
+
+    if(status == WHD_SCAN_INCOMPLETE)
+    {
+        result = *result_ptr;
+        /*
+         * Only record the AP here. The known channels and the roam target belong to the STA lock, they are
+         * updated by roam_join_handler() on the roam thread once the scan has completed.
+         */
+        if(roam_handler.is_scanning && !roam_handler.is_stop_scan_req &&
+           (result->SSID.length == roam_handler.SSID.length) &&
+           (memcmp(result->SSID.value, roam_handler.SSID.value, roam_handler.SSID.length) == 0))
+        {
+            roam_record_result(result);
+        }
+        return;
+    }
+
+    if(cy_rtos_get_mutex(&wcm_scan_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+    roam_handler.is_scanning = false;
+    if(roam_handler.is_stop_scan_req)
+    {
+        roam_handler.is_stop_scan_req = false;
+        if(cy_rtos_set_semaphore(&stop_scan_semaphore, false) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "unable to set stop_scan_semaphore \n");
+        }
+    }
+    wake_security_probe();
+    if(cy_rtos_set_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+
+    if((status == WHD_SCAN_COMPLETED_SUCCESSFULLY) && (roam_handler.result_count > 0))
+    {
+        if((res = cy_worker_thread_enqueue(&roam_worker_thread, roam_join_handler, NULL)) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : Failed to send async event to the roam thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+        }
+    }
+}
+
+/*
+ * Picks the roam target from the results of the last roam scan and joins it. Runs on the roam thread and joins
+ * without the STA lock, so that neither the WCM worker nor the API calls are held up for the length of a join;
+ * meanwhile is_joining keeps cy_wcm_connect_ap and the scans out, and a cy_wcm_disconnect_ap is acted on once
+ * the join returns.
+ */
+static void roam_join_handler(void *arg)
+{
+    cy_rslt_t res;
+    whd_scan_result_t ap;
+    int32_t current_rssi;
+    const wcm_roam_result_t *candidate = NULL;
+    uint8_t key[CY_WCM_MAX_PASSPHRASE_LEN];
+    uint8_t keylen;
+    uint8_t i;
+
+    UNUSED_PARAMETER(arg);
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+
+    /* No samples means the link changed after the scan was started, the results are stale */
+    if(!roam_handler.is_enabled || !wcm_sta_link_up || is_disconnect_triggered || !roam_handler.has_samples)
+    {
+        goto exit;
+    }
+
+    for(i = 0; i < roam_handler.result_count; i++)
+    {
+        roam_add_channel(roam_handler.results[i].channel);
+        if(!CMP_MAC(roam_handler.results[i].BSSID.octet, roam_handler.current_bssid.octet) &&
+           ((candidate == NULL) || (roam_handler.results[i].signal_strength > candidate->signal_strength)))
+        {
+            candidate = &roam_handler.results[i];
+        }
+    }
+    if(candidate == NULL)
+    {
+        goto exit;
+    }
+
+    current_rssi = roam_handler.smoothed_rssi / WCM_ROAM_RSSI_SCALE;
+    if(candidate->signal_strength < (current_rssi + roam_handler.config.rssi_delta))
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "Best AP found has RSSI %d dBm, current AP %ld dBm, not roaming \n",
+            candidate->signal_strength, (long)current_rssi);
+        goto exit;
+    }
+
+    memset(&ap, 0, sizeof(ap));
+    ap.security = connected_ap_details.security;
+    ap.SSID.length = connected_ap_details.SSID.length;
+    memcpy(ap.SSID.value, connected_ap_details.SSID.value, ap.SSID.length);
+    memcpy(ap.BSSID.octet, candidate->BSSID.octet, CY_WCM_MAC_ADDR_LEN);
+    ap.channel = candidate->channel;
+    ap.band = candidate->band;
+    keylen = connected_ap_details.keylen;
+    memcpy(key, connected_ap_details.key, keylen);
+
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "Roaming to %02X:%02X:%02X:%02X:%02X:%02X on channel %u, RSSI %d dBm \n",
+        ap.BSSID.octet[0], ap.BSSID.octet[1], ap.BSSID.octet[2], ap.BSSID.octet[3], ap.BSSID.octet[4], ap.BSSID.octet[5],
+        ap.channel, candidate->signal_strength);
+
+    roam_handler.is_joining = true;
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+
+    whd_wifi_set_ioctl_value(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], WLC_SET_BAND, WLC_BAND_AUTO);
+    res = whd_wifi_join_specific(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &ap, key, keylen);
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        roam_handler.is_joining = false;
+        return;
+    }
+    roam_handler.is_joining = false;
+    /* The trend of the old AP says nothing about the new one */
+    roam_handler.has_samples = false;
+
+    if(is_disconnect_triggered)
+    {
+        /* cy_wcm_disconnect_ap was called during the join and has already reported the link down */
+        if(res == CY_RSLT_SUCCESS)
+        {
+            whd_wifi_leave(whd_ifs[CY_WCM_INTERFACE_TYPE_STA]);
+        }
+        goto exit;
+    }
+
+    if(res == CY_RSLT_SUCCESS)
+    {
+        link_up();
+        /* The agreements were with the old AP */
+        itwt_link_lost();
+        if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, itwt_restore_handler, NULL, true)) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to queue the iTWT restore. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+        }
+    }
+    else
+    {
+        /* The firmware has left the old AP. Report the link down and let the retry logic join any AP of the network. */
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Roaming failed : %ld, notify application that WCM will retry to connect to the AP!\n", res);
+        link_down(WLC_E_LINK_DISASSOC);
+        if((res = wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, notify_connection_status, (void *)CY_WCM_EVENT_INITIATED_RETRY, false)) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to send retry status. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+        }
+        handshake_timeout_handler(0);
+    }
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+}
+
+/* Runs a job on the WCM worker thread */
+cy_rslt_t cy_wcm_enqueue_worker_job(cy_worker_thread_func_t *work_func, void *arg)
+{
+    return wcm_worker_enqueue(CY_WCM_WORKER_LANE_CONTROL, work_func, arg, false);
+}
+
+#ifdef COMPONENT_WPS
+/* Takes a reference on the thread that runs the WPS event loops started with cy_wps_start_on_worker(), creating it if this
+ * is the first user. A WPS step can block for seconds (WPS scan, Diffie-Hellman key calculation, join), so the steps do not
+ * run on the WCM worker where they would hold up link, IP change and retry handling. The thread is deleted again by
+ * cy_wcm_release_wps_worker() when the last enrollment or registrar using it has finished.
+ * Called with wcm_wps_mutex held. */
+cy_rslt_t cy_wcm_create_wps_worker(void)
+{
+    cy_worker_thread_params_t params;
+    cy_rslt_t res;
+
+    if(is_wps_thread_deleting)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : The WPS thread of the previous session is still being deleted\r\n", __LINE__, __FUNCTION__);
+        return CY_RSLT_WCM_WPS_IN_PROGRESS;
+    }
+
+    if(wps_worker_users != 0)
+    {
+        wps_worker_users++;
+        return CY_RSLT_SUCCESS;
+    }
+
+    memset(&params, 0, sizeof(params));
+    params.name = "WCM- WPS";
+    params.priority = WCM_WORKER_THREAD_PRIORITY;
+    params.stack = NULL;
+    params.stack_size = WCM_WPS_THREAD_STACK_SIZE;
+    params.num_entries = 0;
+    if((res = cy_worker_thread_create(&wps_worker_thread, &params)) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "L%d : %s() : ERROR : Failed to create the WPS thread. Err = [%lu]\r\n", __LINE__, __FUNCTION__, res);
+        return res;
+    }
+    wps_worker_users = 1;
+
+    return CY_RSLT_SUCCESS;
+}
+
+/* Drops a reference taken with cy_wcm_create_wps_worker() and deletes the WPS thread when it was the last one.
+ * Deleting the thread waits for its queued jobs, which can call back into the application, so this must be called
+ * without wcm_wps_mutex held and not from the WPS thread. */
+void cy_wcm_release_wps_worker(void)
+{
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    if((wps_worker_users == 0) || (--wps_worker_users != 0))
+    {
+        cy_rtos_set_mutex(&wcm_wps_mutex);
+        return;
+    }
+    is_wps_thread_deleting = true;
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+
+    cy_worker_thread_delete(&wps_worker_thread);
+
+    cy_rtos_get_mutex(&wcm_wps_mutex, CY_RTOS_NEVER_TIMEOUT);
+    is_wps_thread_deleting = false;
+    cy_rtos_set_mutex(&wcm_wps_mutex);
+}
+
+/* Runs a step of a WPS event loop on the WPS thread created by cy_wcm_create_wps_worker() */
+cy_rslt_t cy_wcm_enqueue_wps_job(cy_worker_thread_func_t *work_func, void *arg)
+{
+    return cy_worker_thread_enqueue(&wps_worker_thread, work_func, arg);
+}
+#endif
+
+static cy_rslt_t init_wcm_locks(void)
+{
+    if(cy_rtos_init_mutex(&wcm_scan_mutex) != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    if(cy_rtos_init_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&wcm_scan_mutex);
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    if(cy_rtos_init_mutex(&wcm_ap_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&wcm_sta_mutex);
+        cy_rtos_deinit_mutex(&wcm_scan_mutex);
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    if(cy_rtos_init_mutex(&wcm_config_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&wcm_ap_mutex);
+        cy_rtos_deinit_mutex(&wcm_sta_mutex);
+        cy_rtos_deinit_mutex(&wcm_scan_mutex);
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+#ifdef COMPONENT_WPS
+    if(cy_rtos_init_mutex(&wcm_wps_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_rtos_deinit_mutex(&wcm_config_mutex);
+        cy_rtos_deinit_mutex(&wcm_ap_mutex);
+        cy_rtos_deinit_mutex(&wcm_sta_mutex);
+        cy_rtos_deinit_mutex(&wcm_scan_mutex);
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+#endif
+    return CY_RSLT_SUCCESS;
+}
+
+static void deinit_wcm_locks(void)
+{
+    cy_mutex_t *locks[] = {
+#ifdef COMPONENT_WPS
+                            &wcm_wps_mutex,
+#endif
+                            &wcm_config_mutex, &wcm_ap_mutex, &wcm_sta_mutex, &wcm_scan_mutex };
+    uint8_t i;
+
+    for(i = 0; i < sizeof(locks) / sizeof(locks[0]); i++)
+    {
+        if(cy_rtos_deinit_mutex(locks[i]) != CY_RSLT_SUCCESS)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Error while de initializing mutex \n");
+        }
+    }
+}
+
+static void reset_worker_lanes(void)
+{
+    uint8_t lane;
+
+    for(lane = 0; lane < CY_WCM_WORKER_LANE_MAX; lane++)
+    {
+        worker_lanes[lane].head = 0;
+        worker_lanes[lane].count = 0;
+        memset(&worker_lanes[lane].stats, 0, sizeof(worker_lanes[lane].stats));
+    }
+    is_worker_dispatch_queued = false;
+}
+
+/* Removes every work item waiting in the lanes and copies it to jobs, which must hold both lanes. Returns the number of items. */
+static uint16_t take_worker_jobs(wcm_worker_job_t *jobs)
+{
+    wcm_worker_lane_t *worker_lane;
+    uint16_t count = 0;
+    uint8_t lane;
+
+    if(cy_rtos_get_mutex(&worker_lane_mutex, CY_RTOS_NEVER_TIMEOUT) != CY_RSLT_SUCCESS)
+    {
+        return 0;
+    }
+    for(lane = 0; lane < CY_WCM_WORKER_LANE_MAX; lane++)
+    {
+        worker_lane = &worker_lanes[lane];
+        while(worker_lane->count > 0)
+        {
+            jobs[count++] = worker_lane->jobs[worker_lane->head];
+            worker_lane->head = (worker_lane->head + 1) % worker_lane->size;
+            worker_lane->count--;
+        }
+    }
+    cy_rtos_set_mutex(&worker_lane_mutex);
+    return count;
+}
+
+/* Frees the arguments that work items which will never run were given ownership of */
+static void free_worker_jobs(const wcm_worker_job_t *jobs, uint16_t count)
+{
+    uint16_t i;
+
+    for(i = 0; i < count; i++)
+    {
+        /*
+         * Scan results and AP events are copied to the heap by the WHD callbacks and freed by their handler.
+         * Replaced event registries wait for free_event_registry(); freeing them here is safe as no dispatch
+         * can read them once the worker is gone.
+         */
+        if((jobs[i].work_func == process_scan_data) || (jobs[i].work_func == ap_callback_handler) ||
+           (jobs[i].work_func == free_event_registry))
+        {
+            free(jobs[i].arg);
+        }
+    }
+}
+
+/*
+ * Queues a work item in a lane of the WCM worker thread.
+ * The worker thread itself only ever holds a single wcm_worker_dispatch() item, which drains the lanes.
+ * If coalesce is true and the most recently queued item of the lane runs the same function, that item
+ * takes the new argument instead of a second item being queued. Only the tail is checked so that the
+ * order of different items in a lane is never changed; for example, a link-down queued after a link-up
+ * is never merged into an older link-down.
+ */
+static cy_rslt_t wcm_worker_enqueue(cy_wcm_worker_lane_t lane, cy_worker_thread_func_t *work_func, void *arg, bool coalesce)
+{
+    cy_rslt_t result = CY_RSLT_SUCCESS;
+    wcm_worker_lane_t *worker_lane = &worker_lanes[lane];
+    wcm_worker_job_t *job;
+
+    if(cy_rtos_get_mutex(&worker_lane_mutex, CY_RTOS_NEVER_TIMEOUT) != CY_RSLT_SUCCESS)
+    {
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+
+    if(coalesce && (worker_lane->count > 0))
+    {
+        job = &worker_lane->jobs[(worker_lane->head + worker_lane->count - 1) % worker_lane->size];
+        if(job->work_func == work_func)
+        {
+            job->arg = arg;
+            worker_lane->stats.coalesced++;
+            goto exit;
+        }
+    }
 
-#if defined(COMPONENT_55900) || defined(COMPONENT_PSE84)
-        case CY_WCM_SECURITY_WPA3_ENT:
-            return WHD_SECURITY_WPA3_ENT;
+    if(worker_lane->count == worker_lane->size)
+    {
+        worker_lane->stats.dropped++;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Worker lane %d is full \n", (int)lane);
+        result = CY_RSLT_WCM_OUT_OF_MEMORY;
+        goto exit;
+    }
 
-        case CY_WCM_SECURITY_WPA3_ENT_AES_CCMP:
-            return WHD_SECURITY_WPA3_ENT_AES_CCMP;
+    if(!is_worker_dispatch_queued)
+    {
+        if((result = cy_worker_thread_enqueue(&cy_wcm_worker_thread, wcm_worker_dispatch, NULL)) != CY_RSLT_SUCCESS)
+        {
+            worker_lane->stats.dropped++;
+            goto exit;
+        }
+        is_worker_dispatch_queued = true;
+    }
 
-        case CY_WCM_SECURITY_WPA3_192BIT_ENT:
-            return WHD_SECURITY_WPA3_192BIT_ENT;
-#endif
+    job = &worker_lane->jobs[(worker_lane->head + worker_lane->count) % worker_lane->size];
+    job->work_func = work_func;
+    job->arg = arg;
+    cy_rtos_get_time(&job->queued_time);
+    worker_lane->count++;
+    worker_lane->stats.enqueued++;
+    if(worker_lane->count > worker_lane->stats.high_water_mark)
+    {
+        worker_lane->stats.high_water_mark = worker_lane->count;
+    }
 
-        case CY_WCM_SECURITY_WPA2_MIXED_ENT:
-            return WHD_SECURITY_WPA2_MIXED_ENT;
+exit:
+    cy_rtos_set_mutex(&worker_lane_mutex);
+    return result;
+}
 
-        case CY_WCM_SECURITY_WPA2_FBT_ENT:
-            return WHD_SECURITY_WPA2_FBT_ENT;
+/*
+ * Runs on the WCM worker thread and drains the lanes. The control lane is checked again before every
+ * bulk item, so a burst of scan results delays control work by at most one bulk item.
+ */
+static void wcm_worker_dispatch(void *arg)
+{
+    wcm_worker_lane_t *worker_lane;
+    wcm_worker_job_t job;
+    cy_time_t now;
+    uint32_t latency;
 
-        case CY_WCM_SECURITY_IBSS_OPEN:
-            return WHD_SECURITY_IBSS_OPEN;
+    (void)arg;
 
-        case CY_WCM_SECURITY_WPS_SECURE:
-            return WHD_SECURITY_WPS_SECURE;
+    while(cy_rtos_get_mutex(&worker_lane_mutex, CY_RTOS_NEVER_TIMEOUT) == CY_RSLT_SUCCESS)
+    {
+        if(worker_lanes[CY_WCM_WORKER_LANE_CONTROL].count > 0)
+        {
+            worker_lane = &worker_lanes[CY_WCM_WORKER_LANE_CONTROL];
+        }
+        else if(worker_lanes[CY_WCM_WORKER_LANE_BULK].count > 0)
+        {
+            worker_lane = &worker_lanes[CY_WCM_WORKER_LANE_BULK];
+        }
+        else
+        {
+            is_worker_dispatch_queued = false;
+            cy_rtos_set_mutex(&worker_lane_mutex);
+            return;
+        }
 
-#ifdef COMPONENT_WIFI6
-        case CY_WCM_SECURITY_OWE:
-            return WHD_SECURITY_WPA3_OWE;
-#endif
+        job = worker_lane->jobs[worker_lane->head];
+        worker_lane->head = (worker_lane->head + 1) % worker_lane->size;
+        worker_lane->count--;
+        cy_rtos_get_time(&now);
+        latency = (uint32_t)(now - job.queued_time);
+        if(latency > worker_lane->stats.max_latency_ms)
+        {
+            worker_lane->stats.max_latency_ms = latency;
+        }
+        cy_rtos_set_mutex(&worker_lane_mutex);
 
-        default:
-            return WHD_SECURITY_UNKNOWN;
+        job.work_func(job.arg);
     }
 }
 
@@ -4521,7 +7365,7 @@ cy_wcm_security_t whd_to_wcm_security(whd_security_t sec)
     }
 }
 
-static cy_wcm_wifi_band_t whd_to_wcm_band(whd_802_11_band_t band)
+cy_wcm_wifi_band_t whd_to_wcm_band(whd_802_11_band_t band)
 {
     if(band == WHD_802_11_BAND_5GHZ)
     {
@@ -4845,7 +7689,7 @@ cy_rslt_t cy_wcm_set_ap_ip_setting(cy_wcm_ip_setting_t *ap_ip, const char *ip_ad
     }
 
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_DEBUG, "wcm mutex locked %s %d\r\n", __FILE__, __LINE__);
-    if((res = cy_rtos_get_mutex(&wcm_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS)) != CY_RSLT_SUCCESS)
+    if((res = cy_rtos_get_mutex(&wcm_ap_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS)) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
         return res;
@@ -4864,7 +7708,7 @@ cy_rslt_t cy_wcm_set_ap_ip_setting(cy_wcm_ip_setting_t *ap_ip, const char *ip_ad
     ap_ip->netmask.version = ver;
     ap_ip->gateway.version = ver;
 
-    if ((res = cy_rtos_set_mutex(&wcm_mutex)) != CY_RSLT_SUCCESS)
+    if ((res = cy_rtos_set_mutex(&wcm_ap_mutex)) != CY_RSLT_SUCCESS)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to release WCM mutex \n");
     }
@@ -4931,19 +7775,15 @@ cy_rslt_t cy_wcm_allow_low_power_mode(cy_wcm_powersave_mode_t mode)
 cy_rslt_t cy_wcm_sta_itwt_setup(cy_wcm_itwt_setup_params_t *itwt_params)
 {
 #ifdef COMPONENT_55900
-    whd_itwt_setup_params_t twt_params;
     cy_rslt_t       result = CY_RSLT_SUCCESS;
-    whd_interface_t ifp    = NULL;
+    wcm_itwt_flow_t *flow;
+    uint8_t         flow_id;
 
     if( itwt_params == NULL )
     {
         return CY_RSLT_WCM_BAD_ARG;
     }
 
-    if(is_itwt_enabled == true)
-    {
-        return CY_RSLT_WCM_ITWT_ENABLED;
-    }
     if(!is_wcm_initalized)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
@@ -4955,52 +7795,45 @@ cy_rslt_t cy_wcm_sta_itwt_setup(cy_wcm_itwt_setup_params_t *itwt_params)
         return CY_RSLT_WCM_NOT_CONNECTED_TO_AP;
     }
 
-    if( cy_wcm_get_whd_interface(CY_WCM_INTERFACE_TYPE_STA, &ifp) != CY_RSLT_SUCCESS )
+    if((itwt_params->setup_cmd > CY_WCM_TWT_SETUP_CMD_REJECT_TWT) ||
+       ((itwt_params->flow_id >= WCM_ITWT_MAX_FLOWS) && (itwt_params->flow_id != CY_WCM_TWT_FLOW_ID_ALL)))
     {
-        return CY_RSLT_WCM_INTERFACE_NOT_UP;
+        return CY_RSLT_WCM_BAD_ARG;
     }
 
-    if((itwt_params->setup_cmd >= CY_WCM_TWT_SETUP_CMD_REQUEST_TWT) && (itwt_params->setup_cmd <= CY_WCM_TWT_SETUP_CMD_REJECT_TWT))
-    {
-        twt_params.setup_cmd     = itwt_params->setup_cmd;
-    }
-    else
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
-        goto exit;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
     }
 
-    if(((itwt_params->flow_id>=0) && (itwt_params->flow_id <= 7)) || (itwt_params->flow_id == 0xFF))
+    if(itwt_params->flow_id == CY_WCM_TWT_FLOW_ID_ALL)
     {
-        twt_params.flow_id       = itwt_params->flow_id;
+        /* WCM picks the flow ID itself, so that it knows which agreement to track */
+        for(flow_id = 0; (flow_id < WCM_ITWT_MAX_FLOWS) && itwt_flows[flow_id].is_active; flow_id++);
     }
     else
     {
-        goto exit;
+        flow_id = itwt_params->flow_id;
     }
 
-    twt_params.trigger       = (uint8_t)itwt_params->trigger;
-    twt_params.flow_type     = (uint8_t)itwt_params->flow_type;
-    twt_params.wake_duration = itwt_params->wake_duration; /* Can be any uint8_t value. Internally will be multiplied with 256usec */
-    twt_params.exponent      = itwt_params->exponent;      /* Can be any uint8_t value. Used to compute interval */
-    twt_params.mantissa      = itwt_params->mantissa;      /* Can be any uint16_t value. Used to compute interval */
-    twt_params.wake_time_h   = itwt_params->wake_time_h;   /* Can be any uint32_t value. */
-    twt_params.wake_time_l   = itwt_params->wake_time_l;   /* Can be any uint32_t value. */
-
-    result = whd_wifi_itwt_setup(ifp, &twt_params);
-    if( result != CY_RSLT_SUCCESS)
+    if((flow_id >= WCM_ITWT_MAX_FLOWS) || itwt_flows[flow_id].is_active)
     {
-        if( result == WHD_WLAN_UNSUPPORTED )
-        {
-            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "iTWT Not supported for this capabilities\n");
-        }
-        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_itwt_setup failed %ld\r\n", result);
+        result = CY_RSLT_WCM_ITWT_ENABLED;
+        goto exit;
     }
 
-    is_itwt_enabled = true;
-    return result;
+    flow = &itwt_flows[flow_id];
+    memset(flow, 0, sizeof(wcm_itwt_flow_t));
+    flow->params = *itwt_params;
+    flow->params.flow_id = flow_id;
+    result = itwt_setup_flow(flow_id);
 
 exit:
-    result = ~CY_RSLT_SUCCESS;
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
     return result;
 
 #else
@@ -5013,27 +7846,36 @@ cy_rslt_t cy_wcm_sta_itwt_teardown(uint8_t flow_id, bool all_twt)
 {
 #ifdef COMPONENT_55900
     whd_twt_teardown_params_t twt_params;
-    whd_interface_t ifp = NULL;
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    uint8_t i;
 
-    if(is_itwt_enabled == false)
-    {
-        return CY_RSLT_WCM_ITWT_NOT_ENABLED;
-    }
     if(!is_wcm_initalized)
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
         return CY_RSLT_WCM_NOT_INITIALIZED;
     }
 
+    all_twt = (all_twt || (flow_id == CY_WCM_TWT_FLOW_ID_ALL));
+    if(!all_twt && (flow_id >= WCM_ITWT_MAX_FLOWS))
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
     if( !cy_wcm_is_connected_to_ap() )
     {
         return CY_RSLT_WCM_INTERFACE_NOT_UP;
     }
 
-    if( cy_wcm_get_whd_interface(CY_WCM_INTERFACE_TYPE_STA, &ifp) != CY_RSLT_SUCCESS )
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
     {
-        return CY_RSLT_WCM_NOT_INITIALIZED;
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+
+    if((all_twt && !is_itwt_enabled) || (!all_twt && !itwt_flows[flow_id].is_active))
+    {
+        result = CY_RSLT_WCM_ITWT_NOT_ENABLED;
+        goto exit;
     }
 
     twt_params.negotiation_type = TWT_CTRL_NEGO_TYPE_0;
@@ -5041,14 +7883,26 @@ cy_rslt_t cy_wcm_sta_itwt_teardown(uint8_t flow_id, bool all_twt)
     twt_params.bcast_twt_id = 0;
     twt_params.teardown_all_twt = all_twt;
 
-    result = whd_wifi_twt_teardown(ifp, &twt_params);
+    result = whd_wifi_twt_teardown(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &twt_params);
     if( result != CY_RSLT_SUCCESS )
     {
         cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR,
                 "iTWT session tear-down failed! Error code: %ld\n", result);
     }
 
-    is_itwt_enabled = false;
+    for(i = 0; i < WCM_ITWT_MAX_FLOWS; i++)
+    {
+        if(all_twt || (i == flow_id))
+        {
+            itwt_flow_down(i, false);
+        }
+    }
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
     return result;
 #else
     cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "This API is supported only on CYW955913EVK-01 Wi-Fi Bluetooth Prototyping Kit (CYW955913EVK-01) \n");
@@ -5120,4 +7974,258 @@ cy_rslt_t cy_wcm_sta_itwt_get_session_info(cy_wcm_itwt_negotiated_params_t *nego
 #endif /* COMPONENT_55900 */
 }
 
+cy_rslt_t cy_wcm_sta_itwt_get_flow_stats(uint8_t flow_id, cy_wcm_itwt_flow_stats_t *stats)
+{
+#ifdef COMPONENT_55900
+    wcm_itwt_flow_t *flow;
+    cy_time_t now = 0;
+
+    if(!is_wcm_initalized)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "WCM is not initialized. To initialize call cy_wcm_init(). \n");
+        return CY_RSLT_WCM_NOT_INITIALIZED;
+    }
+
+    if((stats == NULL) || (flow_id >= WCM_ITWT_MAX_FLOWS))
+    {
+        return CY_RSLT_WCM_BAD_ARG;
+    }
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return CY_RSLT_WCM_WAIT_TIMEOUT;
+    }
+
+    flow = &itwt_flows[flow_id];
+    if(flow->is_active)
+    {
+        itwt_read_negotiated(flow_id);
+    }
+    *stats = flow->stats;
+    if(flow->is_active)
+    {
+        stats->session_state = CY_WCM_TWT_SESSION_STATE_SETUP_COMPLETE;
+        cy_rtos_get_time(&now);
+        stats->active_time_ms += (uint32_t)(now - flow->active_since);
+    }
+    else
+    {
+        stats->session_state = CY_WCM_TWT_SESSION_STATE_INACTIVE;
+    }
+
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+        return CY_RSLT_WCM_MUTEX_ERROR;
+    }
+    return CY_RSLT_SUCCESS;
+#else
+    cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "This API is supported only on CYW955913EVK-01 Wi-Fi Bluetooth Prototyping Kit (CYW955913EVK-01) \n");
+    return CY_RSLT_WCM_UNSUPPORTED_API;
+#endif /* COMPONENT_55900 */
+}
+
+/* Wake interval in microseconds requested by mantissa * 2^exponent, saturated to 32 bits */
+static uint32_t itwt_wake_interval_us(uint16_t mantissa, uint8_t exponent)
+{
+    uint64_t interval;
+
+    if(mantissa == 0)
+    {
+        return 0;
+    }
+    if(exponent >= 32)
+    {
+        return UINT32_MAX;
+    }
+    interval = (uint64_t)mantissa << exponent;
+    return (interval > UINT32_MAX) ? UINT32_MAX : (uint32_t)interval;
+}
+
+/* Requests the agreement of a flow with the parameters stored in itwt_flows. Called with wcm_sta_mutex held. */
+static cy_rslt_t itwt_setup_flow(uint8_t flow_id)
+{
+    wcm_itwt_flow_t *flow = &itwt_flows[flow_id];
+    whd_itwt_setup_params_t twt_params;
+    cy_rslt_t result;
+
+    twt_params.setup_cmd     = flow->params.setup_cmd;
+    twt_params.trigger       = (uint8_t)flow->params.trigger;
+    twt_params.flow_type     = (uint8_t)flow->params.flow_type;
+    twt_params.flow_id       = flow_id;
+    twt_params.wake_duration = flow->params.wake_duration; /* Can be any uint8_t value. Internally will be multiplied with 256usec */
+    twt_params.exponent      = flow->params.exponent;      /* Can be any uint8_t value. Used to compute interval */
+    twt_params.mantissa      = flow->params.mantissa;      /* Can be any uint16_t value. Used to compute interval */
+    twt_params.wake_time_h   = flow->params.wake_time_h;   /* Can be any uint32_t value. */
+    twt_params.wake_time_l   = flow->params.wake_time_l;   /* Can be any uint32_t value. */
+
+    flow->stats.requested_wake_duration_us = (uint32_t)flow->params.wake_duration * WCM_ITWT_WAKE_DURATION_UNIT_US;
+    flow->stats.requested_wake_interval_us = itwt_wake_interval_us(flow->params.mantissa, flow->params.exponent);
+
+    result = whd_wifi_itwt_setup(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &twt_params);
+    if( result != CY_RSLT_SUCCESS )
+    {
+        if( result == WHD_WLAN_UNSUPPORTED )
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "iTWT Not supported for this capabilities\n");
+        }
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "whd_wifi_itwt_setup failed %ld\r\n", result);
+        return result;
+    }
+
+    flow->is_active = true;
+    flow->stats.setup_count++;
+    cy_rtos_get_time(&flow->active_since);
+    is_itwt_enabled = true;
+    itwt_read_negotiated(flow_id);
+    return result;
+}
+
+/* Copies the negotiated schedule of the flow, if the firmware reports it as its current session. Called with wcm_sta_mutex held. */
+static void itwt_read_negotiated(uint8_t flow_id)
+{
+#ifdef COMPONENT_55900
+    whd_itwt_negotiated_params_t negotiated;
+    cy_wcm_itwt_flow_stats_t *stats = &itwt_flows[flow_id].stats;
+
+    if((whd_wifi_itwt_get_negotiated_info(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &negotiated) != CY_RSLT_SUCCESS) ||
+       ((cy_wcm_twt_session_state_t)negotiated.session_state != CY_WCM_TWT_SESSION_STATE_SETUP_COMPLETE) || (negotiated.flow_id != flow_id))
+    {
+        return;
+    }
+    stats->wake_duration_us = negotiated.wake_duration;
+    stats->wake_interval_us = negotiated.wake_interval;
+    stats->duty_cycle_permille = (negotiated.wake_interval != 0) ?
+                                 (uint16_t)(((uint64_t)negotiated.wake_duration * 1000) / negotiated.wake_interval) : 0;
+#else
+    UNUSED_PARAMETER(flow_id);
+#endif
+}
+
+/*
+ * Marks the agreement of a flow as ended. If restore is true, it is set up again once the STA is reconnected.
+ * Called with wcm_sta_mutex held.
+ */
+static void itwt_flow_down(uint8_t flow_id, bool restore)
+{
+    wcm_itwt_flow_t *flow = &itwt_flows[flow_id];
+    cy_time_t now = 0;
+    uint8_t i;
+
+    if(flow->is_active)
+    {
+        cy_rtos_get_time(&now);
+        flow->stats.active_time_ms += (uint32_t)(now - flow->active_since);
+        flow->is_active = false;
+        flow->restore = restore;
+    }
+    else if(!restore)
+    {
+        flow->restore = false;
+    }
+
+    is_itwt_enabled = false;
+    for(i = 0; i < WCM_ITWT_MAX_FLOWS; i++)
+    {
+        is_itwt_enabled = (is_itwt_enabled || itwt_flows[i].is_active);
+    }
+}
+
+/* The agreements are with the AP, they end with the link. Called with wcm_sta_mutex held. */
+static void itwt_link_lost(void)
+{
+    uint8_t i;
+
+    for(i = 0; i < WCM_ITWT_MAX_FLOWS; i++)
+    {
+        itwt_flow_down(i, true);
+    }
+}
+
+/* Sets up again the agreements that ended with the link, after the STA has reconnected or roamed */
+static void itwt_restore_handler(void *arg)
+{
+    wcm_itwt_flow_t *flow;
+    uint8_t i;
+
+    UNUSED_PARAMETER(arg);
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+    for(i = 0; (i < WCM_ITWT_MAX_FLOWS) && wcm_sta_link_up; i++)
+    {
+        flow = &itwt_flows[i];
+        if(!flow->restore)
+        {
+            continue;
+        }
+        flow->restore = false;
+        /* The target wake time was in the TSF of the previous association, let the AP pick a new one */
+        flow->params.wake_time_h = 0;
+        flow->params.wake_time_l = 0;
+        flow->stats.renegotiation_count++;
+        if(itwt_setup_flow(i) != CY_RSLT_SUCCESS)
+        {
+            flow->stats.renegotiation_failures++;
+        }
+    }
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+}
+
+#ifdef COMPONENT_55900
+/*
+ * Handles a teardown of agreements started by the AP. arg carries the flow ID of the teardown event, or
+ * CY_WCM_TWT_FLOW_ID_ALL when the AP tore down all agreements or the event had no usable payload. In the
+ * latter case the firmware still reports a single negotiated session, which is kept.
+ */
+static void itwt_teardown_event_handler(void *arg)
+{
+    whd_itwt_negotiated_params_t negotiated;
+    uint32_t flow_id = (uint32_t)arg;
+    bool has_session;
+    uint8_t i;
+
+    if(cy_rtos_get_mutex(&wcm_sta_mutex, CY_WCM_MAX_MUTEX_WAIT_TIME_MS) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Unable to acquire WCM mutex \n");
+        return;
+    }
+    if(flow_id != CY_WCM_TWT_FLOW_ID_ALL)
+    {
+        if((flow_id < WCM_ITWT_MAX_FLOWS) && itwt_flows[flow_id].is_active)
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "iTWT flow %d torn down by the AP \n", (int)flow_id);
+            itwt_flows[flow_id].stats.ap_teardown_count++;
+            itwt_flow_down((uint8_t)flow_id, false);
+        }
+        goto exit;
+    }
+
+    has_session = ((whd_wifi_itwt_get_negotiated_info(whd_ifs[CY_WCM_INTERFACE_TYPE_STA], &negotiated) == CY_RSLT_SUCCESS) &&
+                   ((cy_wcm_twt_session_state_t)negotiated.session_state == CY_WCM_TWT_SESSION_STATE_SETUP_COMPLETE));
+    for(i = 0; i < WCM_ITWT_MAX_FLOWS; i++)
+    {
+        if(itwt_flows[i].is_active && !(has_session && (negotiated.flow_id == i)))
+        {
+            cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_INFO, "iTWT flow %d torn down by the AP \n", i);
+            itwt_flows[i].stats.ap_teardown_count++;
+            itwt_flow_down(i, false);
+        }
+    }
+
+exit:
+    if(cy_rtos_set_mutex(&wcm_sta_mutex) != CY_RSLT_SUCCESS)
+    {
+        cy_wcm_log_msg(CYLF_MIDDLEWARE, CY_LOG_ERR, "Failed to release the mutex \n");
+    }
+}
+#endif /* COMPONENT_55900 */
+
 #endif
@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+#
+# (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+# Technologies AG. All rights reserved.
+# This software, associated documentation and materials ("Software") is
+# owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+# and is protected by and subject to worldwide patent protection, worldwide
+# copyright laws, and international treaty provisions. Therefore, you may use
+# this Software only as provided in the license agreement accompanying the
+# software package from which you obtained this Software. If no license
+# agreement applies, then any use, reproduction, modification, translation, or
+# compilation of this Software is prohibited without the express written
+# permission of Infineon.
+#
+# Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+# IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+# THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+# SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+# Infineon reserves the right to make changes to the Software without notice.
+# You are responsible for properly designing, programming, and testing the
+# functionality and safety of your intended application of the Software, as
+# well as complying with any legal requirements related to its use. Infineon
+# does not guarantee that the Software will be free from intrusion, data theft
+# or loss, or other breaches ("Security Breaches"), and Infineon shall have
+# no liability arising out of any Security Breaches. Unless otherwise
+# explicitly approved by Infineon, the Software may not be used in any
+# application where a failure of the Product or any consequences of the use
+# thereof can reasonably be expected to result in personal injury.
+"""Host test and benchmark for the multiply kernels of the WPS natural number
+library (source/COMPONENT_WPS/nn.c).
+
+Builds nn.c twice with the host compiler, once with the Comba/Karatsuba
+kernels and once with NN_REFERENCE_MUL, and checks NN_Mul, NN_MulModMont and
+NN_ExpModMont of both builds against Python integers:
+
+    python3 tools/nn_host_test.py
+
+Random operands cover every length from 1 to 48 words. The edge cases are
+moduli and operands made of all-ones words and the WPS Diffie-Hellman prime,
+whose top and bottom words are 0xffffffff. --bench N also times N 1536-bit
+Montgomery squarings and N/100 exponentiations with and without the kernels.
+The host timings only compare the two paths; cycle counts for a target must
+be taken on the target, for example with the DWT cycle counter.
+"""
+
+import argparse
+import os
+import random
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+TOOLS = os.path.dirname(os.path.abspath(__file__))
+NN_DIR = os.path.join(TOOLS, "..", "source", "COMPONENT_WPS")
+STUB_DIR = os.path.join(TOOLS, "nn_host_test")
+
+BUILDS = (("kernels", []), ("reference", ["-DNN_REFERENCE_MUL"]))
+
+
+def build(cc, out_dir, name, defines):
+    """Compiles nn.c with the host driver, returns the path of the executable."""
+    exe = os.path.join(out_dir, "nn_" + name)
+    cmd = [cc, "-O2", "-Wall", "-DENABLE_UNUSED_NN_FUNCTIONS"] + defines + [
+        "-I" + STUB_DIR, "-I" + NN_DIR,
+        os.path.join(NN_DIR, "nn.c"), os.path.join(STUB_DIR, "nn_host_driver.c"), "-o", exe]
+    subprocess.check_call(cmd)
+    return exe
+
+
+def load_wps_prime():
+    """Returns the WPS Diffie-Hellman prime read from DH_P_VALUE in cy_wps_common.c."""
+    with open(os.path.join(NN_DIR, "cy_wps_common.c"), "r") as source:
+        text = source.read()
+    body = re.search(r"DH_P_VALUE\[\w+\]\s*=\s*\{(.*?)\}", text, re.S)
+    if body is None:
+        sys.exit("DH_P_VALUE not found in cy_wps_common.c")
+    return int("".join("%02x" % int(b, 16) for b in re.findall(r"0x[0-9a-fA-F]+", body.group(1))), 16)
+
+
+def to_hex(value, words):
+    return "%0*x" % (8 * words, value)
+
+
+def random_odd_modulus(rng, words):
+    return rng.getrandbits(32 * words) | (1 << (32 * words - 1)) | 1
+
+
+def vectors(rng, count):
+    """Yields (command, expected result) pairs."""
+    all_ones = lambda words: (1 << (32 * words)) - 1
+    prime = load_wps_prime()
+
+    for words in range(1, 49):
+        for _ in range(count):
+            x, y = rng.getrandbits(32 * words), rng.getrandbits(32 * words)
+            yield "mul %s %s" % (to_hex(x, words), to_hex(y, words)), x * y
+        x = y = all_ones(words)
+        yield "mul %s %s" % (to_hex(x, words), to_hex(y, words)), x * y
+        x = rng.getrandbits(32 * words)
+        yield "mul %s %s" % (to_hex(x, words), to_hex(x, words)), x * x
+
+    def mont(m, x, y, words):
+        r_inv = pow(1 << (32 * words), -1, m)
+        for op in ("mont", "montref"):
+            yield "%s %s %s %s" % (op, to_hex(m, words), to_hex(x, words), to_hex(y, words)), x * y * r_inv % m
+
+    for words in range(1, 49):
+        for _ in range(count):
+            m = random_odd_modulus(rng, words)
+            yield from mont(m, rng.randrange(m), rng.randrange(m), words)
+        m = all_ones(words)
+        yield from mont(m, m - 1, m - 1, words)
+        yield from mont(m, m - 2, m - 1, words)
+        x = rng.randrange(m)
+        yield from mont(m, x, x, words)
+
+    for x, y in ((prime - 1, prime - 1), (prime - 2, prime - 1), (1, 1), (0, prime - 1)):
+        yield from mont(prime, x, y, 48)
+    for _ in range(count):
+        x = rng.randrange(prime)
+        yield from mont(prime, x, x, 48)
+        yield from mont(prime, x, rng.randrange(prime), 48)
+
+    for _ in range(max(1, count // 4)):
+        for m, base in ((prime, 2), (prime, rng.randrange(prime)), (random_odd_modulus(rng, 48), None)):
+            x = base if base is not None else rng.randrange(m)
+            e = rng.getrandbits(384)
+            for op in ("exp", "expref"):
+                yield "%s %s %s %s" % (op, to_hex(m, 48), to_hex(x, 48), to_hex(e, 12)), pow(x, e, m)
+
+
+def check(exe, cases):
+    """Runs the cases through one build, returns the number of mismatches."""
+    commands = "".join(command + "\n" for command, _ in cases)
+    output = subprocess.run([exe], input=commands, stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout.split()
+    failures = 0
+    for (command, expected), result in zip(cases, output):
+        if result == "error" or int(result, 16) != expected:
+            failures += 1
+            if failures <= 5:
+                print("  FAIL %s\n    got      %s\n    expected %x" % (command, result, expected))
+    if len(output) != len(cases):
+        print("  FAIL %d results for %d commands" % (len(output), len(cases)))
+        failures += 1
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check the NN multiply kernels against Python integers.")
+    parser.add_argument("--cc", default=os.environ.get("CC", "cc"), help="host C compiler (default: %(default)s)")
+    parser.add_argument("--count", type=int, default=20, help="random vectors per operand length (default: %(default)s)")
+    parser.add_argument("--seed", type=int, default=1, help="random seed (default: %(default)s)")
+    parser.add_argument("--bench", type=int, metavar="N", help="also time N squarings and N/100 exponentiations")
+    args = parser.parse_args()
+
+    cases = list(vectors(random.Random(args.seed), args.count))
+    out_dir = tempfile.mkdtemp(prefix="nn_host_test")
+    failures = 0
+    try:
+        for name, defines in BUILDS:
+            exe = build(args.cc, out_dir, name, defines)
+            failed = check(exe, cases)
+            print("%-9s %d/%d passed" % (name, len(cases) - failed, len(cases)))
+            failures += failed
+            if args.bench:
+                # Each line: average per call with scratch (kernels) and without (interleaved loop)
+                bench = subprocess.run([exe], input="bench %d\n" % args.bench, stdout=subprocess.PIPE,
+                                       universal_newlines=True, check=True).stdout
+                for line in bench.splitlines():
+                    op, fast, slow, unit = line.split(" ", 3)
+                    print("  %s  %10s with scratch  %10s without  (%s)" % (op, fast, slow, unit))
+    finally:
+        shutil.rmtree(out_dir)
+
+    sys.exit(1 if failures else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,224 @@
+/*
+ * (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+ * Technologies AG. All rights reserved.
+ * This software, associated documentation and materials ("Software") is
+ * owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+ * and is protected by and subject to worldwide patent protection, worldwide
+ * copyright laws, and international treaty provisions. Therefore, you may use
+ * this Software only as provided in the license agreement accompanying the
+ * software package from which you obtained this Software. If no license
+ * agreement applies, then any use, reproduction, modification, translation, or
+ * compilation of this Software is prohibited without the express written
+ * permission of Infineon.
+ *
+ * Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+ * IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+ * THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+ * SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+ * Infineon reserves the right to make changes to the Software without notice.
+ * You are responsible for properly designing, programming, and testing the
+ * functionality and safety of your intended application of the Software, as
+ * well as complying with any legal requirements related to its use. Infineon
+ * does not guarantee that the Software will be free from intrusion, data theft
+ * or loss, or other breaches ("Security Breaches"), and Infineon shall have
+ * no liability arising out of any Security Breaches. Unless otherwise
+ * explicitly approved by Infineon, the Software may not be used in any
+ * application where a failure of the Product or any consequences of the use
+ * thereof can reasonably be expected to result in personal injury.
+ */
+
+/*
+ * Host driver for tools/nn_host_test.py. Links against nn.c and runs one
+ * command per line of stdin, numbers are big-endian hex, 8 digits per word:
+ *
+ *   mul X Y        prints X * Y                    (NN_Mul)
+ *   mont M X Y     prints X * Y * R^-1 mod M       (NN_MulModMont, kernels)
+ *   montref M X Y  the same with the interleaved loop (no scratch)
+ *   exp M X E      prints X ^ E mod M              (NN_ExpModMont, kernels)
+ *   expref M X E   the same with the interleaved loop (no scratch)
+ *   bench N        times N 1536-bit squarings and exponentiations
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nn.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <x86intrin.h>
+#define CYCLES()            __rdtsc()
+#define CYCLES_UNIT         "TSC cycles"
+#else
+static uint64_t cycles_ns( void )
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+#define CYCLES()            cycles_ns()
+#define CYCLES_UNIT         "ns"
+#endif
+
+#define MAX_WORDS           96
+
+typedef struct
+{
+    uint32_t len;
+    uint32_t num[ MAX_WORDS ];
+} host_NN_t;
+
+static uint32_t scratch[ NN_MONT_SCRATCH_WORDS( 48 ) ];
+
+static int parse( host_NN_t* n, const char* hex )
+{
+    size_t   digits = strlen( hex );
+    uint32_t i;
+    char     word[ 9 ];
+
+    if ( ( digits == 0 ) || ( digits % 8 ) || ( digits / 8 > MAX_WORDS ) )
+    {
+        return -1;
+    }
+
+    n->len = digits / 8;
+    word[ 8 ] = 0;
+
+    for ( i = 0 ; i < n->len ; i++ )
+    {
+        memcpy( word, hex + 8 * i, 8 );
+        n->num[ i ] = (uint32_t) strtoul( word, NULL, 16 );
+    }
+
+    return 0;
+}
+
+static void print( const host_NN_t* n )
+{
+    uint32_t i;
+
+    for ( i = 0 ; i < n->len ; i++ )
+    {
+        printf( "%08x", n->num[ i ] );
+    }
+
+    printf( "\n" );
+}
+
+static uint32_t lcg( void )
+{
+    static uint64_t state = 0x2545f4914f6cdd1dULL;
+
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (uint32_t) ( state >> 32 );
+}
+
+static void bench( unsigned long iterations )
+{
+    host_NN_t m, x, e, w, r, t;
+    uint64_t  start, mont, ref;
+    uint32_t  i, mt;
+    unsigned long k;
+
+    m.len = x.len = e.len = w.len = r.len = t.len = 48;
+
+    for ( i = 0 ; i < 48 ; i++ )
+    {
+        m.num[ i ] = lcg();
+        x.num[ i ] = lcg();
+        e.num[ i ] = lcg();
+    }
+
+    m.num[ 0 ] |= 0x80000000;
+    m.num[ 47 ] |= 1;
+    x.num[ 0 ] &= 0x7fffffff;
+    mt = NN_EmTick( (NN_t*) &m );
+
+    start = CYCLES();
+    for ( k = iterations ; k-- ; )
+    {
+        NN_MulModMont( (NN_t*) &r, (NN_t*) &x, (NN_t*) &x, (NN_t*) &m, mt, scratch );
+    }
+    mont = CYCLES() - start;
+
+    start = CYCLES();
+    for ( k = iterations ; k-- ; )
+    {
+        NN_MulModMont( (NN_t*) &r, (NN_t*) &x, (NN_t*) &x, (NN_t*) &m, mt, NULL );
+    }
+    ref = CYCLES() - start;
+
+    printf( "sqr %llu %llu %s\n", (unsigned long long) ( mont / iterations ), (unsigned long long) ( ref / iterations ), CYCLES_UNIT );
+
+    iterations = ( iterations + 99 ) / 100;
+
+    start = CYCLES();
+    for ( k = iterations ; k-- ; )
+    {
+        memcpy( &t, &x, sizeof( t ) );
+        NN_ExpModMont( (NN_t*) &r, (NN_t*) &t, (NN_t*) &e, (NN_t*) &m, (NN_t*) &w, scratch );
+    }
+    mont = CYCLES() - start;
+
+    start = CYCLES();
+    for ( k = iterations ; k-- ; )
+    {
+        memcpy( &t, &x, sizeof( t ) );
+        NN_ExpModMont( (NN_t*) &r, (NN_t*) &t, (NN_t*) &e, (NN_t*) &m, (NN_t*) &w, NULL );
+    }
+    ref = CYCLES() - start;
+
+    printf( "exp %llu %llu %s\n", (unsigned long long) ( mont / iterations ), (unsigned long long) ( ref / iterations ), CYCLES_UNIT );
+}
+
+int main( void )
+{
+    char      line[ 4096 ];
+    char      op[ 16 ], a[ 1024 ], b[ 1024 ], c[ 1024 ];
+    host_NN_t m, x, y, r, w;
+    uint32_t* s;
+    int       args;
+
+    while ( fgets( line, sizeof( line ), stdin ) != NULL )
+    {
+        args = sscanf( line, "%15s %1023s %1023s %1023s", op, a, b, c );
+
+        if ( ( args == 2 ) && ( strcmp( op, "bench" ) == 0 ) )
+        {
+            bench( strtoul( a, NULL, 10 ) );
+        }
+#ifdef ENABLE_UNUSED_NN_FUNCTIONS
+        else if ( ( args == 3 ) && ( strcmp( op, "mul" ) == 0 ) && !parse( &x, a ) && !parse( &y, b ) )
+        {
+            r.len = x.len + y.len;
+            NN_Mul( (NN_t*) &r, (NN_t*) &x, (NN_t*) &y );
+            print( &r );
+        }
+#endif
+        else if ( ( args == 4 ) && ( strncmp( op, "mont", 4 ) == 0 ) && !parse( &m, a ) && !parse( &x, b ) && !parse( &y, c ) )
+        {
+            s = strcmp( op, "mont" ) ? NULL : scratch;
+            r.len = m.len;
+            NN_MulModMont( (NN_t*) &r, (NN_t*) &x, (NN_t*) &y, (NN_t*) &m, NN_EmTick( (NN_t*) &m ), s );
+            print( &r );
+        }
+        else if ( ( args == 4 ) && ( strncmp( op, "exp", 3 ) == 0 ) && !parse( &m, a ) && !parse( &x, b ) && !parse( &y, c ) )
+        {
+            s = strcmp( op, "exp" ) ? NULL : scratch;
+            r.len = w.len = m.len;
+            NN_ExpModMont( (NN_t*) &r, (NN_t*) &x, (NN_t*) &y, (NN_t*) &m, (NN_t*) &w, s );
+            print( &r );
+        }
+        else
+        {
+            printf( "error\n" );
+        }
+
+        fflush( stdout );
+    }
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+#
+# (c) 2025, Infineon Technologies AG, or an affiliate of Infineon
+# Technologies AG. All rights reserved.
+# This software, associated documentation and materials ("Software") is
+# owned by Infineon Technologies AG or one of its affiliates ("Infineon")
+# and is protected by and subject to worldwide patent protection, worldwide
+# copyright laws, and international treaty provisions. Therefore, you may use
+# this Software only as provided in the license agreement accompanying the
+# software package from which you obtained this Software. If no license
+# agreement applies, then any use, reproduction, modification, translation, or
+# compilation of this Software is prohibited without the express written
+# permission of Infineon.
+#
+# Disclaimer: UNLESS OTHERWISE EXPRESSLY AGREED WITH INFINEON, THIS SOFTWARE
+# IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+# INCLUDING, BUT NOT LIMITED TO, ALL WARRANTIES OF NON-INFRINGEMENT OF
+# THIRD-PARTY RIGHTS AND IMPLIED WARRANTIES SUCH AS WARRANTIES OF FITNESS FOR A
+# SPECIFIC USE/PURPOSE OR MERCHANTABILITY.
+# Infineon reserves the right to make changes to the Software without notice.
+# You are responsible for properly designing, programming, and testing the
+# functionality and safety of your intended application of the Software, as
+# well as complying with any legal requirements related to its use. Infineon
+# does not guarantee that the Software will be free from intrusion, data theft
+# or loss, or other breaches ("Security Breaches"), and Infineon shall have
+# no liability arising out of any Security Breaches. Unless otherwise
+# explicitly approved by Infineon, the Software may not be used in any
+# application where a failure of the Product or any consequences of the use
+# thereof can reasonably be expected to result in personal injury.
+#
+"""Decodes a dump of the WCM binary trace buffer (cy_wcm_trace_buffer).
+
+Build the application with DEFINES+=ENABLE_WCM_TRACE, dump the buffer from the
+target, for example with GDB:
+
+    dump binary value wcm_trace.bin cy_wcm_trace_buffer
+
+and decode it:
+
+    python3 tools/wcm_trace_decode.py wcm_trace.bin
+
+Event names and argument descriptions are read from include/cy_wcm_log.h, so
+the decoder follows the event list without changes of its own.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+TRACE_MAGIC = 0x54434D57
+TRACE_VERSION = 1
+HEADER = struct.Struct("<IHHII")
+RECORD = struct.Struct("<IIIiii")
+
+DEFAULT_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "cy_wcm_log.h")
+
+
+def load_events(header_path):
+    """Returns {id: (name, argument description)} parsed from the cy_wcm_trace_event_t enum."""
+    with open(header_path, "r") as header:
+        text = header.read()
+    body = re.search(r"typedef enum\s*\{(.*?)\}\s*cy_wcm_trace_event_t;", text, re.S)
+    if body is None:
+        sys.exit("cy_wcm_trace_event_t not found in %s" % header_path)
+
+    events = {}
+    value = 0
+    for match in re.finditer(r"CY_WCM_TRACE_(\w+)\s*(?:=\s*(\d+))?\s*,?\s*/\*\*<\s*(.*?)\s*\*/", body.group(1)):
+        if match.group(2) is not None:
+            value = int(match.group(2))
+        events[value] = (match.group(1), match.group(3))
+        value += 1
+    return events
+
+
+def format_arg(value):
+    # Results and security types are bit fields; small values are counts, channels and RSSI
+    return ("%d" % value) if -0x10000 < value < 0x10000 else ("0x%08X" % (value & 0xFFFFFFFF))
+
+
+def decode(dump, events):
+    if len(dump) < HEADER.size:
+        sys.exit("Dump is too short for the trace header")
+
+    magic, version, record_size, capacity, head = HEADER.unpack_from(dump, 0)
+    if magic != TRACE_MAGIC:
+        sys.exit("Bad magic 0x%08X; is this a dump of cy_wcm_trace_buffer?" % magic)
+    if version != TRACE_VERSION or record_size != RECORD.size:
+        sys.exit("Unsupported trace version %d (record size %d)" % (version, record_size))
+    if len(dump) < HEADER.size + capacity * record_size:
+        sys.exit("Dump is truncated: expected %d records" % capacity)
+
+    records = []
+    for slot in range(capacity):
+        sequence, timestamp, event, arg0, arg1, arg2 = RECORD.unpack_from(dump, HEADER.size + slot * record_size)
+        # Skip empty slots and records that were being written when the buffer was dumped
+        if sequence == 0 or (sequence - 1) % capacity != slot:
+            continue
+        records.append((sequence, timestamp, event, (arg0, arg1, arg2)))
+    records.sort()
+
+    if head > capacity:
+        print("# %d records written, %d oldest overwritten" % (head, head - capacity))
+
+    previous = None
+    for sequence, timestamp, event, args in records:
+        if previous is not None and sequence != previous + 1:
+            print("# %d records lost" % (sequence - previous - 1))
+        previous = sequence
+
+        name, description = events.get(event, ("UNKNOWN_%d" % event, ""))
+        names = [part.strip() for part in description.split(",")] if description not in ("", "none") else []
+        values = []
+        for index, arg in enumerate(args):
+            if index < len(names):
+                values.append("%s=%s" % (names[index], format_arg(arg)))
+            elif arg != 0:
+                values.append("arg%d=%s" % (index, format_arg(arg)))
+        print("%10u ms  #%-6u %-18s %s" % (timestamp, sequence, name, ", ".join(values)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a WCM binary trace dump.")
+    parser.add_argument("dump", help="binary dump of cy_wcm_trace_buffer")
+    parser.add_argument("--header", default=DEFAULT_HEADER, help="path to cy_wcm_log.h (default: %(default)s)")
+    args = parser.parse_args()
+
+    with open(args.dump, "rb") as dump:
+        decode(dump.read(), load_events(args.header))
+
+
+if __name__ == "__main__":
+    main()